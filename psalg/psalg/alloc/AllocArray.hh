@@ -1,6 +1,9 @@
 #ifndef ALLOCARRAY__H
 #define ALLOCARRAY__H
 
+#include <new>
+#include <string.h>
+
 #include "psalg/utils/SysLog.hh"
 #include "xtcdata/xtc/Array.hh"
 #include "xtcdata/xtc/DescData.hh"
@@ -14,10 +17,8 @@ template <typename T>
 class AllocArray:public Array<T>{
 public:
 
-    AllocArray(Allocator& allocator, size_t maxElem, uint32_t rank):_allocator(allocator){
-        void *ptr = _allocator.malloc(sizeof(Shape) +
-                                      sizeof(*_refCntPtr) +
-                                      maxElem*sizeof(T)); // shape + refcnt + data
+    AllocArray(Allocator& allocator, size_t maxElem, uint32_t rank):_allocator(&allocator){
+        void *ptr = _allocator->malloc(_blockSize(maxElem)); // shape + refcnt + data
         Array<T>::_shape = reinterpret_cast<uint32_t*>(ptr);
         _refCntPtr = reinterpret_cast<uint32_t*>(Array<T>::_shape+MaxRank);
         Array<T>::_data = reinterpret_cast<T*>(_refCntPtr+1);
@@ -40,7 +41,7 @@ public:
         if (this != &other) {
             decRefCnt();
             if (_refCnt() == 0) {
-                _allocator.free(this->_shape);
+                _allocator->free(this->_shape);
             }
 
             this->_shape = other._shape;
@@ -65,7 +66,7 @@ public:
             // are array-of-arrays.
             Array<T>::_data[i].~T();
             }
-            _allocator.free(Array<T>::_shape); // free the memory
+            _allocator->free(Array<T>::_shape); // free the memory
         }
     }
 
@@ -84,8 +85,36 @@ public:
     }
 
 protected:
+    static size_t _blockSize(size_t maxElem){
+        return sizeof(Shape) + sizeof(uint32_t) + maxElem*sizeof(T);
+    }
+
+    // Makes room for maxElem elements: in place if the allocator can
+    // extend the block (an Arena can, for its most recent one), otherwise
+    // by moving them to a new block.  Only possible while the array isn't
+    // shared, since the copies would keep pointing to the old block.
+    bool _reserve(size_t maxElem){
+        if (_refCnt() != 1) return false;
+        if (_allocator->grow(Array<T>::_shape, _blockSize(maxElem))) return true;
+        uint32_t *shape = reinterpret_cast<uint32_t*>(_allocator->malloc(_blockSize(maxElem)));
+        if (!shape) return false;
+        uint32_t *refCntPtr = shape+MaxRank;
+        T *data = reinterpret_cast<T*>(refCntPtr+1);
+        memcpy(shape, Array<T>::_shape, MaxRank*sizeof(uint32_t));
+        *refCntPtr = 1;
+        for(unsigned i = 0; i < Array<T>::num_elem(); i++) {
+            new(data+i) T(Array<T>::_data[i]);
+            Array<T>::_data[i].~T();
+        }
+        _allocator->free(Array<T>::_shape);
+        Array<T>::_shape = shape;
+        Array<T>::_data = data;
+        _refCntPtr = refCntPtr;
+        return true;
+    }
+
     uint32_t *_refCntPtr;
-    Allocator& _allocator;
+    Allocator *_allocator;
 };
 
 
@@ -118,9 +147,11 @@ public:
     // ----- std::vector-like methods
 
     void push_back(const T& i){
-        if (AllocArray<T>::_shape[0] >= _maxShape) {
+        if (AllocArray<T>::_shape[0] >= _maxShape &&
+            !reserve(_maxShape ? 2*_maxShape : 16)) {
             psalg::SysLog::error("AllocArray: maxShape exceeded: %d >= %d\n",
                                  AllocArray<T>::_shape[0],_maxShape);
+            return;
         }
         new(AllocArray<T>::_data+AllocArray<T>::_shape[0]) T(i);
         AllocArray<T>::_shape[0]++;
@@ -136,6 +167,14 @@ public:
         AllocArray<T>::_shape[0] = 0;
     }
 
+    // Grows the capacity to at least maxElem; fails for a shared array
+    bool reserve(size_t maxElem){
+        if (maxElem <= _maxShape) return true;
+        if (!AllocArray<T>::_reserve(maxElem)) return false;
+        _maxShape = maxElem;
+        return true;
+    }
+
     uint32_t capacity(){
         return _maxShape;
     }
@@ -8,24 +8,113 @@ class Allocator{ //Heap -> Allocator
 public:
     virtual void *malloc(size_t size) = 0;
     virtual void free(void *ptr) = 0;
+    // Extends the block at ptr to newSize bytes where it is, if the
+    // allocator can; returns false if the caller has to move it
+    virtual bool grow(void *, size_t) {return false;}
 };
 
-class Stack:public Allocator{ // PebbleHeap -> Stack
+// Bump allocator over one contiguous region: either borrowed (the
+// unused end of a pebble buffer, say) or owned.  Allocation moves a
+// pointer and free() only gives back the most recent block, so all the
+// temporaries of an event cost no malloc and take no lock; reset()
+// releases everything at once.  Nothing allocated from the arena may be
+// used after reset(), so the usual pattern is a reset() at the start of
+// each event, with the arrays of the previous event already released
+// (or two arenas used alternately when results live until the next
+// event).  Not thread safe: each worker thread needs its own Arena.
+//
+// A request that doesn't fit is served by ::malloc and counted, so a
+// region that is too small shows up in the statistics rather than as
+// memory corruption.
+class Arena:public Allocator{
 public:
-    Stack():_allocator(_buf){}
+    enum {Alignment=16};
 
-private:
-    uint8_t _buf[1024*1024];
-    uint8_t *_allocator;
+    Arena(void *buf, size_t size):_owned(0){_init(buf, size);}
+    Arena(size_t size):_owned(new uint8_t[size]){_init(_owned, size);}
+    virtual ~Arena(){delete[] _owned;}
+
+    virtual void *malloc(size_t size) {
+        size_t offset = _align(_used);
+        if (size > _size || offset > _size - size) {
+            _overflows++;
+            return ::malloc(size);
+        }
+        _last = offset;
+        _used = offset + size;
+        if (_used > _highWater) _highWater = _used;
+        _allocs++;
+        _live++;
+        return _base + offset;
+    }
 
     virtual void free(void *ptr) {
+        if (!_contains(ptr)) {
+            ::free(ptr);
+            return;
+        }
+        if (_live) _live--;
+        if ((uint8_t*)ptr == _base + _last) _used = _last;
     }
 
-    virtual void *malloc(size_t size) {
-        void *curr_allocator = _allocator;
-        _allocator += size;
-        return curr_allocator;
+    virtual bool grow(void *ptr, size_t newSize) {
+        if ((uint8_t*)ptr != _base + _last || newSize > _size - _last) return false;
+        _used = _last + newSize;
+        if (_used > _highWater) _highWater = _used;
+        return true;
     }
+
+    void reset() {
+        if (_live) _staleResets++;
+        _used = 0;
+        _last = _size;
+        _live = 0;
+    }
+
+    size_t capacity()    const {return _size;}
+    size_t used()        const {return _used;}
+    size_t highWater()   const {return _highWater;} // most ever used between resets
+    size_t live()        const {return _live;}      // blocks not freed yet
+    size_t allocs()      const {return _allocs;}
+    size_t overflows()   const {return _overflows;} // requests passed on to the heap
+    size_t staleResets() const {return _staleResets;} // resets with blocks still live
+
+private:
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+    void _init(void *buf, size_t size) {
+        // start on an aligned address so that offsets and addresses agree
+        uintptr_t b = (uintptr_t)buf;
+        uintptr_t a = (b + Alignment - 1) & ~uintptr_t(Alignment - 1);
+        _base = (uint8_t*)a;
+        _size = size > a - b ? size - (a - b) : 0;
+        _live = _highWater = _allocs = _overflows = _staleResets = 0;
+        reset();
+    }
+    static size_t _align(size_t n) {return (n + Alignment - 1) & ~size_t(Alignment - 1);}
+    bool _contains(void *ptr) const {
+        return (uint8_t*)ptr >= _base && (uint8_t*)ptr < _base + _size;
+    }
+
+    uint8_t *_owned;
+    uint8_t *_base;
+    size_t   _size;
+    size_t   _used;
+    size_t   _last;   // offset of the most recent block
+    size_t   _live;
+    size_t   _highWater;
+    size_t   _allocs;
+    size_t   _overflows;
+    size_t   _staleResets;
+};
+
+class Stack:public Arena{ // PebbleHeap -> Stack
+public:
+    Stack():Arena(_buf, sizeof(_buf)){}
+
+private:
+    uint8_t _buf[1024*1024];
 };
 
 class Heap:public Allocator{ // StandardHeap -> Heap
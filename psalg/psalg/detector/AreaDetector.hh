@@ -13,6 +13,7 @@
 
 #include "psalg/detector/Detector.hh"
 #include "psalg/detector/UtilsConfig.hh" // configNames
+#include "psalg/detector/PixelCalib.hh"
 
 #include "xtcdata/xtc/DataIter.hh"
 #include "xtcdata/xtc/ConfigIter.hh"
@@ -151,6 +152,13 @@ public:
   /// access to raw, calibrated data, and image
   virtual void load_calib_constants();
 
+  /// calibrated frame of raw data from the event, nthreads - number of threads to process panels
+  const NDArray<calib_t>& calib(XtcData::DescData& ddata, const int nthreads=1);
+  const NDArray<calib_t>& calib(XtcData::DataIter& datao, const int nthreads=1);
+
+  /// engine used by calib(...), e.g. to set common mode parameters
+  PixelCalib& pixel_calib() {return _pixel_calib;}
+
   virtual const NDArray<raw_t>& raw(const event_t&);
   virtual const NDArray<calib_t>& calib(const event_t&);
   virtual const NDArray<image_t>& image(const event_t&);
@@ -199,6 +207,11 @@ protected:
   int                     _ind_data;
   void _set_index_data(XtcData::DescData& ddata, const char* dataname);
 
+  /// how the gain state of a pixel is encoded in its raw value
+  virtual PixelCalib::GAINMODE gain_mode() const {return PixelCalib::SINGLE;}
+
+  PixelCalib              _pixel_calib;
+
 private:
 
   calib::CalibPars*       _calib_pars;
@@ -78,6 +78,11 @@ public:
 
   enum {MAX_NUMBER_OF_MODULES=8};
 
+protected:
+
+  /// gain state in bits 14-15 of raw data
+  virtual PixelCalib::GAINMODE gain_mode() const {return PixelCalib::JUNGFRAU;}
+
 private:
 
   cfg_int64_t _moduleVersion  [MAX_NUMBER_OF_MODULES];
@@ -0,0 +1,176 @@
+#ifndef PSALG_PIXELCALIB_H
+#define PSALG_PIXELCALIB_H
+
+//-------------------
+
+#include <vector>
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint16_t
+
+#include "psalg/calib/AreaDetectorTypes.hh" // raw_t, calib_t
+#include "psalg/calib/CalibPars.hh"
+#include "psalg/calib/Query.hh"
+
+//-------------------
+
+namespace detector {
+
+/// @addtogroup detector
+
+/**
+ *  @ingroup detector
+ *
+ *  @brief Per-pixel calibration of raw area detector frames: pedestal, gain, status and common mode.
+ *
+ *  Constants are rearranged once, when they are set, into one plane per hardware gain state
+ *  of the detector (1 for epix100a, 2 for the bit 14 of epix10ka, 3 for the gain bits 14-15
+ *  of jungfrau). Each plane holds the pedestal with the offset added and the inverse gain,
+ *  the latter zeroed for pixels with bad status or outside the mask, so that calibrating
+ *  a pixel is a branch-free (adc - ped[state]) * gfac[state]. The planes are stored
+ *  structure-of-arrays, so that the AVX2 kernel reads 8 consecutive pixels of each with
+ *  plain loads; a scalar kernel is used on cpus without AVX2.
+ *
+ *  Common mode, when enabled, is the median of the good, highest gain pixels with |value| < cormax
+ *  in each bank, row and/or column of a panel, computed in ADU between the pedestal and gain steps.
+ *  Panels are calibrated in parallel with OpenMP.
+ *
+ *  Gain-switching epix10ka-style detectors have 7 gain ranges of constants (FH, FM, FL, AHL-H, AML-M,
+ *  AHL-L, AML-L), of which each pixel uses the pair set by its configuration: set_switch_ranges()
+ *  takes them per pixel, and AHL-H/AHL-L are used for all pixels by default.
+ *
+ *  @note This software was developed for the LCLS project.
+ *  If you use all or part of it, please give an appropriate acknowledgment.
+ *
+ *  @anchor interface
+ *  @par<interface> Interface Description
+ *
+ *  @li  Include
+ *  @code
+ *  #include "psalg/detector/PixelCalib.hh"
+ *  @endcode
+ *
+ *  @li Instatiation
+ *  @code
+ *    detector::PixelCalib pc(detector::PixelCalib::JUNGFRAU, nmodules, nrows, ncols);
+ *    pc.load(*calib::getCalibPars("jungfrau"), query);   // or
+ *    pc.set_constants(peds, gains, offsets, status);      // nranges() planes of size() values each
+ *    pc.set_common_mode(PixelCalib::CM_ROWS | PixelCalib::CM_BANKS, 200, 10, 256);
+ *  @endcode
+ *
+ *  @li Access methods
+ *  @code
+ *    std::vector<detector::calib_t> out(pc.size());
+ *    pc.calibrate(raw_data, out.data());     // raw_data - size() raw values, panel after panel
+ *    pc.calibrate(raw_data, out.data(), 8);  // the same using 8 threads
+ *  @endcode
+ */
+
+class PixelCalib {
+public:
+
+  /// How the gain state of a pixel is encoded in its raw value
+  enum GAINMODE {SINGLE=0,   ///< one gain, all 16 bits are data (epix100a)
+                 EPIX10KA,   ///< 14 data bits, bit 14 set when switched, 7 ranges of constants
+                 JUNGFRAU};  ///< 14 data bits, bits 14-15 are 0, 1, 3 for gain 0, 1, 2
+
+  /// Common mode groups, any combination of which is applied in the order banks, rows, columns
+  enum CMODE {CM_NONE=0, CM_ROWS=1, CM_COLS=2, CM_BANKS=4};
+
+  /// Epix10ka gain ranges, the order of the constants
+  enum EPIX10KA_RANGE {FH=0, FM, FL, AHL_H, AML_M, AHL_L, AML_L, EPIX10KA_NRANGES};
+
+  /**
+   *  @param[in] mode - gain encoding of the detector
+   *  @param[in] npanels, nrows, ncols - shape of the raw data
+   */
+  PixelCalib(const GAINMODE mode=SINGLE, const size_t npanels=1, const size_t nrows=0, const size_t ncols=0);
+
+  PixelCalib(const PixelCalib&) = delete;
+  PixelCalib& operator = (const PixelCalib&) = delete;
+
+  ~PixelCalib(){}
+
+  /// Changes gain encoding and shape; constants have to be set again
+  void set_geometry(const GAINMODE mode, const size_t npanels, const size_t nrows, const size_t ncols);
+
+  /// Sets constants, each of nranges() planes of size() values in the order of the raw data
+  /**
+   *  @param[in] peds - pedestals, required
+   *  @param[in] gains - gains in ADU per unit of output, 1 if 0
+   *  @param[in] offsets - offsets in ADU, added to the pedestals, none if 0
+   *  @param[in] status - non-zero for bad pixels, which calibrate to 0; all good if 0
+   *  @param[in] mask - one plane, zero for pixels to suppress; all on if 0
+   */
+  void set_constants(const float* peds,
+                     const float* gains=0,
+                     const float* offsets=0,
+                     const uint16_t* status=0,
+                     const uint16_t* mask=0);
+
+  /// Sets the two EPIX10KA_RANGE of each pixel, used with bit 14 clear and set, as from its configuration
+  void set_switch_ranges(const uint8_t* rclear, const uint8_t* rset);
+
+  /**
+   *  @param[in] cmflags - combination of CMODE
+   *  @param[in] cormax - pixels with |value| in ADU at or above it are left out of the median
+   *  @param[in] npixmin - minimal number of pixels for a group to be corrected
+   *  @param[in] bankcols - width of banks in columns; rows are corrected in segments of it if non-zero
+   */
+  void set_common_mode(const unsigned cmflags, const float cormax=100, const size_t npixmin=10, const size_t bankcols=0);
+
+  /// Loads pedestals, gain, offset, status and common mode parameters for the current shape from CalibPars
+  /**
+   *  Common mode parameters are (alg, mode, cormax, npixmin), applied if alg is 7, with CMODE bits in mode.
+   *  Returns false if pedestals are missing or of the wrong size.
+   */
+  bool load(calib::CalibPars& cp, calib::Query& q);
+
+  /// Calibrates size() raw values panel by panel into out
+  void calibrate(const raw_t* raw, calib_t* out, const int nthreads=1) const;
+
+  bool     ready()   const {return m_ready;}
+  GAINMODE mode()    const {return m_mode;}
+  size_t   nstates() const {return m_nstates;}      ///< number of planes of SoA constants
+  size_t   nranges() const;                          ///< number of planes of constants as stored
+  size_t   npanels() const {return m_npanels;}
+  size_t   nrows()   const {return m_nrows;}
+  size_t   ncols()   const {return m_ncols;}
+  size_t   size()    const {return m_npanels * m_nrows * m_ncols;}
+
+  /// Name of the kernel in use: "avx2" or "scalar"
+  const char* kernel() const;
+
+private:
+
+  void _common_mode(const raw_t* raw, calib_t* out, size_t begin, float* work) const;
+  void _correct(const raw_t* raw, calib_t* out, size_t begin, size_t n, size_t stride, float* work) const;
+
+  GAINMODE m_mode;
+  size_t   m_npanels;
+  size_t   m_nrows;
+  size_t   m_ncols;
+  size_t   m_nstates;
+  bool     m_ready;
+
+  unsigned m_cmflags;
+  float    m_cormax;
+  size_t   m_npixmin;
+  size_t   m_bankcols;
+
+  std::vector<float>    m_peds;      // as set, EPIX10KA only, to rebuild the planes
+                                     // on set_switch_ranges()
+  std::vector<float>    m_gains;
+  std::vector<float>    m_offsets;
+  std::vector<uint16_t> m_status;
+  std::vector<uint16_t> m_mask;
+  std::vector<uint8_t>  m_rclear;    // EPIX10KA only
+  std::vector<uint8_t>  m_rset;
+
+  std::vector<float>    m_ped;       // nstates() planes of pedestal + offset
+  std::vector<float>    m_gfac;      // nstates() planes of 1/gain, 0 for bad pixels
+};
+
+} // namespace detector
+
+#endif // PSALG_PIXELCALIB_H
+//-------------------
@@ -1,6 +1,7 @@
 
 #include <stdio.h>  // for  sprintf, printf( "%lf\n", accum );
 #include <iostream> // for cout, puts etc.
+#include <algorithm> // std::fill
 
 #include "psalg/detector/AreaDetector.hh"
 #include "psalg/utils/Logger.hh" // for MSG
@@ -383,7 +384,34 @@ const NDArray<pixel_mask_t>& AreaDetector::mask(const event_t& evt, const bool&
 //-------------------
 
 void AreaDetector::load_calib_constants() {
-  _default_msg("load_calib_constants");
+  _pixel_calib.set_geometry(gain_mode(), (numberOfModules > 0) ? numberOfModules : 1, numberOfRows, numberOfColumns);
+  if(! _pixel_calib.load(*calib_pars(), query()))
+    MSG(WARNING, "AreaDetector::load_calib_constants - calibration constants are not available for " << detname());
+}
+
+const NDArray<calib_t>& AreaDetector::calib(XtcData::DescData& ddata, const int nthreads) {
+  raw_t* pdata = 0;
+  raw<raw_t>(ddata, pdata);
+  if(! _calib.ndim()) { // first call: constants are looked up once, not on every event
+    if(! _pixel_calib.ready()) load_calib_constants();
+    _calib.reserve_data_buffer(size());
+    _calib.set_shape(shape(), ndim());
+  }
+  // The frame shape is fixed by the detector class; don't read past data of another shape
+  XtcData::Array<raw_t> frame = ddata.get_array<raw_t>(_ind_data);
+  if(frame.num_elem() != _pixel_calib.size()) {
+    MSG(ERROR, "AreaDetector::calib - raw data of " << frame.num_elem() << " pixels doesn't match the "
+               << _pixel_calib.size() << " pixels of the calibration of " << detname());
+    std::fill(_calib.data(), _calib.data() + _calib.size(), calib_t(0));
+    return _calib;
+  }
+  _pixel_calib.calibrate(pdata, _calib.data(), nthreads);
+  return _calib;
+}
+
+const NDArray<calib_t>& AreaDetector::calib(XtcData::DataIter& di, const int nthreads) {
+  DescData& ddata = di.desc_value(_pconfit->namesLookup());
+  return calib(ddata, nthreads);
 }
 
 /// access to raw, calibrated data, and image
@@ -11,6 +11,12 @@ namespace detector {
 
 AreaDetectorEpix100a::AreaDetectorEpix100a(const std::string& detname) : AreaDetector(detname) {
   MSG(DEBUG, "In c-tor AreaDetectorEpix100a for " << detname);
+  maxModulesPerDetector = 1;
+  numberOfModules = 1;
+  numberOfRows    = 704;
+  numberOfColumns = 768;
+  numberOfPixels  = numberOfRows * numberOfColumns;
+  _pixel_calib.set_common_mode(PixelCalib::CM_NONE, 100, 10, 96); // 352x96 pixel banks
 }
 
 AreaDetectorEpix100a::~AreaDetectorEpix100a() {
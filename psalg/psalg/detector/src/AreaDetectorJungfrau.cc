@@ -17,12 +17,14 @@ namespace detector {
 AreaDetectorJungfrau::AreaDetectorJungfrau(const std::string& detname, XtcData::ConfigIter& configo)
   : AreaDetector(detname, configo) {
   MSG(DEBUG, "In c-tor AreaDetectorJungfrau(detname, configo) for " << detname);
+  _pixel_calib.set_common_mode(PixelCalib::CM_NONE, 100, 10, 256);
   process_config();
 }
 
 AreaDetectorJungfrau::AreaDetectorJungfrau(const std::string& detname)
   : AreaDetector(detname) {
   MSG(DEBUG, "In c-tor AreaDetectorJungfrau(detname) for " << detname);
+  _pixel_calib.set_common_mode(PixelCalib::CM_NONE, 100, 10, 256);
 }
 
 AreaDetectorJungfrau::~AreaDetectorJungfrau() {
@@ -0,0 +1,433 @@
+//-------------------
+
+#include "psalg/detector/PixelCalib.hh"
+
+#include <algorithm> // nth_element, fill, min, max
+#include <cmath>     // fabs
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PIXELCALIB_X86
+#endif
+
+#include "psalg/utils/Logger.hh" // MSG, LOGGER
+
+//-------------------
+
+namespace detector {
+
+namespace {
+
+  const raw_t M14 = 0x3fff; // data bits of gain switching detectors
+  const raw_t B14 = 0x4000; // epix10ka switched gain bit
+
+  /// Kernels calibrate pixels [begin, end) of the SoA planes: FUSED does it all,
+  /// PEDS only subtracts pedestals and GAIN applies the gain factors to its output
+  enum OP {FUSED, PEDS, GAIN};
+
+  struct Planes {
+    const float* ped[3];
+    const float* gfac[3];
+  };
+
+  typedef void (*kernel_t)(const raw_t*, calib_t*, const Planes&, size_t, size_t);
+
+  struct Kernels {
+    kernel_t fused;
+    kernel_t peds;
+    kernel_t gain;
+  };
+
+  /// Gain state of a raw value, -1 for the jungfrau gain bits 2, which is invalid
+  template<int MODE>
+  inline int state_of(const raw_t r) {
+    if (MODE == PixelCalib::EPIX10KA) return (r & B14) ? 1 : 0;
+    if (MODE == PixelCalib::JUNGFRAU) {
+      const int g = r >> 14;
+      return g == 3 ? 2 : (g == 2 ? -1 : g);
+    }
+    return 0;
+  }
+
+  template<int MODE>
+  inline float adc_of(const raw_t r) {
+    return MODE == PixelCalib::SINGLE ? float(r) : float(r & M14);
+  }
+
+  template<int MODE, int OPER>
+  void kernel_scalar(const raw_t* raw, calib_t* out, const Planes& p, size_t begin, size_t end) {
+    for (size_t i=begin; i<end; ++i) {
+      const int s = state_of<MODE>(raw[i]);
+      if (s < 0)              out[i] = 0;
+      else if (OPER == FUSED) out[i] = (adc_of<MODE>(raw[i]) - p.ped[s][i]) * p.gfac[s][i];
+      else if (OPER == PEDS)  out[i] =  adc_of<MODE>(raw[i]) - p.ped[s][i];
+      else                    out[i] *= p.gfac[s][i];
+    }
+  }
+
+#ifdef PIXELCALIB_X86
+  /// Constants of the gain state of each of 8 pixels are picked with blends, and the
+  /// invalid jungfrau state is given zeros
+  template<int MODE, int OPER>
+  __attribute__((target("avx2")))
+  void kernel_avx2(const raw_t* raw, calib_t* out, const Planes& p, size_t begin, size_t end) {
+    const __m256i m14 = _mm256_set1_epi32(M14);
+    const __m256i b14 = _mm256_set1_epi32(B14);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256i thr = _mm256_set1_epi32(3);
+    size_t i = begin;
+    for (; i+8<=end; i+=8) {
+      const __m256i r = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(raw+i)));
+      __m256 ped  = _mm256_setzero_ps();
+      __m256 gfac = _mm256_setzero_ps();
+      __m256 bad  = _mm256_setzero_ps();
+      if (MODE == PixelCalib::SINGLE) {
+        if (OPER != GAIN) ped  = _mm256_loadu_ps(p.ped[0]+i);
+        if (OPER != PEDS) gfac = _mm256_loadu_ps(p.gfac[0]+i);
+      }
+      else if (MODE == PixelCalib::EPIX10KA) {
+        const __m256 s1 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(r, b14), b14));
+        if (OPER != GAIN) ped  = _mm256_blendv_ps(_mm256_loadu_ps(p.ped [0]+i), _mm256_loadu_ps(p.ped [1]+i), s1);
+        if (OPER != PEDS) gfac = _mm256_blendv_ps(_mm256_loadu_ps(p.gfac[0]+i), _mm256_loadu_ps(p.gfac[1]+i), s1);
+      }
+      else {
+        const __m256i g  = _mm256_srli_epi32(r, 14);
+        const __m256  s1 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(g, one));
+        const __m256  s2 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(g, thr));
+        bad = _mm256_castsi256_ps(_mm256_cmpeq_epi32(g, two));
+        if (OPER != GAIN) {
+          ped = _mm256_blendv_ps(_mm256_loadu_ps(p.ped[0]+i), _mm256_loadu_ps(p.ped[1]+i), s1);
+          ped = _mm256_blendv_ps(ped, _mm256_loadu_ps(p.ped[2]+i), s2);
+        }
+        if (OPER != PEDS) {
+          gfac = _mm256_blendv_ps(_mm256_loadu_ps(p.gfac[0]+i), _mm256_loadu_ps(p.gfac[1]+i), s1);
+          gfac = _mm256_blendv_ps(gfac, _mm256_loadu_ps(p.gfac[2]+i), s2);
+        }
+      }
+      __m256 v;
+      if (OPER == GAIN) {
+        v = _mm256_mul_ps(_mm256_loadu_ps(out+i), gfac);
+      }
+      else {
+        const __m256 adc = _mm256_cvtepi32_ps(MODE == PixelCalib::SINGLE ? r : _mm256_and_si256(r, m14));
+        v = _mm256_sub_ps(adc, ped);
+        if (OPER == FUSED) v = _mm256_mul_ps(v, gfac);
+      }
+      if (MODE == PixelCalib::JUNGFRAU) v = _mm256_andnot_ps(bad, v);
+      _mm256_storeu_ps(out+i, v);
+    }
+    kernel_scalar<MODE, OPER>(raw, out, p, i, end);
+  }
+#endif
+
+  bool cpu_has_avx2() {
+#ifdef PIXELCALIB_X86
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+  }
+
+  template<int MODE>
+  Kernels kernels_for() {
+#ifdef PIXELCALIB_X86
+    static const bool avx2 = cpu_has_avx2();
+    if (avx2) {
+      Kernels k = {kernel_avx2<MODE, FUSED>, kernel_avx2<MODE, PEDS>, kernel_avx2<MODE, GAIN>};
+      return k;
+    }
+#endif
+    Kernels k = {kernel_scalar<MODE, FUSED>, kernel_scalar<MODE, PEDS>, kernel_scalar<MODE, GAIN>};
+    return k;
+  }
+
+  Kernels kernels_for(const PixelCalib::GAINMODE mode) {
+    switch (mode) {
+      case PixelCalib::EPIX10KA: return kernels_for<PixelCalib::EPIX10KA>();
+      case PixelCalib::JUNGFRAU: return kernels_for<PixelCalib::JUNGFRAU>();
+      default:                   return kernels_for<PixelCalib::SINGLE>();
+    }
+  }
+
+  /// Good pixel in the highest gain state, the only ones common mode is computed from and applied to
+  inline bool is_state0(const PixelCalib::GAINMODE mode, const raw_t r) {
+    return mode == PixelCalib::SINGLE || (r & (mode == PixelCalib::JUNGFRAU ? 0xc000 : B14)) == 0;
+  }
+
+} // namespace
+
+//-------------------
+
+PixelCalib::PixelCalib(const GAINMODE mode, const size_t npanels, const size_t nrows, const size_t ncols)
+  : m_ready(false)
+  , m_cmflags(CM_NONE)
+  , m_cormax(100)
+  , m_npixmin(10)
+  , m_bankcols(0)
+{
+  set_geometry(mode, npanels, nrows, ncols);
+}
+
+//-------------------
+
+void PixelCalib::set_geometry(const GAINMODE mode, const size_t npanels, const size_t nrows, const size_t ncols) {
+  m_mode    = mode;
+  m_npanels = npanels;
+  m_nrows   = nrows;
+  m_ncols   = ncols;
+  m_nstates = (mode == JUNGFRAU) ? 3 : (mode == EPIX10KA) ? 2 : 1;
+  m_ready   = false;
+  m_ped.clear();
+  m_gfac.clear();
+  m_peds.clear();
+  m_gains.clear();
+  m_offsets.clear();
+  m_status.clear();
+  m_mask.clear();
+  m_rclear.assign(mode == EPIX10KA ? size() : 0, AHL_H);
+  m_rset  .assign(mode == EPIX10KA ? size() : 0, AHL_L);
+}
+
+//-------------------
+
+size_t PixelCalib::nranges() const {
+  return (m_mode == EPIX10KA) ? (size_t)EPIX10KA_NRANGES : m_nstates;
+}
+
+//-------------------
+
+const char* PixelCalib::kernel() const {
+#ifdef PIXELCALIB_X86
+  if (cpu_has_avx2()) return "avx2";
+#endif
+  return "scalar";
+}
+
+//-------------------
+
+void PixelCalib::set_common_mode(const unsigned cmflags, const float cormax, const size_t npixmin, const size_t bankcols) {
+  m_cmflags  = cmflags & (CM_ROWS | CM_COLS | CM_BANKS);
+  m_cormax   = cormax;
+  m_npixmin  = std::max(npixmin, (size_t)1);
+  m_bankcols = bankcols;
+  if ((m_cmflags & CM_BANKS) && !m_bankcols) {
+    MSG(WARNING, "PixelCalib: common mode in banks needs the bank width, ignored");
+    m_cmflags &= ~CM_BANKS;
+  }
+}
+
+//-------------------
+
+void PixelCalib::set_constants(const float* peds, const float* gains, const float* offsets,
+                               const uint16_t* status, const uint16_t* mask) {
+  const size_t npix = size();
+  const size_t nr   = nranges();
+  if (!peds || !npix) {
+    MSG(WARNING, "PixelCalib: no pedestals or no pixels, calibration disabled");
+    m_ready = false;
+    return;
+  }
+
+  // epix10ka constants are kept to rebuild the planes when the ranges in use change
+  if (m_mode == EPIX10KA && peds != m_peds.data()) {
+    m_peds.assign(peds, peds + nr*npix);
+    if (gains)   m_gains  .assign(gains,   gains   + nr*npix); else m_gains  .clear();
+    if (offsets) m_offsets.assign(offsets, offsets + nr*npix); else m_offsets.clear();
+    if (status)  m_status .assign(status,  status  + nr*npix); else m_status .clear();
+    if (mask)    m_mask   .assign(mask,    mask    + npix);    else m_mask   .clear();
+  }
+
+  m_ped .resize(m_nstates * npix);
+  m_gfac.resize(m_nstates * npix);
+  for (size_t s=0; s<m_nstates; ++s) {
+    for (size_t i=0; i<npix; ++i) {
+      const size_t r = (m_mode == EPIX10KA) ? (s ? m_rset[i] : m_rclear[i]) : s;
+      const size_t k = r*npix + i;
+      const float  g = gains ? gains[k] : 1;
+      const bool good = (!status || status[k] == 0) && (!mask || mask[i] != 0) && g != 0;
+      m_ped [s*npix + i] = peds[k] + (offsets ? offsets[k] : 0);
+      m_gfac[s*npix + i] = good ? 1/g : 0;
+    }
+  }
+  m_ready = true;
+}
+
+//-------------------
+
+void PixelCalib::set_switch_ranges(const uint8_t* rclear, const uint8_t* rset) {
+  if (m_mode != EPIX10KA) {
+    MSG(WARNING, "PixelCalib: switch ranges apply to EPIX10KA mode only, ignored");
+    return;
+  }
+  const size_t npix = size();
+  for (size_t i=0; i<npix; ++i) {
+    m_rclear[i] = std::min(rclear[i], (uint8_t)(EPIX10KA_NRANGES-1));
+    m_rset  [i] = std::min(rset  [i], (uint8_t)(EPIX10KA_NRANGES-1));
+  }
+  if (m_peds.empty()) return;
+  set_constants(m_peds.data(),
+                m_gains  .empty() ? 0 : m_gains  .data(),
+                m_offsets.empty() ? 0 : m_offsets.data(),
+                m_status .empty() ? 0 : m_status .data(),
+                m_mask   .empty() ? 0 : m_mask   .data());
+}
+
+//-------------------
+
+bool PixelCalib::load(calib::CalibPars& cp, calib::Query& q) {
+  const size_t npix = size();
+  const size_t nr   = nranges();
+
+  // the calibration type is a query parameter, and the db returns the same array for
+  // all types of the same element type: copy each before fetching the next
+  calib::Query::map_t& qmap = q.qmap();
+  const std::string ctype = qmap[calib::Query::CALIBTYPE];
+
+  q.set_calibtype(calib::PEDESTALS);
+  const NDArray<pedestals_t>& peds = cp.pedestals(q);
+  if (!peds.ndim() || peds.size() != nr*npix) {
+    MSG(WARNING, "PixelCalib: pedestals of size " << (peds.ndim() ? peds.size() : 0)
+                  << " where " << nr << "x" << npix << " are needed, calibration disabled");
+    qmap[calib::Query::CALIBTYPE] = ctype;
+    m_ready = false;
+    return false;
+  }
+  std::vector<float> vpeds(peds.const_data(), peds.const_data() + nr*npix);
+
+  std::vector<float> vgain;
+  q.set_calibtype(calib::PIXEL_GAIN);
+  const NDArray<pixel_gain_t>& gain = cp.gain(q);
+  if (gain.ndim() && gain.size() == nr*npix) vgain.assign(gain.const_data(), gain.const_data() + nr*npix);
+  else if (gain.ndim()) MSG(WARNING, "PixelCalib: gain of wrong size, ignored");
+
+  std::vector<float> voffset;
+  q.set_calibtype(calib::PIXEL_OFFSET);
+  const NDArray<pixel_offset_t>& offset = cp.offset(q);
+  if (offset.ndim() && offset.size() == nr*npix) voffset.assign(offset.const_data(), offset.const_data() + nr*npix);
+  else if (offset.ndim()) MSG(WARNING, "PixelCalib: offset of wrong size, ignored");
+
+  // status may also come as one plane for all gain ranges
+  std::vector<pixel_status_t> vstatus;
+  q.set_calibtype(calib::PIXEL_STATUS);
+  const NDArray<pixel_status_t>& status = cp.status(q);
+  if (status.ndim() && status.size() == nr*npix) {
+    vstatus.assign(status.const_data(), status.const_data() + nr*npix);
+  }
+  else if (status.ndim() && status.size() == npix) {
+    for (size_t r=0; r<nr; ++r) vstatus.insert(vstatus.end(), status.const_data(), status.const_data() + npix);
+  }
+  else if (status.ndim()) {
+    MSG(WARNING, "PixelCalib: status of wrong size, ignored");
+  }
+
+  q.set_calibtype(calib::COMMON_MODE);
+  const NDArray<common_mode_t>& cmpars = cp.common_mode(q);
+  if (cmpars.ndim() && cmpars.size() >= 2) {
+    const common_mode_t* cm = cmpars.const_data();
+    if (cm[0] == 7) set_common_mode((unsigned)cm[1],
+                                    cmpars.size() > 2 ? (float)cm[2] : m_cormax,
+                                    cmpars.size() > 3 ? (size_t)cm[3] : m_npixmin,
+                                    m_bankcols);
+    else            set_common_mode(CM_NONE, m_cormax, m_npixmin, m_bankcols);
+  }
+  qmap[calib::Query::CALIBTYPE] = ctype;
+
+  set_constants(vpeds.data(),
+                vgain  .empty() ? 0 : vgain  .data(),
+                voffset.empty() ? 0 : voffset.data(),
+                vstatus.empty() ? 0 : vstatus.data());
+  return m_ready;
+}
+
+//-------------------
+
+void PixelCalib::_correct(const raw_t* raw, calib_t* out, size_t begin, size_t nr, size_t nc, float* work) const {
+  const float* gfac0 = m_gfac.data();
+  size_t n = 0;
+  for (size_t r=0; r<nr; ++r) {
+    const size_t row = begin + r*m_ncols;
+    for (size_t i=row; i<row+nc; ++i) {
+      if (gfac0[i] != 0 && is_state0(m_mode, raw[i]) && std::fabs(out[i]) < m_cormax) work[n++] = out[i];
+    }
+  }
+  if (n < m_npixmin) return;
+
+  std::nth_element(work, work + n/2, work + n);
+  const float cm = work[n/2];
+  for (size_t r=0; r<nr; ++r) {
+    const size_t row = begin + r*m_ncols;
+    for (size_t i=row; i<row+nc; ++i) {
+      if (is_state0(m_mode, raw[i])) out[i] -= cm;
+    }
+  }
+}
+
+//-------------------
+
+void PixelCalib::_common_mode(const raw_t* raw, calib_t* out, size_t begin, float* work) const {
+  const size_t bank = m_bankcols ? std::min(m_bankcols, m_ncols) : m_ncols;
+  if (m_cmflags & CM_BANKS) {
+    for (size_t c=0; c<m_ncols; c+=bank) _correct(raw, out, begin + c, m_nrows, std::min(bank, m_ncols-c), work);
+  }
+  if (m_cmflags & CM_ROWS) {
+    for (size_t r=0; r<m_nrows; ++r)
+      for (size_t c=0; c<m_ncols; c+=bank) _correct(raw, out, begin + r*m_ncols + c, 1, std::min(bank, m_ncols-c), work);
+  }
+  if (m_cmflags & CM_COLS) {
+    for (size_t c=0; c<m_ncols; ++c) _correct(raw, out, begin + c, m_nrows, 1, work);
+  }
+}
+
+//-------------------
+
+void PixelCalib::calibrate(const raw_t* raw, calib_t* out, const int nthreads) const {
+  const size_t npix = size();
+  if (!m_ready) {
+    MSG(DEBUG, "PixelCalib: constants are not set, output zeroed");
+    std::fill(out, out + npix, 0);
+    return;
+  }
+
+  const Kernels k = kernels_for(m_mode);
+  Planes p;
+  for (size_t s=0; s<3; ++s) {
+    const size_t ss = std::min(s, m_nstates-1);
+    p.ped [s] = m_ped .data() + ss*npix;
+    p.gfac[s] = m_gfac.data() + ss*npix;
+  }
+
+  // without common mode panels don't matter: split into equal chunks
+  if (!m_cmflags) {
+    const size_t chunk = 1 << 16;
+    const long nchunks = (npix + chunk - 1) / chunk;
+    #pragma omp parallel for schedule(static) num_threads(nthreads) if(nthreads > 1)
+    for (long c=0; c<nchunks; ++c) {
+      const size_t begin = c*chunk;
+      k.fused(raw, out, p, begin, std::min(begin + chunk, npix));
+    }
+    return;
+  }
+
+  const size_t ppix  = m_nrows * m_ncols;
+  const size_t bank  = m_bankcols ? std::min(m_bankcols, m_ncols) : m_ncols;
+  const size_t wsize = std::max(m_ncols, (m_cmflags & CM_BANKS) ? m_nrows*bank : m_nrows);
+  #pragma omp parallel num_threads(nthreads) if(nthreads > 1)
+  {
+    std::vector<float> work(wsize);
+    #pragma omp for schedule(static)
+    for (long ip=0; ip<(long)m_npanels; ++ip) {
+      const size_t begin = ip*ppix;
+      k.peds(raw, out, p, begin, begin + ppix);
+      _common_mode(raw, out, begin, work.data());
+      k.gain(raw, out, p, begin, begin + ppix);
+    }
+  }
+}
+
+//-------------------
+
+} // namespace detector
+
+//-------------------
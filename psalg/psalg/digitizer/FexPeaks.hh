@@ -0,0 +1,152 @@
+#ifndef HSD_FEXPEAKS_HH
+#define HSD_FEXPEAKS_HH
+
+/*
+ * Batch decoding of the sparsified (fex) stream of a channel.
+ *
+ * The fex payload is a sequence of groups of four uint16_t samples.
+ * A group whose first sample has bit 15 set is a "skip" group: the low
+ * 15 bits of its four samples add up to the number of raw samples that
+ * were suppressed.  Any other group holds four samples of a peak, and a
+ * peak continues until the next skip group.  The start of a peak in the
+ * raw waveform is the number of skipped samples plus the width of all
+ * the previous peaks.
+ *
+ * Rather than testing one sample at a time, the skip flags of 64 groups
+ * are gathered into a bitmask (with SSE2/AVX2 when the compiler targets
+ * them), from which the groups where peaks begin and end are found by
+ * counting trailing zeros.  Header only, so that psana's hsd extension
+ * can use it without linking the digitizer library.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace Pds {
+  namespace HSD {
+
+    // Bit k is set if group k of the ngroups (<= 64) groups starting at q
+    // is a skip group.  Only whole groups within nwords are loaded as vectors.
+    inline uint64_t fex_skip_mask(const uint16_t* q, unsigned ngroups, unsigned nwords)
+    {
+        uint64_t m = 0;
+        unsigned k = 0;
+#if defined(__AVX2__)
+        for(; k+4<=ngroups && 4*(k+4)<=nwords; k+=4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q+4*k));
+            m |= uint64_t(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_slli_epi64(v,48)))) << k;
+        }
+#elif defined(__SSE2__)
+        for(; k+2<=ngroups && 4*(k+2)<=nwords; k+=2) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q+4*k));
+            m |= uint64_t(_mm_movemask_pd(_mm_castsi128_pd(_mm_slli_epi64(v,48)))) << k;
+        }
+#endif
+        for(; k<ngroups; k++)
+            m |= uint64_t(q[4*k]>>15) << k;
+        return m;
+    }
+
+    // Sum of the low 15 bits of the samples of a skip group
+    inline unsigned fex_skip_count(const uint16_t* q, unsigned nwords)
+    {
+        if (nwords < 4) {
+            unsigned ns = 0;
+            for(unsigned j=0; j<nwords; j++)
+                ns += q[j]&0x7fff;
+            return ns;
+        }
+        uint64_t x;
+        memcpy(&x, q, sizeof(x));
+        x &= 0x7fff7fff7fff7fffULL;
+        x = (x & 0x0000ffff0000ffffULL) + ((x>>16) & 0x0000ffff0000ffffULL);
+        return unsigned((x + (x>>32)) & 0xffffffff);
+    }
+
+    // Adds up the skip groups of q selected by the bits of m
+    inline unsigned fex_skip_sum(const uint16_t* q, unsigned nwords, uint64_t m)
+    {
+        unsigned ns = 0;
+        while(m) {
+            unsigned j = __builtin_ctzll(m);
+            ns += fex_skip_count(q+4*j, nwords-4*j);
+            m &= m-1;
+        }
+        return ns;
+    }
+
+    // Decodes the nsamples fex samples at q, calling
+    //   sink(start, length, offset)
+    // for each peak: its start in the raw waveform, its length in samples,
+    // and the index of its first sample in q.  Returns the number of peaks.
+    // This is the loop of Channel::_parse_peaks and ChannelPython::next_peak,
+    // visiting only the groups where a peak begins or ends, and the skips.
+    template <class Sink>
+    unsigned parse_fex_peaks(const uint16_t* q, unsigned nsamples, Sink&& sink)
+    {
+        unsigned npeaks   = 0;
+        unsigned ns       = 0;  // number of skipped samples
+        unsigned totWidth = 0;  // width of the completed peaks
+        unsigned start    = 0;
+        unsigned width    = 0;
+        unsigned first    = 0;
+        bool     in       = false;
+
+        const unsigned ngroups = (nsamples+3)/4;
+        for(unsigned g0=0; g0<ngroups; g0+=64) {
+            const unsigned  n     = ngroups-g0 < 64 ? ngroups-g0 : 64;
+            const uint16_t* qg    = q+4*g0;
+            const unsigned  nw    = nsamples-4*g0;
+            const uint64_t  valid = n<64 ? (uint64_t(1)<<n)-1 : ~uint64_t(0);
+            const uint64_t  skip  = fex_skip_mask(qg, n, nw);
+            // groups which follow a skip (or no peak)
+            const uint64_t  after = (skip<<1) | (in ? 0 : 1);
+            const uint64_t  begin = ~skip &  after & valid;
+            const uint64_t  end   =  skip & ~after & valid;
+            uint64_t edges = begin | end;
+            unsigned from  = 0;  // first group of the open peak in this chunk
+            unsigned done  = 0;  // skips before this group are counted
+            while(edges) {
+                unsigned k = __builtin_ctzll(edges);
+                edges &= edges-1;
+                if ((begin>>k)&1) {
+                    ns += fex_skip_sum(qg, nw, skip & ((uint64_t(1)<<k)-1) & ~((uint64_t(1)<<done)-1));
+                    done  = k;
+                    start = ns+totWidth;
+                    first = g0+k;
+                    from  = k;
+                    width = 0;
+                    in    = true;
+                }
+                else {
+                    width += 4*(k-from);
+                    sink(start, width, 4*first);
+                    npeaks++;
+                    totWidth += width;
+                    in = false;
+                }
+            }
+            if (in)
+                width += 4*(n-from);
+            ns += fex_skip_sum(qg, nw, skip & valid & ~((uint64_t(1)<<done)-1));
+        }
+        if (in) {
+            sink(start, width, 4*first);
+            npeaks++;
+        }
+        return npeaks;
+    }
+
+    // Upper limit on the number of peaks in nsamples fex samples
+    inline unsigned max_fex_peaks(unsigned nsamples)
+    {
+        return ((nsamples+3)/4+1)/2;
+    }
+  } // HSD
+} // Pds
+
+#endif
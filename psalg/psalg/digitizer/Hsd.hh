@@ -18,10 +18,10 @@
  * Channel::_parse_peaks.  There is (at least) one complex idea:
  * The unpacked arrays are variable-length and we wanted to avoid calling
  * malloc on every event in the drp (OK to do that for psana) so
- * we should try to use the simple Stack obj in psalg/alloc/Allocator.hh
- * in the drp.  the python uses a similar Heap obj which calls malloc.
- * In the drp each core should have its own Stack to avoid reentrancy
- * problems.
+ * we should try to use the Arena obj in psalg/alloc/Allocator.hh
+ * in the drp, reset for every event.  the python uses a similar Heap obj
+ * which calls malloc.  In the drp each core should have its own Arena to
+ * avoid reentrancy problems.
  *
  * The "event header" is formed from the two uint32_t _opaque fields of the
  * TimingHeader and contains information about whether the event contains
@@ -57,6 +57,7 @@
 
 #include "xtcdata/xtc/Dgram.hh"
 #include "Stream.hh"
+#include "FexPeaks.hh"
 #include "psalg/alloc/Allocator.hh"
 #include "psalg/alloc/AllocArray.hh"
 
@@ -96,40 +97,13 @@ namespace Pds {
         }
 
         void _parse_peaks(const StreamHeader& s) {
-            const Pds::HSD::StreamHeader& sh_fex = *reinterpret_cast<const Pds::HSD::StreamHeader*>(&s);
-            const uint16_t* q = reinterpret_cast<const uint16_t*>(&sh_fex+1);
-
-            unsigned ns=0;
-            bool in = false;
-            unsigned width = 0;
-            unsigned totWidth = 0;
-            for(unsigned i=0; i<s.num_samples();) {
-                if (q[i]&0x8000) {
-                    for (unsigned j=0; j<4; j++, i++) {
-                        ns += (q[i]&0x7fff);
-                    }
-                    totWidth += width;
-                    if (in) {
-                        len.push_back(width);
-                        numFexPeaks++;
-                    }
-                    width = 0;
-                    in = false;
-                } else {
-                    if (!in) {
-                        sPos.push_back(ns+totWidth);
-                        fexPtr.push_back((uint16_t *) (q+i));
-                    }
-                    for (unsigned j=0; j<4; j++, i++) {
-                        width++;
-                    }
-                    in = true;
-                }
-            }
-            if (in) {
-                len.push_back(width);
-                numFexPeaks++;
-            }
+            const uint16_t* q = reinterpret_cast<const uint16_t*>(&s+1);
+            numFexPeaks += parse_fex_peaks(q, s.num_samples(),
+                                           [&](unsigned start, unsigned width, unsigned offset) {
+                                               sPos.push_back(start);
+                                               len.push_back(width);
+                                               fexPtr.push_back((uint16_t *) (q+offset));
+                                           });
         }
     };
   } // HSD
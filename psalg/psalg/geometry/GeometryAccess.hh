@@ -10,6 +10,7 @@
 #include <stdint.h>  // uint8_t, uint16_t, uint32_t, etc.
 
 #include "psalg/geometry/GeometryObject.hh"
+#include "psalg/geometry/ImageMapper.hh"
 
 #include "psalg/calib/NDArray.hh"
 
@@ -107,6 +108,10 @@ namespace geometry {
  *    // Make image from index, iX, iY, and intensity, W, arrays
  *        ndarray<geometry::GeometryAccess::image_t> img = 
  *                geometry::GeometryAccess::img_from_pixel_arrays(iX, iY, 0, isize);
+ *
+ *    // or, to assemble images of each event, make the ImageMapper once and reuse it
+ *        geometry::ImageMapper* mapper = geometry.image_mapper(pix_scale_size_um, xy0_off_pix);
+ *        mapper->assemble(data, img_buffer);
  *    
  *    // Access and print comments from the calibration "geometry" file:
  *        std::map<int, std::string>& dict = geometry.get_dict_of_comments ();
@@ -345,6 +350,16 @@ public:
                             const double* W = 0,
                             const gsize_t& size = 0);
 
+  /// Returns new ImageMapper for entire detector pixel indexes, to be deleted by the caller
+ /**
+   *  @param[in]  pix_scale_size_um - ex.: 109.92 (default - search for the first segment pixel size)
+   *  @param[in]  xy0_off_pix - array containing X and Y coordinates of the offset (default - use xmin, ymin)
+   *  @param[in]  mode - how to fill image bins fed by more than one pixel
+   */
+  ImageMapper* image_mapper(const pixel_coord_t& pix_scale_size_um = 0, 
+                            const int* xy0_off_pix = 0,
+                            const ImageMapper::MODE mode = ImageMapper::LAST);
+
   /// Loads calibration file
  /**
    *  @param[in] path - path to the file with calibration parameters of type "geometry"
@@ -0,0 +1,138 @@
+#ifndef PSALG_IMAGEMAPPER_H
+#define PSALG_IMAGEMAPPER_H
+
+//-------------------
+
+#include <vector>
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint32_t
+
+#include "psalg/geometry/GeometryTypes.hh"
+#include "psalg/calib/Types.hh" // shape_t
+
+//-------------------
+
+namespace geometry {
+
+/// @addtogroup geometry
+
+/**
+ *  @ingroup geometry
+ *
+ *  @brief Pixel-to-image scatter table for repeated image assembly.
+ *
+ *  GeometryAccess::img_from_pixel_arrays scans the index arrays for the image size
+ *  and scatters every pixel through iX, iY on each call. ImageMapper does this work once
+ *  per geometry: pixels are sorted by their image bin, consecutive pixels which land in
+ *  consecutive bins are merged into copy spans, and bins fed by several pixels are kept
+ *  as lists of contributing pixels. Each span also knows the run of empty bins in front of it,
+ *  so that assemble() writes the caller's image buffer strictly in order, once.
+ *  Spans write disjoint parts of the image, which lets assemble() split them between threads.
+ *
+ *  @note This software was developed for the LCLS project.
+ *  If you use all or part of it, please give an appropriate acknowledgment.
+ *
+ *  @anchor interface
+ *  @par<interface> Interface Description
+ *
+ *  @li  Include
+ *  @code
+ *  #include "psalg/geometry/ImageMapper.hh"
+ *  @endcode
+ *
+ *  @li Instatiation
+ *  @code
+ *    const pixel_idx_t* iX;
+ *    const pixel_idx_t* iY;
+ *    gsize_t isize;
+ *    geometry.get_pixel_coord_indexes(iX, iY, isize);
+ *    geometry::ImageMapper mapper(iX, iY, isize, geometry::ImageMapper::MEAN);
+ *    // or
+ *    geometry::ImageMapper* pmapper = geometry.image_mapper();
+ *  @endcode
+ *
+ *  @li Access methods
+ *  @code
+ *    std::vector<geometry::ImageMapper::image_t> img(mapper.image_size());
+ *    mapper.assemble(raw_data, img.data());      // raw_data - per-pixel array of isize values
+ *    mapper.assemble(raw_data, img.data(), 4);   // the same using 4 threads
+ *    psalg::NDArray<geometry::ImageMapper::image_t> nda(mapper.shape(), 2, img.data());
+ *  @endcode
+ */
+
+class ImageMapper {
+public:
+
+  typedef psalg::types::shape_t shape_t;
+  typedef double image_t; // the same as GeometryAccess::image_t
+
+  /// How to fill an image bin fed by more than one pixel
+  enum MODE {LAST=0, ///< value of the last such pixel, as img_from_pixel_arrays does
+             SUM,    ///< sum of the values
+             MEAN};  ///< average of the values
+
+  /**
+   *  @param[in] iX - pointer to x pixel index coordinate array (image row)
+   *  @param[in] iY - pointer to y pixel index coordinate array (image column)
+   *  @param[in] size - size of the pixel coordinate array (number of pixels)
+   *  @param[in] mode - how to fill image bins fed by more than one pixel
+   */
+  ImageMapper(const pixel_idx_t* iX,
+              const pixel_idx_t* iY,
+              const gsize_t& size,
+              const MODE mode=LAST);
+
+  ImageMapper(const ImageMapper&) = delete;
+  ImageMapper& operator = (const ImageMapper&) = delete;
+
+  ~ImageMapper(){}
+
+  /// Fills image buffer img of image_size() elements from per-pixel data array of size() elements
+  /**
+   *  @param[in]  data - pointer to the per-pixel intensity array, in the order of iX, iY
+   *  @param[out] img - pointer to the image buffer, row-major with shape()
+   *  @param[in]  nthreads - number of threads to use (if built with OpenMP)
+   */
+  template<typename T>
+  void assemble(const T* data, image_t* img, const int nthreads=1) const;
+
+  /// Returns number of pixels
+  gsize_t size() const {return m_size;}
+
+  /// Returns image shape {rows, cols}
+  const shape_t* shape() const {return m_shape;}
+
+  /// Returns number of bins in image
+  size_t image_size() const {return m_image_size;}
+
+  /// Returns number of spans, which are the units of work in assemble()
+  size_t nspans() const {return m_spans.size();}
+
+  MODE mode() const {return m_mode;}
+
+  void print() const;
+
+private:
+
+  /// Run of empty bins [zbeg, dst) followed by either a copy of len pixels
+  /// from src to dst, or, if nsrc>0, a single bin combining m_srcs[src:src+nsrc]
+  struct Span {
+    size_t   zbeg;
+    size_t   dst;
+    uint32_t src;
+    uint32_t len;
+    uint32_t nsrc;
+  };
+
+  MODE                  m_mode;
+  gsize_t               m_size;
+  shape_t               m_shape[2];
+  size_t                m_image_size;
+  size_t                m_zend;  // start of empty bins after the last span
+  std::vector<Span>     m_spans;
+  std::vector<uint32_t> m_srcs;
+};
+
+} // namespace geometry
+
+#endif // PSALG_IMAGEMAPPER_H
@@ -697,6 +697,20 @@ GeometryAccess::ref_img_from_pixel_arrays(const pixel_idx_t*& iX,
     return *p_image;
 }
 
+//-------------------
+
+ImageMapper*
+GeometryAccess::image_mapper(const pixel_coord_t& pix_scale_size_um,
+                             const int* xy0_off_pix,
+                             const ImageMapper::MODE mode)
+{
+  const pixel_idx_t* iX;
+  const pixel_idx_t* iY;
+  gsize_t size;
+  get_pixel_coord_indexes(iX, iY, size, std::string(), 0, pix_scale_size_um, xy0_off_pix, true);
+  return new ImageMapper(iX, iY, size, mode);
+}
+
 //-------------------
 //-------------------
 //-- Static Methods--
@@ -0,0 +1,127 @@
+//-------------------
+
+#include "psalg/geometry/ImageMapper.hh"
+
+#include <algorithm> // sort, fill
+#include <utility>   // pair
+
+#include "psalg/utils/Logger.hh" // MSG, LOGGER
+
+//-------------------
+
+namespace geometry {
+
+typedef ImageMapper::image_t image_t;
+
+//-------------------
+
+ImageMapper::ImageMapper(const pixel_idx_t* iX,
+                         const pixel_idx_t* iY,
+                         const gsize_t& size,
+                         const MODE mode)
+  : m_mode(mode)
+  , m_size(size)
+  , m_image_size(0)
+  , m_zend(0)
+{
+  m_shape[0] = 0;
+  m_shape[1] = 0;
+  if (!size) return;
+
+  pixel_idx_t ix_max=iX[0]; for(gsize_t i=0; i<size; ++i) {if (iX[i] > ix_max) ix_max = iX[i];} ix_max++;
+  pixel_idx_t iy_max=iY[0]; for(gsize_t i=0; i<size; ++i) {if (iY[i] > iy_max) iy_max = iY[i];} iy_max++;
+
+  m_shape[0] = ix_max;
+  m_shape[1] = iy_max;
+  m_image_size = size_t(ix_max) * iy_max;
+
+  // (image bin, pixel) sorted by bin; pixels of a bin stay in their original order
+  std::vector<std::pair<size_t, uint32_t> > order(size);
+  for(gsize_t i=0; i<size; ++i) order[i] = std::make_pair(size_t(iX[i]) * iy_max + iY[i], i);
+  std::sort(order.begin(), order.end());
+
+  size_t prev_end = 0;
+  for(gsize_t i=0; i<size;) {
+    const size_t dst = order[i].first;
+    gsize_t j = i+1;
+    while (j<size && order[j].first == dst) ++j;
+    const uint32_t n = j-i;
+
+    if (n == 1 || m_mode == LAST) {
+      const uint32_t src = order[j-1].second;
+      Span* last = m_spans.empty() ? 0 : &m_spans.back();
+      if (last && !last->nsrc && last->dst + last->len == dst && last->src + last->len == src) {
+        last->len++;
+      }
+      else {
+        Span s = {prev_end, dst, src, 1, 0};
+        m_spans.push_back(s);
+      }
+    }
+    else {
+      Span s = {prev_end, dst, uint32_t(m_srcs.size()), 1, n};
+      for(gsize_t k=i; k<j; ++k) m_srcs.push_back(order[k].second);
+      m_spans.push_back(s);
+    }
+    prev_end = dst+1;
+    i = j;
+  }
+  m_zend = prev_end;
+
+  MSG(DEBUG, "ImageMapper for " << size << " pixels, image " << m_shape[0] << 'x' << m_shape[1]
+             << ", " << m_spans.size() << " spans");
+}
+
+//-------------------
+
+template<typename T>
+void ImageMapper::assemble(const T* data, image_t* img, const int nthreads) const
+{
+  const Span*     spans = m_spans.data();
+  const uint32_t* srcs  = m_srcs.data();
+  const long      nspans = m_spans.size();
+  const bool      mean  = (m_mode == MEAN);
+
+  #pragma omp parallel for schedule(static) num_threads(nthreads) if(nthreads > 1)
+  for(long i=0; i<nspans; ++i) {
+    const Span& s = spans[i];
+    std::fill(img + s.zbeg, img + s.dst, image_t(0));
+    if (s.nsrc) {
+      image_t v = 0;
+      for(uint32_t k=0; k<s.nsrc; ++k) v += (image_t) data[srcs[s.src+k]];
+      img[s.dst] = mean ? v/s.nsrc : v;
+    }
+    else {
+      const T* d = data + s.src;
+      image_t* p = img + s.dst;
+      for(uint32_t k=0; k<s.len; ++k) p[k] = (image_t) d[k];
+    }
+  }
+  std::fill(img + m_zend, img + m_image_size, image_t(0));
+}
+
+//-------------------
+
+void ImageMapper::print() const
+{
+  MSG(INFO, "ImageMapper: mode=" << m_mode
+         << " pixels=" << m_size
+         << " image shape=(" << m_shape[0] << ',' << m_shape[1] << ')'
+         << " spans=" << m_spans.size()
+         << " pixels in shared bins=" << m_srcs.size());
+}
+
+//-------------------
+
+template void ImageMapper::assemble<double>  (const double*,   image_t*, const int) const;
+template void ImageMapper::assemble<float>   (const float*,    image_t*, const int) const;
+template void ImageMapper::assemble<int16_t> (const int16_t*,  image_t*, const int) const;
+template void ImageMapper::assemble<uint16_t>(const uint16_t*, image_t*, const int) const;
+template void ImageMapper::assemble<int32_t> (const int32_t*,  image_t*, const int) const;
+template void ImageMapper::assemble<uint32_t>(const uint32_t*, image_t*, const int) const;
+
+//-------------------
+
+} // namespace geometry
+
+//-------------------
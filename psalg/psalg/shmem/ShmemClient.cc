@@ -17,9 +17,12 @@
 #include "xtcdata/xtc/Dgram.hh"
 #include "ShmemClient.hh"
 #include "XtcMonitorMsg.hh"
+#include "XtcMonitorDir.hh"
+#include "XtcMonitorRing.hh"
 
 #include <poll.h>
 #include <time.h>
+#include <new>
 
 //#define DBUG
 //#define DBUG2
@@ -83,6 +86,7 @@ namespace psalg {
       unsigned                     _ev_index;
       const char*                  _tag;
       char*                        _shm;
+      XtcMonitorRings*             _rings;
       timespec                     _tmo;
 
     public:
@@ -97,10 +101,10 @@ namespace psalg {
 
       DgramHandler(ShmemClient& client, XtcMonitorMsg myMsg,
                    int trfd, mqd_t evqin, mqd_t* evqout, unsigned ev_index,
-                   const char* tag, char* myShm) :
+                   const char* tag, char* myShm, XtcMonitorRings* rings=0) :
         _client(client), _myMsg(myMsg),
         _trfd(trfd), _evqin(evqin), _evqout(evqout), _ev_index(ev_index),
-        _tag(tag), _shm(myShm)
+        _tag(tag), _shm(myShm), _rings(rings)
       {
         _tmo.tv_sec = _tmo.tv_nsec = 0;
       }
@@ -125,7 +129,12 @@ namespace psalg {
 #ifdef DBUG
               printf("ShmemClient DgramHandler free dgram index %d size %d\n",index,size);
 #endif
-              mq_timedsend(oq[ioq], (const char *)&myMsg, sizeof(myMsg), priority, &_tmo);
+              if (_rings) {
+                  _rings->channel(_ev_index).returns.push(index);
+                  _rings->bell().ring();
+              }
+              else
+                  mq_timedsend(oq[ioq], (const char *)&myMsg, sizeof(myMsg), priority, &_tmo);
           } else {
               if(::send(_trfd,(char*)&myMsg,sizeof(myMsg),MSG_NOSIGNAL)<0) {
                   // cpo: we can get an error if the server exits
@@ -181,6 +190,24 @@ namespace psalg {
       }
 
 
+      /*
+      ** ++
+      **
+      **
+      ** --
+      */
+
+      XtcData::Dgram* buffer(unsigned i, int &index, size_t &size) {
+        if (i < unsigned(_myMsg.numberOfBuffers())) {
+          index = i;
+          size = _myMsg.sizeOfBuffers();
+          return (XtcData::Dgram*) (_shm + (_myMsg.sizeOfBuffers() * (size_t)i));
+        }
+        fprintf(stderr, "ILLEGAL EV BUFFER INDEX %u numBuffers %d\n", i,_myMsg.numberOfBuffers());
+        return NULL;
+      }
+
+
       /*
       ** ++
       **
@@ -242,7 +269,14 @@ ShmemClient::ShmemClient() :
   _handler          (0),
   _numberOfEvQueues (0),
   _myInputEvQueue   ((mqd_t)-1),
-  _myOutputEvQueue  (nullptr)
+  _myOutputEvQueue  (nullptr),
+  _directory        (false),
+  _zeroCopy         (false),
+  _sizeOfBuffers    (0),
+  _rings            (nullptr),
+  _ringsSize        (0),
+  _ringIndex        (0),
+  _trSeen           (0)
 {
 }
 
@@ -266,6 +300,107 @@ void ShmemClient::_shutdown()
   if (_myOutputEvQueue)  { delete [] _myOutputEvQueue;  _myOutputEvQueue = nullptr; }
 
   if (!(_myTrFd < 0))    { ::close(_myTrFd);            _myTrFd = -1; }
+
+  if (_rings)            { munmap(_rings, _ringsSize);     _rings = nullptr; }
+
+  _unmapRegions();
+  for (auto buf : _assembled)  delete [] buf;
+  _assembled.clear();
+}
+
+void ShmemClient::_unmapRegions()
+{
+  for (unsigned i = 0; i < _regions.size(); ++i)
+  {
+    if (_regions[i])  munmap(_regions[i], _regionSizes[i]);
+  }
+  _regions.clear();
+  _regionSizes.clear();
+}
+
+/*
+** ++
+**
+**   Locate a contribution listed in a directory, mapping the region
+**   holding it the first time it is referred to.
+**
+** --
+*/
+
+const XtcData::Xtc* ShmemClient::contribution(const XtcMonitorDirEntry& entry)
+{
+  if (entry.region >= _regions.size()) {
+    _regions.resize(entry.region+1, nullptr);
+    _regionSizes.resize(entry.region+1, 0);
+  }
+  if (!_regions[entry.region]) {
+    char name[128];
+    XtcMonitorMsg::regionMemoryName(_tag.c_str(), entry.region, name);
+    int shm = shm_open(name, OFLAGS, PERMS_IN);
+    if (shm < 0) {
+      perror("shm_open region");
+      return NULL;
+    }
+    struct stat st;
+    if (fstat(shm, &st) < 0) {
+      perror("fstat region");
+      close(shm);
+      return NULL;
+    }
+    char* p = (char*)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, shm, 0);
+    close(shm);
+    if (p == MAP_FAILED) {
+      perror("mmap region");
+      return NULL;
+    }
+#ifdef DBUG
+    printf("Mapped region %s of size 0x%zx at %p\n", name, (size_t)st.st_size, (void*)p);
+#endif
+    _regions[entry.region]     = p;
+    _regionSizes[entry.region] = st.st_size;
+  }
+  if (entry.offset + entry.extent > _regionSizes[entry.region]) {
+    fprintf(stderr, "ILLEGAL DIRECTORY ENTRY region %u offset 0x%lx extent 0x%x size 0x%zx\n",
+            entry.region, (unsigned long)entry.offset, entry.extent, _regionSizes[entry.region]);
+    return NULL;
+  }
+  return (const XtcData::Xtc*)(_regions[entry.region] + entry.offset);
+}
+
+/*
+** ++
+**
+**   Build the event described by a directory into this buffer index's
+**   private space, for clients that expect contiguous datagrams.
+**
+** --
+*/
+
+void* ShmemClient::_assemble(int index, const XtcData::Dgram* dir)
+{
+  if (size_t(index) >= _assembled.size())
+    _assembled.resize(index+1, nullptr);
+  if (!_assembled[index])
+    _assembled[index] = new char[_sizeOfBuffers];
+
+  char*       buf    = _assembled[index];
+  const void* bufEnd = buf + _sizeOfBuffers;
+  XtcData::Dgram* odg = new((void*)buf) XtcData::Dgram(*dir, XtcData::Xtc(dir->xtc.contains,
+                                                                          dir->xtc.src,
+                                                                          dir->xtc.damage));
+  const XtcMonitorDirEntry* entry = (const XtcMonitorDirEntry*)dir->xtc.payload();
+  const XtcMonitorDirEntry* last  = (const XtcMonitorDirEntry*)dir->xtc.next();
+  for (; entry < last; ++entry) {
+    const XtcData::Xtc* xtc = contribution(*entry);
+    if (!xtc)  return NULL;
+    if (sizeof(*odg) + odg->xtc.sizeofPayload() + entry->extent > _sizeOfBuffers) {
+      fprintf(stderr, "Buffer of size %zu is too small to add Xtc of size %u\n",
+              _sizeOfBuffers, entry->extent);
+      return NULL;
+    }
+    memcpy(odg->xtc.alloc(entry->extent, bufEnd), xtc, entry->extent);
+  }
+  return odg;
 }
 
 /*
@@ -292,19 +427,71 @@ void* ShmemClient::get(int& index, size_t& size)
   index = -1;
   size = 0;
 
+  if (_rings)
+    return _ringGet(index,size);
+
   while (1) {
     if (::poll(_pfd, _nfd, -1) > 0) {
       if (_pfd[0].revents & POLLIN) { // Transition
         return _handler->transition(index,size);
       }
       else if (_pfd[1].revents & POLLIN) { // Event
-        return _handler->event(index,size);
+        return _event(_handler->event(index,size),index,size);
       }
     }
   }
   return NULL;
 }
 
+void* ShmemClient::_event(XtcData::Dgram* dg, int index, size_t size)
+{
+  if (dg && _directory && !_zeroCopy &&
+      dg->service() == XtcData::TransitionId::L1Accept) {
+    void* odg = _assemble(index, dg);
+    if (!odg)  _handler->free(index, size);
+    return odg;
+  }
+  return dg;
+}
+
+/*
+** ++
+**
+**   In rings mode, the server counts the transitions it sends so that
+**   the socket needs to be read only when there's one waiting.  Waiting
+**   for events is done on the channel's futex, with a timeout for noticing
+**   that the server has gone away.
+**
+** --
+*/
+
+void* ShmemClient::_ringGet(int& index, size_t& size)
+{
+  XtcMonitorChannel& ch = _rings->channel(_ringIndex);
+
+  while (1) {
+    uint32_t seq = ch.bell.sequence();
+
+    if (ch.transitions.load() != _trSeen) {
+      ++_trSeen;
+      return _handler->transition(index,size);
+    }
+
+    uint32_t i;
+    if (ch.events.pop(i))
+      return _event(_handler->buffer(i,index,size),index,size);
+
+    ch.bell.wait(seq, 1000);
+
+    char c;
+    if (::recv(_myTrFd, &c, sizeof(c), MSG_PEEK|MSG_DONTWAIT) == 0) {
+      printf("Server disconnected\n");
+      return NULL;
+    }
+  }
+  return NULL;
+}
+
 /*
 ** ++
 **
@@ -383,6 +570,10 @@ int ShmemClient::connect(const char* tag, int tr_index) {
     return ++error;
     }
 
+  _tag           = tag;
+  _directory     = myMsg.directory();
+  _sizeOfBuffers = myMsg.sizeOfBuffers();
+
   //
   //  Initialize shared memory from first message
   //
@@ -405,27 +596,51 @@ int ShmemClient::connect(const char* tag, int tr_index) {
   close(shm);  // Done with the file descriptor
 
   int ev_index = myMsg.bufferIndex();
-  XtcMonitorMsg::eventInputQueue(tag,ev_index,qname);
-  _myInputEvQueue = _openQueue(qname, O_RDONLY, PERMS_IN);
-  if (_myInputEvQueue == (mqd_t)-1)
-    error++;
 
   _numberOfEvQueues = myMsg.numberOfQueues()+1;
   _myOutputEvQueue = new mqd_t[_numberOfEvQueues];
   for(int i=0; i<=myMsg.numberOfQueues(); i++)
     _myOutputEvQueue[i]=-1;
 
-  if (myMsg.serial()) {
-    XtcMonitorMsg::eventOutputQueue(tag,ev_index,qname);
-    _myOutputEvQueue[ev_index] = _openQueue(qname, O_WRONLY, PERMS_OUT);
-    if (_myOutputEvQueue[ev_index] == (mqd_t)-1)
-      error++;
+  if (myMsg.rings()) {
+    //
+    //  Event buffers come and go through the index rings after the buffers
+    //
+    size_t offset = XtcMonitorRings::offset(myMsg.numberOfBuffers(), myMsg.sizeOfBuffers());
+    _ringsSize = XtcMonitorRings::size(myMsg.numberOfQueues());
+    _ringIndex = ev_index;
+    _trSeen    = 0;
+    XtcMonitorMsg::sharedMemoryName(tag, qname);
+    int shm = shm_open(qname, O_RDWR, PERMS);
+    if (shm < 0) perror("shm_open rings");
+    void* rings = mmap(NULL, _ringsSize, PROT_READ|PROT_WRITE, MAP_SHARED, shm, offset);
+    close(shm);
+    if (rings == MAP_FAILED) {
+      perror("mmap rings");
+      delete[] qname;
+      return ++error;
+    }
+    _rings = (XtcMonitorRings*)rings;
+    printf("Index rings at %p\n", rings);
   }
   else {
-    XtcMonitorMsg::eventInputQueue(tag,myMsg.return_queue(),qname);
-    _myOutputEvQueue[ev_index] = _openQueue(qname, O_WRONLY, PERMS_OUT);
-    if (_myOutputEvQueue[ev_index] == (mqd_t)-1)
+    XtcMonitorMsg::eventInputQueue(tag,ev_index,qname);
+    _myInputEvQueue = _openQueue(qname, O_RDONLY, PERMS_IN);
+    if (_myInputEvQueue == (mqd_t)-1)
       error++;
+
+    if (myMsg.serial()) {
+      XtcMonitorMsg::eventOutputQueue(tag,ev_index,qname);
+      _myOutputEvQueue[ev_index] = _openQueue(qname, O_WRONLY, PERMS_OUT);
+      if (_myOutputEvQueue[ev_index] == (mqd_t)-1)
+        error++;
+    }
+    else {
+      XtcMonitorMsg::eventInputQueue(tag,myMsg.return_queue(),qname);
+      _myOutputEvQueue[ev_index] = _openQueue(qname, O_WRONLY, PERMS_OUT);
+      if (_myOutputEvQueue[ev_index] == (mqd_t)-1)
+        error++;
+    }
   }
   delete[] qname;
 
@@ -452,7 +667,7 @@ int ShmemClient::connect(const char* tag, int tr_index) {
                               myMsg,
                               _myTrFd,
                               _myInputEvQueue, _myOutputEvQueue, ev_index,
-                              tag,myShm);
+                              tag,myShm,_rings);
 
   return 0;
 }
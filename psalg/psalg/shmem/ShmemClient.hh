@@ -4,10 +4,13 @@
 #include <poll.h>
 #include <stddef.h>
 #include <mqueue.h>
+#include <string>
+#include <vector>
 
 namespace XtcData {
 
     class Dgram;
+    class Xtc;
 
 };
 
@@ -15,6 +18,8 @@ namespace psalg {
   namespace shmem {
 
     class DgramHandler;
+    class XtcMonitorDirEntry;
+    class XtcMonitorRings;
 
     class ShmemClient {
     public:
@@ -30,9 +35,23 @@ namespace psalg {
       int connect(const char* tag, int tr_index=0);
       void* get(int& index, size_t& size);
       void free(int index, size_t size);
+    public:
+      //
+      //  When the server serves L1Accepts as directories, get() assembles
+      //  them into a private buffer unless zero copy is requested, in which
+      //  case get() returns the directory and the contributions it lists
+      //  are read in place with contribution()
+      //
+      bool directory() const { return _directory; }
+      void zeroCopy(bool enable) { _zeroCopy = enable; }
+      const XtcData::Xtc* contribution(const XtcMonitorDirEntry&);
 
     private:
       void _shutdown();
+      void _unmapRegions();
+      void* _assemble(int index, const XtcData::Dgram* dir);
+      void* _event(XtcData::Dgram* dg, int index, size_t size);
+      void* _ringGet(int& index, size_t& size);
 
     private:
       int           _myTrFd;
@@ -42,6 +61,17 @@ namespace psalg {
       unsigned      _numberOfEvQueues;  // number of message queues for events
       mqd_t         _myInputEvQueue;    // message queue for returned events
       mqd_t*        _myOutputEvQueue;   // message queues[nclients] for distributing events
+      std::string   _tag;
+      bool          _directory;         // server serves L1Accepts as directories
+      bool          _zeroCopy;          // hand directories to the caller as is
+      size_t        _sizeOfBuffers;
+      std::vector<char*>  _regions;     // contribution regions mapped so far
+      std::vector<size_t> _regionSizes;
+      std::vector<char*>  _assembled;   // per buffer index assembly space
+      XtcMonitorRings* _rings;          // server's index rings, in rings mode
+      size_t        _ringsSize;
+      unsigned      _ringIndex;         // our channel
+      uint32_t      _trSeen;            // transitions received
     };
   };
 };
@@ -0,0 +1,28 @@
+#ifndef PsAlg_ShMem_XtcMonitorDir_hh
+#define PsAlg_ShMem_XtcMonitorDir_hh
+
+#include <stdint.h>
+
+namespace psalg {
+  namespace shmem {
+    //
+    //  When the server is in directory mode (XtcMonitorMsg::directory()),
+    //  the payload of each L1Accept it serves is an array of these entries
+    //  instead of the event's contribution Xtcs.  Each entry locates one
+    //  contribution Xtc within the shared memory region named by
+    //  XtcMonitorMsg::regionMemoryName(tag, region).  Transitions are
+    //  always served whole.
+    //
+    class XtcMonitorDirEntry {
+    public:
+      XtcMonitorDirEntry(unsigned region_, uint64_t offset_, uint32_t extent_) :
+        region(region_), extent(extent_), offset(offset_) {}
+    public:
+      uint32_t region;                  // contribution source's region number
+      uint32_t extent;                  // size of the contribution Xtc
+      uint64_t offset;                  // location of the Xtc within the region
+    };
+  };
+};
+
+#endif
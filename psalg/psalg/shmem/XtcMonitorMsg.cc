@@ -9,6 +9,11 @@ void XtcMonitorMsg::sharedMemoryName     (const char* tag, char* buffer)
   sprintf(buffer,"/PdsMonitorSharedMemory_%s",tag);
 }
 
+void XtcMonitorMsg::regionMemoryName     (const char* tag, unsigned region, char* buffer)
+{
+  sprintf(buffer,"/PdsMonitorRegion_%s_%d",tag,region);
+}
+
 void XtcMonitorMsg::eventInputQueue      (const char* tag, unsigned client, char* buffer)
 {
   sprintf(buffer,"/PdsToMonitorEvQueue_%s_%d",tag,client);
@@ -9,6 +9,7 @@ namespace psalg {
     class XtcMonitorMsg {
       enum { SizeMask   = 0x0fffffff };
       enum { SerialShift = 28 };
+      enum { DirectoryFlag = 0x1, RingsFlag = 0x2 };
     public:
       XtcMonitorMsg() : _bufferIndex(0),
                         _numberOfBuffers(0),
@@ -26,14 +27,19 @@ namespace psalg {
       size_t sizeOfBuffers() const { return (size_t)_sizeOfBuffers&SizeMask; }
       bool serial         () const { return return_queue()==0; }
       int return_queue    () const { return (_numberOfBuffers>>16)&0xff; }
+      bool directory      () const { return _reserved&DirectoryFlag; }
+      bool rings          () const { return _reserved&RingsFlag; }
     public:
       XtcMonitorMsg* bufferIndex(int b) {_bufferIndex=b; return this;}
       void numberOfBuffers      (int n) {_numberOfBuffers &= ~0xff; _numberOfBuffers |= ((n&0xff)<<0); }
       void numberOfQueues       (int n) {_numberOfBuffers &= ~0xff00; _numberOfBuffers |= ((n&0xff)<<8); }
       void sizeOfBuffers        (int s) {_sizeOfBuffers = (_sizeOfBuffers&~SizeMask) | (s&SizeMask);}
       void return_queue         (int q) {_numberOfBuffers &= ~0xff0000; _numberOfBuffers |= ((q&0xff)<<16); }
+      void directory            (bool d) {_reserved = d ? (_reserved|DirectoryFlag) : (_reserved&~DirectoryFlag); }
+      void rings                (bool r) {_reserved = r ? (_reserved|RingsFlag) : (_reserved&~RingsFlag); }
     public:
       static void sharedMemoryName     (const char* tag, char* buffer);
+      static void regionMemoryName     (const char* tag, unsigned region, char* buffer);
       static void eventInputQueue      (const char* tag, unsigned client, char* buffer);
       static void eventOutputQueue     (const char* tag, unsigned client, char* buffer);
       static void transitionInputQueue (const char* tag, unsigned client, char* buffer);
@@ -43,7 +49,7 @@ namespace psalg {
       int32_t  _bufferIndex;
       int32_t  _numberOfBuffers;
       uint32_t _sizeOfBuffers; // hoping we don't get larger than 4GB and SizeMask matters
-      uint32_t _reserved;
+      uint32_t _reserved;      // flags
     };
   };
 };
@@ -0,0 +1,141 @@
+#ifndef PsAlg_ShMem_XtcMonitorRing_hh
+#define PsAlg_ShMem_XtcMonitorRing_hh
+
+//--------------------------------------
+//
+//  Index rings used in place of the POSIX message queues for
+//  passing event buffers between the XtcMonitorServer and its
+//  clients.  They live in the server's shared memory segment,
+//  after the datagram buffers, as one channel per client:
+//  a ring of buffer indices for the client to process and a
+//  ring for giving them back.  Each side waits on a futex only
+//  when it finds nothing to do, and the other side makes the
+//  wake-up system call only when someone is waiting.
+//
+//  Transitions still go over the TCP socket; the server counts
+//  them in the channel so that the client learns of them without
+//  having to poll the socket.
+//
+//--------------------------------------
+
+#include <atomic>
+#include <limits.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+namespace psalg {
+  namespace shmem {
+
+    class XtcMonitorBell {
+    public:
+      void init() { _seq.store(0); _waiting.store(0); }
+      uint32_t sequence() const { return _seq.load(); }
+      void ring() {
+        _seq.fetch_add(1);
+        if (_waiting.load())
+          syscall(SYS_futex, &_seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+      }
+      //  Sleep until ring() is called after the sequence was sampled
+      void wait(uint32_t seq, unsigned ms) {
+        _waiting.fetch_add(1);
+        if (_seq.load() == seq) {
+          timespec tmo;
+          tmo.tv_sec  = ms / 1000;
+          tmo.tv_nsec = (ms % 1000) * 1000000L;
+          syscall(SYS_futex, &_seq, FUTEX_WAIT, seq, &tmo, NULL, 0);
+        }
+        _waiting.fetch_sub(1);
+      }
+    private:
+      alignas(64) std::atomic<uint32_t> _seq;
+      std::atomic<uint32_t>             _waiting;
+    };
+
+    //
+    //  Single producer ring.  Consumers claim entries with a
+    //  compare-and-swap so that, besides the client, the server
+    //  can take back indices a client has fallen behind on.
+    //
+    template <typename T>
+    class XtcMonitorRingT {
+    public:
+      enum { Capacity = 256 };          // numberOfBuffers is limited to 8 bits
+    public:
+      void init() { _head.store(0); _tail.store(0); }
+      bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+      }
+      bool push(T v) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) >= Capacity)
+          return false;
+        _slot[tail % Capacity].store(v, std::memory_order_relaxed);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+      }
+      bool pop(T& v) {
+        uint32_t head = _head.load(std::memory_order_acquire);
+        do {
+          if (head == _tail.load(std::memory_order_acquire))
+            return false;
+          v = _slot[head % Capacity].load(std::memory_order_relaxed);
+        } while (!_head.compare_exchange_weak(head, head + 1,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire));
+        return true;
+      }
+    private:
+      alignas(64) std::atomic<uint32_t> _head;
+      alignas(64) std::atomic<uint32_t> _tail;
+      std::atomic<T>                    _slot[Capacity];
+    };
+
+    typedef XtcMonitorRingT<uint32_t> XtcMonitorRing;
+
+    class XtcMonitorChannel {
+    public:
+      void init() {
+        bell.init();
+        events.init();
+        returns.init();
+        transitions.store(0);
+      }
+    public:
+      XtcMonitorBell        bell;        // wakes the client
+      XtcMonitorRing        events;      // buffers for the client to process
+      XtcMonitorRing        returns;     // buffers the client is done with
+      alignas(64) std::atomic<uint32_t> transitions; // sent on the TCP socket
+    };
+
+    class XtcMonitorRings {
+    public:
+      //  Where the rings start in the shared memory segment, and their size
+      static size_t offset(unsigned numberOfBuffers, size_t sizeOfBuffers) {
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t sz = size_t(numberOfBuffers) * sizeOfBuffers;
+        return pageSize * ((sz + pageSize - 1) / pageSize);
+      }
+      static size_t size(unsigned numberOfQueues) {
+        return sizeof(XtcMonitorRings) + numberOfQueues * sizeof(XtcMonitorChannel);
+      }
+    public:
+      void init(unsigned numberOfQueues) {
+        _bell.init();
+        for (unsigned i = 0; i < numberOfQueues; i++)
+          channel(i).init();
+      }
+      XtcMonitorBell&    bell() { return _bell; }
+      XtcMonitorChannel& channel(unsigned i) {
+        return reinterpret_cast<XtcMonitorChannel*>(this + 1)[i];
+      }
+    private:
+      XtcMonitorBell _bell;             // wakes the server
+    };
+  };
+};
+
+#endif
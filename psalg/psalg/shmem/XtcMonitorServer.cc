@@ -23,6 +23,7 @@
 #include <arpa/inet.h>
 
 #include <list>
+#include <new>
 
 //#define DBUG                            // Print client connection info
 //#define DBUG2                           // Print buffer management info
@@ -101,12 +102,21 @@ XtcMonitorServer::XtcMonitorServer(const char* tag,
   _myOutputEvQueue  (new mqd_t[numberofEvQueues]),
   _myTrFd           (0),
   _msgDest          (numberofEvBuffers),
+  _held             (numberofEvBuffers, nullptr),
   _pfd              (new pollfd[32]),
   _nfd              (3),
   _shuffleQueue     (-1),
   _requestQueue     (-1),
-  _ievt             (0)
+  _ievt             (0),
+  _rings            (nullptr),
+  _ringState        (numberofEvQueues),
+  _reclaim          (false),
+  _isteal           (0)
 {
+  _shuffleRing.init();
+  for(unsigned i=0; i<numberofEvQueues; i++)
+    _ringState[i].store(Detached);
+
   _myMsg.numberOfBuffers(numberofEvBuffers+numberofTrBuffers);
   _myMsg.numberOfQueues (numberofEvQueues);
   _myMsg.sizeOfBuffers  (sizeofBuffers);
@@ -143,6 +153,7 @@ XtcMonitorServer::~XtcMonitorServer()
   _terminate.store(true, std::memory_order_release);
   if (_discThread.joinable())  _discThread.join();
   if (_taskThread.joinable())  _taskThread.join();
+  if (_ringThread.joinable())  _ringThread.join();
 
   printf("Not Unlinking Shared Memory... \n");
 
@@ -154,6 +165,19 @@ XtcMonitorServer::~XtcMonitorServer()
   delete [] _pfd;
 }
 
+void* XtcMonitorServer::operator new(size_t sz)
+{
+  void* p;
+  if (posix_memalign(&p, alignof(XtcMonitorServer), sz))
+    throw std::bad_alloc();
+  return p;
+}
+
+void XtcMonitorServer::operator delete(void* p)
+{
+  free(p);
+}
+
 void XtcMonitorServer::distribute(bool l)
 {
   unsigned rq = l ? _numberOfEvQueues : 0;
@@ -163,8 +187,39 @@ void XtcMonitorServer::distribute(bool l)
   _replQueue(_myInputEvQueue, rq);
 }
 
+void XtcMonitorServer::directory(bool l)
+{
+  _myMsg.directory(l);
+}
+
+void XtcMonitorServer::rings(bool l)
+{
+  _myMsg.rings(l);
+}
+
+//
+//  Give back the source datagram of a buffer served in directory mode
+//  once no client can still be referring to it
+//
+void XtcMonitorServer::_release(int i)
+{
+  if (_held[i]) {
+    _deleteDatagram(_held[i]);
+    _held[i] = nullptr;
+  }
+}
+
 bool XtcMonitorServer::_send(Dgram* dg)
 {
+  if (_rings) {
+    //  The ring thread finds a buffer for it
+    if (_shuffleRing.push(dg))
+      _rings->bell().ring();
+    else
+      _deleteDatagram(dg);
+    return true;
+  }
+
   //
   //  For reasons I don't yet understand, sometimes the message queues
   //  are opened in blocking mode.  So, I use mq_timedreceive
@@ -246,8 +301,14 @@ XtcMonitorServer::Result XtcMonitorServer::events(Dgram* dg)
       //
       //  Steal all event buffers from the clients
       //
-      for(unsigned i=0; i<_numberOfEvQueues; i++)
-        _moveQueue(_myOutputEvQueue[i], _myInputEvQueue);
+      if (_rings) {
+        _reclaim.store(true);
+        _rings->bell().ring();
+      }
+      else {
+        for(unsigned i=0; i<_numberOfEvQueues; i++)
+          _moveQueue(_myOutputEvQueue[i], _myInputEvQueue);
+      }
     }
 
     //
@@ -257,7 +318,7 @@ XtcMonitorServer::Result XtcMonitorServer::events(Dgram* dg)
       int oq = _myTrFd[i];
       if (oq == -1 || !_transitionCache->allocate(itr,i))
         continue;
-      if (::send(oq, (const char*)&_myMsg, sizeof(_myMsg), 0) < 0) {
+      if (_sendTr(i, _myMsg) < 0) {
         perror("Error sending transition");
         _transitionCache->deallocate(itr,i);
       }
@@ -393,6 +454,7 @@ void XtcMonitorServer::routine()
         XtcMonitorMsg msg;
         const timespec no_wait={0,0};
         while(mq_timedreceive(_myInputEvQueue, (char*)&msg, sizeof(msg), NULL, &no_wait) > 0) {
+          _release(msg.bufferIndex());
           if (mq_timedsend(_requestQueue, (const char*)&msg, sizeof(msg), 0, &_tmo))
             perror("Writing to requestQ");
           else {
@@ -415,8 +477,16 @@ void XtcMonitorServer::routine()
         if (mq_receive(_shuffleQueue, (char*)&m, sizeof(m), NULL) < 0)
           perror("mq_receive");
 
-        _copyDatagram(m.dg(),_myShm+_sizeOfBuffers*m.msg().bufferIndex(), _sizeOfBuffers);
-        _deleteDatagram(m.dg());
+        int ib = m.msg().bufferIndex();
+        if (_myMsg.directory()) {
+          _release(ib);                 // Buffer was stolen rather than returned
+          _copyDatagram(m.dg(),_myShm+_sizeOfBuffers*ib, _sizeOfBuffers);
+          _held[ib] = m.dg();
+        }
+        else {
+          _copyDatagram(m.dg(),_myShm+_sizeOfBuffers*ib, _sizeOfBuffers);
+          _deleteDatagram(m.dg());
+        }
 
         if (m.msg().serial()) {
           //
@@ -483,6 +553,12 @@ void XtcMonitorServer::routine()
                 }
                 else { // retire client
                   printf("Retiring client %d [%d]\n",q,_pfd[i].fd);
+                  if (_rings) {
+                    //  The ring thread recovers the buffers
+                    _ringState[q].store(Retiring);
+                    _rings->bell().ring();
+                  }
+                  else {
                   //  Recover buffers last sent to this client
 
                   //  First, account for the ones waiting in our input queue
@@ -503,6 +579,7 @@ void XtcMonitorServer::routine()
                       else
                         _msgDest[j]=-1;
                     }
+                  }
 
                   _myTrFd[q]=-1;
                   //  Clear the transition tracking for this client
@@ -527,6 +604,166 @@ void XtcMonitorServer::routine()
   ::close(_pfd[0].fd);
 }
 
+//
+//  Event distribution in rings mode.  Only this thread touches the buffer
+//  bookkeeping (_freeBuffers, _msgDest, _held) in this mode.
+//
+void XtcMonitorServer::ringRoutine()
+{
+  //  Prime the source as routine() does for the buffers queued by _init()
+  for(size_t i=0; i<_freeBuffers.size(); i++)
+    _requestDatagram();
+
+  while(!_terminate.load(std::memory_order_relaxed)) {
+    uint32_t seq  = _rings->bell().sequence();
+    bool     work = false;
+
+    for(unsigned q=0; q<_numberOfEvQueues; q++) {
+      if (_ringState[q].load() == Retiring) {
+        _ringRetire(q);
+        work = true;
+      }
+    }
+
+    if (_reclaim.exchange(false)) {
+      int ib;
+      while(_ringSteal(ib))
+        _ringFree(ib);
+    }
+
+    //
+    //  Handle buffers returned from clients
+    //
+    for(unsigned q=0; q<_numberOfEvQueues; q++) {
+      if (_ringState[q].load() != Attached)  continue;
+      uint32_t ib;
+      while(_rings->channel(q).returns.pop(ib)) {
+        work = true;
+        if (ib >= _numberOfEvBuffers) {
+          printf("ILLEGAL RETURNED BUFFER INDEX %u from client %u\n", ib, q);
+          continue;
+        }
+        _msgDest[ib] = -1;
+        //  Serial distribution passes the event on to the next client
+        if (!(_myMsg.serial() && _ringDispatch(ib, q+1)))
+          _ringFree(ib);
+      }
+    }
+
+    //
+    //  Handle events ready for distribution
+    //
+    Dgram* dg;
+    while(_shuffleRing.pop(dg)) {
+      work = true;
+      _ringDistribute(dg);
+    }
+
+    if (!work)
+      _rings->bell().wait(seq, 100);
+  }
+}
+
+void XtcMonitorServer::_ringDistribute(Dgram* dg)
+{
+  int ib;
+  if (!_freeBuffers.empty()) {
+    ib = _freeBuffers.front();
+    _freeBuffers.pop();
+  }
+  else if (!_ringSteal(ib)) {
+    // No shared memory buffer found.  Dropping new event.
+    _deleteDatagram(dg);
+    return;
+  }
+
+  _copyDatagram(dg, _myShm+_sizeOfBuffers*ib, _sizeOfBuffers);
+  if (_myMsg.directory())
+    _held[ib] = dg;
+  else
+    _deleteDatagram(dg);
+
+  if (!_ringDispatch(ib, 0))
+    _ringFree(ib);
+}
+
+//
+//  Queue a buffer to the first attached client at or after the given one
+//  with room, or, when distributing, to the next one around
+//
+bool XtcMonitorServer::_ringDispatch(int ib, int first)
+{
+  for(unsigned i=first; i<_numberOfEvQueues; i++) {
+    unsigned q = _myMsg.serial() ? i : _ievt++%_numberOfEvQueues;
+    if (_ringState[q].load() != Attached)  continue;
+    XtcMonitorChannel& ch = _rings->channel(q);
+    if (ch.events.push(ib)) {
+      _msgDest[ib] = q;
+      ch.bell.ring();
+      return true;
+    }
+  }
+  return false;
+}
+
+//
+//  Take back the oldest buffer queued to a client, round-robin
+//
+bool XtcMonitorServer::_ringSteal(int& ib)
+{
+  for(unsigned i=0; i<_numberOfEvQueues; i++) {
+    unsigned q = _isteal++%_numberOfEvQueues;
+    if (_ringState[q].load() != Attached)  continue;
+    uint32_t b;
+    if (_rings->channel(q).events.pop(b)) {
+      _msgDest[b] = -1;
+      _release(b);
+      ib = b;
+      return true;
+    }
+  }
+  return false;
+}
+
+void XtcMonitorServer::_ringFree(int ib)
+{
+  _release(ib);
+  _freeBuffers.push(ib);
+  _requestDatagram();
+}
+
+//
+//  Recover the buffers queued to or held by a departed client
+//
+void XtcMonitorServer::_ringRetire(unsigned q)
+{
+  XtcMonitorChannel& ch = _rings->channel(q);
+  uint32_t ib;
+  while(ch.events.pop(ib))
+    _msgDest[ib] = q;
+  while(ch.returns.pop(ib))
+    _msgDest[ib] = q;
+  for(int j=0; j<int(_msgDest.size()); j++)
+    if (_msgDest[j]==int(q)) {
+      printf("Recovering buffer %d\n",j);
+      _msgDest[j]=-1;
+      _ringFree(j);
+    }
+  _ringState[q].store(Detached);
+}
+
+int XtcMonitorServer::_sendTr(int iclient, const XtcMonitorMsg& msg)
+{
+  int rc = ::send(_myTrFd[iclient], (const char*)&msg, sizeof(msg), 0);
+  if (rc >= 0 && _rings) {
+    //  Let the client know without it having to watch the socket
+    XtcMonitorChannel& ch = _rings->channel(iclient);
+    ch.transitions.fetch_add(1);
+    ch.bell.ring();
+  }
+  return rc;
+}
+
 void XtcMonitorServer::_clearDest(mqd_t queue)
 {
   XtcMonitorMsg msg;
@@ -562,6 +799,12 @@ int XtcMonitorServer::_init()
   size_t sizeOfShm = size_t(_numberOfEvBuffers + numberofTrBuffers) * _sizeOfBuffers;
   unsigned remainder = sizeOfShm%pageSize;
   if (remainder) sizeOfShm += pageSize - remainder;
+  size_t ringOffset = XtcMonitorRings::offset(_numberOfEvBuffers + numberofTrBuffers, _sizeOfBuffers);
+  if (_myMsg.rings()) {
+    sizeOfShm = ringOffset + XtcMonitorRings::size(_numberOfEvQueues);
+    remainder = sizeOfShm%pageSize;
+    if (remainder) sizeOfShm += pageSize - remainder;
+  }
 
   umask(1);  // try to enable world members to open these devices.
 
@@ -575,6 +818,13 @@ int XtcMonitorServer::_init()
 
   close(shm);  // Done with the file descriptor
 
+  if (_myMsg.rings() && _myShm != MAP_FAILED) {
+    _rings = reinterpret_cast<XtcMonitorRings*>(_myShm + ringOffset);
+    _rings->init(_numberOfEvQueues);
+    for(unsigned i=0; i<_numberOfEvBuffers; i++)
+      _freeBuffers.push(i);
+  }
+
   _transitionCache = new TransitionCache(_myShm+_numberOfEvBuffers*_sizeOfBuffers,
                                          _sizeOfBuffers,
                                          numberofTrBuffers);
@@ -591,6 +841,7 @@ int XtcMonitorServer::_init()
   for(unsigned i=0; i<_numberOfEvBuffers; i++) {
     _myMsg.bufferIndex(i);
     _msgDest[i]=-1;
+    if (_rings)  continue;              // Buffers start out on _freeBuffers
     if (mq_timedsend(_myInputEvQueue, (const char*)&_myMsg, sizeof(_myMsg), 0, &_tmo)<0)
       perror("Failed to queue buffer to input queue (initialize)");
   }
@@ -642,6 +893,8 @@ int XtcMonitorServer::_init()
   _terminate.store(false, std::memory_order_release);
   _taskThread = std::thread(&XtcMonitorServer::routine,  std::ref(*this));
   _discThread = std::thread(&XtcMonitorServer::discover, std::ref(*this));
+  if (_rings)
+    _ringThread = std::thread(&XtcMonitorServer::ringRoutine, std::ref(*this));
 
   delete[] shmName;
   delete[] toQname;
@@ -689,6 +942,16 @@ void XtcMonitorServer::_initialize_client()
   _pfd[_nfd].revents = 0;
   _nfd++;
 
+  if (_rings) {
+    //  Wait for the ring thread to be done with any previous client
+    while(_ringState[iclient].load() == Retiring) {
+      _rings->bell().ring();
+      usleep(1000);
+    }
+    _rings->channel(iclient).init();
+    _ringState[iclient].store(Attached);
+  }
+
   _myTrFd[iclient] = s;
   printf("Initialized client %d [socket %d]\n",iclient,s);
 
@@ -718,7 +981,7 @@ void XtcMonitorServer::_update(int iclient,
       _myMsg.bufferIndex(ib);
 
       if (_transitionCache->allocate(itr,iclient))
-        if (::send(_myTrFd[iclient], (const char*)&_myMsg, sizeof(_myMsg), 0)<0) {
+        if (_sendTr(iclient, _myMsg)<0) {
           perror("Error sending current");
           _transitionCache->deallocate(itr,iclient);
         }
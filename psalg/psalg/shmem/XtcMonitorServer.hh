@@ -41,9 +41,23 @@
 //  transitions are not reused until all clients have returned
 //  the buffer.
 //
+//  In directory mode, event buffers hold only a small datagram
+//  locating each contribution in separately named shared memory
+//  regions (see XtcMonitorDirEntry) rather than the event itself.
+//  The source datagram is then held until the client returns the
+//  buffer, since it still refers to the contributions' memory.
+//
+//  In rings mode, event buffers are passed to and from clients
+//  through index rings in the shared memory (see XtcMonitorRing)
+//  rather than through message queues, and a dedicated thread does
+//  the work of the message queue handling in routine().  Serial
+//  distribution then passes each buffer back through the server
+//  on its way to the next client.
+//
 //-----------------------------------
 
 #include "XtcMonitorMsg.hh"
+#include "XtcMonitorRing.hh"
 
 #include "xtcdata/xtc/TransitionId.hh"
 
@@ -73,15 +87,23 @@ namespace psalg {
                        unsigned numberofEvBuffers,
                        unsigned numberofEvQueues);
       virtual ~XtcMonitorServer();
+    public:
+      //  The index rings are cache line aligned, which the global new
+      //  doesn't honor before C++17
+      static void* operator new   (size_t);
+      static void  operator delete(void*);
     public:
       enum Result { Handled, Deferred };
       Result events   (XtcData::Dgram* dg);
       void wait       ();
       void discover   ();
       void routine    ();
+      void ringRoutine();
       void unlink     ();
     public:
       void distribute (bool);
+      void directory  (bool);
+      void rings      (bool);
     protected:
       int  _init             ();
     private:
@@ -94,6 +116,13 @@ namespace psalg {
       bool _send             (XtcData::Dgram*);
       void _update           (int, XtcData::TransitionId::Value);
       void _clearDest        (mqd_t);
+      void _release          (int);
+      int  _sendTr           (int, const XtcMonitorMsg&);
+      void _ringDistribute   (XtcData::Dgram*);
+      bool _ringDispatch     (int, int);
+      bool _ringSteal        (int&);
+      void _ringFree         (int);
+      void _ringRetire       (unsigned);
     private:
       virtual void _copyDatagram   (XtcData::Dgram* dg, char*, size_t);
       virtual void _deleteDatagram (XtcData::Dgram* dg);
@@ -112,6 +141,7 @@ namespace psalg {
       std::vector<int>  _myTrFd;            // TCP sockets to clients for distributing
                                             // transitions and detecting disconnects.
       std::vector<int>  _msgDest;           // last client to which the buffer was sent
+      std::vector<XtcData::Dgram*> _held;   // source datagrams of buffers in directory mode
       TransitionCache*  _transitionCache;
       int               _initFd;
       pollfd*           _pfd;               /* poll descriptors for:
@@ -127,6 +157,14 @@ namespace psalg {
       std::thread       _discThread;        // thread for receiving new client connections
       std::thread       _taskThread;        // thread for datagram distribution
       unsigned          _ievt;              // event vector
+      enum { Detached, Attached, Retiring };
+      XtcMonitorRings*  _rings;             // index rings in shared memory, in rings mode
+      XtcMonitorRingT<XtcData::Dgram*> _shuffleRing; // events ready for distribution
+      std::vector<std::atomic<int> > _ringState; // of each client's channel
+      std::atomic<bool> _reclaim;           // take back all buffers queued to clients
+      std::queue<int>   _freeBuffers;       // event buffers not held by any client
+      unsigned          _isteal;            // next channel to steal from
+      std::thread       _ringThread;        // thread for distribution in rings mode
     };
   };
 };
@@ -46,11 +46,13 @@ public:
   MyMonitorServer(const char* tag,
                   unsigned sizeofBuffers,
                   unsigned numberofEvBuffers,
-                  unsigned numberofClients) :
+                  unsigned numberofClients,
+                  bool rings) :
     XtcMonitorServer(tag,
                      sizeofBuffers,
                      numberofEvBuffers,
                      numberofClients) {
+    XtcMonitorServer::rings(rings);
     _init();
 
     // when reading from files, this is the mode that makes the most
@@ -226,7 +228,7 @@ void XtcRunSet::addPathsFromListFile(string listFile) {
   _addPaths(newPaths);
 }
 
-void XtcRunSet::connect(char* partitionTag, unsigned sizeOfBuffers, int numberOfBuffers, unsigned nclients, int rate, bool verbose, bool veryverbose, bool interactive) {
+void XtcRunSet::connect(char* partitionTag, unsigned sizeOfBuffers, int numberOfBuffers, unsigned nclients, int rate, bool verbose, bool veryverbose, bool interactive, bool rings) {
   if (_server == NULL) {
     _verbose = verbose;
     _veryverbose = veryverbose;
@@ -245,7 +247,8 @@ void XtcRunSet::connect(char* partitionTag, unsigned sizeOfBuffers, int numberOf
     _server = new MyMonitorServer(partitionTag,
                                   sizeOfBuffers,
                                   numberOfBuffers,
-                                  nclients);
+                                  nclients,
+                                  rings);
     clock_gettime(CLOCK, &now);
     printf("Opening shared memory took %.3f msec.\n", timeDiff(&now, &start) / 1e6);
   }
@@ -4,6 +4,7 @@
 #include <string>
 #include <iostream>
 #include <iomanip>  // for setw, setfill
+#include <vector>
 
 //#include "psalg/geometry/GeometryObject.hh"
 #include "psalg/geometry/GeometryAccess.hh"
@@ -159,6 +160,51 @@ void test_geo_get_misc()
 
 //-------------------
 
+void test_image_mapper()
+{
+  cout << "\n==test_image_mapper\n";
+
+  // 4 segments of 352x384 pixels, the last one overlapping the third by half
+  const gsize_t rows=352, cols=384, nseg=4, size=nseg*rows*cols;
+  std::vector<pixel_idx_t> vX(size), vY(size);
+  std::vector<double> data(size);
+  for(gsize_t i=0; i<size; ++i) {
+    gsize_t seg = i/(rows*cols), r = (i/cols)%rows, c = i%cols;
+    vX[i] = r + ((seg<3) ? seg*(rows+4) : 2*(rows+4)+rows/2);
+    vY[i] = c + ((seg==1) ? cols : 0);
+    data[i] = i%1000;
+  }
+  const pixel_idx_t* iX = vX.data();
+  const pixel_idx_t* iY = vY.data();
+
+  clock_gettime(CLOCK_REALTIME, &start);
+  psalg::NDArray<geometry::GeometryAccess::image_t> img =
+    geometry::GeometryAccess::img_from_pixel_arrays(iX, iY, data.data(), size);
+  clock_gettime(CLOCK_REALTIME, &stop);
+  printf("img_from_pixel_arrays time (sec) = %.6f\n", dtime(start, stop));
+
+  geometry::ImageMapper mapper(iX, iY, size);
+  mapper.print();
+  std::vector<geometry::ImageMapper::image_t> buf(mapper.image_size(), -1);
+
+  for(int nthreads=1; nthreads<=4; nthreads*=2) {
+    clock_gettime(CLOCK_REALTIME, &start);
+    mapper.assemble(data.data(), buf.data(), nthreads);
+    clock_gettime(CLOCK_REALTIME, &stop);
+    printf("ImageMapper::assemble with %d threads time (sec) = %.6f\n", nthreads, dtime(start, stop));
+  }
+
+  size_t ndiff = (img.size() == buf.size()) ? 0 : buf.size();
+  for(size_t i=0; i<buf.size() && !ndiff; ++i) if(img.data()[i] != buf[i]) ++ndiff;
+  cout << "  images " << ((ndiff) ? "DIFFER" : "are the same") << '\n';
+
+  geometry::ImageMapper mean(iX, iY, size, geometry::ImageMapper::MEAN);
+  mean.print();
+  mean.assemble(data.data(), buf.data());
+}
+
+//-------------------
+
 void print_hline(const unsigned nchars, const char c) {printf("%s\n", std::string(nchars,c).c_str());}
 
 //-------------------
@@ -172,6 +218,7 @@ std::string usage(const std::string& tname="")
   if (tname == "" || tname=="2"	) ss << "\n   2  - test_geo_get_pixel_coords_as_pointer()";
   if (tname == "" || tname=="3"	) ss << "\n   3  - test_geo_get_pixel_coords_as_ndarray()";
   if (tname == "" || tname=="4"	) ss << "\n   4  - test_geo_get_misc()";
+  if (tname == "" || tname=="5"	) ss << "\n   5  - test_image_mapper()";
   ss << '\n';
   return ss.str();
 }
@@ -195,6 +242,7 @@ int main(int argc, char* argv[])
   else if (tname=="2")  test_geo_get_pixel_coords_as_pointer();
   else if (tname=="3")  test_geo_get_pixel_coords_as_ndarray();
   else if (tname=="4")  test_geo_get_misc();
+  else if (tname=="5")  test_image_mapper();
 
   else MSG(WARNING, "Undefined test name: " << tname);
 
@@ -0,0 +1,127 @@
+// == Build locally
+// cd .../lcls2/psalg/build
+// make
+// == Then run
+// psalg/test_PixelCalib
+//
+// Checks detector::PixelCalib against a plain per-pixel calibration for
+// each gain mode, and the removal of a common mode offset per row.
+// Returns non-zero on a mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include "psalg/detector/PixelCalib.hh"
+
+using namespace detector;
+
+typedef std::size_t size_type; // detector::size_t is 32 bits
+
+//-------------------
+
+/// Calibrated value of pixel i of raw value r, with one plane of size npix per range of constants
+float reference(PixelCalib::GAINMODE mode, raw_t r, size_type i, size_type npix,
+                const float* peds, const float* gains, const float* offsets, const uint16_t* status) {
+  size_type range;
+  raw_t adc;
+  if(mode == PixelCalib::SINGLE) {
+    range = 0;
+    adc = r;
+  }
+  else if(mode == PixelCalib::JUNGFRAU) {
+    unsigned bits = r >> 14;
+    if(bits == 2) return 0; // invalid gain state
+    range = (bits == 3) ? 2 : bits;
+    adc = r & 0x3fff;
+  }
+  else {
+    range = (r & 0x4000) ? PixelCalib::AHL_L : PixelCalib::AHL_H;
+    adc = r & 0x3fff;
+  }
+  size_type k = range*npix + i;
+  if(status[k] || gains[k] == 0) return 0;
+  return (adc - peds[k] - offsets[k]) / gains[k];
+}
+
+//-------------------
+
+int test_calibrate(PixelCalib::GAINMODE mode) {
+  const size_type npanels=3, nrows=17, ncols=37, npix=npanels*nrows*ncols;
+
+  PixelCalib pc(mode, npanels, nrows, ncols);
+  size_type nranges = pc.nranges();
+
+  std::vector<float>    peds(nranges*npix), gains(nranges*npix), offsets(nranges*npix);
+  std::vector<uint16_t> status(nranges*npix);
+  for(size_type k=0; k<nranges*npix; ++k) {
+    peds[k]    = rand()%1000;
+    gains[k]   = 0.5f + (rand()%100)/50.f;
+    offsets[k] = rand()%10;
+    status[k]  = (rand()%50 == 0);
+  }
+  pc.set_constants(peds.data(), gains.data(), offsets.data(), status.data());
+
+  std::vector<raw_t> raw(npix);
+  for(auto& r : raw) r = rand();
+
+  std::vector<calib_t> out(npix);
+  pc.calibrate(raw.data(), out.data(), 4);
+
+  int nbad = 0;
+  for(size_type i=0; i<npix; ++i) {
+    float expected = reference(mode, raw[i], i, npix, peds.data(), gains.data(), offsets.data(), status.data());
+    if(fabs(expected - out[i]) > 1e-3f*std::max(1.f, fabs(expected))) {
+      if(nbad < 5) printf("  mode %d pixel %zu: %f expected %f\n", mode, i, out[i], expected);
+      ++nbad;
+    }
+  }
+  printf("test_calibrate mode %d: %d bad pixels of %zu\n", mode, nbad, npix);
+  return nbad;
+}
+
+//-------------------
+
+int test_common_mode() {
+  const size_type npanels=3, nrows=17, ncols=37, npix=npanels*nrows*ncols;
+
+  PixelCalib pc(PixelCalib::SINGLE, npanels, nrows, ncols);
+  std::vector<float> peds(npix, 100), gains(npix, 1);
+  pc.set_constants(peds.data(), gains.data());
+  pc.set_common_mode(PixelCalib::CM_ROWS, 100, 5);
+
+  // Each row is offset by up to 6 ADU, with every 5th pixel 1 ADU above the rest
+  std::vector<raw_t> raw(npix);
+  for(size_type i=0; i<npix; ++i) raw[i] = 100 + (i/ncols)%7 + ((i%5) == 0 ? 1 : 0);
+
+  std::vector<calib_t> out(npix);
+  pc.calibrate(raw.data(), out.data(), 2);
+
+  int nbad = 0;
+  for(size_type i=0; i<npix; ++i) {
+    float expected = ((i%5) == 0) ? 1 : 0;
+    if(fabs(out[i] - expected) > 1e-5) {
+      if(nbad < 5) printf("  pixel %zu: %f expected %f\n", i, out[i], expected);
+      ++nbad;
+    }
+  }
+  printf("test_common_mode: %d bad pixels of %zu\n", nbad, npix);
+  return nbad;
+}
+
+//-------------------
+
+int main(int argc, char* argv[]) {
+  printf("PixelCalib kernel: %s\n", PixelCalib(PixelCalib::SINGLE, 1, 1, 1).kernel());
+
+  int nbad = 0;
+  nbad += test_calibrate(PixelCalib::SINGLE);
+  nbad += test_calibrate(PixelCalib::EPIX10KA);
+  nbad += test_calibrate(PixelCalib::JUNGFRAU);
+  nbad += test_common_mode();
+  return nbad ? 1 : 0;
+}
+
+//-------------------
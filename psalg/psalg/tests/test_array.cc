@@ -158,6 +158,53 @@ void testArray(Allocator& buf1){
     delete[] buf;
 }
 
+void testArena(){
+    std::cout << "----- Arena" << std::endl;
+    uint8_t *region = new uint8_t[4096];
+    Arena arena(region, 4096);
+    assert(arena.capacity() <= 4096 && arena.capacity() > 4096-Arena::Alignment);
+
+    {
+        std::cout << "####### Test AllocArray1D growth" << std::endl;
+        auto a = AllocArray1D<double>(arena, 2);
+        for (int i = 0; i < 100; i++) a.push_back(i);
+        assert(a.size()==100 && a.capacity()>=100 && a(99)==99);
+        assert(arena.overflows()==0 && arena.live()==1); // grown in place
+
+        auto b = AllocArray1D<float>(arena, 1);
+        for (int i = 0; i < 10; i++) b.push_back(i);
+        assert(b.size()==10 && b(9)==9);
+        a.push_back(100);                                // no longer the last block: moved
+        assert(a.size()==101 && a(0)==0 && a(100)==100);
+        assert(arena.live()==2);
+
+        auto c(b);
+        assert(!b.reserve(1000));                        // shared
+        assert(b.capacity()<1000);
+
+        std::cout << "####### Test Arena overflow" << std::endl;
+        auto d = AllocArray1D<uint8_t>(arena, 8192);     // served by the heap
+        assert(arena.overflows()==1);
+        d.push_back(1);
+    }
+    assert(arena.live()==0);
+    size_t highWater = arena.highWater();
+    assert(highWater > 0 && highWater <= arena.capacity());
+
+    std::cout << "####### Test Arena reset" << std::endl;
+    arena.reset();
+    assert(arena.used()==0 && arena.staleResets()==0);
+    testArray(arena);
+    arena.reset();
+    assert(arena.staleResets()==0);
+    {
+        auto e = AllocArray1D<int>(arena, 4);
+        arena.reset();
+        assert(arena.staleResets()==1);
+    }
+    delete[] region;
+}
+
 int main () {
 
     // Test with heap
@@ -168,5 +215,7 @@ int main () {
     Stack buf2;
     testArray(buf2);
 
+    testArena();
+
     return 0;
 }
@@ -90,7 +90,7 @@ cdef extern from 'xtcdata/xtc/XtcUpdateIter.hh' namespace "XtcData":
         void setString(char* data, DataDef& datadef, char* varname)
         void setValue(unsigned nodeId, unsigned namesId,
                 char* data, DataDef& datadef, char* varname)
-        void setOutput(char* outbuf)
+        void setOutput(char* outbuf, const Xtc* input)
         void addData(unsigned nodeId, unsigned namesId,
                 unsigned* shape, char* data, DataDef& datadef, char* varname)
         Dgram& createTransition(unsigned transId, unsigned counting_timestamps,
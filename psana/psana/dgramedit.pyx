@@ -214,11 +214,16 @@ cdef class PyXtcUpdateIter():
     def copy_parent(self, PyDgram pydg):
         self.cptr.copyParent(pydg.cptr)
 
-    def set_outbuf(self, outbuf):
+    def set_outbuf(self, outbuf, PyXtc pyxtc=None):
+        # pyxtc: the xtc that will be iterated into outbuf, in case
+        # outbuf is its own memory (saving in place)
         cdef char* o_ptr
+        cdef const Xtc* i_ptr = NULL
         PyObject_GetBuffer(outbuf, &(self.oPybuf), PyBUF_SIMPLE | PyBUF_ANY_CONTIGUOUS)
         o_ptr = <char *>self.oPybuf.buf
-        self.cptr.setOutput(o_ptr)
+        if pyxtc is not None:
+            i_ptr = pyxtc.cptr
+        self.cptr.setOutput(o_ptr, i_ptr)
     
     def free_outbuf(self):
         # TODO: Find way toProtect when PyObject_GetBuffer is not called.
@@ -521,7 +526,7 @@ cdef class DgramEdit:
             self.uiter.set_cfgwrite(True)
         
         # Set main output buffer to point to external buffer given by users
-        self.uiter.set_outbuf(out)
+        self.uiter.set_outbuf(out, pyxtc)
 
         # Copies Names for Configure or ShapesData for L1Accept
         # (also applies remove for ShapesData).
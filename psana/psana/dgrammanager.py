@@ -61,6 +61,8 @@ class DgramManager(object):
         self.shm_inp_mv = None
         self.shm_res_mv = None
         self.shm_size = None
+        self.pebble_mv = None
+        self._drp_offsets = []
         self.shmem_kwargs = {'index':-1,'size':0,'cli_cptr':None}
         self.configs = []
         self._timestamps = [] # built when iterating
@@ -117,6 +119,9 @@ class DgramManager(object):
         for fd, xtc_file in zip(self.fds, self.xtc_files):
             self.fds_map[fd] = xtc_file
 
+        # Striped bigdata files are opened on demand by the EventManager
+        self.stripe_fds = {}
+
         given_configs = True if len(configs) > 0 else False
         if given_configs:
             self.set_configs(configs)
@@ -159,6 +164,15 @@ class DgramManager(object):
         # TODO: Add docstring
         self.shm_inp_mv = mmap.mmap(self.ipc.shm_inp.fd, self.ipc.shm_inp.size)
         self.shm_res_mv = mmap.mmap(self.ipc.shm_res.fd, self.ipc.shm_res.size)
+        self._shm_inp_map = self.shm_inp_mv
+        self._shm_res_map = self.shm_res_mv
+        if self.ipc.shm_pebble is not None:
+            self.pebble_mv = memoryview(mmap.mmap(self.ipc.shm_pebble.fd, self.ipc.shm_pebble.size))
+            # Dgrams are edited in place in the pebble, at the offset of the
+            # Dgram that follows the 8 byte PulseId of the DRP's EbDgram, so
+            # each has its buffer less those 8 bytes
+            self.pebble_bufsize -= 8
+            self.transition_bufsize -= 8
         self.mq_inp = self.ipc.mq_inp
         self.mq_res = self.ipc.mq_res
         self.mq_res.send(b"r\n")
@@ -323,6 +337,9 @@ class DgramManager(object):
         if not self.given_fds:
             for fd in self.fds:
                 os.close(fd)
+        for fd in self.stripe_fds.values():
+            os.close(fd)
+        self.stripe_fds = {}
 
     def __iter__(self):
         return self
@@ -381,14 +398,43 @@ class DgramManager(object):
         elif self.mq_inp:
             if self._stop_iteration:
                 raise StopIteration
-            self.mq_res.send(b"g\n")
-            message, priority = self.mq_inp.receive()
-            if message == b"g":
+            if self._drp_offsets:
+                message = b"b"
+            else:
+                # In zero-copy mode this also tells the DRP that the previous
+                # batch of dgrams has been edited in place
+                self.mq_res.send(b"g\n")
+                message, priority = self.mq_inp.receive()
+                if message[:1] == b"b":
+                    # 'b' padded to 8 bytes, followed by the pebble offsets of the dgrams
+                    self._drp_offsets = np.frombuffer(message, dtype=np.uint64)[1:].tolist()
+                    self._drp_offsets.reverse()
+            if message[:1] == b"b":
+                # Results are saved over the input dgram in the pebble
+                offset = self._drp_offsets.pop()
+                # L1Accepts are in pebble buffers and SlowUpdates in transition
+                # buffers: view only the one the dgram is in, so that saving
+                # can't spill into the next buffer.  The service is in bits
+                # 24-27 of env, which follows the 8 byte timestamp.
+                env = int.from_bytes(self.pebble_mv[offset+8:offset+12], 'little')
+                if (env >> 24) & 0xf == TransitionId.L1Accept:
+                    size = self.pebble_bufsize
+                else:
+                    size = self.transition_bufsize
+                self.shm_inp_mv = self.pebble_mv[offset:offset+size]
+                self.shm_res_mv = self.shm_inp_mv
+                d = dgram.Dgram(config=self.configs[-1], view=self.shm_inp_mv)
+                dgrams = [d]
+            elif message == b"g":
+                self.shm_inp_mv = self._shm_inp_map
+                self.shm_res_mv = self._shm_res_map
                 # use the most recent configure datagram
                 d = dgram.Dgram(config=self.configs[-1], view=self.shm_inp_mv)
                 dgrams = [d]
             elif message == b"s":
                 self._stop_iteration = True
+                self.shm_inp_mv = self._shm_inp_map
+                self.shm_res_mv = self._shm_res_map
                 self.shm_res_mv[:] = self.shm_inp_mv[:]
                 self.mq_res.send(b"s\n")                
                 raise StopIteration
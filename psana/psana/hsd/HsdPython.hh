@@ -9,6 +9,7 @@
 #include <cinttypes>
 
 #include "psalg/digitizer/Stream.hh"
+#include "psalg/digitizer/FexPeaks.hh"
 
 namespace Pds {
   namespace HSD {
@@ -52,6 +53,33 @@ namespace Pds {
         //     return wf;
         // }
 
+        uint16_t* fex(unsigned& numsamples) {
+            if (!_sh_fex) return 0;
+            numsamples = _sh_fex->num_samples();
+            return (uint16_t*)(_sh_fex+1);
+        }
+
+        // Room needed in the arrays passed to peaks()
+        unsigned max_peaks() const {
+            return _sh_fex ? max_fex_peaks(_sh_fex->num_samples()) : 0;
+        }
+
+        // All the peaks in one pass: the start of each in the raw waveform,
+        // its length, and the offset of its first sample in the fex samples.
+        // Returns the number of peaks.
+        unsigned peaks(uint32_t* startPos, uint32_t* length, uint32_t* offset) {
+            if (!_sh_fex) return 0;
+            const uint16_t* q = reinterpret_cast<const uint16_t*>(_sh_fex+1);
+            unsigned n = 0;
+            return parse_fex_peaks(q, _sh_fex->num_samples(),
+                                   [&](unsigned start, unsigned width, unsigned off) {
+                                       startPos[n] = start;
+                                       length  [n] = width;
+                                       offset  [n] = off;
+                                       n++;
+                                   });
+        }
+
         unsigned next_peak(unsigned& startPos, uint16_t** peakPtr) {
             unsigned peakLen = 0; // indicate that, by default, we haven't found a peak
             if (!_sh_fex) return peakLen; // no more peaks to look for
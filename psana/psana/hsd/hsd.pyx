@@ -24,6 +24,8 @@ from amitypes import HSDWaveforms, HSDPeaks, HSDAssemblies, HSDPeakTimes
 ################# High Speed Digitizer #################
 
 cimport libc.stdint as si
+from libc.string cimport memcpy
+from libcpp.vector cimport vector
 ctypedef si.uint32_t evthdr_t
 ctypedef si.uint8_t chan_t
 
@@ -38,22 +40,38 @@ cdef extern from "HsdPython.hh" namespace "Pds::HSD":
         si.uint16_t* waveform(unsigned &numsamples)
         #si.uint16_t* sparse(unsigned &numsamples)
         unsigned next_peak(unsigned &sPos, si.uint16_t** peakPtr)
+        si.uint16_t* fex(unsigned &numsamples)
+        unsigned max_peaks()
+        unsigned peaks(si.uint32_t* startPos, si.uint32_t* length, si.uint32_t* offset)
+
+# Scratch space for ChannelPython::peaks, sized for the largest fex stream seen
+cdef vector[si.uint32_t] _peakStart
+cdef vector[si.uint32_t] _peakLength
+cdef vector[si.uint32_t] _peakOffset
+
+cdef cnp.ndarray _uint32_array(si.uint32_t* data, unsigned n):
+    cdef cnp.npy_intp shape[1]
+    shape[0] = n
+    cdef cnp.ndarray a = cnp.PyArray_SimpleNew(1, shape, cnp.NPY_UINT32)
+    memcpy(cnp.PyArray_DATA(a), data, n*sizeof(si.uint32_t))
+    return a
 
 cdef class PyChannelPython:
     cdef public cnp.ndarray waveform
     #cdef public cnp.ndarray sparse
-    cdef public list peakList
-    cdef public list startPosList
+    cdef public cnp.ndarray fex
+    cdef public cnp.ndarray startPos
+    cdef public cnp.ndarray length
+    cdef public cnp.ndarray offset
+    cdef object _peakList
+    cdef object _startPosList
     def __init__(self, cnp.ndarray[evthdr_t, ndim=1, mode="c"] evtheader, cnp.ndarray[chan_t, ndim=1, mode="c"] chan, dgram):
         cdef cnp.npy_intp shape[1]
         cdef si.uint16_t* wf_ptr
         cdef ChannelPython chanpy
         cdef unsigned numsamples = 0
-        cdef unsigned startSample = 0
-        cdef unsigned startPos = 0
-        cdef unsigned peakLen = 0
-        cdef si.uint16_t* peakPtr = <si.uint16_t*>0
-        cdef cnp.ndarray peak
+        cdef unsigned maxpeaks
+        cdef unsigned npeaks
 
         chanpy = ChannelPython(&evtheader[0], &chan[0])
 
@@ -75,20 +93,61 @@ cdef class PyChannelPython:
 #        else:
 #            self.sparse = None
 
-        self.peakList = None
-        self.startPosList = None
-        while True:
-            shape[0] = chanpy.next_peak(startPos,&peakPtr)
-            if not shape[0]: break
-            if self.peakList is None:
-                # we've found a peak so initialize the arrays
-                self.peakList = []
-                self.startPosList = []
-            peak = cnp.PyArray_SimpleNewFromData(1, shape, cnp.NPY_UINT16, peakPtr)
-            peak.base = <PyObject*> dgram
-            Py_INCREF(dgram)
-            self.peakList.append(peak)
-            self.startPosList.append(startPos)
+        # all the peaks are found in one call, as (start, length, offset)
+        # arrays into the fex samples; the per-peak lists are made on demand
+        self.fex = None
+        self.startPos = None
+        self.length = None
+        self.offset = None
+        self._peakList = None
+        self._startPosList = None
+        numsamples = 0
+        wf_ptr = chanpy.fex(numsamples)
+        if not numsamples: return
+        shape[0] = numsamples
+        self.fex = cnp.PyArray_SimpleNewFromData(1, shape, cnp.NPY_UINT16, wf_ptr)
+        self.fex.base = <PyObject*> dgram
+        Py_INCREF(dgram)
+
+        maxpeaks = chanpy.max_peaks()
+        if _peakStart.size() < maxpeaks:
+            _peakStart.resize(maxpeaks)
+            _peakLength.resize(maxpeaks)
+            _peakOffset.resize(maxpeaks)
+        npeaks = chanpy.peaks(_peakStart.data(), _peakLength.data(), _peakOffset.data())
+        if npeaks:
+            self.startPos = _uint32_array(_peakStart.data(), npeaks)
+            self.length   = _uint32_array(_peakLength.data(), npeaks)
+            self.offset   = _uint32_array(_peakOffset.data(), npeaks)
+
+    @property
+    def peakList(self):
+        """List of the fex samples of each peak, or None if there are none."""
+        cdef cnp.npy_intp shape[1]
+        cdef si.uint16_t* fex_ptr
+        cdef si.uint32_t* length
+        cdef si.uint32_t* offset
+        cdef unsigned i
+        cdef cnp.ndarray peak
+        if self._peakList is None and self.startPos is not None:
+            fex_ptr = <si.uint16_t*>cnp.PyArray_DATA(self.fex)
+            length  = <si.uint32_t*>cnp.PyArray_DATA(self.length)
+            offset  = <si.uint32_t*>cnp.PyArray_DATA(self.offset)
+            self._peakList = []
+            for i in range(self.length.shape[0]):
+                shape[0] = length[i]
+                peak = cnp.PyArray_SimpleNewFromData(1, shape, cnp.NPY_UINT16, fex_ptr+offset[i])
+                peak.base = <PyObject*> self.fex
+                Py_INCREF(self.fex)
+                self._peakList.append(peak)
+        return self._peakList
+
+    @property
+    def startPosList(self):
+        """List of the start of each peak in the waveform, or None if there are none."""
+        if self._startPosList is None and self.startPos is not None:
+            self._startPosList = self.startPos.tolist()
+        return self._startPosList
 
 class hsd_hsd_1_2_3(cyhsd_base_1_2_3, DetectorImpl):
 
@@ -138,8 +197,10 @@ cdef class cyhsd_base_1_2_3:
         self._wvDict = {}
         self._spDict = {}
         self._fexPeaks = []
-        self._peaksDict = {}
+        self._peaksDict = None
+        self._peakArraysDict = {}
         self._peakTimesDict = {}
+        self._pychansegs = {}
         self._evt = None
         self._hsdsegments = None
 
@@ -189,17 +250,18 @@ cdef class cyhsd_base_1_2_3:
     def _parseEvt(self, evt):
         self._wvDict = {}
         self._spDict = {}
-        self._peaksDict = {}
         self._padDict = {}
         self._fexPeaks = []
+        # Keep segment-pychan data for slow padding routine when asked,
+        # and to make the lists of peaks when asked
+        self._pychansegs = {}
+        self._peaksDict = None
+        self._peakArraysDict = {}
         self._hsdsegments = self._segments(evt)
         if self._hsdsegments is None: return # no segments at all
         self._evt = evt
         #seglist = [] # not used at the moment
 
-        # Keep segment-pychan data for slow padding routine when asked
-        self._pychansegs = {}
-
         cdef int iseg
         for iseg in self._hsdsegments:
             #seglist.append(iseg) # not used at the moment
@@ -227,10 +289,11 @@ cdef class cyhsd_base_1_2_3:
 #                            if iseg not in self._spDict.keys():
 #                                self._spDict[iseg] = {}
 #                                self._spDict[iseg][chanNum] = pychan.sparse
-                if pychan.peakList is not None:
-                    if iseg not in self._peaksDict.keys():
-                        self._peaksDict[iseg]={}
-                    self._peaksDict[iseg][chanNum] = (pychan.startPosList,pychan.peakList)
+                if pychan.startPos is not None:
+                    if iseg not in self._peakArraysDict.keys():
+                        self._peakArraysDict[iseg]={}
+                    self._peakArraysDict[iseg][chanNum] = (pychan.startPos,pychan.length,
+                                                           pychan.offset,pychan.fex)
 
         # maybe check that we have all segments in the event?
         # FIXME: also check that we have all the channels we expect?
@@ -290,11 +353,34 @@ cdef class cyhsd_base_1_2_3:
         """
         if self._isNewEvt(evt):
             self._parseEvt(evt)
+        if self._peaksDict is None:
+            self._peaksDict = {}
+            for iseg, (chanNum, pychan) in self._pychansegs.items():
+                if pychan.startPos is not None:
+                    if iseg not in self._peaksDict.keys():
+                        self._peaksDict[iseg]={}
+                    self._peaksDict[iseg][chanNum] = (pychan.startPosList,pychan.peakList)
         if not self._peaksDict:
             return None
         else:
             return self._peaksDict
 
+    def peak_arrays(self, evt):
+        """Return a dictionary of the peaks found in the event, as arrays,
+        which is much faster than peaks() for many peaks.
+        0:    tuple (start, length, offset, fex) for channel 0, where peak i
+              of the waveform begins at sample start[i] and its intensities are
+              fex[offset[i]:offset[i]+length[i]]
+        ...
+        16:   tuple (start, length, offset, fex) for channel 16
+        """
+        if self._isNewEvt(evt):
+            self._parseEvt(evt)
+        if not self._peakArraysDict:
+            return None
+        else:
+            return self._peakArraysDict
+
     @cython.binding(True)
     def peak_times(self, evt) -> HSDPeakTimes:
         """Return a dictionary of available times of peaks found in the event.
@@ -300,7 +300,10 @@ public:
     std::memcpy(map, m_conmap, rows*cols*sizeof(conmap_t)); 
   }
 
-  void setAllocator(Allocator *allocator); // change allocator for each event
+  /// Changes the allocator, e.g. for each event.  The arrays of peaks
+  /// still refer to the previous one until they are refilled, so with
+  /// an Arena, alternate two of them rather than reset a single one.
+  void setAllocator(Allocator *allocator);
 
 private:
   size_t m_seg;      // segment index (for list of images)
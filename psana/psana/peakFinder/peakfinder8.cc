@@ -19,7 +19,12 @@
 #include <cmath>
 #include <cstring>
 #include <stdio.h>
+#include <stdint.h>
 #include <float.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PEAKFINDER8_X86
+#endif
 
 #include "peakfinder8.hh"
 
@@ -85,9 +90,11 @@ struct radial_stats
 struct peakfinder_intern_data
 {
 	char *pix_in_peak_map;
+	int own_map;           // 0 if pix_in_peak_map is shared between threads
 	int *infs;
 	int *inss;
 	int *peak_pixels;
+	uint64_t *row_sel;     // pixels above threshold in the row being searched
 };
 
 
@@ -105,19 +112,207 @@ struct peakfinder_peak_data
 };
 
 
-static void compute_num_radial_bins(int w, int h, float *r_map, float *max_r)
+// Per-pixel passes over the panel.  The radial bin of each pixel,
+// (int)rint(r_map[i]), is computed once per call instead of in every
+// pass.  Pixels are then selected against the per-bin thresholds with
+// AVX-512 or AVX2 where the cpu has them, but whatever is done with the
+// selected pixels is still done one at a time in pixel order, so that
+// the floating point sums, and therefore the peak lists, come out
+// bit-identical to the scalar code.
+
+// Bit i of sel is set if mask[i] != 0 && data[i] > above[rbin[i]],
+// and, if below is given, data[i] < below[rbin[i]]
+static void select_pixels_tail(const float *data, const int *rbin, const char *mask,
+                               const float *above, const float *below,
+                               int i, int n, uint64_t *sel)
 {
-	int ifs, iss;
-	int pidx;
+	for ( ; i<n ; i++ ) {
+		if ( mask[i] != 0
+		  && data[i] > above[rbin[i]]
+		  && (below == NULL || data[i] < below[rbin[i]]) ) {
+			sel[i/64] |= (uint64_t)1 << (i%64);
+		}
+	}
+}
 
-	for ( iss=0 ; iss<h ; iss++ ) {
-		for ( ifs=0 ; ifs<w ; ifs++ ) {
-			pidx = iss * w + ifs;
-			if ( r_map[pidx] > *max_r ) {
-				*max_r = r_map[pidx];
-			}
+
+static void select_pixels_scalar(const float *data, const int *rbin, const char *mask,
+                                 const float *above, const float *below,
+                                 int n, uint64_t *sel)
+{
+	memset(sel, 0, ((n+63)/64)*sizeof(uint64_t));
+	select_pixels_tail(data, rbin, mask, above, below, 0, n, sel);
+}
+
+
+static void radial_bins_scalar(const float *r_map, int i, int n, int *rbin, float *max_r)
+{
+	for ( ; i<n ; i++ ) {
+		if ( r_map[i] > *max_r ) {
+			*max_r = r_map[i];
+		}
+		rbin[i] = (int)rint(r_map[i]);
+	}
+}
+
+
+#ifdef PEAKFINDER8_X86
+// cvtps rounds to nearest even, like rint in the default rounding mode
+__attribute__((target("avx2")))
+static void radial_bins_avx2(const float *r_map, int n, int *rbin, float *max_r)
+{
+	__m256 vmax = _mm256_set1_ps(*max_r);
+	float lanes[8];
+	int i, k;
+
+	for ( i=0 ; i+8<=n ; i+=8 ) {
+		__m256 r = _mm256_loadu_ps(r_map+i);
+		vmax = _mm256_max_ps(r, vmax);
+		_mm256_storeu_si256((__m256i *)(rbin+i), _mm256_cvtps_epi32(r));
+	}
+	_mm256_storeu_ps(lanes, vmax);
+	for ( k=0 ; k<8 ; k++ ) {
+		if ( lanes[k] > *max_r ) *max_r = lanes[k];
+	}
+	radial_bins_scalar(r_map, i, n, rbin, max_r);
+}
+
+
+// the thresholds are only gathered for pixels in the mask, whose
+// radial bins are the only ones known to be in range
+__attribute__((target("avx2")))
+static void select_pixels_avx2(const float *data, const int *rbin, const char *mask,
+                               const float *above, const float *below,
+                               int n, uint64_t *sel)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	int i;
+
+	memset(sel, 0, ((n+63)/64)*sizeof(uint64_t));
+	for ( i=0 ; i+8<=n ; i+=8 ) {
+		__m256i m = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(mask+i)));
+		__m256 inmask = _mm256_castsi256_ps(_mm256_xor_si256(_mm256_cmpeq_epi32(m, zero),
+		                                                     _mm256_set1_epi32(-1)));
+		if ( _mm256_movemask_ps(inmask) == 0 ) continue;
+
+		__m256i idx = _mm256_loadu_si256((const __m256i *)(rbin+i));
+		__m256 v = _mm256_loadu_ps(data+i);
+		__m256 t = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), above, idx, inmask, 4);
+		__m256 ok = _mm256_and_ps(inmask, _mm256_cmp_ps(v, t, _CMP_GT_OQ));
+		if ( below != NULL ) {
+			t = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), below, idx, inmask, 4);
+			ok = _mm256_and_ps(ok, _mm256_cmp_ps(v, t, _CMP_LT_OQ));
+		}
+		sel[i/64] |= (uint64_t)_mm256_movemask_ps(ok) << (i%64);
+	}
+	select_pixels_tail(data, rbin, mask, above, below, i, n, sel);
+}
+
+
+__attribute__((target("avx512f")))
+static void radial_bins_avx512(const float *r_map, int n, int *rbin, float *max_r)
+{
+	__m512 vmax = _mm512_set1_ps(*max_r);
+	float lanes[16];
+	int i, k;
+
+	for ( i=0 ; i+16<=n ; i+=16 ) {
+		__m512 r = _mm512_loadu_ps(r_map+i);
+		vmax = _mm512_max_ps(r, vmax);
+		_mm512_storeu_si512((void *)(rbin+i), _mm512_cvtps_epi32(r));
+	}
+	_mm512_storeu_ps(lanes, vmax);
+	for ( k=0 ; k<16 ; k++ ) {
+		if ( lanes[k] > *max_r ) *max_r = lanes[k];
+	}
+	radial_bins_scalar(r_map, i, n, rbin, max_r);
+}
+
+
+__attribute__((target("avx512f")))
+static void select_pixels_avx512(const float *data, const int *rbin, const char *mask,
+                                 const float *above, const float *below,
+                                 int n, uint64_t *sel)
+{
+	int i;
+
+	memset(sel, 0, ((n+63)/64)*sizeof(uint64_t));
+	for ( i=0 ; i+16<=n ; i+=16 ) {
+		__m512i m = _mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i *)(mask+i)));
+		__mmask16 ok = _mm512_test_epi32_mask(m, m);
+		if ( ok == 0 ) continue;
+
+		__m512i idx = _mm512_loadu_si512((const void *)(rbin+i));
+		__m512 v = _mm512_loadu_ps(data+i);
+		__m512 t = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), ok, idx, above, 4);
+		ok = _mm512_mask_cmp_ps_mask(ok, v, t, _CMP_GT_OQ);
+		if ( below != NULL ) {
+			t = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), ok, idx, below, 4);
+			ok = _mm512_mask_cmp_ps_mask(ok, v, t, _CMP_LT_OQ);
+		}
+		sel[i/64] |= (uint64_t)ok << (i%64);
+	}
+	select_pixels_tail(data, rbin, mask, above, below, i, n, sel);
+}
+#endif
+
+
+struct pixel_kernels
+{
+	void (*radial_bins)(const float *r_map, int n, int *rbin, float *max_r);
+	void (*select_pixels)(const float *data, const int *rbin, const char *mask,
+	                      const float *above, const float *below,
+	                      int n, uint64_t *sel);
+};
+
+
+static void radial_bins_generic(const float *r_map, int n, int *rbin, float *max_r)
+{
+	radial_bins_scalar(r_map, 0, n, rbin, max_r);
+}
+
+
+static struct pixel_kernels choose_pixel_kernels()
+{
+	struct pixel_kernels k = { radial_bins_generic, select_pixels_scalar };
+#ifdef PEAKFINDER8_X86
+	if ( __builtin_cpu_supports("avx512f") ) {
+		k.radial_bins = radial_bins_avx512;
+		k.select_pixels = select_pixels_avx512;
+	} else if ( __builtin_cpu_supports("avx2") ) {
+		k.radial_bins = radial_bins_avx2;
+		k.select_pixels = select_pixels_avx2;
+	}
+#endif
+	return k;
+}
+
+
+static const struct pixel_kernels& cpu_pixel_kernels()
+{
+	static const struct pixel_kernels kernels = choose_pixel_kernels();
+	return kernels;
+}
+
+
+// index of the first pixel selected in sel at or after i, or n if none is
+static inline int next_selected(const uint64_t *sel, int i, int n)
+{
+	while ( i < n ) {
+		uint64_t bits = sel[i/64] >> (i%64);
+		if ( bits != 0 ) {
+			i += __builtin_ctzll(bits);
+			return i < n ? i : n;
 		}
+		i = (i/64 + 1) * 64;
 	}
+	return n;
+}
+
+
+static void compute_num_radial_bins(int num_pix, float *r_map, int *rbin, float *max_r)
+{
+	cpu_pixel_kernels().radial_bins(r_map, num_pix, rbin, max_r);
 }
 
 
@@ -187,32 +382,56 @@ static void free_radial_stats(struct radial_stats *rstats)
 }
 
 
+// With more than one thread the pixels are selected in slices of whole
+// words of sel, and each thread then sums the pixels of its own range of
+// radial bins, still in pixel order.
 static void fill_radial_bins(float *data,
-                             int w,
-                             int h,
-                             float *r_map,
+                             int num_pix,
+                             int *rbin,
                              char *mask,
                              float *rthreshold,
                              float *lthreshold,
                              float *roffset,
                              float *rsigma,
-                             int *rcount)
-{
-	int iss, ifs;
-	int pidx;
-
-	int curr_r;
-	float value;
-
-	for ( iss=0; iss<h ; iss++ ) {
-		for ( ifs=0; ifs<w ; ifs++ ) {
-			pidx = iss * w + ifs;
-			if ( mask[pidx] != 0 ) {
-				curr_r = (int)rint(r_map[pidx]);
-				value = data[pidx];
-				if ( value < rthreshold[curr_r]
-				  && value > lthreshold[curr_r] )
-				{
+                             int *rcount,
+                             int num_rad_bins,
+                             uint64_t *sel,
+                             int num_threads)
+{
+	int num_words;
+	int slice_words;
+	int it;
+
+	num_words = (num_pix+63)/64;
+	slice_words = (num_words+num_threads-1)/num_threads;
+
+	#pragma omp parallel num_threads(num_threads)
+	{
+		#pragma omp for schedule(static)
+		for ( it=0 ; it<num_threads ; it++ ) {
+			int begin = it*slice_words*64;
+			int end = begin + slice_words*64 < num_pix ? begin + slice_words*64 : num_pix;
+			if ( begin < end ) {
+				cpu_pixel_kernels().select_pixels(data+begin, rbin+begin, mask+begin,
+				                                  lthreshold, rthreshold,
+				                                  end-begin, sel+begin/64);
+			}
+		}
+
+		#pragma omp for schedule(static)
+		for ( it=0 ; it<num_threads ; it++ ) {
+			int first_r = (int)((long)num_rad_bins*it/num_threads);
+			int end_r = (int)((long)num_rad_bins*(it+1)/num_threads);
+			int iw;
+
+			for ( iw=0 ; iw<num_words ; iw++ ) {
+				uint64_t bits;
+				for ( bits=sel[iw] ; bits!=0 ; bits&=bits-1 ) {
+					int pidx = iw*64 + __builtin_ctzll(bits);
+					int curr_r = rbin[pidx];
+					float value;
+					if ( curr_r < first_r || curr_r >= end_r ) continue;
+					value = data[pidx];
 					roffset[curr_r] += value;
 					rsigma[curr_r] += (value * value);
 					rcount[curr_r] += 1;
@@ -267,21 +486,22 @@ static struct radial_stats *compute_radial_bins(float *data,
                                                 char *mask,
                                                 int num_pix,
                                                 float *r_map,
+                                                int *rbin,
                                                 int iterations,
                                                 float min_snr,
                                                 float acd_threshold,
-                                                int num_pix_fs,
-                                                int num_pix_ss)
+                                                int num_threads)
 {
 	float max_r;
 	int it_counter;
 	int i;
 	int num_rad_bins;
 	struct radial_stats *rstats;
+	uint64_t *sel;
 
 	max_r = -1e9;
 
-	compute_num_radial_bins(num_pix_fs, num_pix_ss, r_map, &max_r);
+	compute_num_radial_bins(num_pix, r_map, rbin, &max_r);
 
 	num_rad_bins = (int)ceil(max_r) + 1;
 
@@ -291,6 +511,12 @@ static struct radial_stats *compute_radial_bins(float *data,
 		return NULL;
 	}
 
+	sel = (uint64_t *)malloc(((num_pix+63)/64)*sizeof(uint64_t));
+	if ( sel == NULL ) {
+		free_radial_stats(rstats);
+		return NULL;
+	}
+
 	for ( i=0; i<num_rad_bins; i++ ) {
 		rstats->rthreshold[i] = 1e9;
 		rstats->lthreshold[i] = -1e9;
@@ -308,15 +534,17 @@ static struct radial_stats *compute_radial_bins(float *data,
 		}
 
 		fill_radial_bins(data,
-                         num_pix_fs,
-                         num_pix_ss,
-		                 r_map,
+		                 num_pix,
+		                 rbin,
 		                 mask,
 		                 rstats->rthreshold,
 		                 rstats->lthreshold,
 		                 rstats->roffset,
 		                 rstats->rsigma,
-		                 rstats->rcount);
+		                 rstats->rcount,
+		                 num_rad_bins,
+		                 sel,
+		                 num_threads);
 
 		compute_radial_stats(rstats->rthreshold,
 		                     rstats->lthreshold,
@@ -328,6 +556,7 @@ static struct radial_stats *compute_radial_bins(float *data,
 		                     acd_threshold);
 
 	}
+	free(sel);
 	return rstats;
 }
 
@@ -435,43 +664,44 @@ static void free_peak_data(struct peakfinder_peak_data *pkdata) {
 }
 
 
+// With pix_in_peak_map NULL, data_size is the size of the whole panel and
+// the map is allocated here.  Otherwise the map is the panel's, shared with
+// the other threads, and data_size only needs to cover the pixels of one ASIC.
 static struct peakfinder_intern_data *allocate_peakfinder_intern_data(int data_size,
-                                                                      int max_pix_count)
+                                                                      int row_size,
+                                                                      int max_pix_count,
+                                                                      char *pix_in_peak_map)
 {
 
 	struct peakfinder_intern_data *intern_data;
 
-	intern_data = (struct peakfinder_intern_data *)malloc(sizeof(struct peakfinder_intern_data));
+	intern_data = (struct peakfinder_intern_data *)calloc(1, sizeof(struct peakfinder_intern_data));
 	if ( intern_data == NULL ) {
 		return NULL;
 	}
 
-	intern_data->pix_in_peak_map =(char *)calloc(data_size, sizeof(char));
-	if ( intern_data->pix_in_peak_map == NULL ) {
-		free(intern_data);
-		return NULL;
+	if ( pix_in_peak_map == NULL ) {
+		intern_data->pix_in_peak_map =(char *)calloc(data_size, sizeof(char));
+		intern_data->own_map = 1;
+	} else {
+		intern_data->pix_in_peak_map = pix_in_peak_map;
+		intern_data->own_map = 0;
 	}
-
 	intern_data->infs =(int *)calloc(data_size, sizeof(int));
-	if ( intern_data->infs == NULL ) {
-		free(intern_data->pix_in_peak_map);
-		free(intern_data);
-		return NULL;
-	}
-
 	intern_data->inss =(int *)calloc(data_size, sizeof(int));
-	if ( intern_data->inss == NULL ) {
-		free(intern_data->pix_in_peak_map);
-		free(intern_data->infs);
-		free(intern_data);
-		return NULL;
-	}
-
 	intern_data->peak_pixels =(int *)calloc(max_pix_count, sizeof(int));
-	if ( intern_data->peak_pixels == NULL ) {
-		free(intern_data->pix_in_peak_map);
+	intern_data->row_sel =(uint64_t *)calloc((row_size+63)/64, sizeof(uint64_t));
+
+	if ( intern_data->pix_in_peak_map == NULL
+	  || intern_data->infs == NULL
+	  || intern_data->inss == NULL
+	  || intern_data->peak_pixels == NULL
+	  || intern_data->row_sel == NULL ) {
+		if ( intern_data->own_map ) free(intern_data->pix_in_peak_map);
 		free(intern_data->infs);
 		free(intern_data->inss);
+		free(intern_data->peak_pixels);
+		free(intern_data->row_sel);
 		free(intern_data);
 		return NULL;
 	}
@@ -483,9 +713,10 @@ static struct peakfinder_intern_data *allocate_peakfinder_intern_data(int data_s
 static void free_peakfinder_intern_data(struct peakfinder_intern_data *pfid)
 {
 	free(pfid->peak_pixels);
-	free(pfid->pix_in_peak_map);
+	if ( pfid->own_map ) free(pfid->pix_in_peak_map);
 	free(pfid->infs);
 	free(pfid->inss);
+	free(pfid->row_sel);
 	free(pfid);
 }
 
@@ -493,7 +724,7 @@ static void free_peakfinder_intern_data(struct peakfinder_intern_data *pfid)
 
 static void peak_search(int p,
                         struct peakfinder_intern_data *pfinter,
-                        float *copy, char *mask, float *r_map,
+                        float *copy, char *mask, int *rbin,
                         float *rthreshold, float *roffset,
                         int *num_pix_in_peak, int asic_size_fs,
                         int asic_size_ss, int aifs, int aiss,
@@ -525,7 +756,7 @@ static void peak_search(int p,
 		curr_ss = pfinter->inss[p] + search_ss[k] + aiss * asic_size_ss;
 		pi = curr_fs + curr_ss * num_pix_fs;
 
-		curr_radius = (int)rint(r_map[pi]);
+		curr_radius = rbin[pi];
 		curr_threshold = rthreshold[curr_radius];
 
 		// Above threshold?
@@ -551,7 +782,7 @@ static void peak_search(int p,
 
 
 static void search_in_ring(int ring_width, int com_fs_int, int com_ss_int,
-                           float *copy, float *r_map,
+                           float *copy, int *rbin,
                            float *rthreshold, float *roffset,
                            char *pix_in_peak_map, char *mask, int asic_size_fs,
                            int asic_size_ss, int aifs, int aiss,
@@ -601,7 +832,7 @@ static void search_in_ring(int ring_width, int com_fs_int, int com_ss_int,
 			curr_ss = com_ss_int + ssj + aiss * asic_size_ss;
 			pi = curr_fs + curr_ss * num_pix_fs;
 
-			curr_radius = (int)rint(r_map[pi]);
+			curr_radius = rbin[pi];
 			curr_threshold = rthreshold[curr_radius];
 
 			// Intensity above background ??? just intensity?
@@ -632,7 +863,7 @@ static void search_in_ring(int ring_width, int com_fs_int, int com_ss_int,
 			*local_sigma = 0.01;
 		}
 	} else {
-		local_radius = (int)rint(r_map[(int)rint(com_idx)]);
+		local_radius = rbin[com_idx];
 		*local_offset = roffset[local_radius];
 		*local_sigma = 0.01;
 	}
@@ -643,7 +874,7 @@ static void process_panel(int asic_size_fs, int asic_size_ss, int num_pix_fs,
                           int aiss, int aifs, float *rthreshold,
                           float *roffset, int *peak_count,
                           float *copy, struct peakfinder_intern_data *pfinter,
-                          float *r_map, char *mask, int *npix, float *com_fs,
+                          int *rbin, char *mask, int *npix, float *com_fs,
                           float *com_ss, int *com_index, float *tot_i,
                           float *max_i, float *sigma, float *snr,
                           int min_pix_count, int max_pix_count,
@@ -651,24 +882,27 @@ static void process_panel(int asic_size_fs, int asic_size_ss, int num_pix_fs,
 {
 	int pxss, pxfs;
 	int num_pix_in_peak;
+	int row;
 
 	// Loop over pixels within a module
 	for ( pxss=1 ; pxss<asic_size_ss-1 ; pxss++ ) {
-		for ( pxfs=1 ; pxfs<asic_size_fs-1 ; pxfs++ ) {
 
-			float curr_thresh;
-			int pxidx;
-			int curr_rad;
+		// Pixels above threshold in this row of the module.  Whether
+		// they are in a peak yet can change while the row is searched.
+		row = (pxss + aiss * asic_size_ss) * num_pix_fs + aifs * asic_size_fs;
+		cpu_pixel_kernels().select_pixels(copy+row, rbin+row, mask+row,
+		                                  rthreshold, NULL, asic_size_fs,
+		                                  pfinter->row_sel);
 
-			pxidx = (pxss + aiss * asic_size_ss) * num_pix_fs +
-			pxfs + aifs * asic_size_fs;
+		for ( pxfs = next_selected(pfinter->row_sel, 1, asic_size_fs-1) ;
+		      pxfs < asic_size_fs-1 ;
+		      pxfs = next_selected(pfinter->row_sel, pxfs+1, asic_size_fs-1) ) {
 
-			curr_rad = (int)rint(r_map[pxidx]);
-			curr_thresh = rthreshold[curr_rad];
+			int pxidx;
 
-			if ( copy[pxidx] > curr_thresh
-			  && pfinter->pix_in_peak_map[pxidx] == 0
-			  && mask[pxidx] != 0 ) {   //??? not sure if needed
+			pxidx = row + pxfs;
+
+			if ( pfinter->pix_in_peak_map[pxidx] == 0 ) {
 
 				// This might be the start of a new peak - start searching
 				float sum_com_fs, sum_com_ss;
@@ -699,11 +933,14 @@ static void process_panel(int asic_size_fs, int asic_size_ss, int num_pix_fs,
 				do {
 					lt_num_pix_in_pk = num_pix_in_peak;
 
-					// Loop through points known to be within this peak
-					for ( p=0; p<=num_pix_in_peak; p++ ) { //changed from 1 to 0 by O.Y.
+					// Loop through points known to be within this peak.  The
+					// seed at 0 is searched before it has counted itself in;
+					// past that, slot num_pix_in_peak is left over from an
+					// earlier peak (maybe in another ASIC) and not searched.
+					for ( p=0; p<num_pix_in_peak || p==0; p++ ) { //changed from 1 to 0 by O.Y.
 						peak_search(p,
 						            pfinter, copy, mask,
-						            r_map,
+						            rbin,
 						            rthreshold,
 						            roffset,
 						            &num_pix_in_peak,
@@ -744,7 +981,7 @@ static void process_panel(int asic_size_fs, int asic_size_ss, int num_pix_fs,
 
 				search_in_ring(ring_width, peak_com_fs_int,
 				               peak_com_ss_int,
-				               copy, r_map, rthreshold,
+				               copy, rbin, rthreshold,
 				               roffset,
 				               pfinter->pix_in_peak_map,
 				               mask, asic_size_fs,
@@ -859,8 +1096,106 @@ static void process_panel(int asic_size_fs, int asic_size_ss, int num_pix_fs,
 }
 
 
+// Peaks never extend past the edges of an ASIC, so the ASICs can be
+// searched in parallel.  Each keeps its own list of peaks, and the lists
+// are then appended in the order the serial loop would have found them.
+static int process_panels_parallel(int num_threads,
+                                   float *roffset, float *rthreshold,
+                                   float *data, char *mask, int *rbin,
+                                   int asic_size_fs, int num_asics_fs,
+                                   int asic_size_ss, int num_asics_ss,
+                                   int max_n_peaks, int *peak_count,
+                                   int *npix, float *com_fs,
+                                   float *com_ss, int *com_index, float *tot_i,
+                                   float *max_i, float *sigma, float *snr,
+                                   int min_pix_count, int max_pix_count,
+                                   int local_bg_radius, float min_snr,
+                                   char *pix_in_peak_map)
+{
+	int num_pix_fs;
+	int num_asics;
+	int ai, pki;
+	int failed;
+	struct peakfinder_peak_data **asic_peaks;
+	int *asic_count;
+
+	num_pix_fs = asic_size_fs * num_asics_fs;
+	num_asics = num_asics_fs * num_asics_ss;
+
+	asic_peaks = (struct peakfinder_peak_data **)calloc(num_asics, sizeof(struct peakfinder_peak_data *));
+	asic_count = (int *)calloc(num_asics, sizeof(int));
+	if ( asic_peaks == NULL || asic_count == NULL ) {
+		free(asic_peaks);
+		free(asic_count);
+		return 1;
+	}
+
+	failed = 0;
+
+	#pragma omp parallel num_threads(num_threads)
+	{
+		struct peakfinder_intern_data *pfinter;
+		pfinter = allocate_peakfinder_intern_data(asic_size_fs * asic_size_ss,
+		                                          asic_size_fs, max_pix_count,
+		                                          pix_in_peak_map);
+
+		#pragma omp for schedule(dynamic)
+		for ( ai=0 ; ai<num_asics ; ai++ ) {
+			struct peakfinder_peak_data *pkdata;
+			pkdata = allocate_peak_data(max_n_peaks > 0 ? max_n_peaks : 1);
+			asic_peaks[ai] = pkdata;
+			if ( pfinter == NULL || pkdata == NULL ) {
+				#pragma omp atomic write
+				failed = 1;
+				continue;
+			}
+			process_panel(asic_size_fs, asic_size_ss, num_pix_fs,
+			              ai / num_asics_fs, ai % num_asics_fs,
+			              rthreshold, roffset,
+			              &asic_count[ai], data, pfinter, rbin, mask,
+			              pkdata->npix, pkdata->com_fs, pkdata->com_ss,
+			              pkdata->com_index, pkdata->tot_i,
+			              pkdata->max_i, pkdata->sigma, pkdata->snr,
+			              min_pix_count, max_pix_count,
+			              local_bg_radius, min_snr, max_n_peaks);
+		}
+
+		if ( pfinter != NULL ) {
+			free_peakfinder_intern_data(pfinter);
+		}
+	}
+
+	for ( ai=0 ; ai<num_asics ; ai++ ) {
+		struct peakfinder_peak_data *pkdata = asic_peaks[ai];
+		if ( pkdata == NULL ) continue;
+		if ( !failed ) {
+			for ( pki=0 ;
+			      pki<asic_count[ai] && *peak_count+pki<max_n_peaks ;
+			      pki++ ) {
+				int pidx = *peak_count + pki;
+				npix[pidx] = pkdata->npix[pki];
+				com_fs[pidx] = pkdata->com_fs[pki];
+				com_ss[pidx] = pkdata->com_ss[pki];
+				com_index[pidx] = pkdata->com_index[pki];
+				tot_i[pidx] = pkdata->tot_i[pki];
+				max_i[pidx] = pkdata->max_i[pki];
+				sigma[pidx] = pkdata->sigma[pki];
+				snr[pidx] = pkdata->snr[pki];
+			}
+			*peak_count += asic_count[ai];
+		}
+		free_peak_data(pkdata);
+	}
+
+	free(asic_peaks);
+	free(asic_count);
+
+	return failed;
+}
+
+
 static int peakfinder8_base(float *roffset, float *rthreshold,
-                            float *data, char *mask, float *r_map,
+                            float *data, char *mask, int *rbin,
                             int asic_size_fs, int num_asics_fs,
                             int asic_size_ss, int num_asics_ss,
                             int max_n_peaks, int *num_found_peaks,
@@ -869,7 +1204,7 @@ static int peakfinder8_base(float *roffset, float *rthreshold,
                             float *max_i, float *sigma, float *snr,
                             int min_pix_count, int max_pix_count,
                             int local_bg_radius, float min_snr,
-                            char* outliersMask)
+                            char* outliersMask, int num_threads)
 {
 
 	int num_pix_fs, num_pix_ss, num_pix_tot;
@@ -881,23 +1216,38 @@ static int peakfinder8_base(float *roffset, float *rthreshold,
 	num_pix_ss = asic_size_ss * num_asics_ss;
 	num_pix_tot = num_pix_fs * num_pix_ss;
 
-	pfinter = allocate_peakfinder_intern_data(num_pix_tot, max_pix_count);
+	pfinter = allocate_peakfinder_intern_data(num_pix_tot, asic_size_fs, max_pix_count, NULL);
 	if ( pfinter == NULL ) {
 		return 1;
 	}
 
 	peak_count = 0;
 
-	// Loop over modules (nxn array)
-	for ( aiss=0 ; aiss<num_asics_ss ; aiss++ ) {
-		for ( aifs=0 ; aifs<num_asics_fs ; aifs++ ) {                 // ??? to change to proper panels need
-			process_panel(asic_size_fs, asic_size_ss, num_pix_fs, // change copy, mask, r_map
-			              aiss, aifs, rthreshold, roffset,
-			              &peak_count, data, pfinter, r_map, mask,
-			              npix, com_fs, com_ss, com_index, tot_i,
-			              max_i, sigma, snr, min_pix_count,
-			              max_pix_count, local_bg_radius, min_snr,
-			              max_n_peaks);
+	if ( num_threads > 1 && num_asics_fs * num_asics_ss > 1 ) {
+		if ( process_panels_parallel(num_threads, roffset, rthreshold,
+		                             data, mask, rbin,
+		                             asic_size_fs, num_asics_fs,
+		                             asic_size_ss, num_asics_ss,
+		                             max_n_peaks, &peak_count,
+		                             npix, com_fs, com_ss, com_index, tot_i,
+		                             max_i, sigma, snr, min_pix_count,
+		                             max_pix_count, local_bg_radius, min_snr,
+		                             pfinter->pix_in_peak_map) != 0 ) {
+			free_peakfinder_intern_data(pfinter);
+			return 1;
+		}
+	} else {
+		// Loop over modules (nxn array)
+		for ( aiss=0 ; aiss<num_asics_ss ; aiss++ ) {
+			for ( aifs=0 ; aifs<num_asics_fs ; aifs++ ) {                 // ??? to change to proper panels need
+				process_panel(asic_size_fs, asic_size_ss, num_pix_fs, // change copy, mask, r_map
+				              aiss, aifs, rthreshold, roffset,
+				              &peak_count, data, pfinter, rbin, mask,
+				              npix, com_fs, com_ss, com_index, tot_i,
+				              max_i, sigma, snr, min_pix_count,
+				              max_pix_count, local_bg_radius, min_snr,
+				              max_n_peaks);
+			}
 		}
 	}
 	*num_found_peaks = peak_count;
@@ -919,7 +1269,8 @@ int peakfinder8(tPeakList *peaklist, float *data, char *mask, float *pix_r,
                 long asic_nx, long asic_ny, long nasics_x, long nasics_y,
                 float ADCthresh, float hitfinderMinSNR,
                 long hitfinderMinPixCount, long hitfinderMaxPixCount,
-                long hitfinderLocalBGRadius, char* outliersMask)
+                long hitfinderLocalBGRadius, char* outliersMask,
+                int num_threads)
 {
 	struct radial_stats *rstats;
 	struct peakfinder_peak_data *pkdata;
@@ -931,23 +1282,42 @@ int peakfinder8(tPeakList *peaklist, float *data, char *mask, float *pix_r,
 	int ret;
 	int pki;
 	int peaks_to_add;
+	int *rbin;
 
 	max_num_peaks = peaklist->nPeaks_max;
 
+#ifndef _OPENMP
+	num_threads = 1;	// built without OpenMP
+#endif
+	if ( num_threads < 1 ) {
+		num_threads = 1;
+	}
+
 	// Derived values
 	num_pix_fs = asic_nx * nasics_x;
 	num_pix_ss = asic_ny * nasics_y;
 	num_pix_tot = num_pix_fs * num_pix_ss;
 
+	// Radial bin of every pixel
+	rbin = (int *)malloc(num_pix_tot*sizeof(int));
+	if ( rbin == NULL ) {
+		return 1;
+	}
+
 	// Compute radial statistics as 1 function (O.Y.)
 	iterations = 5;
-	rstats = compute_radial_bins(data, mask, num_pix_tot, pix_r,
+	rstats = compute_radial_bins(data, mask, num_pix_tot, pix_r, rbin,
 	                             iterations, hitfinderMinSNR, ADCthresh,
-	                             num_pix_fs, num_pix_ss);
+	                             num_threads);
+	if ( rstats == NULL ) {
+		free(rbin);
+		return 1;
+	}
 
 	pkdata = allocate_peak_data(max_num_peaks);
 	if ( pkdata == NULL ) {
 		free_radial_stats(rstats);
+		free(rbin);
 		return 1;
 	}
 
@@ -957,7 +1327,7 @@ int peakfinder8(tPeakList *peaklist, float *data, char *mask, float *pix_r,
 	                       rstats->rthreshold,
 	                       data,
 	                       mask,
-	                       pix_r,
+	                       rbin,
 	                       asic_nx, nasics_x,
 	                       asic_ny, nasics_y,
 	                       max_num_peaks  ,
@@ -974,11 +1344,13 @@ int peakfinder8(tPeakList *peaklist, float *data, char *mask, float *pix_r,
 	                       hitfinderMaxPixCount,
 	                       hitfinderLocalBGRadius,
 	                       hitfinderMinSNR,
-	                       outliersMask);
+	                       outliersMask,
+	                       num_threads);
 
 	if ( ret != 0 ) {
 		free_radial_stats(rstats);
 		free_peak_data(pkdata);
+		free(rbin);
 		return 1;
 	}
 
@@ -1004,5 +1376,6 @@ int peakfinder8(tPeakList *peaklist, float *data, char *mask, float *pix_r,
 
 	free_radial_stats(rstats);
 	free_peak_data(pkdata);
+	free(rbin);
 	return 0;
 }
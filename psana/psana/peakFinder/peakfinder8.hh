@@ -52,6 +52,7 @@ int peakfinder8(tPeakList *peaklist, float *data, char *mask, float *pix_r,
                 long asic_nx, long asic_ny, long nasics_x, long nasics_y,
                 float ADCthresh, float hitfinderMinSNR,
 				long hitfinderMinPixCount, long hitfinderMaxPixCount,
-				long hitfinderLocalBGRadius, char* outliersMask);
+				long hitfinderLocalBGRadius, char* outliersMask,
+				int num_threads = 1);	// > 1 searches the ASICs in parallel
 
 #endif // PEAKFINDER8_H
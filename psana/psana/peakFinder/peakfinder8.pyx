@@ -58,14 +58,15 @@ cdef extern from "peakfinder8.hh":
                     long asic_nx, long asic_ny, long nasics_x, long nasics_y,
                     float ADCthresh, float hitfinderMinSNR,
                     long hitfinderMinPixCount, long hitfinderMaxPixCount,
-                    long hitfinderLocalBGRadius, char *outliersMask)
+                    long hitfinderLocalBGRadius, char *outliersMask,
+                    int num_threads)
 
 
 def peakfinder_8(int max_num_peaks, float[:,::1] data, char[:,::1] mask,
                  float[:,::1] pix_r, long asic_nx, long asic_ny, long nasics_x,
                  long nasics_y, float adc_thresh, float hitfinder_min_snr,
                  long hitfinder_min_pix_count, long hitfinder_max_pix_count,
-                 long hitfinder_local_bg_radius):
+                 long hitfinder_local_bg_radius, int num_threads=1):
     # The peakfinder8 algorithm isdescribed in the following publication:
     #
     #     A. Barty, R. A. Kirian, F. R. N. C. Maia, M. Hantke, C. H. Yoon, T. A. White,
@@ -110,13 +111,16 @@ def peakfinder_8(int max_num_peaks, float[:,::1] data, char[:,::1] mask,
     #
     # hitfinder_local_bg_radius: the radius (in pixels) for the estimation of the local
     #           background.
+    #
+    # num_threads: the number of threads to search the ASICs with. The peaks found
+    #           are the same, in the same order, for any number of threads.
     cdef tPeakList peak_list
     allocatePeakList(&peak_list, max_num_peaks)
 
     peakfinder8(&peak_list, &data[0, 0], &mask[0,0], &pix_r[0, 0], asic_nx, asic_ny,
                 nasics_x, nasics_y, adc_thresh, hitfinder_min_snr,
                 hitfinder_min_pix_count, hitfinder_max_pix_count,
-                hitfinder_local_bg_radius, NULL)
+                hitfinder_local_bg_radius, NULL, num_threads)
 
     cdef int i
     cdef float peak_x, peak_y, peak_value
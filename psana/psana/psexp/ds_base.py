@@ -37,6 +37,7 @@ class DsParms:
     timestamps:         np.ndarray
     intg_det:           str
     smd_callback:       int = 0
+    lazy_dgram:         bool = False
     terminate_flag:     bool = False
 
     def set_det_class_table(self, det_classes, xtc_info, det_info_table, det_stream_id_table):
@@ -90,6 +91,7 @@ class DataSourceBase(abc.ABC):
         self.intg_det  = ''          # integrating detector name (contains marker ts for a batch)
         self.current_retry_no = 0    # global counting var for no. of read attemps
         self.smd_callback= 0
+        self.lazy_dgram  = False     # only build a detector's dgram attributes when it is used
 
         if kwargs is not None:
             self.smalldata_kwargs = {}
@@ -113,6 +115,7 @@ class DataSourceBase(abc.ABC):
                     'dbsuffix',
                     'intg_det',
                     'smd_callback',
+                    'lazy_dgram',
                     )
 
             for k in keywords:
@@ -161,6 +164,7 @@ class DataSourceBase(abc.ABC):
                 self.timestamps,
                 self.intg_det,
                 self.smd_callback,
+                self.lazy_dgram,
                 )
 
         if 'mpi_ts' not in kwargs:
@@ -33,7 +33,7 @@ class EventManager(object):
     """
     def __init__(self, view, smd_configs, dm, esm, 
             filter_fn=0, prometheus_counter=None, 
-            max_retries=0, use_smds=[]):
+            max_retries=0, use_smds=[], lazy_dgram=False):
         if view:
             pf = PacketFooter(view=view)
             self.n_events = pf.n_packets
@@ -48,6 +48,7 @@ class EventManager(object):
         self.prometheus_counter = prometheus_counter
         self.max_retries = max_retries
         self.use_smds = use_smds
+        self.lazy_dgram = lazy_dgram
         self.smd_view = view
         self.i_evt = 0
         self.exit_id = ExitId.NoError
@@ -95,9 +96,13 @@ class EventManager(object):
 
         self.bd_offset_array[i_evt, i_smd] = d.smdinfo[0].offsetAlg.intOffset
         self.bd_size_array[i_evt, i_smd] = d.smdinfo[0].offsetAlg.intDgramSize 
+        # Striped recordings spread L1Accepts over several bigdata files
+        stripe = getattr(d.smdinfo[0].offsetAlg, 'intStripe', 0)
+        self.bd_stripe_array[i_evt, i_smd] = stripe
         
         # Check continuous chunk 
         if current_bd_offsets[i_smd] == self.bd_offset_array[i_evt, i_smd]  \
+                and self.current_bd_stripes[i_smd] == stripe                \
                 and i_evt != i_first_L1                                     \
                 and current_bd_chunk_sizes[i_smd] + self.bd_size_array[i_evt, i_smd] < self.BD_CHUNKSIZE:
             self.cutoff_flag_array[i_evt, i_smd] = 0
@@ -106,6 +111,7 @@ class EventManager(object):
             current_bd_chunk_sizes[i_smd] = self.bd_size_array[i_evt, i_smd]
 
         current_bd_offsets[i_smd] = self.bd_offset_array[i_evt, i_smd] + self.bd_size_array[i_evt, i_smd]
+        self.current_bd_stripes[i_smd] = stripe
         
     @s_bd_gen_smd_batch.time()
     def _get_offset_and_size(self):
@@ -124,6 +130,7 @@ class EventManager(object):
         # Row - events, col = smd files
         self.bd_offset_array    = np.zeros((smd_chunk_pf.n_packets, self.n_smd_files), dtype=dtype) 
         self.bd_size_array      = np.zeros((smd_chunk_pf.n_packets, self.n_smd_files), dtype=dtype)
+        self.bd_stripe_array    = np.zeros((smd_chunk_pf.n_packets, self.n_smd_files), dtype=dtype)
         self.smd_offset_array   = np.zeros((smd_chunk_pf.n_packets, self.n_smd_files), dtype=dtype)
         self.smd_size_array     = np.zeros((smd_chunk_pf.n_packets, self.n_smd_files), dtype=dtype)
         self.new_chunk_id_array = np.zeros((smd_chunk_pf.n_packets, self.n_smd_files), dtype=dtype)
@@ -132,6 +139,7 @@ class EventManager(object):
         smd_aux_sizes           = np.zeros(self.n_smd_files, dtype=dtype)
         # For comparing if the next dgram should be in the same read
         current_bd_offsets      = np.zeros(self.n_smd_files, dtype=dtype) 
+        self.current_bd_stripes = np.zeros(self.n_smd_files, dtype=dtype)
         # Current chunk size (gets reset at boundary)
         current_bd_chunk_sizes  = np.zeros(self.n_smd_files, dtype=dtype) 
         i_evt = 0
@@ -148,7 +156,8 @@ class EventManager(object):
             if smd_aux_sizes[i_smd] == 0:
                 self.cutoff_flag_array[i_evt, i_smd] = 0
             else:
-                d = dgram.Dgram(config=self.smd_configs[i_smd], view=self.smd_view, offset=offset)
+                # Only a few attributes of these are looked at here
+                d = dgram.Dgram(config=self.smd_configs[i_smd], view=self.smd_view, offset=offset, lazy=1)
                 
                 self.smd_offset_array[i_evt, i_smd] = offset
                 self.smd_size_array[i_evt, i_smd]   = d._size
@@ -190,7 +199,27 @@ class EventManager(object):
         for i_smd in range(self.n_smd_files):
             self.cutoff_indices.append(np.where(self.cutoff_flag_array[:, i_smd] == 1)[0])
 
+    def _get_bd_fd(self, i_smd, stripe):
+        """ Returns the fd of the bigdata file holding the given stripe.
+        Stripe n > 0 of chunk file <name>.xtc2 is <name>-iNN.xtc2, opened
+        on first use.
+        """
+        if stripe == 0:
+            return self.dm.fds[i_smd]
+        fd = self.dm.stripe_fds.get((i_smd, stripe))
+        if fd is None:
+            filename = self.dm.xtc_files[i_smd]
+            filename = filename[:-len('.xtc2')] + f'-i{stripe:02d}.xtc2'
+            fd = os.open(filename, os.O_RDONLY)
+            self.dm.stripe_fds[(i_smd, stripe)] = fd
+        return fd
+
+    def _close_stripe_fds(self, i_smd):
+        for key in [key for key in self.dm.stripe_fds if key[0] == i_smd]:
+            os.close(self.dm.stripe_fds.pop(key))
+
     def _open_new_bd_file(self, i_smd, new_chunk_id):
+        self._close_stripe_fds(i_smd)
         os.close(self.dm.fds[i_smd])
         xtc_dir = os.path.dirname(self.dm.xtc_files[i_smd])
         new_filename = os.path.join(xtc_dir, self.chunkinfo[(i_smd, new_chunk_id)])
@@ -242,7 +271,7 @@ class EventManager(object):
             offset += got
             size -= got
             
-            print(f'Warning: bigdata read retry#{i_retry}/{self.max_retries} fd:{fd} {self.dm.fds_map[fd]} ask={size} offset={offset} got={got}') 
+            print(f'Warning: bigdata read retry#{i_retry}/{self.max_retries} fd:{fd} {self.dm.fds_map.get(fd, "")} ask={size} offset={offset} got={got}') 
 
             time.sleep(1)
         
@@ -290,7 +319,8 @@ class EventManager(object):
         else:
             i_next_evt_cutoff = cutoff_indices[self.chunk_indices[i_smd] + 1]
             read_size = np.sum(self.bd_size_array[i_evt_cutoff:i_next_evt_cutoff, i_smd])
-        self.bd_bufs[i_smd] = self._read(self.dm.fds[i_smd], read_size, begin_chunk_offset)
+        fd = self._get_bd_fd(i_smd, self.bd_stripe_array[i_evt_cutoff, i_smd])
+        self.bd_bufs[i_smd] = self._read(fd, read_size, begin_chunk_offset)
 
     def _get_next_evt(self):
         """ Generate bd evt for different cases:
@@ -337,7 +367,8 @@ class EventManager(object):
                 self.bd_buf_offsets[i_smd] += size
             
             if size > 0:  # handles missing dgram
-                dgrams[i_smd] = dgram.Dgram(config=self.dm.configs[i_smd], view=view, offset=offset)
+                dgrams[i_smd] = dgram.Dgram(config=self.dm.configs[i_smd], view=view, offset=offset,
+                        lazy=int(self.lazy_dgram))
 
         self.i_evt += 1
         self._inc_prometheus_counter('evts')
@@ -41,6 +41,7 @@ class Events:
                             prometheus_counter  = self.c_read,
                             max_retries         = self.ds.dsparms.max_retries,
                             use_smds            = self.ds.dsparms.use_smds,
+                            lazy_dgram          = self.ds.dsparms.lazy_dgram,
                             )
                     return self.__next__()
                 except StopIteration:
@@ -66,6 +67,7 @@ class Events:
                         prometheus_counter  = self.c_read,
                         max_retries         = self.ds.dsparms.max_retries,
                         use_smds            = self.ds.dsparms.use_smds,
+                        lazy_dgram          = self.ds.dsparms.lazy_dgram,
                         )
                 evt = next(self._evt_man)
                 if not any(evt._dgrams): return self.__next__()
@@ -33,11 +33,34 @@ class TestDgramInit:
                 raised = True
             assert raised
 
+    def testLazyAttributes(self):
+        """ lazy dgrams make the same attributes as eager ones, on demand """
+        dir_path = os.path.dirname(os.path.realpath(__file__))
+        full_path = os.path.join(dir_path, "test_hsd.xtc2")
+        fd = os.open(full_path, os.O_RDONLY)
+        config = dgram.Dgram(file_descriptor=fd)
+        detnames = list(config.software.__dict__)
+        n_dgrams = 0
+        while True:
+            try:
+                d = dgram.Dgram(config=config)
+            except StopIteration:
+                break
+            lazy_d = dgram.Dgram(config=config, view=d._dgrambytes, lazy=1)
+            for detname in detnames:
+                assert hasattr(d, detname) == hasattr(lazy_d, detname)
+            assert not hasattr(lazy_d, "nosuchdet")
+            assert sorted(d.__dict__) == sorted(lazy_d.__dict__)
+            n_dgrams += 1
+        os.close(fd)
+        assert n_dgrams > 0
+
 def run():
     test = TestDgramInit()
     test.testInvalidEmptyDgram()
     test.testInvalidFileDescriptor()
     test.testInvalidSequentialRead() 
+    test.testLazyAttributes()
 
 if __name__ == "__main__":
     run()
@@ -0,0 +1,55 @@
+import numpy as np
+
+from psana.peakfinder8 import peakfinder_8
+
+#------------------------------
+
+ASIC_NX, ASIC_NY, NASICS_X, NASICS_Y = 32, 32, 4, 2
+
+def pixel(data, asic, fs, ss, value):
+    data[(asic // NASICS_X) * ASIC_NY + ss, (asic % NASICS_X) * ASIC_NX + fs] += value
+
+def find_peaks(data, num_threads):
+    mask = np.ones(data.shape, dtype=np.int8)
+    y, x = np.indices(data.shape)
+    pix_r = np.hypot(x - data.shape[1] / 2, y - data.shape[0] / 2).astype(np.float32)
+    return peakfinder_8(100, data, mask, pix_r, ASIC_NX, ASIC_NY, NASICS_X, NASICS_Y,
+                        100, 3, 1, 50, 3, num_threads)
+
+def panels():
+    """A 5x5 peak in the first ASIC, then in every other ASIC a 2 pixel and a
+    3 pixel peak, the second next to where the third pixel of the first ASIC's
+    peak was.  Left over pixel coordinates would merge the two.
+    """
+    rng = np.random.RandomState(1)
+    data = (10 * rng.random_sample((ASIC_NY * NASICS_Y, ASIC_NX * NASICS_X))).astype(np.float32)
+    for ss in range(10, 15):
+        for fs in range(10, 15):
+            pixel(data, 0, fs, ss, 1000)
+    for asic in range(1, NASICS_X * NASICS_Y):
+        pixel(data, asic, 2, 2, 800)
+        pixel(data, asic, 3, 2, 800)
+        for fs in range(11, 14):
+            pixel(data, asic, fs, 11, 800)
+    return data
+
+#------------------------------
+
+def test_peakfinder8_serial():
+    peaks = find_peaks(panels(), 1)
+    npix = peaks[4]
+    assert list(npix) == [25] + [2, 3] * (NASICS_X * NASICS_Y - 1)
+
+def test_peakfinder8_threads():
+    data = panels()
+    serial = find_peaks(data, 1)
+    # Which ASICs a thread gets varies from call to call, so try a few times
+    for num_threads in (2, 4, 8):
+        for _ in range(10):
+            assert find_peaks(data, num_threads) == serial
+
+#------------------------------
+
+if __name__ == "__main__":
+    test_peakfinder8_serial()
+    test_peakfinder8_threads()
@@ -182,8 +182,8 @@ if 'PEAKFINDER' in BUILD_LIST :
                              "psana/peakFinder/peakfinder8.cc"],
                     libraries = ['utils'], # for SysLog
                     language="c++",
-                    extra_compile_args = extra_cxx_compile_args,
-                    extra_link_args = extra_link_args_rpath,
+                    extra_compile_args = extra_cxx_compile_args + openmp_compile_args,
+                    extra_link_args = extra_link_args_rpath + openmp_link_args,
                     include_dirs=[np.get_include(), os.path.join(instdir, 'include')],
                     library_dirs = [os.path.join(instdir, 'lib')],
     )
@@ -14,6 +14,9 @@
 #include <numpy/arrayobject.h>
 #include <numpy/ndarraytypes.h>
 #include <structmember.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
 
 using namespace XtcData;
 #define TMPSTRINGSIZE 1024
@@ -33,6 +36,36 @@ struct ContainerInfo {
     PyObject* pycontainertype;
 };
 
+// The part of the attribute tree that is the same for every dgram
+// of a configuration, built once from the config's Names: for each
+// NamesId the interned python names along the path to each Name,
+// e.g. {"raw","value"} under detName[segment].  Events then don't
+// have to re-format and re-parse "detname.alg.name" for every value.
+struct NamesSkeleton {
+    std::string detName;
+    PyObject* pyDetName;
+    PyObject* pySegment;
+    std::vector<std::vector<PyObject*> > paths; // indexed like the Names
+};
+typedef std::unordered_map<unsigned,NamesSkeleton> ConfigSkeleton;
+
+struct PyDgramObject;
+
+// For a dgram created with lazy=1, the ShapesData of each detector are
+// only located when the dgram is created.  Their python objects are made
+// the first time the detector's attribute is looked up (or the whole
+// __dict__ is asked for), so events where only a few of many detectors
+// are looked at don't pay for building all the others.
+struct LazyDetector {
+    std::string detName;
+    std::vector<ShapesData*> shapesdata;
+};
+
+struct LazyDgram {
+    PyDgramObject* config;  // holds a reference: its NamesLookup is used later
+    std::vector<LazyDetector> pending; // in xtc order
+};
+
 struct PyDgramObject {
     PyObject_HEAD
     PyObject* dict;
@@ -43,6 +76,8 @@ struct PyDgramObject {
     Py_buffer buf;
     ContainerInfo contInfo;
     NamesIter* namesIter;   // only nonzero in the config dgram
+    ConfigSkeleton* skeleton; // only nonzero in the config dgram
+    LazyDgram* lazy;        // only nonzero while lazy attributes are pending
     ssize_t size;           // size of dgram - for allocating dgram of any size
     int max_retries;        // set no. of retries when reading data (default=0)
 };
@@ -138,24 +173,49 @@ static void setXtc(PyObject* parent, PyObject* pycontainertype, Xtc* myXtc) {
     Py_DECREF(pyDamage);
 }
 
-// add _xtc to each segment of det_name dictionary object
-static void setXtcForSegment(PyObject* parent, PyObject* pycontainertype,
-        const char* detName, unsigned segment, Xtc* myXtc) {
-    PyObject* dict;
-    dict = PyObject_GetAttrString(parent, detName);
+// same as addObjHierarchy, but with the path already split up in the
+// config's skeleton.  the first time a segment's container is made its
+// _xtc is added as well.  the dgram's own attributes are looked up
+// generically so that a lazy dgram doesn't come back into lazyResolve.
+static void addObjSkeleton(PyObject* parent, PyObject* pycontainertype,
+                           NamesSkeleton& skel, std::vector<PyObject*>& path,
+                           PyObject* obj, Xtc* myXtc) {
+    PyObject* dict = PyObject_GenericGetAttr(parent, skel.pyDetName);
+    if (!dict) {
+        PyErr_Clear();
+        dict = PyDict_New();
+        int fail = PyObject_GenericSetAttr(parent, skel.pyDetName, dict);
+        if (fail) printf("Dgram: failed to set container attribute\n");
+    }
     Py_DECREF(dict); // transfer ownership to parent
 
-    // get segment container for this segment
-    PyObject* pySeg = Py_BuildValue("i", segment);
-    PyObject* container;
-    container = PyDict_GetItem(dict, pySeg);
-    Py_DECREF(pySeg);
+    bool newSegment = false;
+    PyObject* container = PyDict_GetItem(dict, skel.pySegment);
+    if (!container) {
+        container = PyObject_CallObject(pycontainertype, NULL);
+        PyDict_SetItem(dict, skel.pySegment, container);
+        Py_DECREF(container); // transfer ownership to parent
+        newSegment = true;
+    }
 
-    const char* xtcLabel = "_xtc";
-    int hasXtcLabel = PyObject_HasAttrString(container, xtcLabel);
-    if (hasXtcLabel == 1) return;
+    PyObject* node = container;
+    unsigned last = path.size()-1;
+    for (unsigned i = 0; i < last; i++) {
+        PyObject* child = PyObject_GetAttr(node, path[i]);
+        if (!child) {
+            PyErr_Clear();
+            child = PyObject_CallObject(pycontainertype, NULL);
+            int fail = PyObject_SetAttr(node, path[i], child);
+            if (fail) printf("addObj: failed to set container attribute\n");
+        }
+        Py_DECREF(child); // transfer ownership to parent
+        node = child;
+    }
+    int fail = PyObject_SetAttr(node, path[last], obj);
+    if (fail) printf("addObj: failed to set object attribute\n");
+    Py_DECREF(obj); // transfer ownership to parent
 
-    setXtc(container, pycontainertype, myXtc);
+    if (newSegment) setXtc(container, pycontainertype, myXtc);
 }
 
 static void setAlg(PyObject* parent, PyObject* pycontainertype, const char* baseName, Alg& alg, unsigned segment) {
@@ -204,6 +264,53 @@ static void setDetInfo(PyObject* parent, PyObject* pycontainertype, Names& names
     addObjHierarchy(parent, pycontainertype, keyName, detId, segment);
 }
 
+static void buildSkeleton(PyDgramObject* configDgram, NamesLookup& namesLookup)
+{
+    char tempName[TMPSTRINGSIZE];
+    ConfigSkeleton* skeleton = new ConfigSkeleton;
+    configDgram->skeleton = skeleton;
+
+    for (auto & namesPair : namesLookup) {
+        NameIndex& nameIndex = namesPair.second;
+        if (!nameIndex.exists()) continue;
+        Names& names = nameIndex.names();
+        NamesSkeleton& skel = (*skeleton)[namesPair.first];
+        skel.detName = names.detName();
+        skel.pyDetName = PyUnicode_InternFromString(names.detName());
+        skel.pySegment = Py_BuildValue("i", names.segment());
+        skel.paths.resize(names.num());
+
+        unsigned algLen = strlen(names.alg().name());
+        for (unsigned i = 0; i < names.num(); i++) {
+            Name& name = names.get(i);
+            snprintf(tempName,sizeof(tempName),"%s%s%s",
+                     names.alg().name(),PyNameDelim,name.name());
+            if (name.type() == Name::ENUMVAL) {
+                // overwrite the delimiter with the null character
+                // so the value's python name doesn't include the dict
+                // name (which follows the EnumDelim).
+                char* delim = strchr(tempName+algLen,EnumDelim);
+                if (!delim) throw std::runtime_error("dgram.cc: failed to find delimitor in enum");
+                *delim = '\0';
+            }
+            for (char* key = ::strtok(tempName,PyNameDelim); key; key = ::strtok(NULL,PyNameDelim))
+                skel.paths[i].push_back(PyUnicode_InternFromString(key));
+        }
+    }
+}
+
+static void freeSkeleton(ConfigSkeleton* skeleton)
+{
+    for (auto & skelPair : *skeleton) {
+        NamesSkeleton& skel = skelPair.second;
+        Py_XDECREF(skel.pyDetName);
+        Py_XDECREF(skel.pySegment);
+        for (auto & path : skel.paths)
+            for (PyObject* key : path) Py_XDECREF(key);
+    }
+    delete skeleton;
+}
+
 static void dictAssignConfig(PyDgramObject* pyDgram, NamesLookup& namesLookup)
 {
     // This function gets called at configure: add attributes "software" and "version" to pyDgram and return
@@ -291,13 +398,11 @@ static PyObject* createEnum(const char* enumname, PyDgramObject* pyDgram, DescDa
     return parent;
 }
 
-static void dictAssign(PyDgramObject* pyDgram, DescData& descdata, Xtc* myXtc)
+static void dictAssign(PyDgramObject* pyDgram, DescData& descdata, Xtc* myXtc,
+                       NamesSkeleton& skel)
 {
     Names& names = descdata.nameindex().names();
 
-
-    char keyName[2*TMPSTRINGSIZE];
-    char tempName[TMPSTRINGSIZE];
     for (unsigned i = 0; i < names.num(); i++) {
         Name& name = names.get(i);
         const char* varName = name.name();
@@ -368,18 +473,8 @@ static void dictAssign(PyDgramObject* pyDgram, DescData& descdata, Xtc* myXtc)
                 break;
             }
             case Name::ENUMVAL: {
+                // the skeleton's path leaves out the enum dict name
                 newobj = createEnum(varName, pyDgram, descdata);
-
-                // overwrite the delimiter with the null character
-                // so the value's python name doesn't include the dict
-                // name (which follows the EnumDelim).
-                strncpy(tempName,varName,TMPSTRINGSIZE-1);
-                char* delim = strchr(tempName,EnumDelim);
-                if (!delim) throw std::runtime_error("dgram.cc: failed to find delimitor in enum");
-
-                *delim = '\0';
-                // tell the object adder to use our modified name
-                varName = tempName;
                 break;
             }
             default: {
@@ -469,21 +564,60 @@ static void dictAssign(PyDgramObject* pyDgram, DescData& descdata, Xtc* myXtc)
             PyArray_CLEARFLAGS((PyArrayObject*)newobj, NPY_ARRAY_WRITEABLE);
         }
         if (newobj) {
-            snprintf(keyName,sizeof(keyName),"%s%s%s%s%s",
-                     names.detName(),PyNameDelim,names.alg().name(),
-                     PyNameDelim,varName);
-            addObjHierarchy((PyObject*)pyDgram, pyDgram->contInfo.pycontainertype, keyName, newobj, names.segment());
-            setXtcForSegment((PyObject*)pyDgram, pyDgram->contInfo.pycontainertype, names.detName(), names.segment(), myXtc);
+            addObjSkeleton((PyObject*)pyDgram, pyDgram->contInfo.pycontainertype,
+                           skel, skel.paths[i], newobj, myXtc);
+        }
+    }
+}
+
+static void lazyAdd(LazyDgram* lazy, const std::string& detName, ShapesData& shapesdata)
+{
+    for (auto & det : lazy->pending) {
+        if (det.detName == detName) {
+            det.shapesdata.push_back(&shapesdata);
+            return;
         }
     }
+    lazy->pending.push_back(LazyDetector{detName, {&shapesdata}});
+}
+
+static void lazyRelease(PyDgramObject* self)
+{
+    Py_DECREF((PyObject*)self->lazy->config);
+    delete self->lazy;
+    self->lazy = 0;
+}
+
+// make the python objects of the pending detector called name,
+// or of all of them if name is 0
+static void lazyResolve(PyDgramObject* self, const char* name)
+{
+    PyDgramObject* config = self->lazy->config;
+    NamesLookup& namesLookup = config->namesIter->namesLookup();
+    bool done = true;
+    for (auto & det : self->lazy->pending) {
+        if (name && det.detName != name) {
+            done &= det.shapesdata.empty();
+            continue;
+        }
+        std::vector<ShapesData*> shapesdatas;
+        shapesdatas.swap(det.shapesdata); // whatever happens, only try once
+        for (ShapesData* shapesdata : shapesdatas) {
+            NamesId namesId = shapesdata->namesId();
+            DescData descdata(*shapesdata, namesLookup[namesId]);
+            dictAssign(self, descdata, (Xtc*)shapesdata, (*config->skeleton)[namesId]);
+        }
+    }
+    if (done) lazyRelease(self);
 }
 
 class PyConvertIter : public XtcIterator
 {
 public:
     enum { Stop, Continue };
-    PyConvertIter(Xtc* xtc, const void* bufEnd, PyDgramObject* pyDgram, NamesLookup& namesLookup) :
-        XtcIterator(xtc, bufEnd), _pyDgram(pyDgram), _namesLookup(namesLookup)
+    PyConvertIter(Xtc* xtc, const void* bufEnd, PyDgramObject* pyDgram, NamesLookup& namesLookup,
+                  ConfigSkeleton& skeleton) :
+        XtcIterator(xtc, bufEnd), _pyDgram(pyDgram), _namesLookup(namesLookup), _skeleton(skeleton)
     {
     }
 
@@ -503,8 +637,12 @@ public:
             // should be fatal, since it is a sign the xtc is "corrupted",
             // in some sense.
             if (_namesLookup.count(namesId)>0) {
-                DescData descdata(shapesdata, _namesLookup[namesId]);
-                dictAssign(_pyDgram, descdata, xtc);
+                if (_pyDgram->lazy) {
+                    lazyAdd(_pyDgram->lazy, _skeleton[namesId].detName, shapesdata);
+                } else {
+                    DescData descdata(shapesdata, _namesLookup[namesId]);
+                    dictAssign(_pyDgram, descdata, xtc, _skeleton[namesId]);
+                }
             } else {
                 printf("*** Corrupt xtc: namesid 0x%x not found in NamesLookup\n",(int)namesId);
                 throw "invalid namesid";
@@ -520,6 +658,7 @@ public:
 private:
     PyDgramObject* _pyDgram;
     NamesLookup&      _namesLookup;
+    ConfigSkeleton&   _skeleton;
 };
 
 static void assignDict(PyDgramObject* self, PyDgramObject* configDgram) {
@@ -534,21 +673,27 @@ static void assignDict(PyDgramObject* self, PyDgramObject* configDgram) {
         configDgram->namesIter = new NamesIter(&(configDgram->dgram->xtc), configEnd);
         configDgram->namesIter->iterate();
 
+        buildSkeleton(configDgram, configDgram->namesIter->namesLookup());
         dictAssignConfig(configDgram, configDgram->namesIter->namesLookup());
     } else {
         self->namesIter = 0; // in case dgram was not created via dgram_init
+        self->skeleton = 0;
     }
 
     auto size = sizeof(Dgram) + self->dgram->xtc.sizeofPayload();
     const void* bufEnd = (char*)(self->dgram) + size;
-    PyConvertIter iter(&self->dgram->xtc, bufEnd, self, configDgram->namesIter->namesLookup());
+    PyConvertIter iter(&self->dgram->xtc, bufEnd, self, configDgram->namesIter->namesLookup(),
+                       *configDgram->skeleton);
     iter.iterate();
+    if (self->lazy && self->lazy->pending.empty()) lazyRelease(self);
 }
 
 static void dgram_dealloc(PyDgramObject* self)
 {
     Py_XDECREF(self->dict);
     if (self->namesIter) delete self->namesIter; // for config dgram only
+    if (self->skeleton) freeSkeleton(self->skeleton); // for config dgram only
+    if (self->lazy) lazyRelease(self);
     if (self->buf.buf == NULL) {
         // can be NULL if we had a problem early in dgram_init
         //Py_XDECREF(self->dgrambytes);
@@ -654,9 +799,12 @@ static int dgram_init(PyDgramObject* self, PyObject* args, PyObject* kwds)
                              (char*)"fake_endrun_sec",
                              (char*)"fake_endrun_usec",
                              (char*)"max_retries",
+                             (char*)"lazy",
                              NULL};
 
     self->namesIter = 0;
+    self->skeleton = 0;
+    self->lazy = 0;
     int fd=-1;
     PyObject* configDgram=0;
     self->offset=0;
@@ -667,9 +815,10 @@ static int dgram_init(PyDgramObject* self, PyObject* args, PyObject* kwds)
     unsigned fake_endrun_sec=0;
     unsigned fake_endrun_usec=0;
     self->max_retries=0;
+    int lazy=0;
 
     if (!PyArg_ParseTupleAndKeywords(args, kwds,
-                                     "|iOllOiIIi", kwlist,
+                                     "|iOllOiIIii", kwlist,
                                      &fd,
                                      &configDgram,
                                      &self->offset,
@@ -678,7 +827,8 @@ static int dgram_init(PyDgramObject* self, PyObject* args, PyObject* kwds)
                                      &fake_endrun,
                                      &fake_endrun_sec,
                                      &fake_endrun_usec,
-                                     &self->max_retries)) {
+                                     &self->max_retries,
+                                     &lazy)) {
         return -1;
     }
 
@@ -804,6 +954,14 @@ static int dgram_init(PyDgramObject* self, PyObject* args, PyObject* kwds)
         configDgram = 0;
     }
 
+    // with lazy=1, a data dgram only makes its detectors' python
+    // objects when they are looked up (see dgram_getattro)
+    if (lazy && configDgram) {
+        self->lazy = new LazyDgram;
+        self->lazy->config = (PyDgramObject*)configDgram;
+        Py_INCREF(configDgram);
+    }
+
     assignDict(self, (PyDgramObject*)configDgram);
 
     // Add top level xtc container and its attributes
@@ -867,6 +1025,25 @@ static PyBufferProcs PyDgramObject_as_buffer = {
     (releasebufferproc)0, // no special release required
 };
 
+static PyObject* dgram_getattro(PyDgramObject* self, PyObject* name)
+{
+    if (self->lazy) {
+        const char* key = PyUnicode_AsUTF8(name);
+        if (key == NULL) return NULL;
+        try {
+            // asking for the whole dictionary needs every detector
+            lazyResolve(self, strcmp(key, "__dict__")==0 ? 0 : key);
+        } catch (const std::exception& e) {
+            PyErr_SetString(PyExc_RuntimeError, e.what());
+            return NULL;
+        } catch (const char* s) {
+            PyErr_SetString(PyExc_RuntimeError, s);
+            return NULL;
+        }
+    }
+    return PyObject_GenericGetAttr((PyObject*)self, name);
+}
+
 static PyMemberDef dgram_members[] = {
     { (char*)"__dict__",
       T_OBJECT_EX, offsetof(PyDgramObject, dict),
@@ -915,7 +1092,7 @@ static PyTypeObject dgram_DgramType = {
     0, /* tp_hash */
     0, /* tp_call */
     0, /* tp_str */
-    0, /* tp_getattro */
+    (getattrofunc)dgram_getattro, /* tp_getattro */
     0, /* tp_setattro */
     &PyDgramObject_as_buffer, /* tp_as_buffer */
     (Py_TPFLAGS_DEFAULT
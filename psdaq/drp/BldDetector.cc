@@ -371,7 +371,7 @@ Bld::Bld(unsigned mcaddr,
          uint64_t timestampCorr) :
   m_timestampPos(timestampPos), m_pulseIdPos(pulseIdPos),
   m_headerSize(headerSize), m_payloadSize(payloadSize),
-  m_bufferSize(0), m_position(0),  m_buffer(Bld::MTU), m_payload(m_buffer.data()),
+  m_bufferSize(0), m_position(0), m_buffer(nullptr), m_payload(nullptr), m_polled(false),
   m_timestampCorr(timestampCorr), m_pulseId(0), m_pulseIdJump(0)
 {
     logging::info("Bld listening for %x.%d with payload size %u",mcaddr,port,payloadSize);
@@ -405,6 +405,8 @@ Bld::Bld(unsigned mcaddr,
     if (setsockopt(m_sockfd, IPPROTO_IP, IP_ADD_MEMBERSHIP,
                    &ipmreq, sizeof(ipmreq)) == -1)
         HANDLE_ERR("mcast join");
+
+    m_ring = std::make_unique<BldRing>(m_sockfd, RingDepth, Bld::MTU);
 }
 
 Bld::Bld(const Bld& o) :
@@ -412,7 +414,13 @@ Bld::Bld(const Bld& o) :
     m_pulseIdPos  (o.m_pulseIdPos),
     m_headerSize  (o.m_headerSize),
     m_payloadSize (o.m_payloadSize),
-    m_sockfd      (o.m_sockfd)
+    m_sockfd      (o.m_sockfd),
+    m_bufferSize  (0),
+    m_position    (0),
+    m_ring        (std::make_unique<BldRing>(o.m_sockfd, RingDepth, Bld::MTU)),
+    m_buffer      (nullptr),
+    m_payload     (nullptr),
+    m_polled      (false)
 {
     logging::error("Bld copy ctor called");
 }
@@ -452,11 +460,8 @@ void     Bld::clear(uint64_t ts)
     while(1) {
         // get new multicast if buffer is empty
         if ((m_position + m_payloadSize + 4) > m_bufferSize) {
-            ssize_t bytes = recv(m_sockfd, m_buffer.data(), Bld::MTU, MSG_DONTWAIT);
-            if (bytes <= 0)
+            if (!nextPacket(true))      // Read ahead even when polled
                 break;
-            //printf("*** 1 pos %u,  pay %u, bufSz %d, bytes %zd\n", m_position, m_payloadSize, m_bufferSize, bytes);
-            m_bufferSize = bytes;
             timestamp    = headerTimestamp();
             if (timestamp >= ts) {
                 m_position = 0;
@@ -479,11 +484,11 @@ void     Bld::clear(uint64_t ts)
             m_position   = m_headerSize + m_payloadSize;
         }
         else {
-            uint32_t timestampOffset = *reinterpret_cast<uint32_t*>(m_buffer.data() + m_position)&0xfffff;
+            uint32_t timestampOffset = *reinterpret_cast<uint32_t*>(m_buffer + m_position)&0xfffff;
             timestamp   = headerTimestamp() + timestampOffset;
             if (timestamp >= ts)
                 break;
-            uint32_t pulseIdOffset   = (*reinterpret_cast<uint32_t*>(m_buffer.data() + m_position)>>20)&0xfff;
+            uint32_t pulseIdOffset   = (*reinterpret_cast<uint32_t*>(m_buffer + m_position)>>20)&0xfff;
             pulseId     = headerPulseId  () + pulseIdOffset;
             m_payload   = &m_buffer[m_position + 4];
             m_position += 4 + m_payloadSize;
@@ -498,6 +503,21 @@ void     Bld::clear(uint64_t ts)
     }
 }
 
+//  Move on to the next packet in the ring, receiving more into it first if
+//  it has run dry and we may.  The previous packet is kept if there is none.
+bool Bld::nextPacket(bool receive)
+{
+    const BldRing::Packet* packet = m_ring->next();
+    if (!packet && receive && m_ring->receive() > 0)
+        packet = m_ring->next();
+    if (!packet)
+        return false;
+
+    m_buffer     = packet->data;
+    m_bufferSize = packet->size;
+    return true;
+}
+
 //  Advance to the next event
 uint64_t Bld::next()
 {
@@ -505,12 +525,8 @@ uint64_t Bld::next()
     uint64_t pulseId  (0L);
     // get new multicast if buffer is empty
     if ((m_position + m_payloadSize + 4) > m_bufferSize) {
-        ssize_t bytes = recv(m_sockfd, m_buffer.data(), Bld::MTU, MSG_DONTWAIT);
-        if (bytes <= 0)
-            return timestamp; // Check only for EWOULDBLOCK and EAGAIN?
-        //printf("*** 2 pos %u,  pay %u, bufSz %d, bytes %zd\n", m_position, m_payloadSize, m_bufferSize, bytes);
-        // To do: Handle partial reads?
-        m_bufferSize = bytes;
+        if (!nextPacket(!m_polled))
+            return timestamp;
         timestamp    = headerTimestamp();
         pulseId      = headerPulseId  ();
         m_payload    = &m_buffer[m_headerSize];
@@ -527,9 +543,9 @@ uint64_t Bld::next()
         //printf("*** 2b pid %014lx\n", pulseId);
     }
     else {
-        uint32_t timestampOffset = *reinterpret_cast<uint32_t*>(m_buffer.data() + m_position)&0xfffff;
+        uint32_t timestampOffset = *reinterpret_cast<uint32_t*>(m_buffer + m_position)&0xfffff;
         timestamp   = headerTimestamp() + timestampOffset;
-        uint32_t pulseIdOffset   = (*reinterpret_cast<uint32_t*>(m_buffer.data() + m_position)>>20)&0xfff;
+        uint32_t pulseIdOffset   = (*reinterpret_cast<uint32_t*>(m_buffer + m_position)>>20)&0xfff;
         pulseId     = headerPulseId  () + pulseIdOffset;
         m_payload   = &m_buffer[m_position + 4];
         m_position += 4 + m_payloadSize;
@@ -745,6 +761,32 @@ void Pgp::worker(std::shared_ptr<Pds::MetricExporter> exporter)
     for(unsigned i=0; i<bldPva.size(); i++)
         m_config.push_back(std::make_shared<BldFactory>(*bldPva[i].get()));
 
+    //
+    //  Drain all the multicast groups with one epoll loop, many packets per
+    //  recvmmsg() call, and count drops and delays per source
+    //
+    BldReceiver receiver;
+    bool timestamping = m_para.kwargs["bld_timestamps"] == "yes";
+    for(unsigned i=0; i<m_config.size(); i++) {
+        Bld&     bld  = m_config[i]->handler();
+        BldRing& ring = bld.ring();
+        if (timestamping)
+            ring.timestamping();
+        if (receiver.add(ring) == 0)
+            bld.polled();
+        std::string n(std::to_string(i));
+        exporter->add("bld_rx_pkts"+n, labels, Pds::MetricType::Counter,
+                      [&ring](){return ring.packets();});
+        exporter->add("bld_rx_drops"+n, labels, Pds::MetricType::Counter,
+                      [&ring](){return ring.drops();});
+        exporter->add("bld_ring_full"+n, labels, Pds::MetricType::Counter,
+                      [&ring](){return ring.fullCnt();});
+        exporter->add("bld_rx_calls"+n, labels, Pds::MetricType::Counter,
+                      [&ring](){return ring.syscalls();});
+        ring.latency(exporter->latency("bld_rx_latQ"+n, labels)); // ns, kernel to worker
+    }
+    receiver.poll(0);
+
     uint64_t nextId = -1UL;
     uint64_t timestamp[m_config.size()];
     memset(timestamp,0,sizeof(timestamp));
@@ -858,6 +900,7 @@ void Pgp::worker(std::shared_ptr<Pds::MetricExporter> exporter)
         }
 
         if (!lHold) {
+            receiver.poll(0);
             nextId++;
             for(unsigned i=0; i<m_config.size(); i++) {
                 if (dgram)
@@ -1247,9 +1290,14 @@ int main(int argc, char* argv[])
         if (kwargs.first == "pebbleBufSize")  continue;  // DrpBase
         if (kwargs.first == "pebbleBufCount") continue;  // DrpBase
         if (kwargs.first == "batching")       continue;  // DrpBase
+        if (kwargs.first == "result_fanout")  continue;  // DrpBase
         if (kwargs.first == "directIO")       continue;  // DrpBase
+        if (kwargs.first == "writeQueueDepth") continue;  // DrpBase
+        if (kwargs.first == "stripeDirs")  continue;  // DrpBase
+        if (kwargs.first == "xtcIndex")       continue;  // DrpBase
         if (kwargs.first == "pva_addr")       continue;  // DrpBase
         if (kwargs.first == "interface")      continue;
+        if (kwargs.first == "bld_timestamps") continue;
         logging::critical("Unrecognized kwarg '%s=%s'\n",
                           kwargs.first.c_str(), kwargs.second.c_str());
         return 1;
@@ -5,6 +5,7 @@
 #include <string>
 #include "DrpBase.hh"
 #include "XpmDetector.hh"
+#include "BldReceiver.hh"
 #include "psdaq/service/Collection.hh"
 #include "psdaq/service/fast_monotonic_clock.hh"
 #include "psdaq/epicstools/PVBase.hh"
@@ -32,6 +33,7 @@ public:
     ~Bld();
 public:
     static const unsigned MTU = 9000;
+    static const unsigned RingDepth = 256;  // Packets buffered per source
     static const unsigned TimestampPos      =  0; // LCLS-II style
     static const unsigned PulseIdPos        =  8; // LCLS-II style
     static const unsigned HeaderSize        = 20;
@@ -45,9 +47,13 @@ public:
     uint8_t* payload    () const { return m_payload; }
     unsigned payloadSize() const { return m_payloadSize; }
     unsigned fd         () const { return m_sockfd; }
+    BldRing& ring       ()       { return *m_ring; }
+    // Once polled by a BldReceiver, next() only takes what it has received
+    void     polled     ()       { m_polled = true; }
 private:
-    uint64_t headerTimestamp  () const {return *reinterpret_cast<const uint64_t*>(m_buffer.data()+m_timestampPos) - m_timestampCorr;}
-    uint64_t headerPulseId    () const {return *reinterpret_cast<const uint64_t*>(m_buffer.data()+m_pulseIdPos);}
+    bool     nextPacket (bool receive);
+    uint64_t headerTimestamp  () const {return *reinterpret_cast<const uint64_t*>(m_buffer+m_timestampPos) - m_timestampCorr;}
+    uint64_t headerPulseId    () const {return *reinterpret_cast<const uint64_t*>(m_buffer+m_pulseIdPos);}
     int      m_timestampPos;
     int      m_pulseIdPos;
     int      m_headerSize;
@@ -55,8 +61,10 @@ private:
     int      m_sockfd;
     int      m_bufferSize;
     int      m_position;
-    std::vector<uint8_t> m_buffer;
+    std::unique_ptr<BldRing> m_ring;
+    uint8_t* m_buffer;                  // The packet being parsed, in m_ring
     uint8_t* m_payload;
+    bool     m_polled;
     uint64_t m_timestampCorr;
     uint64_t m_pulseId;
     unsigned m_pulseIdJump;
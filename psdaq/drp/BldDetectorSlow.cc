@@ -1202,7 +1202,11 @@ int main(int argc, char* argv[])
         if (kwargs.first == "pebbleBufSize")  continue;  // DrpBase
         if (kwargs.first == "pebbleBufCount") continue;  // DrpBase
         if (kwargs.first == "batching")       continue;  // DrpBase
+        if (kwargs.first == "result_fanout")  continue;  // DrpBase
         if (kwargs.first == "directIO")       continue;  // DrpBase
+        if (kwargs.first == "writeQueueDepth") continue;  // DrpBase
+        if (kwargs.first == "stripeDirs")  continue;  // DrpBase
+        if (kwargs.first == "xtcIndex")       continue;  // DrpBase
         if (kwargs.first == "pva_addr")       continue;  // DrpBase
         if (kwargs.first == "interface")      continue;
         if (kwargs.first == "timeout")        continue;
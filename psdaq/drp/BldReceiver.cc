@@ -0,0 +1,198 @@
+#include "BldReceiver.hh"
+
+#include <algorithm>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/net_tstamp.h>
+#include "psdaq/service/LatencyHistogram.hh"
+#include "psalg/utils/SysLog.hh"
+
+using logging = psalg::SysLog;
+
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+
+namespace {
+    // As struct scm_timestamping in linux/errqueue.h: software, (legacy),
+    // raw hardware
+    struct Timestamping { timespec ts[3]; };
+
+    // Room for a timestamp and a drop count
+    const size_t ControlSize = CMSG_SPACE(sizeof(Timestamping)) + CMSG_SPACE(sizeof(uint32_t));
+
+    // Kept within what the kernel handles in one go
+    const unsigned MaxBatch = 64;
+
+    uint64_t nsNow()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+}
+
+namespace Drp {
+
+BldRing::BldRing(int fd, unsigned depth, unsigned mtu) :
+    m_fd(fd), m_depth(depth), m_mtu(mtu),
+    m_head(0), m_tail(0), m_held(false), m_timestamps(false),
+    m_buffer(size_t(depth) * mtu),
+    m_control(depth * ControlSize),
+    m_msgs(depth),
+    m_iovs(depth),
+    m_packet(depth),
+    m_packets(0), m_drops(0), m_fullCnt(0), m_syscalls(0)
+{
+    for (unsigned i = 0; i < depth; ++i) {
+        m_iovs[i].iov_base = &m_buffer[size_t(i) * mtu];
+        m_iovs[i].iov_len  = mtu;
+        m_packet[i].data   = &m_buffer[size_t(i) * mtu];
+    }
+
+    // Have the kernel report its drop count for the socket with each packet
+    int y = 1;
+    if (setsockopt(m_fd, SOL_SOCKET, SO_RXQ_OVFL, &y, sizeof(y)) == -1)
+        logging::warning("BldRing: SO_RXQ_OVFL not supported: %m");
+}
+
+BldRing::~BldRing()
+{
+}
+
+int BldRing::timestamping()
+{
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == -1) {
+        logging::warning("BldRing: SO_TIMESTAMPING not supported: %m");
+        return -1;
+    }
+    m_timestamps = true;
+    return 0;
+}
+
+int BldRing::receive()
+{
+    unsigned avail = m_depth - unsigned(m_tail - m_head);
+    if (avail == 0) {
+        ++m_fullCnt;
+        return 0;
+    }
+
+    // One call fills the free slots up to the end of the ring; the slots at
+    // its start are left for the next call
+    unsigned first = m_tail % m_depth;
+    unsigned count = std::min(std::min(avail, m_depth - first), MaxBatch);
+    for (unsigned i = first; i < first + count; ++i) {
+        msghdr& hdr        = m_msgs[i].msg_hdr;
+        hdr.msg_name       = nullptr;
+        hdr.msg_namelen    = 0;
+        hdr.msg_iov        = &m_iovs[i];
+        hdr.msg_iovlen     = 1;
+        hdr.msg_control    = &m_control[i * ControlSize];
+        hdr.msg_controllen = ControlSize;   // Updated by the kernel
+        hdr.msg_flags      = 0;
+    }
+
+    ++m_syscalls;
+    int n = recvmmsg(m_fd, &m_msgs[first], count, MSG_DONTWAIT, nullptr);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return 0;
+        logging::error("BldRing: recvmmsg failed: %m");
+        return -1;
+    }
+
+    uint64_t now = nsNow();
+    for (int i = 0; i < n; ++i)
+        _parse(first + i, m_msgs[first + i], now);
+    m_tail    += n;
+    m_packets += n;
+    return n;
+}
+
+void BldRing::_parse(unsigned slot, const mmsghdr& msg, uint64_t now)
+{
+    Packet& packet = m_packet[slot];
+    packet.size    = msg.msg_len;
+    packet.rxTime  = now;
+
+    msghdr* hdr = const_cast<msghdr*>(&msg.msg_hdr);
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(hdr); cmsg; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET)  continue;
+        if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+            m_drops = *reinterpret_cast<const uint32_t*>(CMSG_DATA(cmsg)); // Running total
+        }
+        else if (cmsg->cmsg_type == SO_TIMESTAMPING && m_timestamps) {
+            const Timestamping& ts = *reinterpret_cast<const Timestamping*>(CMSG_DATA(cmsg));
+            if (ts.ts[0].tv_sec)
+                packet.rxTime = uint64_t(ts.ts[0].tv_sec) * 1000000000ull + ts.ts[0].tv_nsec;
+        }
+    }
+}
+
+const BldRing::Packet* BldRing::next()
+{
+    if (m_tail - m_head <= (m_held ? 1u : 0u))
+        return nullptr;
+
+    if (m_held)  ++m_head;
+    m_held = true;
+
+    const Packet* packet = &m_packet[m_head % m_depth];
+    if (m_latency) {
+        uint64_t now = nsNow();
+        m_latency->record(now > packet->rxTime ? now - packet->rxTime : 0);
+    }
+    return packet;
+}
+
+
+BldReceiver::BldReceiver() :
+    m_epfd(epoll_create1(0))
+{
+    if (m_epfd < 0)
+        logging::error("BldReceiver: epoll_create1 failed: %m");
+}
+
+BldReceiver::~BldReceiver()
+{
+    if (m_epfd >= 0)  close(m_epfd);
+}
+
+int BldReceiver::add(BldRing& ring)
+{
+    epoll_event event;
+    event.events   = EPOLLIN;           // Level triggered: a full ring is retried
+    event.data.u32 = m_rings.size();
+    if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, ring.fd(), &event) == -1) {
+        logging::error("BldReceiver: epoll_ctl failed for fd %d: %m", ring.fd());
+        return -1;
+    }
+    m_rings.push_back(&ring);
+    m_events.resize(m_rings.size());
+    return 0;
+}
+
+int BldReceiver::poll(int msTimeout)
+{
+    if (m_rings.empty())  return 0;
+
+    int n = epoll_wait(m_epfd, m_events.data(), m_events.size(), msTimeout);
+    if (n < 0) {
+        if (errno != EINTR)
+            logging::error("BldReceiver: epoll_wait failed: %m");
+        return 0;
+    }
+
+    int packets = 0;
+    for (int i = 0; i < n; ++i) {
+        BldRing& ring = *m_rings[m_events[i].data.u32];
+        int rc = ring.receive();
+        if (rc > 0)  packets += rc;
+    }
+    return packets;
+}
+
+}
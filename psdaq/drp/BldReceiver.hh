@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace Pds {
+class LatencyHistogram;
+}
+
+namespace Drp {
+
+// Ring of preallocated MTU sized packet buffers for one datagram socket,
+// filled with recvmmsg() as many packets per system call as there is room
+// for.  The packet handed out by next() stays valid until the following
+// next() returns another one, so payload pointers into it can be kept
+// until the consumer moves on.
+class BldRing
+{
+public:
+    struct Packet
+    {
+        uint8_t* data;
+        unsigned size;
+        uint64_t rxTime;    // ns since the POSIX epoch, from the kernel if enabled
+    };
+public:
+    BldRing(int fd, unsigned depth, unsigned mtu);
+    ~BldRing();
+    BldRing(const BldRing&) = delete;
+    BldRing& operator=(const BldRing&) = delete;
+public:
+    // Ask the kernel to timestamp packets on arrival (SO_TIMESTAMPING)
+    int      timestamping();
+    // Receive whatever fits without blocking; returns the number of packets
+    // received, or -1 on an error other than there being nothing to read
+    int      receive();
+    // Release the packet returned last and return the following one, or
+    // nullptr (keeping the previous one) if there is none yet
+    const Packet* next();
+    bool     full()  const { return m_tail - m_head == m_depth; }
+    int      fd()    const { return m_fd; }
+    // Records the time between the kernel receiving a packet and next()
+    void     latency(const std::shared_ptr<Pds::LatencyHistogram>& histogram) { m_latency = histogram; }
+public:
+    uint64_t packets () const { return m_packets;  }
+    uint64_t drops   () const { return m_drops;    } // By the kernel, socket buffer full
+    uint64_t fullCnt () const { return m_fullCnt;  } // Receives skipped, ring full
+    uint64_t syscalls() const { return m_syscalls; }
+private:
+    void     _parse(unsigned slot, const mmsghdr& msg, uint64_t now);
+private:
+    int                    m_fd;
+    unsigned               m_depth;
+    unsigned               m_mtu;
+    uint64_t               m_head;      // Oldest packet, the one in use if m_held
+    uint64_t               m_tail;      // Next slot to receive into
+    bool                   m_held;
+    bool                   m_timestamps;
+    std::vector<uint8_t>   m_buffer;
+    std::vector<uint8_t>   m_control;
+    std::vector<mmsghdr>   m_msgs;
+    std::vector<iovec>     m_iovs;
+    std::vector<Packet>    m_packet;
+    std::shared_ptr<Pds::LatencyHistogram> m_latency;
+    uint64_t               m_packets;
+    uint64_t               m_drops;
+    uint64_t               m_fullCnt;
+    uint64_t               m_syscalls;
+};
+
+// One epoll loop over the sockets of all BLD sources: poll() drains every
+// socket with data into its ring, and leaves the idle ones alone rather
+// than asking each for a packet in turn
+class BldReceiver
+{
+public:
+    BldReceiver();
+    ~BldReceiver();
+    BldReceiver(const BldReceiver&) = delete;
+    BldReceiver& operator=(const BldReceiver&) = delete;
+public:
+    int add(BldRing& ring);
+    // Wait up to msTimeout for data and receive it; returns the number of
+    // packets received
+    int poll(int msTimeout);
+private:
+    int                      m_epfd;
+    std::vector<BldRing*>    m_rings;
+    std::vector<epoll_event> m_events;
+};
+
+}
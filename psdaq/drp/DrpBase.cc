@@ -8,8 +8,11 @@
 #include <chrono>
 #include <sys/types.h>
 #include <sys/stat.h>                   // stat()
+#include <sys/mman.h>                   // shm_open(), mmap()
+#include <fcntl.h>
 #include "psdaq/service/kwargs.hh"
 #include "psdaq/service/EbDgram.hh"
+#include "psdaq/eb/utilities.hh"
 #include <DmaDriver.h>
 #include "DrpBase.hh"
 #include "RunInfoDef.hh"
@@ -70,7 +73,8 @@ static unsigned nextPowerOf2(unsigned n)
 }
 
 
-void Pebble::create(unsigned nL1Buffers, size_t l1BufSize, unsigned nTrBuffers, size_t trBufSize)
+void Pebble::create(unsigned nL1Buffers, size_t l1BufSize, unsigned nTrBuffers, size_t trBufSize,
+                    const std::string& shmKey)
 {
     size_t algnSz = 16;                    // For cache boundaries
     m_bufferSize  = algnSz * ((l1BufSize + algnSz - 1) / algnSz);
@@ -79,10 +83,48 @@ void Pebble::create(unsigned nL1Buffers, size_t l1BufSize, unsigned nTrBuffers,
     m_size        = nL1Buffers*m_bufferSize + nTrBuffers*trBufSize;
     m_size        = pgSz * ((m_size + pgSz - 1) / pgSz);
     m_buffer      = nullptr;
-    int    ret    = posix_memalign((void**)&m_buffer, pgSz, m_size);
-    if (ret) {
-        logging::critical("Pebble creation of size %zu failed: %s\n", m_size, strerror(ret));
-        throw "Pebble creation failed";
+    if (shmKey.empty()) {
+        int    ret    = posix_memalign((void**)&m_buffer, pgSz, m_size);
+        if (ret) {
+            logging::critical("Pebble creation of size %zu failed: %s\n", m_size, strerror(ret));
+            throw "Pebble creation failed";
+        }
+    } else {
+        shm_unlink(shmKey.c_str());     // Start from a clean segment
+        int fd = shm_open(shmKey.c_str(), O_RDWR | O_CREAT, 0666);
+        if (fd == -1 || ftruncate(fd, m_size) == -1) {
+            logging::critical("Pebble shared memory %s of size %zu failed: %m", shmKey.c_str(), m_size);
+            if (fd != -1)  close(fd);
+            throw "Pebble creation failed";
+        }
+        void* p = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            logging::critical("Pebble shared memory %s mmap failed: %m", shmKey.c_str());
+            shm_unlink(shmKey.c_str());
+            throw "Pebble creation failed";
+        }
+        m_buffer = (uint8_t*)p;
+        m_shmKey = shmKey;
+        logging::info("Pebble allocated in shared memory %s", shmKey.c_str());
+    }
+}
+
+uint64_t Pebble::offset(const Pds::EbDgram* dgram) const
+{
+    return offset(static_cast<const XtcData::Dgram*>(dgram));
+}
+
+Pebble::~Pebble()
+{
+    if (m_buffer) {
+        if (m_shmKey.empty()) {
+            free(m_buffer);
+        } else {
+            munmap(m_buffer, m_size);
+            shm_unlink(m_shmKey.c_str());
+        }
+        m_buffer = nullptr;
     }
 }
 
@@ -127,8 +169,19 @@ MemPool::MemPool(Parameters& para) :
                         m_nbuffers, m_nDmaBuffers);
       abort();
     }
+    // With Drp Python in zero-copy mode, the pebble (including the transition
+    // buffers) is placed in shared memory that the Python workers map, so
+    // that only buffer offsets need to be exchanged with them
+    std::string pebbleShmKey;
+    auto drpIt = para.kwargs.find("drp");
+    auto zcIt  = para.kwargs.find("pythonZeroCopy");
+    if (drpIt != para.kwargs.end() && drpIt->second == "python" &&
+        zcIt  != para.kwargs.end() && zcIt->second  == "yes") {
+        pebbleShmKey = "/shmpebble_p" + std::to_string(para.partition) + "_" +
+                       para.detName + "_" + std::to_string(para.detSegment);
+    }
     auto nTrBuffers = m_transitionBuffers.size();
-    pebble.create(m_nbuffers, maxL1ASize, nTrBuffers, para.maxTrSize);
+    pebble.create(m_nbuffers, maxL1ASize, nTrBuffers, para.maxTrSize, pebbleShmKey);
     logging::info("nL1Buffers %u,  pebble buffer size %zu", m_nbuffers, pebble.bufferSize());
     logging::info("nTrBuffers %u,  transition buffer size %zu", nTrBuffers, para.maxTrSize);
 
@@ -468,8 +521,12 @@ EbReceiver::EbReceiver(Parameters& para, Pds::Eb::TebCtrbParams& tPrms,
   m_det(nullptr),
   m_tsId(-1u),
   m_mon(mon),
-  m_fileWriter(std::max(pool.pebble.bufferSize(), para.maxTrSize), para.kwargs["directIO"] == "yes"),
+  m_fileWriter(std::max(pool.pebble.bufferSize(), para.maxTrSize), para.kwargs["directIO"] == "yes",
+               para.kwargs["writeQueueDepth"].empty() ? 0 : std::stoul(para.kwargs["writeQueueDepth"])),
   m_smdWriter(std::max(pool.pebble.bufferSize(), para.maxTrSize)),
+  m_idxWriter(0x100000),
+  m_stripe(0),
+  m_indexing(para.kwargs["xtcIndex"] != "no"), // Default to "yes"
   m_writing(false),
   m_inprocSend(inprocSend),
   m_offset(0),
@@ -487,6 +544,25 @@ EbReceiver::EbReceiver(Parameters& para, Pds::Eb::TebCtrbParams& tPrms,
          {"partition", std::to_string(para.partition)},
          {"detname", para.detName},
          {"alias", para.alias}};
+
+    // Colon separated list of output roots for the additional stripes
+    std::istringstream stripeDirs(para.kwargs["stripeDirs"]);
+    std::string stripeDir;
+    while (std::getline(stripeDirs, stripeDir, ':')) {
+        if (stripeDir.empty())  continue;
+        Stripe stripe;
+        stripe.outputDir  = stripeDir;
+        stripe.fileWriter = std::make_unique<BufferedFileWriterMT>(std::max(pool.pebble.bufferSize(), para.maxTrSize),
+                                                                   para.kwargs["directIO"] == "yes",
+                                                                   para.kwargs["writeQueueDepth"].empty() ? 0 : std::stoul(para.kwargs["writeQueueDepth"]));
+        stripe.idxWriter  = std::make_unique<IndexWriter>(0x100000);
+        stripe.offset     = 0;
+        m_stripes.push_back(std::move(stripe));
+    }
+    if (!m_stripes.empty()) {
+        logging::info("Striping L1Accepts over %zu bigdata files", m_stripes.size() + 1);
+    }
+
     exporter->add("DRP_Damage"    ,   labels, Pds::MetricType::Gauge,   [&](){ return m_damage; });
     exporter->add("DRP_RecordSize",   labels, Pds::MetricType::Counter, [&](){ return m_offset; });
     exporter->add("DRP_RecordDepth",  labels, Pds::MetricType::Gauge,   [&](){ return m_fileWriter.depth(); });
@@ -496,8 +572,12 @@ EbReceiver::EbReceiver(Parameters& para, Pds::Eb::TebCtrbParams& tPrms,
     exporter->add("DRP_fileWriting",  labels, Pds::MetricType::Gauge,   [&](){ return m_fileWriter.writing(); });
     exporter->add("DRP_bufFreeBlk",   labels, Pds::MetricType::Gauge,   [&](){ return m_fileWriter.freeBlocked(); });
     exporter->add("DRP_bufPendBlk",   labels, Pds::MetricType::Gauge,   [&](){ return m_fileWriter.pendBlocked(); });
+    exporter->add("DRP_fileInFlight", labels, Pds::MetricType::Gauge,   [&](){ return m_fileWriter.inFlight(); });
+    exporter->add("DRP_fileWrLat",    labels, Pds::MetricType::Gauge,   [&](){ return m_fileWriter.wrLatency(); });
     exporter->add("DRP_evtSize",      labels, Pds::MetricType::Gauge,   [&](){ return m_evtSize; });
     exporter->add("DRP_evtLatency",   labels, Pds::MetricType::Gauge,   [&](){ return m_latency; });
+    m_latencyHist = exporter->latency("DRP_evtLatQ", labels);       // ns
+    m_fileWriter.latencyHistogram(exporter->latency("DRP_fileWrLatQ", labels));
 }
 
 std::string EbReceiver::openFiles(const Parameters& para, const RunInfo& runInfo, std::string hostname, unsigned nodeId)
@@ -530,6 +610,14 @@ std::string EbReceiver::openFiles(const Parameters& para, const RunInfo& runInfo
         } else if (retVal.empty()) {
             retVal = {"Failed to open file '" + absolute_path + "'"};
         }
+        // index
+        if (m_indexing && retVal.empty()) {
+            retVal = _openIndex(m_idxWriter, absolute_path);
+        }
+        if (retVal.empty()) {
+            retVal = _openStripes(para.outputDir, para.instrument, runInfo.experimentName,
+                                  runName, runInfo.runNumber, hostname);
+        }
         // smalldata
         std::string smalldataDir = {para.outputDir + "/" + para.instrument + "/" + runInfo.experimentName + "/xtc/smalldata"};
         local_mkdir(smalldataDir.c_str());
@@ -589,6 +677,8 @@ std::string EbReceiver::reopenFiles()
     // close data file (for old chunk)
     logging::debug("%s: calling m_fileWriter.close()...", __PRETTY_FUNCTION__);
     m_fileWriter.close();
+    if (m_indexing)  m_idxWriter.close();
+    _closeStripes();
 
     // open data file (for new chunk)
     std::string runName = m_fileParameters.runName();
@@ -612,10 +702,79 @@ std::string EbReceiver::reopenFiles()
     } else if (retVal.empty()) {
         retVal = {"Failed to open file '" + absolute_path + "'"};
     }
+    if (m_indexing && retVal.empty()) {
+        retVal = _openIndex(m_idxWriter, absolute_path);
+    }
+    if (retVal.empty()) {
+        retVal = _openStripes(outputDir, instrument, experimentName, runName, runNumber, hostname);
+    }
 
     return retVal;
 }
 
+// The index lives next to its xtc2 chunk and records chunk-relative offsets
+std::string EbReceiver::_openIndex(IndexWriter& idxWriter, const std::string& absolute_path)
+{
+    std::string index_path = {absolute_path + ".idx"};
+    logging::info("Opening file '%s'", index_path.c_str());
+    if (idxWriter.open(index_path) != 0) {
+        return {"Failed to open file '" + index_path + "'"};
+    }
+    return std::string{};
+}
+
+// Stripe n of chunk file <runName>.xtc2 is named <runName>-iNN.xtc2.  When a
+// stripe's output root differs from the primary one, a symbolic link to it is
+// made in the primary xtc directory so that readers find all stripes together.
+std::string EbReceiver::_openStripes(const std::string& outputDir, const std::string& instrument,
+                                     const std::string& experimentName, const std::string& runName,
+                                     unsigned runNumber, const std::string& hostname)
+{
+    m_stripe = 0;
+    for (unsigned i = 0; i < m_stripes.size(); ++i) {
+        auto& stripe = m_stripes[i];
+        std::string exptDir = {stripe.outputDir + "/" + instrument + "/" + experimentName};
+        local_mkdir(exptDir.c_str());
+        std::string dataDir = {exptDir + "/xtc"};
+        local_mkdir(dataDir.c_str());
+        std::ostringstream ss;
+        ss << "/" << instrument << "/" << experimentName << "/xtc/" << runName <<
+              "-i" << std::setfill('0') << std::setw(2) << i + 1 << ".xtc2";
+        std::string path = ss.str();
+        std::string absolute_path = {stripe.outputDir + path};
+        std::cout << "Opening file " << absolute_path << std::endl;
+        logging::info("Opening file '%s'", absolute_path.c_str());
+        if (stripe.fileWriter->open(absolute_path) != 0) {
+            return {"Failed to open file '" + absolute_path + "'"};
+        }
+        timespec tt; clock_gettime(CLOCK_REALTIME,&tt);
+        json msg = createFileReportMsg(path, absolute_path, tt, tt, runNumber, hostname);
+        m_inprocSend.send(msg.dump());
+        stripe.offset = 0;
+        if (stripe.outputDir != outputDir) {
+            std::string link_path = {outputDir + path};
+            unlink(link_path.c_str());
+            if (symlink(absolute_path.c_str(), link_path.c_str()) < 0) {
+                // %m will be replaced by the string strerror(errno)
+                logging::error("Failed to link '%s' to '%s': %m", link_path.c_str(), absolute_path.c_str());
+            }
+        }
+        if (m_indexing) {
+            std::string retVal = _openIndex(*stripe.idxWriter, absolute_path);
+            if (!retVal.empty())  return retVal;
+        }
+    }
+    return std::string{};
+}
+
+void EbReceiver::_closeStripes()
+{
+    for (auto& stripe : m_stripes) {
+        stripe.fileWriter->close();
+        if (m_indexing)  stripe.idxWriter->close();
+    }
+}
+
 std::string EbReceiver::closeFiles()
 {
     logging::debug("%s: m_writing is %s", __PRETTY_FUNCTION__, m_writing ? "true" : "false");
@@ -625,6 +784,11 @@ std::string EbReceiver::closeFiles()
         m_smdWriter.close();
         logging::debug("calling m_fileWriter.close()...");
         m_fileWriter.close();
+        if (m_indexing) {
+            logging::debug("calling m_idxWriter.close()...");
+            m_idxWriter.close();
+        }
+        _closeStripes();
     }
     return std::string{};
 }
@@ -671,16 +835,40 @@ void EbReceiver::resetCounters(bool all = false)
 void EbReceiver::_writeDgram(XtcData::Dgram* dgram)
 {
     size_t size = sizeof(*dgram) + dgram->xtc.sizeofPayload();
-    m_fileWriter.writeEvent(dgram, size, dgram->time);
+    uint64_t offset = chunkSize();
+    unsigned stripe = 0;
+    if (dgram->service() == XtcData::TransitionId::L1Accept) {
+        if (!m_stripes.empty()) {
+            stripe = m_stripe;
+            m_stripe = m_stripe < m_stripes.size() ? m_stripe + 1 : 0;
+        }
+    } else {
+        // Replicate transitions so that each stripe is a self-contained xtc2 file
+        for (auto& s : m_stripes) {
+            s.fileWriter->writeEvent(dgram, size, dgram->time);
+            if (m_indexing)  s.idxWriter->writeEntry(*dgram, s.offset);
+            s.offset += size;
+        }
+    }
+    if (stripe == 0) {
+        m_fileWriter.writeEvent(dgram, size, dgram->time);
+        if (m_indexing)  m_idxWriter.writeEntry(*dgram, offset);
+    } else {
+        auto& s = m_stripes[stripe - 1];
+        offset = s.offset;
+        s.fileWriter->writeEvent(dgram, size, dgram->time);
+        if (m_indexing)  s.idxWriter->writeEntry(*dgram, offset);
+        s.offset += size;
+    }
 
     // small data writing
-    Smd smd;
+    Smd smd(!m_stripes.empty());
     const void* bufEnd = m_smdWriter.buffer + sizeof(m_smdWriter.buffer);
     XtcData::NamesId namesId(dgram->xtc.src.value(), NamesIndex::OFFSETINFO);
-    XtcData::Dgram* smdDgram = smd.generate(dgram, m_smdWriter.buffer, bufEnd, chunkSize(), size,
-                                            m_smdWriter.namesLookup, namesId);
+    XtcData::Dgram* smdDgram = smd.generate(dgram, m_smdWriter.buffer, bufEnd, offset, size,
+                                            m_smdWriter.namesLookup, namesId, stripe);
     m_smdWriter.writeEvent(smdDgram, sizeof(XtcData::Dgram) + smdDgram->xtc.sizeofPayload(), smdDgram->time);
-    m_offset += size;
+    if (stripe == 0)  m_offset += size;
 }
 
 void EbReceiver::process(const Pds::Eb::ResultDgram& result, unsigned index)
@@ -821,6 +1009,9 @@ void EbReceiver::process(const Pds::Eb::ResultDgram& result, unsigned index)
                  + std::chrono::nanoseconds{dgram->time.nanoseconds()};
         std::chrono::system_clock::time_point tp{std::chrono::duration_cast<std::chrono::system_clock::duration>(dgt)};
         m_latency = std::chrono::duration_cast<ms_t>(now - tp).count();
+        if (now > tp) {
+            m_latencyHist->record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - tp).count());
+        }
 
         if (m_mon.enabled()) {
             // L1Accept
@@ -1328,6 +1519,31 @@ int DrpBase::parseConnectionParams(const json& body, size_t id)
         }
     }
 
+    // With a result_fanout, the TEBs post Results to the roots of a tree of
+    // the DRPs, built here the same way, and each DRP passes them on to its
+    // children.  A DRP that isn't a root receives them from its parent.
+    m_tPrms.rlyAddrs.clear();
+    m_tPrms.rlyPorts.clear();
+    m_tPrms.relayed = false;
+    unsigned fanout = m_para.kwargs.find("result_fanout") == m_para.kwargs.end()
+                    ? 0 : std::stoul(m_para.kwargs["result_fanout"]);
+    if (fanout) {
+        uint64_t members = 0;
+        for (auto it : body["drp"].items()) {
+            unsigned drpId = it.value()["drp_id"];
+            members |= 1ull << drpId;
+        }
+        uint64_t children = Pds::Eb::relayChildren(members, fanout, m_nodeId);
+        for (auto it : body["drp"].items()) {
+            unsigned drpId = it.value()["drp_id"];
+            if (children & (1ull << drpId)) {
+                m_tPrms.rlyAddrs.push_back(it.value()["connect_info"]["nic_ip"]);
+                m_tPrms.rlyPorts.push_back(it.value()["connect_info"]["drp_port"]);
+            }
+        }
+        m_tPrms.relayed = !(Pds::Eb::relayRoots(members, fanout) & (1ull << m_nodeId));
+    }
+
     // Disallow non-common RoG DRPs from having more buffers than the common one
     // because a buffer index based on the common RoG DRPs' won't be able to
     // reach the higher buffer numbers.  Can't use an index based on the largest
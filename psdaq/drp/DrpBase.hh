@@ -104,6 +104,21 @@ public:
     FileParameters *fileParameters()    { return &m_fileParameters; }
 private:
     void _writeDgram(XtcData::Dgram* dgram);
+    std::string _openIndex(IndexWriter& idxWriter, const std::string& absolute_path);
+    std::string _openStripes(const std::string& outputDir, const std::string& instrument,
+                             const std::string& experimentName, const std::string& runName,
+                             unsigned runNumber, const std::string& hostname);
+    void _closeStripes();
+private:
+    // Additional bigdata files, typically on other mount points.  L1Accepts
+    // are distributed round-robin over the primary file and these, while
+    // transitions are written to all of them
+    struct Stripe {
+        std::string outputDir;
+        std::unique_ptr<BufferedFileWriterMT> fileWriter;
+        std::unique_ptr<IndexWriter> idxWriter;
+        uint64_t offset;                // Of the next dgram in the current chunk
+    };
 private:
     MemPool& m_pool;
     Detector* m_det;
@@ -111,6 +126,10 @@ private:
     Pds::Eb::MebContributor& m_mon;
     BufferedFileWriterMT m_fileWriter;
     SmdWriter m_smdWriter;
+    IndexWriter m_idxWriter;
+    std::vector<Stripe> m_stripes;
+    unsigned m_stripe;                  // For the next L1Accept, with 0 the primary file
+    bool m_indexing;
     bool m_writing;
     ZmqSocket& m_inprocSend;
     uint32_t m_lastIndex;
@@ -125,6 +144,7 @@ private:
     uint64_t m_damage;
     uint64_t m_evtSize;
     int64_t m_latency;
+    std::shared_ptr<Pds::LatencyHistogram> m_latencyHist;
     std::shared_ptr<Pds::PromHistogram> m_dmgType;
     FileParameters m_fileParameters;
     unsigned m_partition;
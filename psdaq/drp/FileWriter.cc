@@ -2,11 +2,13 @@
 #include <cstring>
 #include <unistd.h>
 #include <fcntl.h>
-#include <cstring>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <sstream>
 #include <iomanip>      // std::setfill, std::setw
 #include "FileWriter.hh"
+#include "IoUring.hh"
 #include "psalg/utils/SysLog.hh"
 
 using logging = psalg::SysLog;
@@ -29,6 +31,22 @@ static inline ssize_t _write(int fd, const void* buffer, size_t count)
     return sz;
 }
 
+static inline ssize_t _pwrite(int fd, const void* buffer, size_t count, off_t offset)
+{
+    while (count) {
+        auto sz = pwrite(fd, buffer, count, offset);
+        if (sz < 0) {
+            // %m will be replaced by the string strerror(errno)
+            logging::error("pwrite error: %m");
+            return sz;
+        }
+        buffer  = (uint8_t*)buffer + sz;
+        count  -= sz;
+        offset += sz;
+    }
+    return 0;
+}
+
 
 BufferedFileWriter::BufferedFileWriter(size_t bufferSize) :
     m_count(0), m_batch_starttime(0,0), m_buffer(bufferSize), m_writing(0)
@@ -138,33 +156,33 @@ static size_t roundUpSize(size_t bufSize, size_t quantum)
     return quantum * ((bufSize + quantum - 1) / quantum);
 }
 
+// An io_uring queue needs queueDepth+1 buffers to keep it full while one is
+// being filled.  The number of buffers is capped, and with DIO the memory of
+// the default FIFO is divided among them rather than adding large buffers.
+static unsigned fifoDepth(bool dio, unsigned queueDepth)
+{
+    return std::min(std::max(dio ? FIFO_DEPTH_DIO : FIFO_DEPTH, queueDepth + 1), FIFO_DEPTH);
+}
+
 BufferedFileWriterMT::BufferedFileWriterMT(size_t bufferSize) :
-    m_fd(0),
-    m_batch_starttime(0,0),
-    m_free(FIFO_DEPTH),
-    m_pend(FIFO_DEPTH),
-    m_depth(m_free.size()),
-    m_size(m_free.size()),
-    m_writing(0),
-    m_freeBlocked(0),
-    m_pendBlocked(0),
-    m_terminate(false),
-    m_thread{&BufferedFileWriterMT::run,this},
-    m_dio(false)
+    BufferedFileWriterMT(bufferSize, false)
 {
-    _initialize(bufferSize);
 }
 
-BufferedFileWriterMT::BufferedFileWriterMT(size_t bufferSize, bool dio) :
+BufferedFileWriterMT::BufferedFileWriterMT(size_t bufferSize, bool dio, unsigned queueDepth) :
     m_fd(0),
     m_batch_starttime(0,0),
-    m_free(dio ? FIFO_DEPTH_DIO : FIFO_DEPTH),
-    m_pend(dio ? FIFO_DEPTH_DIO : FIFO_DEPTH),
+    m_free(fifoDepth(dio, queueDepth)),
+    m_pend(fifoDepth(dio, queueDepth)),
     m_depth(m_free.size()),
     m_size(m_free.size()),
     m_writing(0),
     m_freeBlocked(0),
     m_pendBlocked(0),
+    m_inFlight(0),
+    m_wrLatency(0),
+    m_queueDepth(std::min(queueDepth, fifoDepth(dio, queueDepth) - 1)),
+    m_offset(0),
     m_terminate(false),
     m_thread{&BufferedFileWriterMT::run,this},
     m_dio(dio)
@@ -188,7 +206,10 @@ void BufferedFileWriterMT::_initialize(size_t bufferSize)
 {
     Buffer b;
     b.count = 0;
-    if (m_dio)  bufferSize = roundUpSize(FIFO_MIN_SIZE, bufferSize); // N buffers >= FIFO_MIN_SIZE
+    if (m_dio) {                        // N buffers >= FIFO_MIN_SIZE in total
+        size_t minSize = FIFO_MIN_SIZE * FIFO_DEPTH_DIO / m_free.size();
+        bufferSize = roundUpSize(minSize, bufferSize);
+    }
     m_bufferSize = roundUpSize(bufferSize, sysconf(_SC_PAGESIZE));   // N pages
     for (unsigned i=0; i<m_free.size(); i++) {
         if (posix_memalign((void**)&b.p, sysconf(_SC_PAGESIZE), m_bufferSize)) {
@@ -210,6 +231,7 @@ int BufferedFileWriterMT::open(const std::string& fileName)
 
     auto oFlags = O_WRONLY | O_CREAT | O_TRUNC;
     if (m_dio)  oFlags |= O_DIRECT;
+    m_offset = 0;                       // Nothing is pending: see close()
     m_fd = ::open(fileName.c_str(), oFlags, S_IRUSR | S_IRGRP);
     if (m_fd == -1) {
         // %m will be replaced by the string strerror(errno)
@@ -304,6 +326,15 @@ void BufferedFileWriterMT::writeEvent(const void* data, size_t size, XtcData::Ti
 
 void BufferedFileWriterMT::run()
 {
+    if (m_queueDepth) {
+        IoUring ring;
+        if (ring.open(m_queueDepth) == 0) {
+            _runAsync(ring);
+            return;
+        }
+        logging::warning("io_uring is unavailable: falling back to synchronous writes");
+    }
+
     while (true) {
         std::chrono::milliseconds tmo{100};
         ++m_pendBlocked;
@@ -318,9 +349,12 @@ void BufferedFileWriterMT::run()
         }
         Buffer& b = m_pend.front();
         ++m_writing;
+        auto start = std::chrono::steady_clock::now();
         if (_write(m_fd, b.p, b.count) == -1) {
             throw "File writing failed";
         }
+        _wrLatency(std::chrono::duration_cast<std::chrono::nanoseconds>
+                   (std::chrono::steady_clock::now() - start).count());
         --m_writing;
         m_pend.pop(b);
         b.count = 0;
@@ -329,6 +363,96 @@ void BufferedFileWriterMT::run()
     }
 }
 
+void BufferedFileWriterMT::_wrLatency(uint64_t ns)
+{
+    m_wrLatency = ns;
+    auto hist = std::atomic_load(&m_wrLatHist); // Set by another thread
+    if (hist)  hist->record(ns);
+}
+
+// Keeps up to m_queueDepth pending buffers in flight, each written at its
+// own file offset, so that a slow write doesn't hold up the ones behind it.
+// Buffers are returned to the free list in the order they were filled.
+void BufferedFileWriterMT::_runAsync(IoUring& ring)
+{
+    struct Slot {
+        bool     done;
+        uint64_t offset;
+        std::chrono::steady_clock::time_point start;
+    };
+    std::vector<Slot> slots(m_queueDepth);
+    uint64_t head = 0;                  // Sequence number of m_pend.front()
+    uint64_t tail = 0;                  // Sequence number of the next buffer to submit
+
+    while (true) {
+        if (head == tail) {
+            std::chrono::milliseconds tmo{100};
+            ++m_pendBlocked;
+            m_pend.pend(tmo);
+            --m_pendBlocked;
+            if (m_pend.empty()) {
+                if (m_terminate.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                else
+                    continue;
+            }
+        }
+
+        // Submit as many of the pending buffers as the queue depth allows
+        while ((tail - head < m_queueDepth) && (tail - head < m_pend.count())) {
+            const Buffer& b = m_pend.peek(tail - head);
+            Slot& slot = slots[tail % m_queueDepth];
+            slot.done   = false;
+            slot.offset = m_offset;
+            slot.start  = std::chrono::steady_clock::now();
+            if (!ring.write(m_fd, b.p, b.count, m_offset, tail))  break;
+            m_offset += b.count;
+            ++tail;
+        }
+        m_inFlight = tail - head;
+        m_writing  = m_inFlight;
+
+        // When the queue isn't full, wake up periodically to submit new buffers
+        unsigned tmoUs = (tail - head < m_queueDepth) ? 1000 : 0;
+        if (ring.submit(1, tmoUs)) {
+            throw "File writing failed";
+        }
+
+        uint64_t seq;
+        int      res;
+        while (ring.complete(seq, res)) {
+            const Buffer& b = m_pend.peek(seq - head);
+            if (res < 0) {
+                errno = -res;
+                // %m will be replaced by the string strerror(errno)
+                logging::error("write error: %m");
+                throw "File writing failed";
+            }
+            Slot& slot = slots[seq % m_queueDepth];
+            if (size_t(res) != b.count) { // Finish a short write synchronously
+                if (_pwrite(m_fd, b.p + res, b.count - res, slot.offset + res) == -1) {
+                    throw "File writing failed";
+                }
+            }
+            slot.done = true;
+            _wrLatency(std::chrono::duration_cast<std::chrono::nanoseconds>
+                       (std::chrono::steady_clock::now() - slot.start).count());
+        }
+
+        while ((head != tail) && slots[head % m_queueDepth].done) {
+            Buffer b;
+            m_pend.pop(b);
+            b.count = 0;
+            m_free.push(b);
+            m_depth = m_free.count();
+            ++head;
+        }
+        m_inFlight = tail - head;
+        m_writing  = m_inFlight;
+    }
+}
+
 BufferedMultiFileWriterMT::BufferedMultiFileWriterMT(size_t bufferSize,
                                                      size_t numFiles) :
     m_index(0)
@@ -399,4 +523,24 @@ void SmdWriter::addNames(XtcData::Xtc& parent, const void* bufEnd, unsigned node
     namesLookup[namesId] = XtcData::NameIndex(offsetNames);
 }
 
+IndexWriter::IndexWriter(size_t bufferSize) : BufferedFileWriter(bufferSize)
+{
+}
+
+int IndexWriter::open(const std::string& fileName)
+{
+    int rv = BufferedFileWriter::open(fileName);
+    if (rv == 0) {
+        XtcData::XtcIndexHeader hdr;
+        writeEvent(&hdr, sizeof(hdr), XtcData::TimeStamp(0,0));
+    }
+    return rv;
+}
+
+void IndexWriter::writeEntry(const XtcData::Dgram& dgram, uint64_t offset)
+{
+    XtcData::XtcIndexEntry entry(dgram, offset);
+    writeEvent(&entry, sizeof(entry), dgram.time);
+}
+
 }
@@ -1,17 +1,22 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <string>
 #include <thread>
 #include <vector>
 #include "psdaq/service/Fifo.hh"
+#include "psdaq/service/LatencyHistogram.hh"
 #include "psdaq/service/Task.hh"
 #include "xtcdata/xtc/VarDef.hh"
 #include "xtcdata/xtc/DescData.hh"
 #include "xtcdata/xtc/TimeStamp.hh"
+#include "xtcdata/xtc/XtcIndex.hh"
 
 namespace Drp {
 
+class IoUring;
+
 class BufferedFileWriter
 {
 public:
@@ -33,7 +38,9 @@ class BufferedFileWriterMT
 {
 public:
     BufferedFileWriterMT(size_t bufferSize);
-    BufferedFileWriterMT(size_t bufferSize, bool dio);
+    // With a non-zero queueDepth, up to that many buffers are written
+    // concurrently through io_uring rather than one at a time with write()
+    BufferedFileWriterMT(size_t bufferSize, bool dio, unsigned queueDepth = 0);
     ~BufferedFileWriterMT();
     int open(const std::string& fileName);
     int close();
@@ -45,8 +52,14 @@ public:
     const uint64_t writing() const { return m_writing; }
     const uint64_t freeBlocked()  const { return m_freeBlocked; }
     const uint64_t pendBlocked()  const { return m_pendBlocked; }
+    const uint64_t inFlight()     const { return m_inFlight; }
+    const uint64_t wrLatency()    const { return m_wrLatency; } // ns
+    // Optional distribution of the write latencies
+    void latencyHistogram(std::shared_ptr<Pds::LatencyHistogram> h) { std::atomic_store(&m_wrLatHist, h); }
 private:
+    void _wrLatency(uint64_t ns);
     void _initialize(size_t bufferSize);
+    void _runAsync(IoUring& ring);
 private:
     size_t m_bufferSize;
     int m_fd;
@@ -63,6 +76,11 @@ private:
     volatile uint64_t m_writing;
     volatile uint64_t m_freeBlocked;
     volatile uint64_t m_pendBlocked;
+    volatile uint64_t m_inFlight;
+    volatile uint64_t m_wrLatency;
+    std::shared_ptr<Pds::LatencyHistogram> m_wrLatHist;
+    unsigned m_queueDepth;
+    uint64_t m_offset;
     std::atomic<bool> m_terminate;
     std::thread m_thread;
     bool m_dio;
@@ -111,4 +129,14 @@ public:
     XtcData::NamesLookup namesLookup;
 };
 
+// Writes the fixed-record timestamp/offset index (see XtcData::XtcIndex)
+// that accompanies each xtc2 chunk
+class IndexWriter : public BufferedFileWriter
+{
+public:
+    IndexWriter(size_t bufferSize);
+    int open(const std::string& fileName);
+    void writeEntry(const XtcData::Dgram& dgram, uint64_t offset);
+};
+
 }
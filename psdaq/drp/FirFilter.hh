@@ -0,0 +1,36 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+namespace Drp {
+
+// Finite impulse response filter of the time tool FEXes:
+//   result[i] = sum_j sample[i+j]*weights[j],  i < sample.size()-weights.size()
+// Short filters are applied by direct convolution, blocked so that the
+// compiler vectorizes over the outputs; long ones by overlap-save FFT
+// convolution with the spectrum of the weights computed at configure time.
+// apply() is const and reuses the caller's result vector, so that one
+// filter can be shared by the DRP workers.
+class FirFilter
+{
+public:
+    FirFilter();
+    void configure(const std::vector<double>& weights);
+    const std::vector<double>& weights() const { return m_weights; }
+    void apply(const std::vector<double>& sample, std::vector<double>& result) const;
+private:
+    bool _useFft(unsigned len) const;
+    void _direct(const double* sample, unsigned len, double* result) const;
+    void _overlapSave(const double* sample, unsigned n, unsigned len, double* result) const;
+    void _fft(std::complex<double>* a, bool inverse) const;
+private:
+    std::vector<double>               m_weights;
+    unsigned                          m_fftSize;  // overlap-save block size
+    unsigned                          m_fftLog2;
+    std::vector<std::complex<double>> m_kernel;   // spectrum of the reversed weights
+    std::vector<std::complex<double>> m_twiddle;
+    std::vector<unsigned>             m_bitrev;
+};
+
+}
@@ -0,0 +1,147 @@
+#include "IoUring.hh"
+
+#include <errno.h>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "psalg/utils/SysLog.hh"
+
+using logging = psalg::SysLog;
+
+namespace Drp {
+
+IoUring::IoUring() :
+    m_fd(-1), m_extArg(false), m_toSubmit(0), m_sqEntries(0),
+    m_sqRing(MAP_FAILED), m_sqRingSize(0),
+    m_cqRing(MAP_FAILED), m_cqRingSize(0),
+    m_sqes((io_uring_sqe*)MAP_FAILED), m_sqesSize(0)
+{
+}
+
+IoUring::~IoUring()
+{
+    close();
+}
+
+int IoUring::open(unsigned entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    m_fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (m_fd < 0) {
+        // %m will be replaced by the string strerror(errno)
+        logging::error("io_uring_setup with %u entries failed: %m", entries);
+        return -1;
+    }
+
+    m_sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    m_cqRingSize = p.cq_off.cqes  + p.cq_entries * sizeof(io_uring_cqe);
+    m_sqesSize   = p.sq_entries * sizeof(io_uring_sqe);
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    m_fd, IORING_OFF_SQ_RING);
+    m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    m_fd, IORING_OFF_CQ_RING);
+    m_sqes   = (io_uring_sqe*)mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                   m_fd, IORING_OFF_SQES);
+    if (m_sqRing == MAP_FAILED || m_cqRing == MAP_FAILED || m_sqes == MAP_FAILED) {
+        logging::error("io_uring mmap failed: %m");
+        close();
+        return -1;
+    }
+
+    char* sq = (char*)m_sqRing;
+    m_sqHead  = (unsigned*)(sq + p.sq_off.head);
+    m_sqTail  = (unsigned*)(sq + p.sq_off.tail);
+    m_sqMask  = (unsigned*)(sq + p.sq_off.ring_mask);
+    m_sqArray = (unsigned*)(sq + p.sq_off.array);
+    char* cq = (char*)m_cqRing;
+    m_cqHead  = (unsigned*)(cq + p.cq_off.head);
+    m_cqTail  = (unsigned*)(cq + p.cq_off.tail);
+    m_cqMask  = (unsigned*)(cq + p.cq_off.ring_mask);
+    m_cqes    = (io_uring_cqe*)(cq + p.cq_off.cqes);
+    m_sqEntries = p.sq_entries;
+    m_toSubmit  = 0;
+    m_extArg    = p.features & IORING_FEAT_EXT_ARG;
+    return 0;
+}
+
+void IoUring::close()
+{
+    if (m_sqes   != MAP_FAILED)  munmap(m_sqes,   m_sqesSize);
+    if (m_cqRing != MAP_FAILED)  munmap(m_cqRing, m_cqRingSize);
+    if (m_sqRing != MAP_FAILED)  munmap(m_sqRing, m_sqRingSize);
+    m_sqes   = (io_uring_sqe*)MAP_FAILED;
+    m_cqRing = MAP_FAILED;
+    m_sqRing = MAP_FAILED;
+    if (m_fd >= 0)  ::close(m_fd);
+    m_fd = -1;
+}
+
+bool IoUring::write(int fd, const void* buffer, size_t count, uint64_t offset, uint64_t userData)
+{
+    unsigned tail = *m_sqTail;          // Only this thread updates the tail
+    unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= m_sqEntries)  return false;
+
+    unsigned index = tail & *m_sqMask;
+    io_uring_sqe* sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_WRITE;
+    sqe->fd        = fd;
+    sqe->addr      = (uint64_t)buffer;
+    sqe->len       = count;
+    sqe->off       = offset;
+    sqe->user_data = userData;
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++m_toSubmit;
+    return true;
+}
+
+int IoUring::submit(unsigned minComplete, unsigned timeoutUs)
+{
+    unsigned flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    void*  argp = nullptr;
+    size_t argSz = 0;
+    if (minComplete && timeoutUs && m_extArg) {
+        ts.tv_sec  = timeoutUs / 1000000;
+        ts.tv_nsec = (timeoutUs % 1000000) * 1000;
+        memset(&arg, 0, sizeof(arg));
+        arg.ts = (uint64_t)&ts;
+        argp   = &arg;
+        argSz  = sizeof(arg);
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+    int rc;
+    do {
+        rc = syscall(__NR_io_uring_enter, m_fd, m_toSubmit, minComplete, flags, argp, argSz);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0 && (errno == ETIME || errno == EBUSY)) {
+        return 0;                       // Timed out, or completions must be reaped first
+    }
+    if (rc < 0) {
+        logging::error("io_uring_enter failed: %m");
+        return rc;
+    }
+    m_toSubmit -= rc;
+    return 0;
+}
+
+bool IoUring::complete(uint64_t& userData, int& result)
+{
+    unsigned head = *m_cqHead;          // Only this thread updates the head
+    unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    if (head == tail)  return false;
+
+    const io_uring_cqe* cqe = &m_cqes[head & *m_cqMask];
+    userData = cqe->user_data;
+    result   = cqe->res;
+    __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+}
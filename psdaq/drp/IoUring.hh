@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace Drp {
+
+// Minimal io_uring interface for queueing positioned writes, implemented
+// directly on the system calls to avoid a dependency on liburing
+class IoUring
+{
+public:
+    IoUring();
+    ~IoUring();
+    int open(unsigned entries);
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+    // Queue a write of count bytes at the file offset; returns false when
+    // the submission queue is full
+    bool write(int fd, const void* buffer, size_t count, uint64_t offset, uint64_t userData);
+    // Submit queued writes and wait for at least minComplete completions,
+    // or until the timeout (if non-zero and supported by the kernel)
+    int submit(unsigned minComplete, unsigned timeoutUs = 0);
+    // Fetch the next completion, if any.  result is the write()'s return value
+    bool complete(uint64_t& userData, int& result);
+private:
+    int m_fd;
+    bool m_extArg;
+    unsigned m_toSubmit;
+    unsigned m_sqEntries;
+    void* m_sqRing;
+    size_t m_sqRingSize;
+    void* m_cqRing;
+    size_t m_cqRingSize;
+    io_uring_sqe* m_sqes;
+    size_t m_sqesSize;
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqArray;
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    io_uring_cqe* m_cqes;
+};
+
+}
@@ -32,8 +32,8 @@ static const char* cuts[] = {"NCalls",
 static void              read_roi(Roi& roi, DescData& descdata, const char* name, 
                                   unsigned columns, unsigned rows);
 // formerly psalg functions
-static std::vector<int>    project_x(NDArray<uint16_t>&, Roi&, unsigned);
-static std::vector<int>    project_y(NDArray<uint16_t>&, Roi&, unsigned);
+static void                project_x(NDArray<uint16_t>&, Roi&, unsigned, std::vector<int>&);
+static void                project_y(NDArray<uint16_t>&, Roi&, unsigned, std::vector<int>&);
 static void            rolling_average(std::vector<int>& a, 
                                        std::vector<double>& avg, 
                                        double fraction);
@@ -43,8 +43,6 @@ static void            rolling_average(std::vector<double>& a,
 //static void            rolling_average(NDArray<double>& a, 
 //                                       NDArray<double>& avg, 
 //                                       double fraction);
-static std::vector<double> finite_impulse_response(std::vector<double>& filter,
-                                               std::vector<double>& sample);
 static std::list<unsigned> find_peaks(std::vector<double>&, double, unsigned);
 static std::vector<double> parab_fit(double* input, unsigned len);
 static std::vector<double> parab_fit(double* qwf, unsigned ix, unsigned len, double nxta);
@@ -160,6 +158,7 @@ void OpalTTFex::configure(XtcData::ConfigIter& configo,
           }
       }
   }
+  m_fir.configure(m_fir_weights);
 
 #define GET_ENUM(a,b,c) {                                                \
     m_##a##_##b = descdata.get_value<int32_t>("fex." #a "." #b ":" #c); \
@@ -327,25 +326,27 @@ OpalTTFex::TTResult OpalTTFex::analyze(std::vector< XtcData::Array<uint8_t> >& s
   //
   //  Project signal ROI
   //
+  //  The projections are per worker, reused from event to event
+  static thread_local std::vector<int> sig, ref, sb;
   if (m_project_axis==0) {
-      m_sig = project_x(f, m_sig_roi, m_pedestal);
+      project_x(f, m_sig_roi, m_pedestal, sig);
       if (m_use_ref_roi)
-          m_ref = project_x(f, m_ref_roi, m_pedestal);
+          project_x(f, m_ref_roi, m_pedestal, ref);
       if (m_use_sb_roi)
-          m_sb  = project_x(f, m_sb_roi , m_pedestal);
+          project_x(f, m_sb_roi , m_pedestal, sb);
   }
   else {
-      m_sig = project_y(f, m_sig_roi, m_pedestal);
+      project_y(f, m_sig_roi, m_pedestal, sig);
       if (m_use_ref_roi)
-          m_ref = project_y(f, m_ref_roi, m_pedestal);
+          project_y(f, m_ref_roi, m_pedestal, ref);
       if (m_use_sb_roi)
-          m_sb  = project_y(f, m_sb_roi , m_pedestal);
+          project_y(f, m_sb_roi , m_pedestal, sb);
   }
 
   m_prescale_projections_counter++;
 
-  sigd.resize(m_sig.size());
-  std::vector<double> refd(m_sig.size());
+  sigd.resize(sig.size());
+  std::vector<double> refd(sig.size());
 
   // If the size stored in the file is out of date,
   // resetting the size to 0 here will cause a new m_ref_avg
@@ -360,7 +361,7 @@ OpalTTFex::TTResult OpalTTFex::analyze(std::vector< XtcData::Array<uint8_t> >& s
   // Checking that the projections of the ROIs are
   // consistent
   if (m_use_ref_roi) {
-     if (sigd.size() != m_ref.size()) {
+     if (sigd.size() != ref.size()) {
          logging::critical(
            "The size of the reference ROI and of the "
            "signal ROI are inconsistent with each other."
@@ -372,7 +373,7 @@ OpalTTFex::TTResult OpalTTFex::analyze(std::vector< XtcData::Array<uint8_t> >& s
       }
   }
   if (m_use_sb_roi) {
-      if (sigd.size() != m_sb.size()) {
+      if (sigd.size() != sb.size()) {
          logging::critical(
            "The size of the side band ROI and of the "
            "signal ROI are inconsistent with each other."
@@ -389,30 +390,30 @@ OpalTTFex::TTResult OpalTTFex::analyze(std::vector< XtcData::Array<uint8_t> >& s
   //
   if (m_use_sb_roi) {
       m_sb_avg_sem.take();
-      rolling_average(m_sb, m_sb_avg, m_sb_convergence);
+      rolling_average(sb, m_sb_avg, m_sb_convergence);
 
-      //    ndarray<const double,1> sbc = commonModeLROE(m_sb, m_sb_avg);
+      //    ndarray<const double,1> sbc = commonModeLROE(sb, m_sb_avg);
       std::vector<double>& sbc = m_sb_avg;
       m_sb_avg_sem.give();
 
       if (m_use_ref_roi)
-          for(unsigned i=0; i<m_sig.size(); i++) {
-              sigd[i] = double(m_sig[i])-sbc[i];
-              refd[i] = double(m_ref[i])-sbc[i];
+          for(unsigned i=0; i<sig.size(); i++) {
+              sigd[i] = double(sig[i])-sbc[i];
+              refd[i] = double(ref[i])-sbc[i];
           }
       else
-          for(unsigned i=0; i<m_sig.size(); i++)
-              sigd[i] = double(m_sig[i])-sbc[i];
+          for(unsigned i=0; i<sig.size(); i++)
+              sigd[i] = double(sig[i])-sbc[i];
   }
   else {
       if (m_use_ref_roi)
-          for(unsigned i=0; i<m_sig.size(); i++) {
-              sigd[i] = double(m_sig[i]);
-              refd[i] = double(m_ref[i]);
+          for(unsigned i=0; i<sig.size(); i++) {
+              sigd[i] = double(sig[i]);
+              refd[i] = double(ref[i]);
           }
       else
-          for(unsigned i=0; i<m_sig.size(); i++)
-              sigd[i] = double(m_sig[i]);
+          for(unsigned i=0; i<sig.size(); i++)
+              sigd[i] = double(sig[i]);
   }
 
   if (!m_use_ref_roi)
@@ -496,7 +497,8 @@ OpalTTFex::TTResult OpalTTFex::analyze(std::vector< XtcData::Array<uint8_t> >& s
   //
   //  Apply the digital filter
   //
-  std::vector<double> qwf = finite_impulse_response(m_fir_weights,sigd);
+  static thread_local std::vector<double> qwf;
+  m_fir.apply(sigd, qwf);
 
   _monitor_flt_sig( qwf );
 
@@ -618,35 +620,54 @@ void read_roi(Roi& roi, DescData& descdata, const char* name, unsigned columns,
 }
 
 
-std::vector<int> project_x(NDArray<uint16_t>& f, 
-                           Roi& roi,
-                           unsigned ped)
+//
+//  Rows of the ROI are added a whole row at a time, and a row is summed
+//  in a block of partial sums, so that the inner loops run over
+//  contiguous pixels and vectorize.
+//
+void project_x(NDArray<uint16_t>& f, 
+               Roi& roi,
+               unsigned ped,
+               std::vector<int>& result)
 {
 #ifdef DBUG2
   printf("proj_x roi [%u,%u],[%u,%u]\n",
          roi.x0,roi.x1,roi.y0,roi.y1);
 #endif
-  std::vector<int> result(roi.x1-roi.x0+1);
-  for(unsigned i=0; i<result.size(); i++) result[i]=-ped*(roi.y1-roi.y0+1);
+  const unsigned stride = f.shape()[1];
+  const unsigned nx     = roi.x1-roi.x0+1;
+  result.assign(nx, -ped*(roi.y1-roi.y0+1));
+  int* r = result.data();
   for(unsigned i=roi.y0; i<=roi.y1; i++) {
-    for(unsigned j=roi.x0, k=0; j<=roi.x1; j++,k++)
-      result[k] += f(i,j);
+    const uint16_t* p = f.data() + size_t(i)*stride + roi.x0;
+    for(unsigned k=0; k<nx; k++)
+      r[k] += p[k];
   }
-  return result;
 }
 
-std::vector<int> project_y(NDArray<uint16_t>& f, 
-                           Roi& roi,
-                           unsigned ped)
+void project_y(NDArray<uint16_t>& f, 
+               Roi& roi,
+               unsigned ped,
+               std::vector<int>& result)
 {
-  std::vector<int> result(roi.y1-roi.y0+1);
+  enum { Lanes = 16 };
+  const unsigned stride = f.shape()[1];
+  const unsigned nx     = roi.x1-roi.x0+1;
+  result.resize(roi.y1-roi.y0+1);
   for(unsigned i=roi.y0,k=0; i<=roi.y1; i++,k++) {
+    const uint16_t* p = f.data() + size_t(i)*stride + roi.x0;
+    int acc[Lanes] = {};
+    unsigned j=0;
+    for(; j+Lanes<=nx; j+=Lanes)
+      for(unsigned l=0; l<Lanes; l++)
+        acc[l] += p[j+l];
     int sum=0;
-    for(unsigned j=roi.x0; j<=roi.x1; j++)
-      sum += f(i,j);
-    result[k] = sum - ped*(roi.x1-roi.x0+1);
+    for(; j<nx; j++)
+      sum += p[j];
+    for(unsigned l=0; l<Lanes; l++)
+      sum += acc[l];
+    result[k] = sum - ped*nx;
   }
-  return result;
 }
 
 void rolling_average(std::vector<int>& a, std::vector<double>& avg, double fraction)
@@ -701,26 +722,6 @@ void rolling_average(std::vector<double>& a, std::vector<double>& avg, double fr
 //  }
 //} 
 
-std::vector<double> finite_impulse_response(std::vector<double>& filter,
-                                            std::vector<double>& sample)
-{
-  unsigned nf = filter.size();
-  if (sample.size()<filter.size()) {
-    logging::critical("OpalTTFex sample size %i smaller than filter size %i", sample.size(), filter.size()); 
-    throw("Error OpalTTFex sample size too small");
-  } else {
-    unsigned len = sample.size()-nf;
-    std::vector<double> result = std::vector<double>(len);
-    for(unsigned i=0; i<len; i++) {
-      double v = 0;
-      for(unsigned j=0; j<nf; j++)
-        v += sample[i+j]*filter[j];
-      result[i] = v;
-    }
-    return result;
-  }
-}
-
 std::list<unsigned> find_peaks(std::vector<double>& a,
                                double afrac,
                                unsigned max_peaks)
@@ -1,5 +1,7 @@
 #include <iostream>
 #include <atomic>
+#include <vector>
+#include <algorithm>
 #include <limits.h>
 #include <fcntl.h>
 #include <sys/msg.h>
@@ -93,9 +95,42 @@ static int drpSendReceive(int inpMqId, int resMqId, XtcData::TransitionId::Value
     return rc;
 }
 
+// In zero-copy mode the pebble is shared with Drp Python, so instead of copying
+// each dgram in and out of the per-worker shared memory buffers, only the pebble
+// offsets of a batch's L1Accept and SlowUpdate dgrams are sent, as 'b' followed by
+// as many 64-bit offsets as fit in a message.  Drp Python edits the dgrams in
+// place and replies once per message.
+static int drpSendReceiveBatch(int inpMqId, int resMqId, const std::vector<uint64_t>& offsets, unsigned threadNum)
+{
+    const unsigned maxOffsets = 63;     // 512 byte message queue messages
+    uint64_t msg[1 + maxOffsets];
+    char recvmsg[520];
+
+    memset(msg, 0, sizeof(msg[0]));
+    *(char*)msg = 'b';
+    for (unsigned first = 0; first < offsets.size(); first += maxOffsets) {
+        unsigned count = std::min<size_t>(offsets.size() - first, maxOffsets);
+        memcpy(&msg[1], &offsets[first], count * sizeof(msg[0]));
+
+        int rc = drpSend(inpMqId, (const char*)msg, (1 + count) * sizeof(msg[0]));
+        if (rc) {
+            logging::error("[Thread %u] Error sending batch of %u offsets to Drp python: %m", threadNum, count);
+            return rc;    // Return rather than abort so that teardown can happen
+        }
+
+        rc = drpRecv(resMqId, recvmsg, sizeof(recvmsg), 15000);
+        if (rc) {
+            logging::error("[Thread %u] Response message from Drp python not received: %m", threadNum);
+            return rc;    // Return rather than abort so that teardown can happen
+        }
+    }
+
+    return 0;
+}
+
 
 void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
-                SPSCQueue<Batch>& inputQueue, SPSCQueue<Batch>& outputQueue, bool pythonDrp,
+                SPSCQueue<Batch>& inputQueue, ReorderBuffer<Batch>& outputQueue, bool pythonDrp,
                 int inpMqId, int resMqId, int inpShmId, int resShmId, size_t shmemSize,
                 unsigned threadNum, std::atomic<int>& threadCountPush, std::atomic<int>& threadCountWrite,
                 int64_t& pythonTime)
@@ -110,6 +145,9 @@ void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
     char recvmsg[520];
     bool transition;
     bool error = false;
+    bool zeroCopy = pythonDrp && pool.pebble.shared();
+    std::vector<uint64_t> pyOffsets;    // Dgrams awaiting Drp Python (zero-copy mode)
+    std::vector<unsigned> pyL1Indices;  // L1Accepts awaiting their trigger primitive
 
     if (pythonDrp) {
 
@@ -149,11 +187,39 @@ void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
             return;     // Return rather than abort so that teardown can happen
         }
 
-        logging::debug("[Thread %u] Starting events", threadNum);
+        logging::debug("[Thread %u] Starting events%s", threadNum, zeroCopy ? " (zero-copy)" : "");
     }
 
     pythonTime = 0ll;
 
+    // Prepare the trigger primitive with whatever input is needed for the TEB to make trigger decisions
+    auto prepareL1TriggerPrimitive = [&](unsigned pebbleIndex) {
+        Pds::EbDgram* dgram = (Pds::EbDgram*)pool.pebble[pebbleIndex];
+        auto l3InpBuf = tebContributor.fetch(pebbleIndex);
+        Pds::EbDgram* l3InpDg = new(l3InpBuf) Pds::EbDgram(*dgram);
+
+        if (triggerPrimitive) { // else this DRP doesn't provide input
+            const void* l3BufEnd = (char*)l3InpDg + sizeof(*l3InpDg) + triggerPrimitive->size();
+            triggerPrimitive->event(pool, pebbleIndex, dgram->xtc, l3InpDg->xtc, l3BufEnd);
+        }
+    };
+
+    // Hand the dgrams accumulated so far to Drp Python in one exchange, then
+    // complete the L1Accepts that depend on its results
+    auto flushPython = [&]() {
+        if (pyOffsets.empty())  return;
+        auto t0{fast_monotonic_clock::now(CLOCK_MONOTONIC)};
+        auto rc = drpSendReceiveBatch(inpMqId, resMqId, pyOffsets, threadNum);
+        auto t1{fast_monotonic_clock::now(CLOCK_MONOTONIC)};
+        pythonTime = std::chrono::duration_cast<ns_t>(t1 - t0).count();
+        if (rc)  error = true;
+        for (auto pebbleIndex : pyL1Indices) {
+            prepareL1TriggerPrimitive(pebbleIndex);
+        }
+        pyOffsets.clear();
+        pyL1Indices.clear();
+    };
+
     while (true) {
 
         if (!inputQueue.pop(batch)) {
@@ -187,6 +253,12 @@ void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
                 const void* bufEnd = (char*)dgram + pool.bufferSize();
                 det->event(*dgram, bufEnd, event);
 
+                if (zeroCopy) {
+                    pyOffsets.push_back(pool.pebble.offset(dgram));
+                    pyL1Indices.push_back(pebbleIndex);
+                    continue;
+                }
+
                 if ( pythonDrp) {
                     XtcData::Dgram* inpDg = dgram;
                     memcpy(inpData, (void*)inpDg, sizeof(*inpDg) + inpDg->xtc.sizeofPayload());
@@ -199,14 +271,7 @@ void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
                     memcpy((void*)inpDg, resData, sizeof(*resDg) + resDg->xtc.sizeofPayload());
                 }
 
-                // Prepare the trigger primitive with whatever input is needed for the TEB to make trigger decisions
-                auto l3InpBuf = tebContributor.fetch(pebbleIndex);
-                Pds::EbDgram* l3InpDg = new(l3InpBuf) Pds::EbDgram(*dgram);
-
-                if (triggerPrimitive) { // else this DRP doesn't provide input
-                    const void* l3BufEnd = (char*)l3InpDg + sizeof(*l3InpDg) + triggerPrimitive->size();
-                    triggerPrimitive->event(pool, pebbleIndex, dgram->xtc, l3InpDg->xtc, l3BufEnd);
-                }
+                prepareL1TriggerPrimitive(pebbleIndex);
             // slow data
             } else if (transitionId == XtcData::TransitionId::SlowUpdate) {
                 // make new dgram in the pebble
@@ -225,7 +290,9 @@ void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
                 memcpy((void*)trDgram, (const void*)dgram, sizeof(*dgram) - sizeof(dgram->xtc));
                 det->slowupdate(trDgram->xtc, bufEnd);
 
-                if (pythonDrp) {
+                if (zeroCopy) {
+                    pyOffsets.push_back(pool.pebble.offset(trDgram));
+                } else if (pythonDrp) {
                     XtcData::Dgram* inpDg = trDgram;
                     memcpy(inpData, (void*)inpDg, sizeof(*inpDg) + inpDg->xtc.sizeofPayload());
                     auto rc = drpSendReceive(inpMqId, resMqId, transitionId, threadNum);
@@ -242,6 +309,10 @@ void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
                 transition = true;
                 Pds::EbDgram* trDgram = pool.transitionDgrams[pebbleIndex];
                 if (pythonDrp) {
+                    // The transition buffer is shared by all workers, so it
+                    // keeps going through the per-worker copy buffers.
+                    // Preserve the ordering of what Drp Python sees.
+                    flushPython();
                     XtcData::Dgram* inpDg = trDgram;
                     memcpy(inpData, (void*)inpDg, sizeof(*inpDg) + inpDg->xtc.sizeofPayload());
                     auto rc = drpSendReceive(inpMqId, resMqId, transitionId, threadNum);
@@ -255,6 +326,8 @@ void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
             }
         }
 
+        flushPython();
+
         if (pythonDrp) {
             // TODO: Comment
             // All but the last worker to get here set the batch size to 0.
@@ -265,7 +338,10 @@ void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
             }
         }
 
-        if (!error)  outputQueue.push(batch);
+        // Always push, so that the collector doesn't wait forever for this
+        // batch's sequence number, and let it release the buffers on failure
+        batch.failed = error;
+        outputQueue.push(batch.seq, batch);
     }
 
     if (pythonDrp) {
@@ -290,10 +366,20 @@ void workerFunc(const Parameters& para, DrpBase& drp, Detector* det,
     }
 }
 
+// Batches in flight are bounded by the sum of the worker input queue depths
+static unsigned resultsCapacity(unsigned nworkers, unsigned nbuffers)
+{
+    unsigned n = nworkers * nbuffers;
+    if (n <= 1)  return 1;
+    return 1u << (32 - __builtin_clz(n - 1));
+}
+
 PGPDetector::PGPDetector(const Parameters& para, DrpBase& drp, Detector* det,
                          bool pythonDrp, int* inpMqId, int* resMqId, int* inpShmId, int* resShmId,
                          size_t shmemSize) :
-    PgpReader(para, drp.pool, MAX_RET_CNT_C, para.batchSize), m_terminate(false),
+    PgpReader(para, drp.pool, MAX_RET_CNT_C, para.batchSize),
+    m_workerResults(resultsCapacity(para.nworkers, drp.pool.nbuffers())),
+    m_terminate(false),
     m_flushTmo(1.1 * drp.tebPrms().maxEntries * 14/13),
     m_shmemSize(shmemSize),
     m_pyAppTime(0),
@@ -302,6 +388,7 @@ PGPDetector::PGPDetector(const Parameters& para, DrpBase& drp, Detector* det,
     threadCountPush.store(0);
     threadCountWrite.store(0);
     m_nodeId = det->nodeId;
+    m_det = det;
     int* m_inpMqId = inpMqId;
     int* m_resMqId = resMqId;
     int* m_inpShmId = inpShmId;
@@ -330,7 +417,6 @@ PGPDetector::PGPDetector(const Parameters& para, DrpBase& drp, Detector* det,
 
     for (unsigned i=0; i<para.nworkers; i++) {
         m_workerInputQueues.emplace_back(SPSCQueue<Batch>(drp.pool.nbuffers()));
-        m_workerOutputQueues.emplace_back(SPSCQueue<Batch>(drp.pool.nbuffers()));
     }
 
     for (unsigned i = 0; i < para.nworkers; i++) {
@@ -339,7 +425,7 @@ PGPDetector::PGPDetector(const Parameters& para, DrpBase& drp, Detector* det,
                                      std::ref(drp),
                                      det,
                                      std::ref(m_workerInputQueues[i]),
-                                     std::ref(m_workerOutputQueues[i]),
+                                     std::ref(m_workerResults),
                                      pythonDrp,
                                      m_inpMqId[i],
                                      m_resMqId[i],
@@ -389,7 +475,12 @@ void PGPDetector::reader(std::shared_ptr<Pds::MetricExporter> exporter, Detector
                   [&](){return queueLength(m_workerInputQueues);});
 
     exporter->add("drp_worker_output_queue", labels, Pds::MetricType::Gauge,
-                  [&](){return queueLength(m_workerOutputQueues);});
+                  [&](){return m_workerResults.depth();});
+
+    // Time the collector spent waiting on a slow worker while batches
+    // completed by the others were already available
+    exporter->add("drp_hol_block_time", labels, Pds::MetricType::Counter,
+                  [&](){return m_workerResults.holBlockingTime();});
 
     uint64_t nDmaRet = 0L;
     exporter->add("drp_num_dma_ret", labels, Pds::MetricType::Gauge,
@@ -441,6 +532,7 @@ void PGPDetector::reader(std::shared_ptr<Pds::MetricExporter> exporter, Detector
                 if (Pds::fast_monotonic_clock::now(CLOCK_MONOTONIC) - tInitial > tmo) {
                     // Time out partial DRP batches
                     if (m_batch.size != 0) {
+                        m_batch.seq = worker;
                         m_workerInputQueues[worker % m_para.nworkers].push(m_batch);
                         worker++;
                         m_batch.start += m_batch.size;
@@ -471,6 +563,7 @@ void PGPDetector::reader(std::shared_ptr<Pds::MetricExporter> exporter, Detector
                 if ( stateTransition) {
                     if (m_batch.size > 1) {
                         m_batch.size--;
+                        m_batch.seq = worker;
                         m_workerInputQueues[worker % m_para.nworkers].push(m_batch);
                         worker++;
                         m_batch.start += m_batch.size;
@@ -516,10 +609,12 @@ void PGPDetector::reader(std::shared_ptr<Pds::MetricExporter> exporter, Detector
                     unsigned numWorkers = pythonDrp ? m_para.nworkers : 1;
 
                     for (unsigned w=0; w < numWorkers; w++) {
+                        m_batch.seq = worker;
                         m_workerInputQueues[worker % m_para.nworkers].push(m_batch);
                         worker++;
                     }
                 } else {
+                    m_batch.seq = worker;
                     m_workerInputQueues[worker % m_para.nworkers].push(m_batch);
                     worker++;
                 }
@@ -535,10 +630,10 @@ void PGPDetector::reader(std::shared_ptr<Pds::MetricExporter> exporter, Detector
 
 void PGPDetector::collector(Pds::Eb::TebContributor& tebContributor)
 {
-    int64_t worker = 0L;
     Batch batch;
     const unsigned bufferMask = m_pool.nDmaBuffers() - 1;
-    bool rc = m_workerOutputQueues[worker % m_para.nworkers].pop(batch);
+    const std::chrono::microseconds tmo(m_flushTmo);
+    bool rc = m_workerResults.popW(batch);
     while (rc) {
         for (unsigned i=0; i<batch.size; i++) {
             unsigned index = (batch.start + i) & bufferMask;
@@ -546,15 +641,27 @@ void PGPDetector::collector(Pds::Eb::TebContributor& tebContributor)
             if (event->mask == 0)
                 continue;               // Skip broken event
             unsigned pebbleIndex = event->pebbleIndex;
+            if (batch.failed) {
+                // Drop the event, but release its buffers like EbReceiver would
+                int lane = __builtin_ffs(event->mask) - 1;
+                auto timingHeader = m_det->getTimingHeader(event->buffers[lane].index);
+                if (timingHeader->service() != XtcData::TransitionId::L1Accept) {
+                    auto trDgram = m_pool.transitionDgrams[pebbleIndex];
+                    if (trDgram)  m_pool.freeTr(trDgram);
+                }
+                freeDma(event);
+                m_pool.freePebble();
+                continue;
+            }
             freeDma(event);
             tebContributor.process(pebbleIndex);
         }
-        worker++;
 
-        // Time out batches for the TEB
-        while (!m_workerOutputQueues[worker % m_para.nworkers].try_pop(batch)) { // Poll
-            if (tebContributor.timeout()) {                                      // After batch is timed out
-                rc = m_workerOutputQueues[worker % m_para.nworkers].popW(batch); // pend
+        // Time out batches for the TEB while waiting for the next batch in order
+        while (!(rc = m_workerResults.popW(batch, tmo))) { // Wait up to the TEB batch timeout
+            if (m_workerResults.terminated())  break;
+            if (tebContributor.timeout()) {                // After batch is timed out
+                rc = m_workerResults.popW(batch);          // pend
                 break;
             }
         }
@@ -587,9 +694,7 @@ void PGPDetector::shutdown()
         }
     }
     logging::info("Worker threads finished");
-    for (unsigned i = 0; i < m_para.nworkers; i++) {
-        m_workerOutputQueues[i].shutdown();
-    }
+    m_workerResults.shutdown();
 
     // Flush the DMA buffers
     flush();
@@ -6,6 +6,7 @@
 #include "Detector.hh"
 #include "drp.hh"
 #include "spscqueue.hh"
+#include "ReorderBuffer.hh"
 
 namespace Pds {
     class MetricExporter;
@@ -18,6 +19,8 @@ struct Batch
 {
     uint32_t start;
     uint32_t size;
+    uint64_t seq;                       // Dispatch order, restored after the workers
+    bool     failed;                    // A worker failed to process it: drop its events
 };
 
 class DrpBase;
@@ -36,11 +39,12 @@ public:
 private:
     static const int MAX_RET_CNT_C = 1000;
     std::vector<SPSCQueue<Batch> > m_workerInputQueues;
-    std::vector<SPSCQueue<Batch> > m_workerOutputQueues;
+    ReorderBuffer<Batch> m_workerResults;
     std::vector<std::thread> m_workerThreads;
     std::atomic<bool> m_terminate;
     Batch m_batch;
     unsigned m_nodeId;
+    Detector* m_det;
     int* m_inpMqId;
     int* m_resMqId;
     int* m_inpShmId;
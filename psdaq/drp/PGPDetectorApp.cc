@@ -183,6 +183,7 @@ static int startDrpPython(pid_t& pyPid, unsigned workerNum, long shmemSize, cons
                std::to_string(para.detSegment).c_str(),
                std::to_string(workerNum).c_str(),
                std::to_string(para.verbose).c_str(),
+               drp.pool.pebble.shared() ? "1" : "0",
                nullptr);
 
         // Execlp returns only on error
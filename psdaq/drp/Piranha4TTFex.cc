@@ -42,8 +42,6 @@ static void                rolling_average(std::vector<double>& a,
 //static void                rolling_average(NDArray<double>& a,
 //                                           NDArray<double>& avg,
 //                                           double fraction);
-static std::vector<double> finite_impulse_response(std::vector<double>& filter,
-                                                   std::vector<double>& sample);
 static std::list<unsigned> find_peaks(std::vector<double>&, double, unsigned);
 static std::vector<double> parab_fit(double* input, unsigned len);
 static std::vector<double> parab_fit(double* qwf, unsigned ix, unsigned len, double nxta);
@@ -153,6 +151,7 @@ void Piranha4TTFex::configure(XtcData::ConfigIter& configo,
       }
     }
   }
+  m_fir.configure(m_fir_weights);
 
 #define GET_ENUM(a,b,c) {                                                \
     m_##a##_##b = descdata.get_value<int32_t>("fex." #a "." #b ":" #c); \
@@ -403,7 +402,8 @@ Piranha4TTFex::TTResult Piranha4TTFex::analyze(std::vector< XtcData::Array<uint8
   //
   //  Apply the digital filter
   //
-  std::vector<double> qwf = finite_impulse_response(m_fir_weights,sigd);
+  static thread_local std::vector<double> qwf;
+  m_fir.apply(sigd, qwf);
 
   _monitor_flt_sig( qwf );
 
@@ -582,26 +582,6 @@ void rolling_average(std::vector<double>& a, std::vector<double>& avg, double fr
 //  }
 //}
 
-std::vector<double> finite_impulse_response(std::vector<double>& filter,
-                                            std::vector<double>& sample)
-{
-  unsigned nf = filter.size();
-  if (sample.size()<filter.size()) {
-    logging::critical("Piranha4TTFex sample size %i smaller than filter size %i", sample.size(), filter.size());
-    throw("Error Piranha4TTFex sample size too small");
-  } else {
-    unsigned len = sample.size()-nf;
-    std::vector<double> result = std::vector<double>(len);
-    for(unsigned i=0; i<len; i++) {
-      double v = 0;
-      for(unsigned j=0; j<nf; j++)
-        v += sample[i+j]*filter[j];
-      result[i] = v;
-    }
-    return result;
-  }
-}
-
 std::list<unsigned> find_peaks(std::vector<double>& a,
                                double afrac,
                                unsigned max_peaks)
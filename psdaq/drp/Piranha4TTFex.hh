@@ -8,6 +8,8 @@
 
 #include "psalg/calib/NDArray.hh"
 
+#include "FirFilter.hh"
+
 #include <vector>
 #include <string>
 
@@ -100,6 +102,7 @@ private:
     double   m_ref_convergence;
 
     std::vector<double> m_fir_weights;
+    FirFilter           m_fir;
     std::vector<double> m_calib_poly;
 
     bool m_ref_empty;
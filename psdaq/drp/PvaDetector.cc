@@ -48,38 +48,22 @@ struct PvaParameters : public Parameters
 
 };
 
-static const XtcData::TimeStamp TimeMax(std::numeric_limits<unsigned>::max(),
-                                        std::numeric_limits<unsigned>::max());
 static unsigned tsMatchDegree = 2;
 
 //
-//  Put all the ugliness of non-global timestamps here
+//  Put all the ugliness of non-global timestamps here: the key by which
+//  PV updates and events are matched, in ns
 //
-static int _compare(const XtcData::TimeStamp& ts1,
-                    const XtcData::TimeStamp& ts2) {
-  int result = 0;
-
-  if ((tsMatchDegree == 0) && !(ts2 == TimeMax))
-      return result;
-
+static uint64_t _matchKey(const XtcData::TimeStamp& ts)
+{
   if (tsMatchDegree == 1) {
     /*
     **  Mask out the fiducial
     */
     const uint64_t mask = 0xfffffffffffe0000ULL;
-    uint64_t ts1m = ts1.value()&mask;
-    uint64_t ts2m = ts2.value()&mask;
-
-    const uint64_t delta = 10000000; // 10 ms!
-    if      (ts1m > ts2m)  result = ts1m - ts2m > delta ?  1 : 0;
-    else if (ts2m > ts1m)  result = ts2m - ts1m > delta ? -1 : 0;
-
-    return result;
+    return XtcData::TimeStamp(ts.value()&mask).to_ns();
   }
-
-  if      (ts1 > ts2) result = 1;
-  else if (ts2 > ts1) result = -1;
-  return result;
+  return ts.to_ns();
 }
 
 template<typename T>
@@ -302,6 +286,7 @@ PvaDetector::PvaDetector(PvaParameters& para,
     m_evtQueue      (drp.pool.nbuffers()),
     m_pvQueue       (drp.pool.nbuffers()),
     m_bufferFreelist(m_pvQueue.size()),
+    m_pvMatcher     (m_pvQueue.size()),
     m_terminate     (false),
     m_running       (false),
     m_firstDimKw    (0)
@@ -389,6 +374,7 @@ unsigned PvaDetector::configure(const std::string& config_alias, XtcData::Xtc& x
     m_pvQueue.startup();
     m_evtQueue.startup();
     m_bufferFreelist.startup();
+    m_pvMatcher.clear([](XtcData::Dgram*){}); // Buffers are all put back below
     size_t bufSize = m_pool->pebble.bufferSize();
     m_buffer.resize(m_pvQueue.size() * bufSize);
     for(unsigned i = 0; i < m_pvQueue.size(); ++i) {
@@ -493,6 +479,12 @@ void PvaDetector::_worker()
     m_timeDiff = 0;
     m_exporter->add("drp_time_diff", labels, Pds::MetricType::Gauge,
                     [&](){return m_timeDiff;});
+    m_pvMatcher.clearStats();
+    m_exporter->add("drp_reorder_count", labels, Pds::MetricType::Counter,
+                    [&](){return m_pvMatcher.nReordered();});
+    m_exporter->add("drp_pending_updates", labels, Pds::MetricType::Gauge,
+                    [&](){return m_pvMatcher.size();});
+    m_pvMatcher.latency(m_exporter->latency("drp_match_latency", labels)); // ns, update to match
 
     m_exporter->add("drp_worker_input_queue", labels, Pds::MetricType::Gauge,
                     [&](){return m_evtQueue.guess_size();});
@@ -529,6 +521,12 @@ void PvaDetector::_worker()
                             std::stoul(Detector::m_para->kwargs["match_tmo_ms"])      :
                             1500) * 1000000;
 
+    // Window within which a PV update with a jittery timestamp still matches
+    const double msTol = (m_para.kwargs.find("match_tol_ms") != m_para.kwargs.end() ?
+                          std::stod(Detector::m_para->kwargs["match_tol_ms"])       :
+                          0.0);
+    m_pvMatcher.tolerance(tsMatchDegree == 1 ? 10000000 : uint64_t(msTol * 1000000)); // 10 ms when masked
+
     while (true) {
         if (m_terminate.load(std::memory_order_relaxed)) {
             break;
@@ -594,6 +592,12 @@ void PvaDetector::process(const XtcData::TimeStamp& timestamp)
 
 void PvaDetector::_matchUp()
 {
+    // Sort the updates that have arrived in amongst those still pending
+    XtcData::Dgram* pvDg;
+    while (!m_pvMatcher.full() && m_pvQueue.try_pop(pvDg)) {
+        m_pvMatcher.insert(_matchKey(pvDg->time), pvDg);
+    }
+
     while (true) {
         uint32_t pebbleIdx;
         if (!m_evtQueue.peek(pebbleIdx))  break;
@@ -605,22 +609,37 @@ void PvaDetector::_matchUp()
             continue;
         }
 
-        XtcData::Dgram* pvDg;
-        if (!m_pvQueue.peek(pvDg))  break;
+        if (m_pvMatcher.empty())  break;
 
-        m_timeDiff = pebbleDg->time.to_ns() - pvDg->time.to_ns();
+        uint64_t key = _matchKey(pebbleDg->time);
+        m_timeDiff = key - m_pvMatcher.oldest();
 
-        int result = _compare(pebbleDg->time, pvDg->time);
+        bool matched;
+        if (tsMatchDegree == 0) {
+            matched = m_pvMatcher.pop(pvDg);    // Any update will do
+        }
+        else {
+            matched = m_pvMatcher.match(key, pvDg);
+
+            // Updates older than this event can't match any that follow
+            m_pvMatcher.retire(key, [&](XtcData::Dgram* dg){ _handleOlder(dg, *pebbleDg); });
+        }
 
-        logging::debug("PGP: %u.%09d, PV: %u.%09d, PGP - PV: %12ld ns, pid %014lx, svc %2d, compare %c, latency %ld ms",
+        logging::debug("PGP: %u.%09d, PGP - PV: %12ld ns, pid %014lx, svc %2d, %s, pending %u, latency %ld ms",
                        pebbleDg->time.seconds(), pebbleDg->time.nanoseconds(),
-                       pvDg->time.seconds(), pvDg->time.nanoseconds(),
                        m_timeDiff, pebbleDg->pulseId(), pebbleDg->service(),
-                       result == 0 ? '=' : (result < 0 ? '<' : '>'), _deltaT<ms_t>(pebbleDg->time));
+                       matched ? "matched" : "unmatched", m_pvMatcher.size(), _deltaT<ms_t>(pebbleDg->time));
 
-        if      (result == 0)  _handleMatch  (*pvDg, *pebbleDg);
-        else if (result  < 0)  _handleYounger(*pvDg, *pebbleDg);
-        else                   _handleOlder  (*pvDg, *pebbleDg);
+        if (matched) {
+            _handleMatch(*pvDg, *pebbleDg);
+            m_bufferFreelist.push(pvDg);        // Return buffer to freelist
+        }
+        else if (m_pvMatcher.passed(key)) {
+            _handleYounger(*pebbleDg);          // Nothing arriving in order can match it
+        }
+        else {
+            break;                              // Wait for an update or the timeout
+        }
     }
 }
 
@@ -673,13 +692,9 @@ void PvaDetector::_handleMatch(const XtcData::Dgram& pvDg, Pds::EbDgram& pebbleD
                    pebbleDg.time.seconds(), pebbleDg.time.nanoseconds());
 
     _sendToTeb(pebbleDg, pebbleIdx);
-
-    XtcData::Dgram* dgram;
-    m_pvQueue.try_pop(dgram);       // Actually consume the element
-    m_bufferFreelist.push(dgram);   // Return buffer to freelist
 }
 
-void PvaDetector::_handleYounger(const XtcData::Dgram& pvDg, Pds::EbDgram& pebbleDg)
+void PvaDetector::_handleYounger(Pds::EbDgram& pebbleDg)
 {
     uint32_t pebbleIdx;
     m_evtQueue.try_pop(pebbleIdx);      // Actually consume the element
@@ -689,62 +704,57 @@ void PvaDetector::_handleYounger(const XtcData::Dgram& pvDg, Pds::EbDgram& pebbl
 
     ++m_nEmpty;
     logging::debug("PV too young!!    "
-                   "TimeStamps: PV %u.%09u > PGP %u.%09u",
-                   pvDg.time.seconds(), pvDg.time.nanoseconds(),
+                   "TimeStamps: PV %lu ns > PGP %u.%09u",
+                   m_pvMatcher.newest(),
                    pebbleDg.time.seconds(), pebbleDg.time.nanoseconds());
 
     _sendToTeb(pebbleDg, pebbleIdx);
 }
 
-void PvaDetector::_handleOlder(const XtcData::Dgram& pvDg, Pds::EbDgram& pebbleDg)
+void PvaDetector::_handleOlder(XtcData::Dgram* pvDg, const Pds::EbDgram& pebbleDg)
 {
     ++m_nTooOld;
     logging::debug("PV too old!!      "
                    "TimeStamps: PV %u.%09u < PGP %u.%09u [0x%08x%04x.%05x < 0x%08x%04x.%05x]",
-                   pvDg.time.seconds(), pvDg.time.nanoseconds(),
+                   pvDg->time.seconds(), pvDg->time.nanoseconds(),
                    pebbleDg.time.seconds(), pebbleDg.time.nanoseconds(),
-                   pvDg.time.seconds(), (pvDg.time.nanoseconds()>>16)&0xfffe, pvDg.time.nanoseconds()&0x1ffff,
+                   pvDg->time.seconds(), (pvDg->time.nanoseconds()>>16)&0xfffe, pvDg->time.nanoseconds()&0x1ffff,
                    pebbleDg.time.seconds(), (pebbleDg.time.nanoseconds()>>16)&0xfffe, pebbleDg.time.nanoseconds()&0x1ffff);
 
-    XtcData::Dgram* dgram;
-    m_pvQueue.try_pop(dgram);           // Actually consume the element
-    m_bufferFreelist.push(dgram);       // Return buffer to freelist
+    m_bufferFreelist.push(pvDg);        // Return buffer to freelist
 }
 
 void PvaDetector::_timeout(const XtcData::TimeStamp& timestamp)
 {
-    // Time out older PV updates
-    XtcData::Dgram* pvDg;
-    if (m_pvQueue.peek(pvDg)) {
-        if (!(pvDg->time > timestamp)) { // pvDg is newer than the timeout timestamp
-            m_pvQueue.try_pop(pvDg);     // Actually consume the element
-            m_bufferFreelist.push(pvDg); // Return buffer to freelist
-        }
-    }
+    // Time out older PV updates, all at once
+    m_pvMatcher.retire(_matchKey(timestamp), [&](XtcData::Dgram* pvDg) {
+        m_bufferFreelist.push(pvDg);    // Return buffer to freelist
+    });
 
-    // Time out older pending PGP datagrams
+    // Time out older pending PGP datagrams, as many as there are after a
+    // stall rather than one per idle pass
     uint32_t index;
-    if (!m_evtQueue.peek(index))  return;
-
-    Pds::EbDgram& dgram = *reinterpret_cast<Pds::EbDgram*>(m_pool->pebble[index]);
-    if (dgram.time > timestamp)  return; // dgram is newer than the timeout timestamp
-
-    uint32_t idx;
-    m_evtQueue.try_pop(idx);             // Actually consume the element
-    assert(idx == index);
-
-    if (dgram.service() == XtcData::TransitionId::L1Accept) {
-        // No PVA data so mark event as damaged
-        dgram.xtc.damage.increase(XtcData::Damage::TimedOut);
-        ++m_nTimedOut;
-        logging::debug("Event timed out!! "
-                       "TimeStamp:  %u.%09u [0x%08x%04x.%05x], age %ld ms",
-                       dgram.time.seconds(), dgram.time.nanoseconds(),
-                       dgram.time.seconds(), (dgram.time.nanoseconds()>>16)&0xfffe, dgram.time.nanoseconds()&0x1ffff,
-                       _deltaT<ms_t>(dgram.time));
-    }
+    while (m_evtQueue.peek(index)) {
+        Pds::EbDgram& dgram = *reinterpret_cast<Pds::EbDgram*>(m_pool->pebble[index]);
+        if (dgram.time > timestamp)  break; // dgram is newer than the timeout timestamp
+
+        uint32_t idx;
+        m_evtQueue.try_pop(idx);            // Actually consume the element
+        assert(idx == index);
+
+        if (dgram.service() == XtcData::TransitionId::L1Accept) {
+            // No PVA data so mark event as damaged
+            dgram.xtc.damage.increase(XtcData::Damage::TimedOut);
+            ++m_nTimedOut;
+            logging::debug("Event timed out!! "
+                           "TimeStamp:  %u.%09u [0x%08x%04x.%05x], age %ld ms",
+                           dgram.time.seconds(), dgram.time.nanoseconds(),
+                           dgram.time.seconds(), (dgram.time.nanoseconds()>>16)&0xfffe, dgram.time.nanoseconds()&0x1ffff,
+                           _deltaT<ms_t>(dgram.time));
+        }
 
-    _sendToTeb(dgram, index);
+        _sendToTeb(dgram, index);
+    }
 }
 
 void PvaDetector::_sendToTeb(const Pds::EbDgram& dgram, uint32_t index)
@@ -1110,10 +1120,15 @@ int main(int argc, char* argv[])
             if (kwargs.first == "pebbleBufSize")  continue;  // DrpBase
             if (kwargs.first == "pebbleBufCount") continue;  // DrpBase
             if (kwargs.first == "batching")       continue;  // DrpBase
+            if (kwargs.first == "result_fanout")  continue;  // DrpBase
             if (kwargs.first == "directIO")       continue;  // DrpBase
+            if (kwargs.first == "writeQueueDepth") continue;  // DrpBase
+            if (kwargs.first == "stripeDirs")  continue;  // DrpBase
+            if (kwargs.first == "xtcIndex")       continue;  // DrpBase
             if (kwargs.first == "pva_addr")       continue;  // DrpBase
             if (kwargs.first == "firstdim")       continue;
             if (kwargs.first == "match_tmo_ms")   continue;
+            if (kwargs.first == "match_tol_ms")   continue;
             logging::critical("Unrecognized kwarg '%s=%s'\n",
                               kwargs.first.c_str(), kwargs.second.c_str());
             return 1;
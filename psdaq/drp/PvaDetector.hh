@@ -8,6 +8,7 @@
 #include "DrpBase.hh"
 #include "XpmDetector.hh"
 #include "spscqueue.hh"
+#include "TimeMatcher.hh"
 #include "psdaq/epicstools/PvMonitorBase.hh"
 #include "psdaq/service/Collection.hh"
 
@@ -63,8 +64,8 @@ private:
     void _matchUp();
     void _handleTransition(uint32_t pebbleIdx, Pds::EbDgram* pebbleDg);
     void _handleMatch(const XtcData::Dgram& pvDg, Pds::EbDgram& pgpDg);
-    void _handleYounger(const XtcData::Dgram& pvDg, Pds::EbDgram& pgpDg);
-    void _handleOlder(const XtcData::Dgram& pvDg, Pds::EbDgram& pgpDg);
+    void _handleYounger(Pds::EbDgram& pgpDg);
+    void _handleOlder(XtcData::Dgram* pvDg, const Pds::EbDgram& pgpDg);
     void _sendToTeb(const Pds::EbDgram& dgram, uint32_t index);
 private:
     enum {RawNamesIndex = NamesIndex::BASE, InfoNamesIndex};
@@ -75,6 +76,7 @@ private:
     SPSCQueue<uint32_t> m_evtQueue;
     SPSCQueue<XtcData::Dgram*> m_pvQueue;
     SPSCQueue<XtcData::Dgram*> m_bufferFreelist;
+    TimeMatcher<XtcData::Dgram*> m_pvMatcher; // Updates taken off m_pvQueue, by time
     std::vector<uint8_t> m_buffer;
     std::atomic<bool> m_terminate;
     std::atomic<bool> m_running;
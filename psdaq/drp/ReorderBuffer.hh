@@ -0,0 +1,183 @@
+#ifndef REORDERBUFFER_H
+#define REORDERBUFFER_H
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <condition_variable>
+#include <cstdio>
+
+#include "psdaq/service/fast_monotonic_clock.hh"
+
+// Multi-producer, single-consumer buffer that restores the order of items
+// completed out of order.  Each item carries the sequence number it was
+// dispatched with; producers publish it into the slot for that number and
+// the consumer drains contiguous completed items from the head.  The number
+// of items in flight must not exceed the capacity.
+template <typename T>
+class ReorderBuffer
+{
+    using us_t = std::chrono::microseconds;
+public:
+    ReorderBuffer(unsigned capacity) :
+        m_slots(new Slot[capacity]),
+        m_capacity(capacity),
+        m_mask(capacity - 1),
+        m_terminate(false),
+        m_waiting(false),
+        m_pushWaiting(0),
+        m_head(0),
+        m_published(0),
+        m_holTime(0)
+    {
+        if ((capacity & (capacity - 1)) != 0) {
+            fprintf(stderr, "ReorderBuffer capacity must be a power of 2, got %u\n", capacity);
+            throw "ReorderBuffer capacity must be a power of 2";
+        };
+        for (unsigned i = 0; i < capacity; ++i) {
+            m_slots[i].ready.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    ReorderBuffer(const ReorderBuffer&) = delete;
+    void operator=(const ReorderBuffer&) = delete;
+
+    // Called by any producer with the item's sequence number
+    void push(uint64_t seq, const T& value)
+    {
+        // Guard against overwriting a slot that hasn't yet been drained
+        if (!_room(seq)) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pushWaiting.fetch_add(1, std::memory_order_acq_rel);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_space.wait(lock, [this, seq] { return _room(seq) || m_terminate.load(std::memory_order_acquire); });
+            m_pushWaiting.fetch_sub(1, std::memory_order_acq_rel);
+            if (!_room(seq))  return;
+        }
+        Slot& slot = m_slots[seq & m_mask];
+        slot.value = value;
+        m_published.fetch_add(1, std::memory_order_acq_rel);
+        slot.ready.store(seq + 1, std::memory_order_release);
+        // avoid reordering of the ready store and the waiting load
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiting.load(std::memory_order_acquire)) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.notify_one();
+        }
+    }
+
+    // non blocking in-order read
+    bool try_pop(T& value)
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[head & m_mask];
+        if (slot.ready.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+        value = slot.value;
+        m_head.store(head + 1, std::memory_order_release);
+        // avoid reordering of the head store and the waiting load
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_pushWaiting.load(std::memory_order_acquire)) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_space.notify_all();
+        }
+        return true;
+    }
+
+    // blocking in-order read; returns false when shut down
+    bool popW(T& value)
+    {
+        while (!_wait(us_t::max())) {
+            if (m_terminate.load(std::memory_order_acquire))  return false;
+        }
+        return try_pop(value);
+    }
+
+    // blocking in-order read with a timeout; returns false on timeout or
+    // when shut down
+    bool popW(T& value, us_t tmo)
+    {
+        return _wait(tmo) && try_pop(value);
+    }
+
+    // Number of items published but not yet drained
+    uint64_t depth() const
+    {
+        return m_published.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    // Total time in us the consumer waited for the head item while later
+    // items were already complete
+    uint64_t holBlockingTime() const { return m_holTime.load(std::memory_order_relaxed); }
+
+    bool terminated() const { return m_terminate.load(std::memory_order_acquire); }
+
+    void shutdown()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_terminate.store(true, std::memory_order_release);
+        m_condition.notify_one();
+        m_space.notify_all();
+    }
+
+private:
+    bool _room(uint64_t seq) const
+    {
+        return seq - m_head.load(std::memory_order_acquire) < m_capacity;
+    }
+
+    bool _ready() const
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        return m_slots[head & m_mask].ready.load(std::memory_order_acquire) == head + 1;
+    }
+
+    // Wait for the head item to be published, accounting for the time
+    // during which it blocked the ones published after it
+    bool _wait(us_t tmo)
+    {
+        if (_ready())  return true;
+
+        bool blocked = depth() != 0;
+        auto t0 = Pds::fast_monotonic_clock::now(CLOCK_MONOTONIC);
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_waiting.store(true, std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto pred = [this] { return _ready() || m_terminate.load(std::memory_order_acquire); };
+            if (tmo == us_t::max())
+                m_condition.wait(lock, pred);
+            else
+                m_condition.wait_for(lock, tmo, pred);
+            m_waiting.store(false, std::memory_order_release);
+        }
+        if (blocked) {
+            auto t1 = Pds::fast_monotonic_clock::now(CLOCK_MONOTONIC);
+            m_holTime.fetch_add(std::chrono::duration_cast<us_t>(t1 - t0).count(),
+                                std::memory_order_relaxed);
+        }
+        return _ready();
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> ready;    // Sequence number + 1 once published
+        T value;
+    };
+    std::unique_ptr<Slot[]> m_slots;
+    unsigned m_capacity;
+    unsigned m_mask;
+    std::atomic<bool> m_terminate;
+    std::atomic<bool> m_waiting;
+    std::atomic<unsigned> m_pushWaiting;
+    alignas(64) std::atomic<uint64_t> m_head;
+    alignas(64) std::atomic<uint64_t> m_published;
+    std::atomic<uint64_t> m_holTime;
+    std::mutex m_mutex;
+    std::condition_variable m_condition; // Consumer waits for the head item
+    std::condition_variable m_space;     // Producers wait for a free slot
+};
+
+#endif // REORDERBUFFER_H
@@ -0,0 +1,197 @@
+#ifndef TIMEMATCHER_H
+#define TIMEMATCHER_H
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+#include "psdaq/service/LatencyHistogram.hh"
+#include "psdaq/service/fast_monotonic_clock.hh"
+
+// Single threaded store of pending updates (PV values, slow BLD, etc.) kept
+// sorted by timestamp in a ring, so that an event can be matched against
+// them by timestamp rather than only against the oldest one.  Updates that
+// arrive out of order are slotted in where they belong, a lookup within the
+// tolerance window is a binary search, and all the updates that have become
+// too old to ever match are retired in one go.  Keys are timestamps in ns.
+template <typename T>
+class TimeMatcher
+{
+    using ns_t = std::chrono::nanoseconds;
+public:
+    TimeMatcher(unsigned capacity, uint64_t tolerance = 0) :
+        m_entries(capacity),
+        m_mask(capacity - 1),
+        m_tolerance(tolerance),
+        m_head(0),
+        m_tail(0)
+    {
+        if ((capacity & (capacity - 1)) != 0) {
+            fprintf(stderr, "TimeMatcher capacity must be a power of 2, got %u\n", capacity);
+            throw "TimeMatcher capacity must be a power of 2";
+        };
+        clearStats();
+    }
+
+    TimeMatcher(const TimeMatcher&) = delete;
+    void operator=(const TimeMatcher&) = delete;
+
+    // Add an update; returns false, leaving it to the caller, when full
+    bool insert(uint64_t key, const T& value)
+    {
+        if (full())  return false;
+
+        // Typically the newest: walk back from the tail otherwise, which is
+        // short for the jitter this is for
+        uint64_t pos = m_tail;
+        while (pos != m_head && _at(pos - 1).key > key) {
+            _at(pos) = _at(pos - 1);
+            --pos;
+        }
+        if (pos != m_tail)  ++m_nReordered;
+        Entry& entry = _at(pos);
+        entry.key   = key;
+        entry.value = value;
+        entry.t0    = Pds::fast_monotonic_clock::now(CLOCK_MONOTONIC);
+        ++m_tail;
+        ++m_nInserted;
+        return true;
+    }
+
+    // Remove and return the update closest to key, if one lies within the
+    // tolerance of it
+    bool match(uint64_t key, T& value)
+    {
+        // The closest is either the first at or after key or the one before
+        uint64_t pos = _lowerBound(key);
+        if (pos != m_head &&
+            (pos == m_tail || key - _at(pos - 1).key < _at(pos).key - key))
+            --pos;
+        if (pos == m_tail || _distance(_at(pos).key, key) > m_tolerance)
+            return false;
+        _erase(pos, value);
+        ++m_nMatched;
+        return true;
+    }
+
+    // Remove and return the oldest update, regardless of its timestamp
+    bool pop(T& value)
+    {
+        if (empty())  return false;
+        _erase(m_head, value);
+        ++m_nMatched;
+        return true;
+    }
+
+    // Retire all updates older than key, less the tolerance, handing each
+    // to retire(value); returns how many there were
+    template <typename F>
+    unsigned retire(uint64_t key, F&& retire)
+    {
+        uint64_t lo  = key > m_tolerance ? key - m_tolerance : 0;
+        uint64_t end = _lowerBound(lo);
+        unsigned n   = end - m_head;
+        while (m_head != end) {
+            Entry& entry = _at(m_head++);
+            _record(entry);
+            retire(entry.value);
+        }
+        m_nRetired += n;
+        return n;
+    }
+
+    // Retire everything, e.g. on Enable
+    template <typename F>
+    void clear(F&& retire)
+    {
+        while (m_head != m_tail)
+            retire(_at(m_head++).value);
+    }
+
+    // True when an update exists beyond the tolerance window of key, in
+    // which case nothing that arrives in order can still match it
+    bool passed(uint64_t key) const
+    {
+        return !empty() && _at(m_tail - 1).key > key + m_tolerance;
+    }
+
+    bool     empty()    const { return m_head == m_tail; }
+    bool     full()     const { return m_tail - m_head == m_entries.size(); }
+    unsigned size()     const { return m_tail - m_head; }
+    unsigned capacity() const { return m_entries.size(); }
+    uint64_t oldest()   const { return _at(m_head).key; }
+    uint64_t newest()   const { return _at(m_tail - 1).key; }
+    uint64_t tolerance() const { return m_tolerance; }
+    void     tolerance(uint64_t tolerance) { m_tolerance = tolerance; }
+
+    // Records the time updates wait in the matcher, in ns
+    void latency(const std::shared_ptr<Pds::LatencyHistogram>& histogram) { m_latency = histogram; }
+
+    uint64_t nInserted () const { return m_nInserted;  }
+    uint64_t nMatched  () const { return m_nMatched;   }
+    uint64_t nRetired  () const { return m_nRetired;   } // Too old to match
+    uint64_t nReordered() const { return m_nReordered; } // Arrived out of order
+    void     clearStats()
+    {
+        m_nInserted = m_nMatched = m_nRetired = m_nReordered = 0;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        T        value;
+        Pds::fast_monotonic_clock::time_point t0;
+    };
+
+    Entry&       _at(uint64_t pos)       { return m_entries[pos & m_mask]; }
+    const Entry& _at(uint64_t pos) const { return m_entries[pos & m_mask]; }
+
+    static uint64_t _distance(uint64_t a, uint64_t b) { return a > b ? a - b : b - a; }
+
+    // First position whose key is not less than key
+    uint64_t _lowerBound(uint64_t key) const
+    {
+        uint64_t lo = m_head;
+        uint64_t hi = m_tail;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (_at(mid).key < key)  lo = mid + 1;
+            else                     hi = mid;
+        }
+        return lo;
+    }
+
+    // Matches are near the head, so close the gap from that side
+    void _erase(uint64_t pos, T& value)
+    {
+        _record(_at(pos));
+        value = _at(pos).value;
+        for (; pos != m_head; --pos)
+            _at(pos) = _at(pos - 1);
+        ++m_head;
+    }
+
+    void _record(const Entry& entry)
+    {
+        if (m_latency) {
+            auto dt = Pds::fast_monotonic_clock::now(CLOCK_MONOTONIC) - entry.t0;
+            m_latency->record(std::chrono::duration_cast<ns_t>(dt).count());
+        }
+    }
+
+private:
+    std::vector<Entry> m_entries;
+    uint64_t m_mask;
+    uint64_t m_tolerance;
+    uint64_t m_head;                    // Oldest update
+    uint64_t m_tail;                    // One past the newest
+    std::shared_ptr<Pds::LatencyHistogram> m_latency;
+    uint64_t m_nInserted;
+    uint64_t m_nMatched;
+    uint64_t m_nRetired;
+    uint64_t m_nReordered;
+};
+
+#endif // TIMEMATCHER_H
@@ -990,29 +990,30 @@ void UdpEncoder::_handleL1Accept(Pds::EbDgram& pgpDg, const encoder_frame_t& fra
 
 void UdpEncoder::_timeout(const XtcData::TimeStamp& timestamp)
 {
-    // Time out older pending PGP datagrams
+    // Time out older pending PGP datagrams, as many as there are after a
+    // stall rather than one per idle pass
     uint32_t index;
-    if (!m_evtQueue.peek(index))  return;
-
-    Pds::EbDgram& dgram = *reinterpret_cast<Pds::EbDgram*>(m_pool->pebble[index]);
-    if (dgram.time > timestamp)  return;  // dgram is newer than the timeout timestamp
-
-    uint32_t idx;
-    auto rc = m_evtQueue.try_pop(idx);              // Actually consume the element
-    if (rc)  assert(idx == index);
-
-    if (dgram.service() == XtcData::TransitionId::L1Accept) {
-        // No encoder data so mark event as damaged
-        dgram.xtc.damage.increase(XtcData::Damage::TimedOut);
-        ++m_nTimedOut;
-        logging::debug("Event timed out!! "
-                       "TimeStamp:  %u.%09u [0x%08x%04x.%05x], age %ld ms",
-                       dgram.time.seconds(), dgram.time.nanoseconds(),
-                       dgram.time.seconds(), (dgram.time.nanoseconds()>>16)&0xfffe, dgram.time.nanoseconds()&0x1ffff,
-                       _deltaT<ms_t>(dgram.time));
-    }
+    while (m_evtQueue.peek(index)) {
+        Pds::EbDgram& dgram = *reinterpret_cast<Pds::EbDgram*>(m_pool->pebble[index]);
+        if (dgram.time > timestamp)  break;   // dgram is newer than the timeout timestamp
+
+        uint32_t idx;
+        auto rc = m_evtQueue.try_pop(idx);              // Actually consume the element
+        if (rc)  assert(idx == index);
+
+        if (dgram.service() == XtcData::TransitionId::L1Accept) {
+            // No encoder data so mark event as damaged
+            dgram.xtc.damage.increase(XtcData::Damage::TimedOut);
+            ++m_nTimedOut;
+            logging::debug("Event timed out!! "
+                           "TimeStamp:  %u.%09u [0x%08x%04x.%05x], age %ld ms",
+                           dgram.time.seconds(), dgram.time.nanoseconds(),
+                           dgram.time.seconds(), (dgram.time.nanoseconds()>>16)&0xfffe, dgram.time.nanoseconds()&0x1ffff,
+                           _deltaT<ms_t>(dgram.time));
+        }
 
-    _sendToTeb(dgram, index);
+        _sendToTeb(dgram, index);
+    }
 }
 
 void UdpEncoder::_sendToTeb(const Pds::EbDgram& dgram, uint32_t index)
@@ -1399,7 +1400,11 @@ int main(int argc, char* argv[])
             if (kwargs.first == "pebbleBufSize")  continue;  // DrpBase
             if (kwargs.first == "pebbleBufCount") continue;  // DrpBase
             if (kwargs.first == "batching")       continue;  // DrpBase
+            if (kwargs.first == "result_fanout")  continue;  // DrpBase
             if (kwargs.first == "directIO")       continue;  // DrpBase
+            if (kwargs.first == "writeQueueDepth") continue;  // DrpBase
+            if (kwargs.first == "stripeDirs")  continue;  // DrpBase
+            if (kwargs.first == "xtcIndex")       continue;  // DrpBase
             if (kwargs.first == "pva_addr")       continue;  // DrpBase
             if (kwargs.first == "match_tmo_ms")   continue;
             if (kwargs.first == "slowGroup")      continue;
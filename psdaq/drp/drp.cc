@@ -116,6 +116,7 @@ int main(int argc, char* argv[])
         if (kwargs.first == "ep_provider")       continue;  // PGPDetectorApp
         if (kwargs.first == "drp")               continue;  // PGPDetectorApp
         if (kwargs.first == "pythonScript")      continue;  // PGPDetectorApp
+        if (kwargs.first == "pythonZeroCopy")    continue;  // PGPDetectorApp
         if (kwargs.first == "sim_length")        continue;  // XpmDetector
         if (kwargs.first == "timebase")          continue;  // XpmDetector
         if (kwargs.first == "xpmpv")             continue;  // BEBDetector
@@ -124,7 +125,11 @@ int main(int argc, char* argv[])
         if (kwargs.first == "pebbleBufSize")     continue;  // DrpBase
         if (kwargs.first == "pebbleBufCount")    continue;  // DrpBase
         if (kwargs.first == "batching")          continue;  // DrpBase
+        if (kwargs.first == "result_fanout")     continue;  // DrpBase
         if (kwargs.first == "directIO")          continue;  // DrpBase
+        if (kwargs.first == "writeQueueDepth")   continue;  // DrpBase
+        if (kwargs.first == "stripeDirs")    continue;  // DrpBase
+        if (kwargs.first == "xtcIndex")          continue;  // DrpBase
         if (kwargs.first == "pva_addr")          continue;  // DrpBase
         if (para.detType == "opal") {
             if (kwargs.first == "simxtc")            continue;  // Opal
@@ -75,13 +75,11 @@ struct PGPEvent
 class Pebble
 {
 public:
-    ~Pebble() {
-        if (m_buffer) {
-            delete m_buffer;
-            m_buffer = nullptr;
-        }
-    }
-    void create(unsigned nL1Buffers, size_t l1BufSize, unsigned nTrBuffers, size_t trBufSize);
+    ~Pebble();
+    // When shmKey is given, the pebble is allocated in a POSIX shared memory
+    // segment of that name so that other processes (Drp Python) can map it
+    void create(unsigned nL1Buffers, size_t l1BufSize, unsigned nTrBuffers, size_t trBufSize,
+                const std::string& shmKey = std::string());
 
     inline uint8_t* operator [] (unsigned index) {
         uint64_t offset = index*m_bufferSize;
@@ -89,10 +87,17 @@ public:
     }
     size_t size() const {return m_size;}
     size_t bufferSize() const {return m_bufferSize;}
+    bool shared() const {return !m_shmKey.empty();}
+    // Offset of a location in the pebble
+    uint64_t offset(const void* p) const {return (const uint8_t*)p - m_buffer;}
+    // Offset of a dgram as exchanged with Drp Python, which parses the
+    // XtcData::Dgram that follows the EbDgram's PulseId
+    uint64_t offset(const Pds::EbDgram* dgram) const;
 private:
     size_t   m_size;
     size_t   m_bufferSize;
     uint8_t* m_buffer;
+    std::string m_shmKey;
 };
 
 class MemPool
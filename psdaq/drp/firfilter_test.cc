@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "FirFilter.hh"
+
+//
+//  Checks FirFilter against a plain nested loop, for filters short enough
+//  to be applied directly as well as long ones that use FFT convolution.
+//
+
+static void reference(const std::vector<double>& sample,
+                      const std::vector<double>& weights,
+                      std::vector<double>&       result)
+{
+    unsigned nf = weights.size();
+    result.resize(sample.size()-nf);
+    for(unsigned i=0; i<result.size(); i++) {
+        double v = 0;
+        for(unsigned j=0; j<nf; j++)
+            v += sample[i+j]*weights[j];
+        result[i] = v;
+    }
+}
+
+static std::vector<double> random_vector(unsigned n, double scale)
+{
+    std::vector<double> v(n);
+    for(unsigned i=0; i<n; i++)
+        v[i] = scale*(double(rand())/RAND_MAX - 0.5);
+    return v;
+}
+
+//  Returns the number of failures
+static unsigned check(unsigned nf, unsigned ns, double tolerance)
+{
+    Drp::FirFilter filter;
+    std::vector<double> weights = random_vector(nf, 1.);
+    std::vector<double> sample  = random_vector(ns, 4096.);
+    filter.configure(weights);
+
+    std::vector<double> expected, result;
+    reference(sample, weights, expected);
+    filter.apply(sample, result);
+
+    if (result.size() != expected.size()) {
+        printf("FAIL nf %u ns %u: result size %zu, expected %zu\n",
+               nf, ns, result.size(), expected.size());
+        return 1;
+    }
+
+    double maxdiff = 0;
+    for(unsigned i=0; i<result.size(); i++)
+        maxdiff = std::max(maxdiff, fabs(result[i]-expected[i]));
+
+    bool ok = maxdiff <= tolerance;
+    printf("%s nf %4u ns %5u: max deviation %g\n", ok ? "ok  " : "FAIL", nf, ns, maxdiff);
+    return ok ? 0 : 1;
+}
+
+int main()
+{
+    srand(1);
+
+    unsigned nfail = 0;
+
+    //  Direct convolution reproduces the nested loop exactly, including the
+    //  outputs beyond the last full block
+    nfail += check(   8,  1024, 0.);
+    nfail += check(  16,  1000, 0.);
+    nfail += check(  31,    47, 0.);
+
+    //  FFT convolution over an odd and an even number of blocks, and short
+    //  samples for which the long filter is still applied directly
+    nfail += check( 200,  4096, 1e-6);
+    nfail += check( 200,  2000, 1e-6);
+    nfail += check( 500, 16384, 1e-6);
+    nfail += check(  64,   100, 1e-6);
+
+    //  A sample no longer than the filter has no outputs
+    nfail += check(  40,    40, 0.);
+
+    //  A sample shorter than the filter is an error
+    Drp::FirFilter filter;
+    filter.configure(std::vector<double>(10, 1.));
+    std::vector<double> result;
+    bool thrown = false;
+    try {
+        filter.apply(std::vector<double>(5, 1.), result);
+    }
+    catch(...) {
+        thrown = true;
+    }
+    printf("%s short sample %s\n", thrown ? "ok  " : "FAIL", thrown ? "rejected" : "accepted");
+    if (!thrown)  nfail++;
+
+    printf("%u failures\n", nfail);
+    return nfail ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "drp.hh"
+#include "psdaq/service/EbDgram.hh"
+#include "xtcdata/xtc/Dgram.hh"
+#include "xtcdata/xtc/TypeId.hh"
+
+//
+//  Round-trips an event through the pebble the way the zero-copy path to
+//  Drp Python does: the DRP builds an EbDgram in a pebble buffer and hands
+//  over its offset, Python reads the service from the env and saves an
+//  edited Dgram in place, and the DRP carries on with the EbDgram.
+//
+
+using namespace XtcData;
+
+static unsigned nfail = 0;
+
+static void check(bool ok, const char* what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)  nfail++;
+}
+
+int main()
+{
+    const unsigned nL1Buffers = 4;
+    const size_t   l1BufSize  = 1024;
+    const unsigned nTrBuffers = 2;
+    const size_t   trBufSize  = 1024;
+
+    Drp::Pebble pebble;
+    pebble.create(nL1Buffers, l1BufSize, nTrBuffers, trBufSize);
+
+    // What the DRP does with an L1Accept
+    const uint64_t pid   = 0x123456789abcull;
+    const unsigned index = 2;
+    Transition     tr(Transition::Event, TransitionId::L1Accept, TimeStamp(1, 2), 0x0001);
+    Dgram          dg(tr, Xtc(TypeId(TypeId::Parent, 0), Src(7)));
+    auto dgram = new(pebble[index]) Pds::EbDgram(Pds::PulseId(pid), dg);
+    const uint32_t payload[] = {0xdeadbeef, 0xfeedface};
+    memcpy(dgram->xtc.alloc(sizeof(payload), (char*)dgram + pebble.bufferSize()), payload, sizeof(payload));
+
+    uint64_t offset = pebble.offset(dgram);
+    const uint8_t* base = pebble[0];
+
+    // What Drp Python does with the offset
+    check(offset == index * pebble.bufferSize() + sizeof(Pds::PulseId),
+          "offset is of the Dgram following the PulseId");
+
+    uint32_t env;
+    memcpy(&env, base + offset + 8, sizeof(env));
+    check(((env >> 24) & 0xf) == TransitionId::L1Accept, "service read from the env at offset+8");
+
+    auto view = reinterpret_cast<const Dgram*>(base + offset);
+    check(view->xtc.sizeofPayload() == sizeof(payload) &&
+          memcmp(view->xtc.payload(), payload, sizeof(payload)) == 0,
+          "payload parsed at the offset");
+
+    // Save an edited dgram in place, using no more than the buffer less the
+    // PulseId, and check the DRP sees it under its EbDgram header
+    size_t viewSize = pebble.bufferSize() - sizeof(Pds::PulseId);
+    std::vector<char> edited(sizeof(Dgram) + sizeof(uint32_t));
+    Dgram* out = new(edited.data()) Dgram(*view);
+    out->xtc.extent = sizeof(Xtc) + sizeof(uint32_t);
+    const uint32_t result = 0xcafef00d;
+    memcpy(out->xtc.payload(), &result, sizeof(result));
+    check(edited.size() <= viewSize, "edited dgram fits the view");
+    memcpy((uint8_t*)base + offset, edited.data(), edited.size());
+
+    check(dgram->pulseId() == pid, "PulseId is intact after the save");
+    check(dgram->service() == TransitionId::L1Accept &&
+          dgram->time == TimeStamp(1, 2), "Dgram header is intact after the save");
+    check(dgram->xtc.sizeofPayload() == sizeof(result) &&
+          memcmp(dgram->xtc.payload(), &result, sizeof(result)) == 0,
+          "edited payload seen through the EbDgram");
+
+    printf("%u failures\n", nfail);
+    return nfail ? 1 : 0;
+}
@@ -702,7 +702,11 @@ int main(int argc, char* argv[])
             if (kwargs.first == "pebbleBufSize")     continue;  // DrpBase
             if (kwargs.first == "pebbleBufCount")    continue;  // DrpBase
             if (kwargs.first == "batching")          continue;  // DrpBase
+            if (kwargs.first == "result_fanout")     continue;  // DrpBase
             if (kwargs.first == "directIO")          continue;  // DrpBase
+            if (kwargs.first == "writeQueueDepth")   continue;  // DrpBase
+            if (kwargs.first == "stripeDirs")    continue;  // DrpBase
+            if (kwargs.first == "xtcIndex")          continue;  // DrpBase
             if (kwargs.first == "pva_addr")          continue;  // DrpBase
             logging::critical("Unrecognized kwarg '%s=%s'\n",
                               kwargs.first.c_str(), kwargs.second.c_str());
@@ -13,13 +13,14 @@ detector_id = sys.argv[7]
 detector_segment = int(sys.argv[8])
 worker_num = int(sys.argv[9])
 verbose = int(sys.argv[10])
+zero_copy = len(sys.argv) > 11 and sys.argv[11] == "1"
 
 logging.basicConfig(format='%(filename)s L%(lineno)04d: <%(levelname).1s> %(message)s',
                     level=logging.INFO if verbose==0 else logging.DEBUG)
 
 
 class IPCInfo:
-    def __init__(self, partition, detector_name, detector_segment, worker_num, shm_mem_size):
+    def __init__(self, partition, detector_name, detector_segment, worker_num, shm_mem_size, zero_copy):
 
         keybase = f"p{partition}_{detector_name}_{detector_segment}";
 
@@ -33,6 +34,14 @@ class IPCInfo:
             self.shm_res = posix_ipc.SharedMemory(f"/shmres_{keybase}_{worker_num}")
         except posix_ipc.Error as exp:
             assert(False)
+        # With zero_copy, the DRP's pebble is shared and L1Accept/SlowUpdate
+        # dgrams are edited in place, identified by their offsets in it
+        self.shm_pebble = None
+        if zero_copy:
+            try:
+                self.shm_pebble = posix_ipc.SharedMemory(f"/shmpebble_{keybase}")
+            except posix_ipc.Error as exp:
+                assert(False)
 
 class DrpInfo:
     def __init__(self, detector_name, detector_type, detector_id, detector_segment, worker_num, pebble_bufsize, transition_bufsize, ipc_info):
@@ -48,7 +57,7 @@ class DrpInfo:
         self.tcp_socket_name = None
         self.ipc_socket_name = f"ipc:///tmp/{detector_name}_{detector_segment}.pipe"
 
-ipc_info = IPCInfo(partition, detector_name, detector_segment, worker_num, shm_mem_size)
+ipc_info = IPCInfo(partition, detector_name, detector_segment, worker_num, shm_mem_size, zero_copy)
 drp_info = DrpInfo(detector_name, detector_type, detector_id, detector_segment, worker_num, pebble_bufsize, transition_bufsize, ipc_info)
 
 try:
@@ -72,3 +81,5 @@ finally:
     ipc_info.mq_res.close()
     ipc_info.shm_inp.close_fd()
     ipc_info.shm_res.close_fd()
+    if ipc_info.shm_pebble is not None:
+        ipc_info.shm_pebble.close_fd()
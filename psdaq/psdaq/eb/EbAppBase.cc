@@ -69,6 +69,7 @@ EbAppBase::EbAppBase(const EbParams&         prms,
 
 EbAppBase::~EbAppBase()
 {
+  // Subclasses overriding _freeRegion() must call _freeRegions() themselves
   for (auto& region : _region)
   {
     if (region)  free(region);
@@ -77,11 +78,32 @@ EbAppBase::~EbAppBase()
   _region.clear();
 }
 
+void* EbAppBase::_allocRegion(unsigned rmtId, size_t size)
+{
+  return allocRegion(size);
+}
+
+void EbAppBase::_freeRegion(unsigned rmtId, void* region, size_t size)
+{
+  free(region);
+}
+
+void EbAppBase::_freeRegions()
+{
+  for (unsigned rmtId = 0; rmtId < _region.size(); ++rmtId)
+  {
+    if (_region[rmtId])  _freeRegion(rmtId, _region[rmtId], _regSize[rmtId]);
+    _region[rmtId]  = nullptr;
+    _regSize[rmtId] = 0;
+  }
+}
+
 int EbAppBase::resetCounters()
 {
   _bufferCnt = 0;
   if (_fixupSrc)  _fixupSrc->clear();
   if (_ctrbSrc)   _ctrbSrc ->clear();
+  for (auto& hist : _arrTimeHist)  if (hist)  hist->clear();
   EventBuilder::resetCounters();
 
   return 0;
@@ -168,6 +190,14 @@ int EbAppBase::connect(unsigned maxTrBuffers)
     _exporter->add("EB_arrTime" + std::to_string(i), labels, MetricType::Gauge, [=](){ return arrTime(i); });
   }
 
+  // Distribution of each contributor's arrival time relative to the creation
+  // of the event, in us: 64 bins of 50 us, with longer times in the overflow
+  _arrTimeHist.resize(nCtrbs);
+  for (auto i = 0u; i < nCtrbs; ++i)
+  {
+    _arrTimeHist[i] = _exporter->histogram("EB_arrTimeHist" + std::to_string(i), labels, 64, 50.0);
+  }
+
   _fixupSrc = _exporter->histogram("EB_FxUpSc", labels, nCtrbs);
   _ctrbSrc  = _exporter->histogram("EB_CtrbSc", labels, nCtrbs); // Revisit: For testing
 
@@ -213,9 +243,9 @@ int EbAppBase::_linksConfigure(const EbParams&            prms,
     // Reallocate the region if the required size has changed
     if (regSize != _regSize[rmtId])
     {
-      if (_region[rmtId])  free(_region[rmtId]);
+      if (_region[rmtId])  _freeRegion(rmtId, _region[rmtId], _regSize[rmtId]);
 
-      _region[rmtId] = allocRegion(regSize);
+      _region[rmtId] = _allocRegion(rmtId, regSize);
       if (!_region[rmtId])
       {
         logging::error("%s:\n  "
@@ -248,13 +278,12 @@ int EbAppBase::_linksConfigure(const EbParams&            prms,
   return 0;
 }
 
-int EbAppBase::process()
+int EbAppBase::process(int msTmo)
 {
   int rc;
 
   // Pend for an input datagram and pass it to the event builder
   uint64_t  data;
-  const int msTmo = 100;
   if ( (rc = _transport.pend(&data, msTmo)) < 0)
   {
     if (rc == -FI_EAGAIN)
@@ -329,9 +358,9 @@ int EbAppBase::process()
     }
   }
 
-  // Tr space bufSize value is irrelevant since idg has EOL set in that case
   if ((_idxSrcs & (1ull << src)) == 0)  data = 0;
-  EventBuilder::process(idg, _maxBufSize[src], data);
+  EventBuilder::process(idg, data);
+  _arrTimeHist[src]->observe(double(arrTime(src)) / 1000.0);
 
   ++_bufferCnt;
 
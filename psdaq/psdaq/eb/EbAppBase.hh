@@ -50,12 +50,16 @@ namespace Pds {
       void             unconfigure();
       void             disconnect();
       void             shutdown();
-      int              process();
+      int              process(int msTmo = 100);
       void             post(const EbDgram* const* begin,
                             const EbDgram** const end);
       void             trim(unsigned dst);
     protected:
       const std::vector<size_t>& bufferSizes() const;
+      // Inbound MR space allocation; may be overridden to place it elsewhere
+      virtual void*    _allocRegion(unsigned rmtId, size_t size);
+      virtual void     _freeRegion (unsigned rmtId, void* region, size_t size);
+      void             _freeRegions();
     public:                            // For EventBuilder
       virtual void     fixup(Pds::Eb::EbEvent* event, unsigned srcId);
       virtual uint64_t contract(const Pds::EbDgram* contrib) const;
@@ -78,6 +82,7 @@ namespace Pds {
       uint64_t                  _bufferCnt;
       PromHisto_t               _fixupSrc;
       PromHisto_t               _ctrbSrc;
+      std::vector<PromHisto_t>  _arrTimeHist;
     private:
       std::vector<size_t>       _regSize;
       std::vector<void*>        _region;
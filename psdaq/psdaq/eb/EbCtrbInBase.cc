@@ -2,6 +2,7 @@
 
 #include "Endpoint.hh"
 #include "EbLfServer.hh"
+#include "EbLfClient.hh"
 #include "TebContributor.hh"
 #include "ResultDgram.hh"
 
@@ -29,6 +30,7 @@ using namespace Pds;
 using namespace Pds::Eb;
 using logging  = psalg::SysLog;
 using ms_t     = std::chrono::milliseconds;
+using ns_t     = std::chrono::nanoseconds;
 
 
 struct Tbuf
@@ -57,6 +59,7 @@ static void _tbDump()
   }
 }
 
+// A size of 0 indicates the entries are packed, as is the case for Inputs
 static void dumpBatch(const TebContributor& ctrb,
                       const EbDgram*        batch,
                       const size_t          size,
@@ -73,7 +76,8 @@ static void dumpBatch(const TebContributor& ctrb,
     printf("  %2u: %16p, %15s, pid %014lx, diff %016lx, RoG %2hx, dmg %04x, idx %u %s\n",
            i, dg, svc, pid, pid - bPid, rog, dmg, index, dg->isEOL() ? "EOL" : "");
     if (dg->isEOL())  return;
-    dg = reinterpret_cast<const EbDgram*>(reinterpret_cast<const char*>(dg) + size);
+    auto sz = size ? size : sizeof(*dg) + dg->xtc.sizeofPayload();
+    dg = reinterpret_cast<const EbDgram*>(reinterpret_cast<const char*>(dg) + sz);
     ++index;
   }
   printf("  EOL not found!\n");
@@ -83,6 +87,7 @@ static void dumpBatch(const TebContributor& ctrb,
 EbCtrbInBase::EbCtrbInBase(const TebCtrbParams&                   prms,
                            const std::shared_ptr<MetricExporter>& exporter) :
   _transport    (prms.verbose, prms.kwargs),
+  _rlyTransport (prms.verbose, prms.kwargs),
   _maxResultSize(0),
   _batchCount   (0),
   _eventCount   (0),
@@ -90,7 +95,10 @@ EbCtrbInBase::EbCtrbInBase(const TebCtrbParams&                   prms,
   _bypassCount  (0),
   _noProgCount  (0),
   _prvNPCnt     (0),
+  _relayCount   (0),
+  _iPidPrv      (0),
   _prms         (prms),
+  _exporter     (exporter),
   _regSize      (0),
   _region       (nullptr)
 {
@@ -106,6 +114,7 @@ EbCtrbInBase::EbCtrbInBase(const TebCtrbParams&                   prms,
   exporter->add("TCtbI_DefSz",  labels, MetricType::Counter, [&](){ return _deferred.size();     });
   exporter->add("TCtbI_BypCt",  labels, MetricType::Counter, [&](){ return _bypassCount;         });
   exporter->add("TCtbI_NPrgCt", labels, MetricType::Counter, [&](){ return _noProgCount;         });
+  exporter->add("TCtbI_RlyCt",  labels, MetricType::Counter, [&](){ return _relayCount;          });
 }
 
 EbCtrbInBase::~EbCtrbInBase()
@@ -123,6 +132,7 @@ int EbCtrbInBase::resetCounters()
 
   _noProgCount = 0;
   _prvNPCnt    = 0;
+  _relayCount  = 0;
 
   return 0;
 }
@@ -134,6 +144,13 @@ void EbCtrbInBase::shutdown()
 
 void EbCtrbInBase::disconnect()
 {
+  for (auto link : _rlyLinks)  _rlyTransport.disconnect(link);
+  _rlyLinks.clear();
+  _rlyLatHist.clear();
+
+  for (auto link : _rlyInLinks)  _transport.disconnect(link);
+  _rlyInLinks.clear();
+
   for (auto link : _links)  _transport.disconnect(link);
   _links.clear();
 }
@@ -144,7 +161,8 @@ void EbCtrbInBase::unconfigure()
 
 int EbCtrbInBase::startConnection(std::string& port)
 {
-  int rc = _transport.listen(_prms.ifAddr, port, MAX_TEBS);
+  // Allow for a DRP relaying Results to us in addition to the TEBs
+  int rc = _transport.listen(_prms.ifAddr, port, MAX_TEBS + 1);
   if (rc)
   {
     logging::error("%s:\n  Failed to initialize %s EbLfServer on %s:%s",
@@ -161,9 +179,108 @@ int EbCtrbInBase::connect()
 
   _links.resize(numEbs);
 
-  int rc = linksConnect(_transport, _links, _prms.id, "TEB");
+  if (!_prms.relayed && _prms.rlyAddrs.empty())
+    return linksConnect(_transport, _links, _prms.id, "TEB");
+
+  // The parent DRP's link shares the completion queue sized by the first accept
+  unsigned numLinks = numEbs + (_prms.relayed ? 1 : 0);
+
+  // Accept the TEBs' links before any of the relay tree's.  A TEB connects to
+  // all DRPs before it exchanges IDs with any of them, so it would otherwise
+  // wait on a parent DRP that waits on its children, which wait on the TEB.
+  int rc = _linksAccept(numEbs, numLinks);
   if (rc)  return rc;
 
+  // Connect to the DRPs we relay Results to before accepting our parent's
+  // link, because our parent's connection to us can't complete before we do.
+  // Connections thus complete from the leaves of the relay tree up.
+  std::map<std::string, std::string> labels{{"instrument", _prms.instrument},
+                                            {"partition", std::to_string(_prms.partition)},
+                                            {"detname", _prms.detName},
+                                            {"detseg", std::to_string(_prms.detSegment)},
+                                            {"alias", _prms.alias}};
+  _rlyLinks.resize(_prms.rlyAddrs.size());
+  _rlyLatHist.resize(_rlyLinks.size());
+  for (unsigned i = 0; i < _rlyLinks.size(); ++i)
+  {
+    const char*    addr = _prms.rlyAddrs[i].c_str();
+    const char*    port = _prms.rlyPorts[i].c_str();
+    const unsigned msTmo(14750);        // < control.py transition timeout
+    if ( (rc = _rlyTransport.connect(&_rlyLinks[i], addr, port, msTmo)) )
+    {
+      logging::error("%s:\n  Error connecting to relay DRP at %s:%s",
+                     __PRETTY_FUNCTION__, addr, port);
+      return rc;
+    }
+    // Relaying DRPs identify themselves with IDs beyond those of the TEBs
+    if ( (rc = _rlyLinks[i]->exchangeId(MAX_TEBS + _prms.id, "DRP")) )
+    {
+      logging::error("%s:\n  Error exchanging IDs with relay DRP at %s:%s",
+                     __PRETTY_FUNCTION__, addr, port);
+      return rc;
+    }
+    logging::info("Outbound link with DRP ID %2d at %s:%s connected for relaying",
+                  _rlyLinks[i]->id(), addr, port);
+
+    labels["drp"] = std::to_string(_rlyLinks[i]->id());
+    _rlyLatHist[i] = _exporter->latency("TCtbI_RlyLatQ", labels); // ns
+  }
+
+  if (_prms.relayed)
+  {
+    rc = _linksAccept(1, numLinks);
+    if (rc)  return rc;
+  }
+
+  if (_rlyInLinks.size() != (_prms.relayed ? 1u : 0u))
+  {
+    logging::error("%s:\n  Expected %u relaying DRP(s), got %zu",
+                   __PRETTY_FUNCTION__, _prms.relayed ? 1 : 0, _rlyInLinks.size());
+    return -1;
+  }
+
+  return 0;
+}
+
+// Accept count links, telling the TEBs and the parent DRP apart by the ID
+// they present
+int EbCtrbInBase::_linksAccept(unsigned count, unsigned numLinks)
+{
+  std::vector<EbLfSvrLink*> tmpLinks(count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    int            rc;
+    const unsigned msTmo(14750);        // < control.py transition timeout
+    if ( (rc = _transport.connect(&tmpLinks[i], numLinks, msTmo)) )
+    {
+      logging::error("%s:\n  Error connecting to a TEB or DRP for link[%u]",
+                     __PRETTY_FUNCTION__, i);
+      return rc;
+    }
+  }
+  for (auto link : tmpLinks)
+  {
+    int rc;
+    if ( (rc = link->exchangeId(_prms.id, "TEB")) )
+    {
+      logging::error("%s:\n  Error exchanging IDs with a TEB or DRP",
+                     __PRETTY_FUNCTION__);
+      return rc;
+    }
+    unsigned rmtId = link->id();
+    if (rmtId < MAX_TEBS)
+    {
+      _links[rmtId] = link;
+      logging::info("Inbound  link with TEB ID %2d connected", rmtId);
+    }
+    else
+    {
+      _rlyInLinks.push_back(link);
+      logging::info("Inbound  link with DRP ID %2d connected for relaying",
+                    rmtId - MAX_TEBS);
+    }
+  }
+
   return 0;
 }
 
@@ -177,6 +294,21 @@ int EbCtrbInBase::configure(unsigned numTebBuffers)
   int rc = _linksConfigure(_links, numTebBuffers, "TEB");
   if (rc)  return rc;
 
+  // The Results region is sized by the TEBs, so relay links can only be set
+  // up afterwards.  Those to our children go before the one from our parent,
+  // so that, like connecting, configuration completes from the leaves up.
+  if (!_rlyLinks.empty())
+  {
+    rc = linksConfigure(_rlyLinks, _region, _regSize, "DRP");
+    if (rc)  return rc;
+  }
+
+  if (!_rlyInLinks.empty())
+  {
+    rc = _linksConfigure(_rlyInLinks, numTebBuffers, "DRP");
+    if (rc)  return rc;
+  }
+
   return 0;
 }
 
@@ -299,6 +431,8 @@ int EbCtrbInBase::_process(TebContributor& ctrb)
       // This does something only if errors prevented replenishment in pend/poll
       for (auto link : _links)
         link->postCompRecv(0);
+      for (auto link : _rlyInLinks)
+        link->postCompRecv(0);
     }
     else if (_transport.pollEQ() == -FI_ENOTCONN)
       rc = -FI_ENOTCONN;
@@ -314,6 +448,10 @@ int EbCtrbInBase::_process(TebContributor& ctrb)
   auto     ofs = idx * _maxResultSize;
   auto     bdg = static_cast<const ResultDgram*>(lnk->lclAdx(ofs)); // (char*)_region + ofs;
 
+  // Pass the batch on down the relay tree before working on it ourselves
+  if ((ImmData::flg(data) & ImmData::Relay) && !_rlyLinks.empty())
+    _relay(bdg, ofs, data);
+
   if (UNLIKELY(_prms.verbose >= VL_BATCH))
   {
     auto     pid     = bdg->pulseId();
@@ -333,6 +471,41 @@ int EbCtrbInBase::_process(TebContributor& ctrb)
   return 0;
 }
 
+int EbCtrbInBase::_relay(const ResultDgram* results,
+                         size_t             offset,
+                         uint64_t           data)
+{
+  // Result entries have a fixed size, so the extent is found from the EOL
+  auto   result = results;
+  size_t extent = _maxResultSize;
+  for (unsigned i = 1; (i < MAX_ENTRIES) && !result->isEOL(); ++i)
+  {
+    result  = reinterpret_cast<const ResultDgram*>(reinterpret_cast<const char*>(result) + _maxResultSize);
+    extent += _maxResultSize;
+  }
+
+  // The batch is written to the same offset in the children's regions and
+  // keeps the TEB's immediate data, so to them it looks as if from the TEB
+  int rc = 0;
+  for (unsigned i = 0; i < _rlyLinks.size(); ++i)
+  {
+    auto link = _rlyLinks[i];
+    auto t0   = std::chrono::steady_clock::now();
+    if ( (rc = link->post(results, extent, offset, data)) < 0)
+    {
+      logging::error("%s:\n  Failed to relay batch @ %16p, pid %014lx, sz %6zd to DRP %2u: rc %d",
+                     __PRETTY_FUNCTION__, results, results->pulseId(), extent, link->id(), rc);
+      continue;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    _rlyLatHist[i]->record(std::chrono::duration_cast<ns_t>(t1 - t0).count());
+  }
+
+  ++_relayCount;
+
+  return rc;
+}
+
 void EbCtrbInBase::_matchUp(TebContributor&    ctrb,
                             const ResultDgram* results)
 {
@@ -462,7 +635,6 @@ void EbCtrbInBase::_deliver(TebContributor&     ctrb,
   auto       result  = results;
   auto       input   = inputs;
   const auto rSize   = _maxResultSize;
-  const auto iSize   = _prms.maxInputSize;
   auto       rPid    = result->pulseId();
   auto       iPid    = input->pulseId();
   unsigned   idx     = ctrb.index(inputs);
@@ -506,11 +678,10 @@ void EbCtrbInBase::_deliver(TebContributor&     ctrb,
 
     if (rPid == iPid)
     {
-      static uint64_t iPidPrv = 0;
-      if (UNLIKELY(!(iPid > iPidPrv)))
+      if (UNLIKELY(!(iPid > _iPidPrv)))
       {
         logging::critical("%s:\n  iPid %014lx <= iPidPrv %014lx",
-                          __PRETTY_FUNCTION__, iPid, iPidPrv);
+                          __PRETTY_FUNCTION__, iPid, _iPidPrv);
         unsigned rIdx = ((char*)result - (char*)_region) / _maxResultSize;
         unsigned iIdx = ctrb.index(input);
         printf("*** results %p, result %p, rIdx %u, rpid %014lx, inputs %p, input %p, iIdx %u, iPid %014lx\n",
@@ -519,7 +690,7 @@ void EbCtrbInBase::_deliver(TebContributor&     ctrb,
         _tbDump();
         throw "Input pulse ID didn't advance";
       }
-      iPidPrv = iPid;
+      _iPidPrv = iPid;
 
       process(*result, idx++);
 
@@ -532,7 +703,9 @@ void EbCtrbInBase::_deliver(TebContributor&     ctrb,
         return;
       }
 
-      input = reinterpret_cast<const EbDgram*>(reinterpret_cast<const char*>(input) + iSize);
+      // Inputs were packed when the batch was posted
+      input = reinterpret_cast<const EbDgram*>(reinterpret_cast<const char*>(input) +
+                                               sizeof(*input) + input->xtc.sizeofPayload());
 
       iPid = input->pulseId();
     }
@@ -602,6 +775,6 @@ void EbCtrbInBase::_dump(TebContributor&    ctrb,
   if (inputs)
   {
     printf("Inputs:\n");
-    dumpBatch(ctrb, inputs, _prms.maxInputSize, ctrb.index(inputs));
+    dumpBatch(ctrb, inputs, 0, ctrb.index(inputs));
   }
 }
@@ -2,6 +2,7 @@
 #define Pds_Eb_EbCtrbInBase_hh
 
 #include "EbLfServer.hh"
+#include "EbLfClient.hh"
 
 #include <memory>
 #include <string>
@@ -13,6 +14,7 @@
 namespace Pds
 {
   class MetricExporter;
+  class LatencyHistogram;
   class EbDgram;
 
   namespace Eb
@@ -44,7 +46,11 @@ namespace Pds
       int     _linksConfigure(std::vector<EbLfSvrLink*>& links,
                               unsigned                   numBuffers,
                               const char*                name);
+      int     _linksAccept(unsigned count, unsigned numLinks);
       int     _process(TebContributor& ctrb);
+      int     _relay(const ResultDgram* results,
+                     size_t             offset,
+                     uint64_t           data);
       void    _matchUp(TebContributor&    ctrb,
                        const ResultDgram* results);
       void    _defer(const ResultDgram* results);
@@ -59,6 +65,10 @@ namespace Pds
     private:
       EbLfServer                    _transport;
       std::vector<EbLfSvrLink*>     _links;
+      std::vector<EbLfSvrLink*>     _rlyInLinks;  // From our parent DRP, if any
+      EbLfClient                    _rlyTransport;
+      std::vector<EbLfCltLink*>     _rlyLinks;    // To our child DRPs
+      std::vector<std::shared_ptr<LatencyHistogram> > _rlyLatHist; // Per child DRP
       size_t                        _maxResultSize;
       const EbDgram*                _inputs;
       std::list<const ResultDgram*> _deferred;
@@ -68,7 +78,10 @@ namespace Pds
       uint64_t                      _bypassCount;
       uint64_t                      _noProgCount;
       uint64_t                      _prvNPCnt;
+      uint64_t                      _relayCount;
+      uint64_t                      _iPidPrv;     // Per instance: several may share a process
       const TebCtrbParams&          _prms;
+      std::shared_ptr<MetricExporter> _exporter;
       size_t                        _regSize;
       void*                         _region;
     };
@@ -34,6 +34,8 @@ EbEvent::EbEvent(uint64_t            contract,
                  const time_point_t& t0) :
   _contract(contract),
   _t0      (t0),
+  _deadline(0),
+  _timedOut(false),
   _immData (immData),                   // May be 0 (invalid), else valid
   _damage  (0),
   _last    (_contributions)
@@ -72,6 +74,10 @@ EbEvent::EbEvent(uint64_t            contract,
 
 EbEvent* EbEvent::_add(const EbDgram* cdg, unsigned immData)
 {
+  // Drop late contributions to an event that was fixed up by the timeout
+  // while waiting for older events to be retired
+  if (_timedOut)  return this;
+
   if (immData > MAX_ENTRIES)            // Require some upper bits to be set
     _immData = immData;                 // Don't overwrite a valid value with 0
 
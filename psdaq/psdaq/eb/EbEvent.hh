@@ -56,6 +56,8 @@ namespace Pds {
       uint64_t             _remaining;       // List of clients which have contributed
       const uint64_t       _contract;        // -> potential list of contributors
       time_point_t         _t0;              // Starting time of timeout
+      uint64_t             _deadline;        // Deadline ring position + 1, or 0
+      bool                 _timedOut;        // Fixed up by the timeout
       unsigned             _immData;         // A contribution's immediate data
       XtcData::Damage      _damage;          // Accumulate damage about this event
       const Pds::EbDgram** _last;            // Pointer into the contributions array
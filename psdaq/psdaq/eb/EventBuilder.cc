@@ -26,6 +26,8 @@ static constexpr unsigned CLS = 64;     // Cache Line Size
 EventBuilder::EventBuilder(unsigned        timeout,
                            const unsigned& verbose) :
   _pending     (),
+  _dlHead      (0),
+  _dlTail      (0),
   _eventTimeout(uint64_t(timeout) * 1000000ul), // Convert to ns
   _tmoEvtCnt   (0),
   _fixupCnt    (0),
@@ -70,6 +72,8 @@ int EventBuilder::initialize(unsigned epochs,
 
   _epochLut.resize(nep, nullptr);
   _eventLut.resize(nev, nullptr);
+  _deadlines.resize(nev);
+  _dlHead = _dlTail = 0;
 
   printf("*** EB Epoch list size %zu\n", _epochLut.size());
   printf("*** EB Event list size %zu\n", _eventLut.size());
@@ -127,6 +131,7 @@ void EventBuilder::clear()
 
   std::fill(_epochLut.begin(), _epochLut.end(), nullptr);
   std::fill(_eventLut.begin(), _eventLut.end(), nullptr);
+  _dlHead = _dlTail = 0;
 }
 
 inline
@@ -238,6 +243,8 @@ EbEvent* EventBuilder::_event(EbEpoch*            epoch,
     unsigned       index = _evIndex(key);
     _eventLut[index] = event;
 
+    if (event->_remaining)  _track(event);
+
     return event;
   }
 
@@ -340,9 +347,55 @@ void EventBuilder::_retire(EbEpoch* epoch, EbEvent* event)
   EbEvent*&      entry = _eventLut[index];
   if (entry == event)  entry = nullptr;
 
+  // Drop the event's deadline, if it is still in the ring
+  if (event->_deadline > _dlHead)
+    _deadlines[(event->_deadline - 1) % _deadlines.size()] = nullptr;
+
   delete event;
 }
 
+// Since events are created in time order, appending to the ring keeps it
+// sorted by deadline.  Should the ring fill, the event is left to be timed
+// out by the pending list scan in _flush().
+void EventBuilder::_track(EbEvent* event)
+{
+  if (_dlTail - _dlHead == _deadlines.size())  return;
+
+  _deadlines[_dlTail % _deadlines.size()] = event;
+  event->_deadline = ++_dlTail;
+}
+
+// Fix up the events that have timed out, which makes them eligible for
+// retirement when _flush() next reaches them.  Until then, they are marked so
+// that late contributions are dropped.  The cost is proportional to the number
+// of deadlines retired, rather than to the number of pending events.  Returns
+// true if any event was timed out.
+bool EventBuilder::_expire(const time_point_t& now)
+{
+  bool expired = false;
+  while (_dlHead != _dlTail)
+  {
+    auto event = _deadlines[_dlHead % _deadlines.size()];
+
+    if (event)                          // Retired events' deadlines are cleared
+    {
+      const auto age{now - event->_t0};
+      if (age < _eventTimeout)  break;  // All later deadlines are later still
+
+      if (event->_remaining)
+      {
+        _fixup(event, age, nullptr);
+        event->_remaining = 0;
+        event->_timedOut  = true;
+        expired = true;
+      }
+      event->_deadline = 0;
+    }
+    ++_dlHead;
+  }
+  return expired;
+}
+
 void EventBuilder::_flush(const EbEvent* const due)
 {
   const EbEpoch* const lastEpoch = _pending.empty();
@@ -414,7 +467,11 @@ void EventBuilder::_tryFlush()
 {
   const ms_t tmo{100};
   auto       now{fast_monotonic_clock::now(CLOCK_MONOTONIC)};
-  if (now - _tLastFlush > tmo)  _flush();
+  if (now - _tLastFlush > tmo)
+  {
+    _expire(now);
+    _flush();
+  }
 }
 
 /*
@@ -455,6 +512,7 @@ void EventBuilder::expired()            // Periodically called upon a timeout
     }
   }
 
+  _expire(fast_monotonic_clock::now(CLOCK_MONOTONIC));
   _flush();                             // Try to flush everything
 }
 
@@ -483,7 +541,6 @@ void EventBuilder::expired()            // Periodically called upon a timeout
 */
 
 void EventBuilder::process(const EbDgram* ctrb,
-                           const size_t   size,
                            unsigned       imm)
 {
   auto t0{fast_monotonic_clock::now(CLOCK_MONOTONIC)};
@@ -517,7 +574,9 @@ void EventBuilder::process(const EbDgram* ctrb,
 
     if (ctrb->isEOL())  break;
 
-    ctrb = reinterpret_cast<const EbDgram*>(reinterpret_cast<const char*>(ctrb) + size);
+    // Contributors pack batch entries back-to-back
+    ctrb = reinterpret_cast<const EbDgram*>(reinterpret_cast<const char*>(ctrb) +
+                                            sizeof(*ctrb) + ctrb->xtc.sizeofPayload());
     imm++;
   }
 
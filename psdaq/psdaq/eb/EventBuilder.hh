@@ -39,7 +39,6 @@ namespace Pds {
       void               expired();
     public:
       void               process(const Pds::EbDgram* dgrams,
-                                 const size_t        bufSize,
                                  unsigned            imm);
     public:
       void               resetCounters();
@@ -86,6 +85,8 @@ namespace Pds {
       void              _flush(const EbEvent* const due);
       void              _flush();
       void              _tryFlush();
+      void              _track(EbEvent*);
+      bool              _expire(const time_point_t& now);
     private:
       LinkedList<EbEpoch>          _pending;       // Listhead, Epochs with events pending
       time_point_t                 _tLastFlush;    // Starting time of timeout
@@ -94,6 +95,9 @@ namespace Pds {
       std::vector<EbEpoch*>        _epochLut;      // LUT of allocated epochs
       std::unique_ptr<GenericPool> _eventFreelist; // Freelist for new events
       std::vector<EbEvent*>        _eventLut;      // LUT of allocated events
+      std::vector<EbEvent*>        _deadlines;     // Ring of incomplete events in creation order
+      uint64_t                     _dlHead;        // Oldest deadline
+      uint64_t                     _dlTail;        // Next free deadline slot
       const ns_t                   _eventTimeout;  // Maximum event age in ms
       mutable uint64_t             _tmoEvtCnt;     // Count of timed out events
       mutable uint64_t             _fixupCnt;      // Count of flushed   events
@@ -266,14 +266,6 @@ void TebContributor::process(const EbDgram* dgram)
         _batch.start = nullptr;         // Start a new batch
       }
     }
-
-    // Keep non-selected TEBs synchronized by forwarding transitions to them.  In
-    // particular, the Disable transition flushes out whatever Results batch they
-    // currently have in-progress.
-    if (!dgram->isEvent())           // Also capture the most recent SlowUpdate
-    {
-      if (contractor)  _post(dgram); // Post, if contributor is providing trigger input
-    }
   }
   else                        // Common RoG didn't trigger: bypass the TEB(s)
   {
@@ -291,6 +283,32 @@ void TebContributor::process(const EbDgram* dgram)
   ++_eventCount;                        // Only count events handled
 }
 
+// Pack the batch's entries back-to-back in place so that only their actual
+// extent goes over the wire.  Entries occupy fixed size slots indexed by
+// pebble index, so each entry can only move to a lower address and copying
+// them in order is safe.  Since posts are asynchronous, nothing may be posted
+// from the batch before it is packed, so transitions to be forwarded to the
+// non-selected TEBs are noted at their packed location.  Returns the packed
+// extent.
+size_t TebContributor::_pack(const Batch& batch)
+{
+  auto   src  = reinterpret_cast<const char*>(batch.start);
+  auto   end  = reinterpret_cast<const char*>(batch.end);
+  char*  dst  = const_cast<char*>(src);
+  while (true)
+  {
+    auto   dg = reinterpret_cast<const EbDgram*>(src);
+    size_t sz = sizeof(*dg) + dg->xtc.sizeofPayload();
+    if (!dg->isEvent() && (dg->readoutGroups() & _prms.contractor))
+      _forward.push_back(reinterpret_cast<const EbDgram*>(dst));
+    if (dst != src)  memmove(dst, src, sz);
+    dst += sz;
+    if (src == end)  break;
+    src += _prms.maxInputSize;
+  }
+  return dst - reinterpret_cast<const char*>(batch.start);
+}
+
 void TebContributor::_post(const Batch& batch)
 {
   using ns_t = std::chrono::nanoseconds;
@@ -299,6 +317,7 @@ void TebContributor::_post(const Batch& batch)
   _entries   = batch.entries;
 
   batch.end->setEOL();        // Avoid race: terminate before adding batch to pending list
+  size_t extent = _pack(batch);
   _pending.push(batch.start); // Get the batch on the queue before any corresponding result can show up
   if (!(size_t(_pending.guess_size()) < _pending.size()))
   {
@@ -313,8 +332,6 @@ void TebContributor::_post(const Batch& batch)
     EbLfCltLink* link   = _links[dst];
     unsigned     offset = link->lclOfs(batch.start);
     uint32_t     idx    = offset / _prms.maxInputSize;
-    size_t       extent = (reinterpret_cast<const char*>(batch.end) -
-                           reinterpret_cast<const char*>(batch.start)) + _prms.maxInputSize;
     uint32_t     data   = ImmData::value(ImmData::Buffer |
                                          ImmData::Response, _id, idx);
 
@@ -360,6 +377,14 @@ void TebContributor::_post(const Batch& batch)
     }
   }
 
+  // Keep non-selected TEBs synchronized by forwarding transitions to them.  In
+  // particular, the Disable transition flushes out whatever Results batch they
+  // currently have in-progress.  SlowUpdates are forwarded too.  The batch is
+  // packed by now, so the transitions are posted from where they will stay.
+  for (auto dgram : _forward)
+    _post(dgram);
+  _forward.clear();
+
   ++_batchCount;                        // Count all batches handled
 }
 
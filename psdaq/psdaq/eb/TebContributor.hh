@@ -65,6 +65,7 @@ namespace Pds {
       BatchQueue& pending()  { return _pending; }
     private:
       void       _flush();
+      size_t     _pack(const Batch& batch);
       void       _post(const Pds::EbDgram* nonEvent);
       void       _post(const Batch& batch);
     public:
@@ -82,6 +83,7 @@ namespace Pds {
       unsigned                  _numEbs;
       BatchQueue                _pending; // Time ordered list of completed batches
       Batch                     _batch;
+      std::vector<const Pds::EbDgram*> _forward; // Packed transitions for the non-selected TEBs
       uint64_t                  _previousPid;
     private:
       mutable uint64_t          _eventCount;
@@ -873,6 +873,9 @@ int main(int argc, char **argv)
                            /* .builders      = */ 0,   // TEBs
                            /* .addrs         = */ { },
                            /* .ports         = */ { },
+                           /* .rlyAddrs      = */ { },
+                           /* .rlyPorts      = */ { },
+                           /* .relayed       = */ false,
                            /* .maxInputSize  = */ MAX_CONTRIB_SIZE,
                            /* .core          = */ { CORE_0, CORE_1 },
                            /* .verbose       = */ 0,
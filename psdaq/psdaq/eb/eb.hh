@@ -74,6 +74,9 @@ namespace Pds {
       uint64_t builders;           // ID bit list of EBs
       vecstr_t addrs;              // TEB addresses
       vecstr_t ports;              // TEB ports
+      vecstr_t rlyAddrs;           // Addresses of DRPs to relay Results to
+      vecstr_t rlyPorts;           // Ports of DRPs to relay Results to
+      bool     relayed;            // Results arrive via another DRP too
       size_t   maxInputSize;       // Max size of contribution
       int      core[2];            // Cores to pin threads to
       mutable
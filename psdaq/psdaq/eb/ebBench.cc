@@ -0,0 +1,799 @@
+// Event build benchmark: TebContributor -> EbAppBase -> EbCtrbInBase
+//
+// All contributors and TEBs run in this one process, each in its own threads
+// and with its own libfabric endpoints, and talk to each other through the
+// provider selected with -k (by default tcp, on the loopback interface).  So
+// every byte goes through the same code and over the same kind of links as in
+// the DAQ, without needing the cluster.
+//
+// For each combination of contributor count, batch size (entries) and
+// contribution payload size, every contributor sends the same sequence of
+// L1Accepts, the TEBs build them and send back Results batches, and the
+// contributors match the Results up with their Inputs.  Reported are:
+// - the rate at which events are delivered back to the slowest contributor,
+// - the latency from the creation of an event's first contribution to its
+//   Result being delivered to a contributor, and
+// - the CPU time of the whole process (all contributors and TEBs) per event.
+// Only the middle 80% of the events is measured, to leave out startup and the
+// time it takes to flush the last batches.
+//
+// The TEBs here post a Result for every event without calling a Trigger, so
+// what is measured is the event building and batching machinery alone.
+
+#include "eb.hh"
+#include "EbAppBase.hh"
+#include "EbEvent.hh"
+#include "BatchManager.hh"
+#include "TebContributor.hh"
+#include "EbCtrbInBase.hh"
+#include "ResultDgram.hh"
+#include "EbLfClient.hh"
+#include "EbLfServer.hh"
+
+#include "utilities.hh"
+
+#include "psdaq/service/EbDgram.hh"
+#include "psdaq/service/MetricExporter.hh"
+#include "psdaq/service/LatencyHistogram.hh"
+#include "psdaq/service/kwargs.hh"
+#include "psalg/utils/SysLog.hh"
+#include "xtcdata/xtc/Dgram.hh"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>                     // For getopt()
+#include <sys/resource.h>               // For getrusage()
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define UNLIKELY(expr)  __builtin_expect(!!(expr), 0)
+#define LIKELY(expr)    __builtin_expect(!!(expr), 1)
+
+#ifndef POSIX_TIME_AT_EPICS_EPOCH
+#define POSIX_TIME_AT_EPICS_EPOCH 631152000u
+#endif
+
+using namespace XtcData;
+using namespace Pds;
+using namespace Pds::Eb;
+
+using logging          = psalg::SysLog;
+using MetricExporter_t = std::shared_ptr<MetricExporter>;
+
+static const char*    default_ifAddr   = "127.0.0.1";
+static const char*    default_kwargs   = "ep_provider=tcp";
+static const char*    default_ctrbs    = "1,2,4,8";
+static const char*    default_entries  = "1,8,64";
+static const char*    default_sizes    = "64,1024";
+static const unsigned default_tebs     = 1;
+static const unsigned default_buffers  = 4096;
+static const uint64_t default_events   = 1000000;
+
+static std::atomic<bool> lRunning(true);
+
+
+static void sigHandler(int signal)
+{
+  static unsigned callCount(0);
+
+  if (callCount == 0)
+  {
+    printf("\nShutting down\n");
+
+    lRunning.store(false, std::memory_order_release);
+  }
+
+  if (callCount++)
+  {
+    fprintf(stderr, "Aborting on 2nd ^C...\n");
+    ::abort();
+  }
+}
+
+static uint64_t _nsNow()
+{
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t _nsTime(const TimeStamp& time)
+{
+  return (uint64_t(time.seconds()) + POSIX_TIME_AT_EPICS_EPOCH) * 1000000000ull +
+         time.nanoseconds();
+}
+
+static uint64_t _usCpu()
+{
+  rusage ru;
+  getrusage(RUSAGE_SELF, &ru);          // All threads of the process
+  return (uint64_t(ru.ru_utime.tv_sec) + ru.ru_stime.tv_sec) * 1000000ull +
+         ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+
+namespace {
+
+  // Results are batched and posted to the contributors as Teb does, but
+  // without a Trigger: every event gets a Result that says to persist it.
+  class BenchTeb : public EbAppBase
+  {
+  public:
+    BenchTeb(const EbParams& prms, const MetricExporter_t& exporter);
+  public:
+    int  startConnection(std::string& port);
+    int  connect();
+    int  configure();
+    void unconfigure();
+    void disconnect();
+    void run(std::atomic<bool>& running);
+  public:                               // For EventBuilder
+    virtual
+    void flush() override;
+    virtual
+    void process(EbEvent* event) override;
+  private:
+    struct Batch
+    {
+      const EbDgram* start;
+      const EbDgram* end;
+      uint64_t       dsts;
+      unsigned       idx;
+    };
+  private:
+    void _tryPost(const EbDgram* dgram, uint64_t dsts, unsigned idx);
+    void _post(const Batch& batch);
+  private:
+    const EbParams&           _prms;
+    EbLfClient                _l3Transport;
+    std::vector<EbLfCltLink*> _l3Links;
+    BatchManager              _batMan;
+    Batch                     _batch;
+  };
+
+  // Counts the Results delivered and records the latency of the events in
+  // the measurement window, which is bracketed with timestamps
+  class BenchCtrbIn : public EbCtrbInBase
+  {
+  public:
+    BenchCtrbIn(const TebCtrbParams&    prms,
+                const MetricExporter_t& exporter,
+                LatencyHistogram&       latency,
+                uint64_t                first,
+                uint64_t                last,
+                bool                    cpu);
+  public:
+    virtual
+    void     process(const ResultDgram& result, unsigned index) override;
+  public:
+    uint64_t delivered() const { return _delivered.load(std::memory_order_acquire); }
+  public:
+    uint64_t tBegin;                    // When event _first was delivered, ns
+    uint64_t tEnd;                      // When event _last  was delivered, ns
+    uint64_t cpuBegin;                  // Process CPU time at tBegin, us
+    uint64_t cpuEnd;                    // Process CPU time at tEnd,   us
+  private:
+    LatencyHistogram&     _latency;
+    std::atomic<uint64_t> _delivered;
+    const uint64_t        _first;
+    const uint64_t        _last;
+    const bool            _cpu;         // Whether to sample the CPU time
+  };
+
+  struct Contributor
+  {
+    Contributor(const TebCtrbParams&    prms,
+                LatencyHistogram&       latency,
+                uint64_t                numEvents,
+                unsigned                numBuffers);
+  public:
+    void produce(uint64_t numEvents, size_t payload);
+  public:
+    TebCtrbParams                   prms;
+    MetricExporter_t                exporter;
+    std::unique_ptr<TebContributor> ctrb;
+    std::unique_ptr<BenchCtrbIn>    in;
+    unsigned                        numBuffers;
+  };
+
+  struct Builder
+  {
+    EbParams                  prms;
+    MetricExporter_t          exporter;
+    std::unique_ptr<BenchTeb> teb;
+  };
+
+  struct Point
+  {
+    unsigned ctrbs;
+    unsigned entries;
+    size_t   size;
+  };
+
+  struct Measurement
+  {
+    double   rate;                      // Events per second
+    uint64_t p50;                       // ns
+    uint64_t p99;                       // ns
+    double   cpu;                       // us per event
+  };
+
+  struct BenchParams
+  {
+    std::string ifAddr;
+    unsigned    numTebs;
+    unsigned    numBuffers;
+    uint64_t    numEvents;
+    unsigned    verbose;
+    std::map<std::string, std::string> kwargs;
+  };
+};
+
+
+BenchTeb::BenchTeb(const EbParams&         prms,
+                   const MetricExporter_t& exporter) :
+  EbAppBase   (prms, exporter, "TEB", EB_TMO_MS),
+  _prms       (prms),
+  _l3Transport(prms.verbose, prms.kwargs),
+  _batch      {nullptr, nullptr, 0, 0}
+{
+}
+
+int BenchTeb::startConnection(std::string& port)
+{
+  return EbAppBase::startConnection(_prms.ifAddr, port, MAX_DRPS);
+}
+
+int BenchTeb::connect()
+{
+  _l3Links.resize(_prms.addrs.size());
+
+  int rc = EbAppBase::connect(TEB_TR_BUFFERS);
+  if (rc)  return rc;
+
+  return linksConnect(_l3Transport, _l3Links, _prms.addrs, _prms.ports, _prms.id, "DRP");
+}
+
+int BenchTeb::configure()
+{
+  int rc = EbAppBase::configure();
+  if (rc)  return rc;
+
+  _batMan.initialize(sizeof(ResultDgram), _prms.maxEntries, _prms.maxBuffers / _prms.maxEntries);
+
+  return linksConfigure(_l3Links, _batMan.batchRegion(), _batMan.batchRegionSize(), "DRP");
+}
+
+void BenchTeb::unconfigure()
+{
+  _batMan.shutdown();
+
+  EbAppBase::unconfigure();
+}
+
+void BenchTeb::disconnect()
+{
+  for (auto link : _l3Links)  _l3Transport.disconnect(link);
+  _l3Links.clear();
+
+  EbAppBase::disconnect();
+}
+
+void BenchTeb::run(std::atomic<bool>& running)
+{
+  _batch.start = nullptr;
+
+  while (running.load(std::memory_order_acquire))
+  {
+    int rc = EbAppBase::process();
+    if ((rc < 0) && (rc != -FI_EAGAIN))
+    {
+      logging::critical("TEB %u: process() failed: rc %d", _prms.id, rc);
+      abort();
+    }
+  }
+}
+
+void BenchTeb::process(EbEvent* event)
+{
+  const EbDgram* dgram = event->creator();
+  unsigned       imm   = event->immData();
+
+  if (ImmData::flg(imm) != (ImmData::Response | ImmData::Buffer))
+  {
+    post(event->begin(), event->end()); // Return the transition buffer(s)
+    return;
+  }
+
+  auto idx = ImmData::idx(imm);
+  auto rdg = new(_batMan.fetch(idx)) ResultDgram(*dgram, _prms.id);
+
+  rdg->xtc.damage.increase(event->damage().value());
+  rdg->persist(true);
+
+  // Avoid sending Results to contributors that failed to supply Input
+  _tryPost(rdg, _prms.receivers[_prms.partition] & ~event->remaining(), idx);
+}
+
+// Called by EB on timeout when it is empty of events
+void BenchTeb::flush()
+{
+  if (_batch.start)
+  {
+    _post(_batch);
+
+    _batch.start = nullptr;             // Start a new batch
+  }
+}
+
+// The same batching rules as Teb, less the transition handling
+void BenchTeb::_tryPost(const EbDgram* dgram, uint64_t dsts, unsigned idx)
+{
+  // On wrapping, post the batch at the end of the region, if any
+  if (dgram == _batMan.batchRegion())  flush();
+
+  if (!_batch.start)  _batch = {dgram, dgram, dsts, idx};
+
+  if (LIKELY(!_batMan.expired(dgram->pulseId(), _batch.start->pulseId())))
+  {
+    _batch.end   = dgram;
+    _batch.dsts |= dsts;
+  }
+  else
+  {
+    _post(_batch);                      // The batch end is the previous Dgram
+
+    _batch = {dgram, dgram, dsts, idx}; // Start a new batch with dgram
+  }
+}
+
+void BenchTeb::_post(const Batch& batch)
+{
+  size_t   size   = sizeof(ResultDgram);
+  size_t   extent = (reinterpret_cast<const char*>(batch.end) -
+                     reinterpret_cast<const char*>(batch.start)) + size;
+  unsigned offset = batch.idx * size;
+  uint64_t data   = ImmData::value(ImmData::Buffer, _prms.id, batch.idx);
+  uint64_t destns = batch.dsts;
+
+  batch.end->setEOL();                  // Terminate the batch
+
+  while (destns)
+  {
+    unsigned dst = __builtin_ffsl(destns) - 1;
+    destns &= ~(1ull << dst);
+
+    int rc = _l3Links[dst]->post(batch.start, extent, offset, data);
+    if (rc < 0)
+    {
+      logging::critical("TEB %u: Failed to post batch [%8u] of pid %014lx to DRP %u: rc %d",
+                        _prms.id, batch.idx, batch.start->pulseId(), dst, rc);
+      abort();
+    }
+  }
+}
+
+
+BenchCtrbIn::BenchCtrbIn(const TebCtrbParams&    prms,
+                         const MetricExporter_t& exporter,
+                         LatencyHistogram&       latency,
+                         uint64_t                first,
+                         uint64_t                last,
+                         bool                    cpu) :
+  EbCtrbInBase(prms, exporter),
+  tBegin      (0),
+  tEnd        (0),
+  cpuBegin    (0),
+  cpuEnd      (0),
+  _latency    (latency),
+  _delivered  (0),
+  _first      (first),
+  _last       (last),
+  _cpu        (cpu)
+{
+}
+
+void BenchCtrbIn::process(const ResultDgram& result, unsigned index)
+{
+  uint64_t count = _delivered.load(std::memory_order_relaxed) + 1;
+
+  if ((count > _first) && (count <= _last))
+  {
+    // The Result carries the time of the event's first contribution to arrive
+    uint64_t now = _nsNow();
+    uint64_t t0  = _nsTime(result.time);
+    _latency.record(now > t0 ? now - t0 : 0);
+    if (count == _last)
+    {
+      tEnd = now;
+      if (_cpu)  cpuEnd = _usCpu();
+    }
+  }
+  else if (count == _first)
+  {
+    tBegin = _nsNow();
+    if (_cpu)  cpuBegin = _usCpu();
+  }
+
+  // Hand the Input buffer back to the producer
+  _delivered.store(count, std::memory_order_release);
+}
+
+
+Contributor::Contributor(const TebCtrbParams& prms_,
+                         LatencyHistogram&    latency,
+                         uint64_t             numEvents,
+                         unsigned             numBuffers_) :
+  prms      (prms_),
+  exporter  (std::make_shared<MetricExporter>()),
+  ctrb      (std::make_unique<TebContributor>(prms, numBuffers_, exporter)),
+  in        (std::make_unique<BenchCtrbIn>(prms, exporter, latency,
+                                           numEvents / 10, numEvents - numEvents / 10,
+                                           prms.id == 0)),
+  numBuffers(numBuffers_)
+{
+}
+
+void Contributor::produce(uint64_t numEvents, size_t payload)
+{
+  // The buffer index follows the pulse ID, as the DMA index does in the DRPs,
+  // so the same index is used by all contributors for an event
+  const uint64_t pid0 = numBuffers;     // Batches start at index 0
+  const uint32_t env  = 1 << prms.partition;
+  const Src      src(prms.id);
+
+  for (uint64_t evt = 0; evt < numEvents; ++evt)
+  {
+    // Wait for the Result of the event last held in the buffer to arrive
+    while (evt - in->delivered() >= numBuffers)
+    {
+      if (UNLIKELY(!lRunning.load(std::memory_order_relaxed)))  return;
+      ctrb->timeout();
+    }
+
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    TimeStamp  time(unsigned(ts.tv_sec - POSIX_TIME_AT_EPICS_EPOCH), unsigned(ts.tv_nsec));
+    uint64_t   pid = pid0 + evt;
+    unsigned   idx = pid % numBuffers;
+    void*      buf = ctrb->fetch(idx);
+    Transition tr(Transition::Event, TransitionId::L1Accept, time, env);
+    auto       dg  = new(buf) EbDgram(PulseId(pid), Dgram(tr, Xtc(TypeId(TypeId::Parent, 0), src)));
+    dg->xtc.alloc(payload, static_cast<char*>(buf) + prms.maxInputSize);
+
+    ctrb->process(dg);
+  }
+
+  // Flush the last batch and wait for everything to come back
+  while (in->delivered() < numEvents)
+  {
+    if (UNLIKELY(!lRunning.load(std::memory_order_relaxed)))  return;
+    ctrb->timeout();
+  }
+}
+
+
+static int _measure(const BenchParams& bp, const Point& pt, Measurement& m)
+{
+  const uint64_t ctrbMask = (pt.ctrbs < 64 ? 1ull << pt.ctrbs : 0) - 1;
+  const uint64_t tebMask  = (1ull << bp.numTebs) - 1;
+
+  LatencyHistogram latency(pt.ctrbs);
+
+  // TEBs listen for the contributors' Inputs
+  std::vector<Builder> builders(bp.numTebs);
+  std::vector<std::string> tebPorts(bp.numTebs);
+  for (unsigned i = 0; i < bp.numTebs; ++i)
+  {
+    auto& b  = builders[i];
+    auto& p  = b.prms;
+    p.ifAddr       = bp.ifAddr;
+    p.instrument   = "bench";
+    p.partition    = 0;
+    p.alias        = "teb" + std::to_string(i);
+    p.id           = i;
+    p.rogs         = 1 << p.partition;
+    p.contributors = ctrbMask;
+    p.indexSources = ctrbMask;
+    p.contractors.fill(0);
+    p.receivers  .fill(0);
+    p.contractors[p.partition] = ctrbMask;
+    p.receivers  [p.partition] = ctrbMask;
+    p.maxTrSize .assign(pt.ctrbs, sizeof(EbDgram));
+    p.maxEntries   = pt.entries;
+    p.maxBuffers   = bp.numBuffers;
+    p.numBuffers.assign(MAX_DRPS, bp.numBuffers);
+    p.numMrqs      = 0;
+    p.kwargs       = bp.kwargs;
+    p.core[0]      = -1;
+    p.core[1]      = -1;
+    p.verbose      = bp.verbose;
+    for (unsigned j = 0; j < pt.ctrbs; ++j)
+      p.drps.push_back("drp" + std::to_string(j));
+
+    b.exporter = std::make_shared<MetricExporter>();
+    b.teb      = std::make_unique<BenchTeb>(p, b.exporter);
+    if (b.teb->startConnection(tebPorts[i]))  return 1;
+  }
+
+  // Contributors listen for the TEBs' Results
+  std::vector<std::unique_ptr<Contributor> > ctrbs;
+  for (unsigned i = 0; i < pt.ctrbs; ++i)
+  {
+    TebCtrbParams p;
+    p.ifAddr       = bp.ifAddr;
+    p.instrument   = "bench";
+    p.partition    = 0;
+    p.alias        = "drp" + std::to_string(i);
+    p.detName      = "bench";
+    p.detSegment   = i;
+    p.id           = i;
+    p.builders     = tebMask;
+    p.addrs.assign(bp.numTebs, bp.ifAddr);
+    p.ports        = tebPorts;
+    p.relayed      = false;
+    p.maxInputSize = sizeof(EbDgram) + pt.size;
+    p.core[0]      = -1;
+    p.core[1]      = -1;
+    p.verbose      = bp.verbose;
+    p.readoutGroup = 1 << p.partition;
+    p.contractor   = p.readoutGroup;
+    p.maxEntries   = pt.entries;
+    p.kwargs       = bp.kwargs;
+
+    ctrbs.emplace_back(new Contributor(p, latency, bp.numEvents, bp.numBuffers));
+    auto& c = *ctrbs.back();
+    if (c.in->startConnection(c.prms.port))  return 1;
+  }
+  for (auto& b : builders)
+  {
+    for (auto& c : ctrbs)
+    {
+      b.prms.addrs.push_back(c->prms.ifAddr);
+      b.prms.ports.push_back(c->prms.port);
+    }
+  }
+
+  // Connect and configure everybody at once, as the DAQ's processes would
+  std::atomic<int>         failed(0);
+  std::vector<std::thread> threads;
+  for (auto& b : builders)
+  {
+    threads.emplace_back([&] { if (b.teb->connect() || b.teb->configure())  ++failed; });
+  }
+  for (auto& c : ctrbs)
+  {
+    auto ctrb = c.get();
+    threads.emplace_back([&, ctrb] { if (ctrb->ctrb->connect() || ctrb->in->connect() ||
+                                         ctrb->ctrb->configure() ||
+                                         ctrb->in->configure(bp.numBuffers))  ++failed; });
+  }
+  for (auto& thread : threads)  thread.join();
+  threads.clear();
+  if (failed)  return 1;
+
+  // Run
+  std::atomic<bool> tebsRunning(true);
+  for (auto& b : builders)
+  {
+    threads.emplace_back([&] { b.teb->run(tebsRunning); });
+  }
+  std::vector<std::thread> producers;
+  for (auto& c : ctrbs)
+  {
+    auto ctrb = c.get();
+    ctrb->ctrb->startup(*ctrb->in);
+    producers.emplace_back([&, ctrb] { ctrb->produce(bp.numEvents, pt.size); });
+  }
+  for (auto& thread : producers)  thread.join();
+  tebsRunning.store(false, std::memory_order_release);
+  for (auto& thread : threads)  thread.join();
+
+  // Tear down from the contributors' end, as on Unconfigure and Disconnect
+  for (auto& c : ctrbs)
+  {
+    c->ctrb->shutdown();                // Stops the Results receiver thread
+    c->in->unconfigure();
+    c->in->disconnect();
+    c->in->shutdown();
+  }
+  for (auto& b : builders)
+  {
+    b.teb->unconfigure();
+    b.teb->disconnect();
+    b.teb->shutdown();
+  }
+  if (!lRunning.load(std::memory_order_relaxed))  return 1;
+
+  // The window ends when the slowest contributor has seen all of its events
+  uint64_t tBegin = UINT64_MAX;
+  uint64_t tEnd   = 0;
+  for (auto& c : ctrbs)
+  {
+    if (c->in->tBegin < tBegin)  tBegin = c->in->tBegin;
+    if (c->in->tEnd   > tEnd)    tEnd   = c->in->tEnd;
+  }
+  uint64_t events = bp.numEvents - 2 * (bp.numEvents / 10);
+  auto&    in0    = *ctrbs[0]->in;
+
+  LatencyHistogram::Snapshot snap;
+  latency.snapshot(snap);
+  m.rate = tEnd > tBegin ? 1.0e9 * double(events) / double(tEnd - tBegin) : 0.0;
+  m.p50  = snap.percentile(0.50);
+  m.p99  = snap.percentile(0.99);
+  m.cpu  = double(in0.cpuEnd - in0.cpuBegin) / double(events);
+
+  return 0;
+}
+
+static bool _parseList(const char* arg, std::vector<unsigned>& list)
+{
+  list.clear();
+  std::string str(arg);
+  size_t      pos = 0;
+  while (pos < str.size())
+  {
+    size_t end = str.find(',', pos);
+    if (end == std::string::npos)  end = str.size();
+    char*    tail;
+    unsigned value = strtoul(str.substr(pos, end - pos).c_str(), &tail, 0);
+    if (*tail || !value)  return false;
+    list.push_back(value);
+    pos = end + 1;
+  }
+  return !list.empty();
+}
+
+static void usage(char *name, char *desc)
+{
+  if (desc)
+    fprintf(stderr, "%s\n\n", desc);
+
+  fprintf(stderr, "Usage:\n");
+  fprintf(stderr, "  %s [OPTIONS]\n", name);
+
+  fprintf(stderr, "\nWhere:\n"
+                  "  <list>, below, is a comma separated list of values to sweep\n");
+
+  fprintf(stderr, "\nOptions:\n");
+
+  fprintf(stderr, " %-20s %s (default: %s)\n",      "-A <interface_addr>",
+          "IP address of the interface to use",     default_ifAddr);
+  fprintf(stderr, " %-20s %s (default: %s)\n",      "-k <kwargs>",
+          "Keyword arguments, e.g., for libfabric", default_kwargs);
+  fprintf(stderr, " %-20s %s (default: %s)\n",      "-c <list>",
+          "Numbers of contributors (1 - 64)",       default_ctrbs);
+  fprintf(stderr, " %-20s %s (default: %s)\n",      "-e <list>",
+          "Batch sizes in entries (powers of 2)",   default_entries);
+  fprintf(stderr, " %-20s %s (default: %s)\n",      "-s <list>",
+          "Contribution payload sizes in bytes",    default_sizes);
+  fprintf(stderr, " %-20s %s (default: %u)\n",      "-t <tebs>",
+          "Number of TEBs",                         default_tebs);
+  fprintf(stderr, " %-20s %s (default: %u)\n",      "-b <buffers>",
+          "Number of Input buffers per contributor", default_buffers);
+  fprintf(stderr, " %-20s %s (default: %lu)\n",     "-n <events>",
+          "Number of events per measurement",       default_events);
+
+  fprintf(stderr, " %-20s %s\n", "-v", "enable debugging output (repeat for increased detail)");
+  fprintf(stderr, " %-20s %s\n", "-h", "display this help output");
+}
+
+
+int main(int argc, char **argv)
+{
+  int                   op;
+  BenchParams           bp{default_ifAddr, default_tebs, default_buffers, default_events, 0, {}};
+  std::string           kwargs_str(default_kwargs);
+  std::vector<unsigned> ctrbCnts;
+  std::vector<unsigned> entries;
+  std::vector<unsigned> sizes;
+  bool                  ok = (_parseList(default_ctrbs,   ctrbCnts) &&
+                              _parseList(default_entries, entries)  &&
+                              _parseList(default_sizes,   sizes));
+
+  while ((op = getopt(argc, argv, "h?vA:k:c:e:s:t:b:n:")) != -1)
+  {
+    switch (op)
+    {
+      case 'A':  bp.ifAddr     = optarg;                     break;
+      case 'k':  kwargs_str    = kwargs_str + "," + optarg;  break;
+      case 'c':  ok &= _parseList(optarg, ctrbCnts);         break;
+      case 'e':  ok &= _parseList(optarg, entries);          break;
+      case 's':  ok &= _parseList(optarg, sizes);            break;
+      case 't':  bp.numTebs    = atoi(optarg);               break;
+      case 'b':  bp.numBuffers = atoi(optarg);               break;
+      case 'n':  bp.numEvents  = strtoull(optarg, nullptr, 0);  break;
+      case 'v':  ++bp.verbose;                               break;
+      case '?':
+      case 'h':
+      default:
+        usage(argv[0], (char*)"Event build latency and throughput benchmark");
+        return 1;
+    }
+  }
+
+  logging::init("bench", bp.verbose ? LOG_DEBUG : LOG_WARNING);
+
+  if (!ok)
+  {
+    fprintf(stderr, "Sweep lists must be comma separated non-zero numbers\n");
+    return 1;
+  }
+  if ((bp.numTebs == 0) || (bp.numTebs > MAX_TEBS))
+  {
+    fprintf(stderr, "Number of TEBs %u is out of range 1 - %u\n", bp.numTebs, MAX_TEBS);
+    return 1;
+  }
+  if (bp.numBuffers & (bp.numBuffers - 1))
+  {
+    fprintf(stderr, "Number of buffers %u must be a power of 2\n", bp.numBuffers);
+    return 1;
+  }
+  if (bp.numEvents < 10)
+  {
+    fprintf(stderr, "Number of events %lu must be at least 10\n", bp.numEvents);
+    return 1;
+  }
+  for (auto n : ctrbCnts)
+  {
+    if (n > MAX_DRPS)
+    {
+      fprintf(stderr, "Number of contributors %u is out of range 1 - %u\n", n, MAX_DRPS);
+      return 1;
+    }
+  }
+  for (auto n : entries)
+  {
+    if ((n & (n - 1)) || (n > MAX_ENTRIES) || (n > bp.numBuffers / 2))
+    {
+      fprintf(stderr, "Batch size %u must be a power of 2 <= %u and <= half the buffers\n",
+              n, MAX_ENTRIES);
+      return 1;
+    }
+  }
+  get_kwargs(kwargs_str, bp.kwargs);
+
+  struct sigaction sigAction;
+  sigAction.sa_handler = sigHandler;
+  sigAction.sa_flags   = SA_RESTART;
+  sigemptyset(&sigAction.sa_mask);
+  if (sigaction(SIGINT, &sigAction, nullptr) > 0)
+    fprintf(stderr, "Failed to set up ^C handler\n");
+
+  printf("%u TEB(s), %u buffers, %lu events per point, kwargs '%s', interface %s\n",
+         bp.numTebs, bp.numBuffers, bp.numEvents, kwargs_str.c_str(), bp.ifAddr.c_str());
+  printf("%6s %8s %8s %12s %12s %12s %12s\n",
+         "ctrbs", "entries", "size", "events/s", "p50 [us]", "p99 [us]", "CPU [us/ev]");
+
+  for (auto nCtrbs : ctrbCnts)
+  {
+    for (auto nEntries : entries)
+    {
+      for (auto size : sizes)
+      {
+        Point       pt{nCtrbs, nEntries, size};
+        Measurement m;
+        if (_measure(bp, pt, m))
+        {
+          if (!lRunning.load(std::memory_order_relaxed))  return 0;
+          fprintf(stderr, "Measurement of %u contributors, %u entries, %u bytes failed\n",
+                  nCtrbs, nEntries, size);
+          return 1;
+        }
+        printf("%6u %8u %8u %12.0f %12.1f %12.1f %12.2f\n",
+               nCtrbs, nEntries, size, m.rate, 1.0e-3 * m.p50, 1.0e-3 * m.p99, m.cpu);
+        fflush(stdout);
+      }
+    }
+  }
+
+  return 0;
+}
@@ -100,6 +100,13 @@ namespace Pds {
       unsigned       idx;
     };
 
+    struct Deferred                     // An event awaiting its trigger result
+    {
+      ResultDgram*   rdg;
+      uint64_t       dsts;
+      unsigned       idx;
+    };
+
     class Teb : public EbAppBase
     {
     public:
@@ -121,6 +128,8 @@ namespace Pds {
     private:
       void     _queueMrqBuffers();
       void     _monitor(ResultDgram* rdg);
+      void     _complete(ResultDgram* rdg, uint64_t dsts, unsigned idx);
+      void     _flushTrigger();
       void     _tryPost(const EbDgram* dg, uint64_t dsts, unsigned idx);
       void     _post(const Batch& batch);
       uint64_t _receivers(unsigned rogs) const;
@@ -131,6 +140,7 @@ namespace Pds {
       BatchManager                 _batMan;
       Batch                        _batch;
       std::vector<Fifo<unsigned> > _monBufLists;
+      std::vector<Deferred>        _pending;
     private:
       //uint64_t                     _trimmed;
       Trigger*                     _trigger;
@@ -139,6 +149,8 @@ namespace Pds {
       unsigned                     _rogReserved[MAX_MRQS];
       uint64_t                     _lastMonPid;
       uint64_t                     _monThrottle;
+      unsigned                     _rlyFanout;
+      uint64_t                     _rlyRoots;
     private:
       unsigned                     _wrtCounter;
       uint64_t                     _pidPrv;
@@ -153,7 +165,11 @@ namespace Pds {
       uint64_t                     _mebCount[MAX_MEBS];
       uint64_t                     _prescaleCount;
       int64_t                      _latency;
+      std::shared_ptr<LatencyHistogram> _latencyHist;
+      std::vector<std::shared_ptr<LatencyHistogram> > _postLatHist; // Per DRP
+      uint64_t                     _relayCount;
       int64_t                      _trgTime;
+      uint64_t                     _trgBatch;
     private:
       const EbParams&              _prms;
       EbLfClient                   _l3Transport;
@@ -204,6 +220,8 @@ Teb::Teb(const EbParams&         prms,
   _rogReserved  {0, 0, 0, 0},
   _lastMonPid   (0),
   _monThrottle  (0),
+  _rlyFanout    (0),
+  _rlyRoots     (0),
   _pidPrv       (0),
   _eventCount   (0),
   _trCount      (0),
@@ -215,13 +233,17 @@ Teb::Teb(const EbParams&         prms,
   _mebCount     {0, 0, 0, 0},
   _prescaleCount(0),
   _latency      (0),
+  _relayCount   (0),
   _trgTime      (0),
+  _trgBatch     (0),
   _prms         (prms),
   _l3Transport  (prms.verbose, prms.kwargs),
   _exporter     (exporter)
 {
   if (_prms.kwargs.find("mon_throttle") != _prms.kwargs.end())
     _monThrottle = std::stoul(const_cast<EbParams&>(_prms).kwargs["mon_throttle"]);
+  if (_prms.kwargs.find("result_fanout") != _prms.kwargs.end())
+    _rlyFanout = std::stoul(const_cast<EbParams&>(_prms).kwargs["result_fanout"]);
 
   std::map<std::string, std::string> labels{{"instrument", prms.instrument},
                                             {"partition", std::to_string(prms.partition)},
@@ -241,7 +263,10 @@ Teb::Teb(const EbParams&         prms,
   exporter->add("TEB_MebCt3", labels, MetricType::Counter, [&](){ return _mebCount[3];           });
   exporter->add("TEB_PsclCt", labels, MetricType::Counter, [&](){ return _prescaleCount;         });
   exporter->add("TEB_EvtLat", labels, MetricType::Gauge,   [&](){ return _latency;               });
+  _latencyHist = exporter->latency("TEB_EvtLatQ", labels); // ns
+  exporter->add("TEB_RlyCt",  labels, MetricType::Counter, [&](){ return _relayCount;            });
   exporter->add("TEB_trg_dt", labels, MetricType::Gauge,   [&](){ return _trgTime;               });
+  exporter->add("TEB_TrgBat", labels, MetricType::Gauge,   [&](){ return _trgBatch;              });
 }
 
 int Teb::resetCounters()
@@ -258,6 +283,8 @@ int Teb::resetCounters()
   _prescaleCount = 0;
   _latency       = 0;
   _trgTime       = 0;
+  _trgBatch      = 0;
+  _relayCount    = 0;
 
   return 0;
 }
@@ -287,6 +314,7 @@ void Teb::unconfigure()
   if (!_l3Links.empty())              // Avoid dumping again if already done
     _batMan.dump();
   _batMan.shutdown();
+  _pending.clear();                     // Results will never be posted
 
   EbAppBase::unconfigure();
 }
@@ -336,6 +364,25 @@ int Teb::connect()
   rc = linksConnect(_l3Transport, _l3Links, _prms.addrs, _prms.ports, _prms.id, "DRP");
   if (rc)  return rc;
 
+  _postLatHist.clear();
+  _postLatHist.resize(_l3Links.size());
+  for (auto link : _l3Links)
+  {
+    if (!link)  continue;
+    labels["drp"] = std::to_string(link->id());
+    _postLatHist[link->id()] = _exporter->latency("TEB_PostLatQ", labels); // ns
+  }
+
+  // With a result_fanout, batches for all the DRPs go only to the roots of
+  // a tree of them, and are relayed from there.  The DRPs build the same tree
+  // from the same kwarg, so it must be given to them and the TEBs alike.
+  _rlyRoots = relayRoots(_prms.contributors, _rlyFanout);
+  if (_rlyRoots == _prms.contributors)  _rlyRoots = 0; // Post directly
+  if (_rlyRoots)
+    logging::info("Relaying Results to %zu DRPs through %zu roots of fan-out %u",
+                  std::bitset<64>(_prms.contributors).count(),
+                  std::bitset<64>(_rlyRoots).count(), _rlyFanout);
+
   return 0;
 }
 
@@ -441,7 +488,10 @@ void Teb::run()
   int rcPrv = 0;
   while (lRunning)
   {
-    rc = EbAppBase::process();
+    // While a deferring trigger holds events, wake up often enough to honor
+    // its deadline even when no further contributions arrive
+    rc = EbAppBase::process(_pending.empty() ? 100 : 1);
+    if (!_pending.empty() && _trigger->ready())  flush();
     if (rc < 0)
     {
       if (rc == -FI_EAGAIN)
@@ -580,45 +630,34 @@ void Teb::process(EbEvent* event)
 
     rdg->xtc.damage.increase(event->damage().value());
 
+    // Avoid sending Results to contributors that failed to supply Input
+    uint64_t dsts = _receivers(dgram->readoutGroups()) & ~event->remaining();
+
     if (rdg->isEvent())
     {
       // Present event contributions to "user" code for building a result datagram
-      auto t0 = std::chrono::system_clock::now();
-      _trigger->event(event->begin(), event->end(), *rdg); // Consume
-      auto t1 = std::chrono::system_clock::now();
-      _trgTime = std::chrono::duration_cast<ns_t>(t1 - t0).count();
-
-      // Handle prescale
-      rdg->prescale(!rdg->persist() && !_wrtCounter--);
-      if (rdg->prescale())
+      if (_trigger->queue(event->begin(), event->end(), *rdg))
       {
-        _wrtCounter = _prescale;        // Rearm
-
-        _prescaleCount++;
+        // The result will be available after the trigger is flushed
+        _pending.push_back({rdg, dsts, idx});
+        if (_trigger->ready())  _flushTrigger();
       }
+      else
+      {
+        auto t0 = std::chrono::system_clock::now();
+        _trigger->event(event->begin(), event->end(), *rdg); // Consume
+        auto t1 = std::chrono::system_clock::now();
+        _trgTime  = std::chrono::duration_cast<ns_t>(t1 - t0).count();
+        _trgBatch = 1;
 
-      if (rdg->persist())  _writeCount++;
-      if (rdg->monitor())  _monitor(rdg);
+        _complete(rdg, dsts, idx);
+      }
     }
-
-    // Avoid sending Results to contributors that failed to supply Input
-    uint64_t dsts = _receivers(dgram->readoutGroups()) & ~event->remaining();
-
-    if (UNLIKELY(_prms.verbose >= VL_EVENT)) // || rdg->monitor()))
+    else
     {
-      const char* svc = TransitionId::name(rdg->service());
-      uint64_t    pid = rdg->pulseId();
-      unsigned    ctl = rdg->control();
-      size_t      sz  = sizeof(rdg) + rdg->xtc.sizeofPayload();
-      unsigned    src = rdg->xtc.src.value();
-      unsigned    env = rdg->env;
-      uint32_t*   pld = reinterpret_cast<uint32_t*>(rdg->xtc.payload());
-      printf("TEB processed %15s result [%8u] @ "
-             "%16p, ctl %02x, pid %014lx, env %08x, sz %6zd, src %2u, dsts %016lx, res [%08x, %08x]\n",
-             svc, idx, rdg, ctl, pid, env, sz, src, dsts, pld[0], pld[1]);
+      _flushTrigger();                  // Results must be posted in order
+      _complete(rdg, dsts, idx);
     }
-
-    _tryPost(rdg, dsts, idx);
   }
   else                                  // "Non-selected" TEB case
   {
@@ -629,6 +668,8 @@ void Teb::process(EbEvent* event)
     // there is is flushed by the same logic batches on "selected" TEBs are
     // flushed.  It's probably done by the first SlowUpdate after a TEB becomes
     // a "non-selected" one, so this seems a bit redundant.
+    _flushTrigger();
+
     if (_batch.start)
     {
       TransitionId::Value svc     = dgram->service();
@@ -666,12 +707,75 @@ void Teb::process(EbEvent* event)
            + std::chrono::nanoseconds{dgram->time.nanoseconds()};
   std::chrono::system_clock::time_point tp{std::chrono::duration_cast<std::chrono::system_clock::duration>(dgt)};
   _latency = std::chrono::duration_cast<ms_t>(now - tp).count();
+  if (now > tp)
+    _latencyHist->record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - tp).count());
+}
+
+void Teb::_complete(ResultDgram* rdg, uint64_t dsts, unsigned idx)
+{
+  if (rdg->isEvent())
+  {
+    // Handle prescale
+    rdg->prescale(!rdg->persist() && !_wrtCounter--);
+    if (rdg->prescale())
+    {
+      _wrtCounter = _prescale;          // Rearm
+
+      _prescaleCount++;
+    }
+
+    if (rdg->persist())  _writeCount++;
+    if (rdg->monitor())  _monitor(rdg);
+  }
+
+  if (UNLIKELY(_prms.verbose >= VL_EVENT)) // || rdg->monitor()))
+  {
+    const char* svc = TransitionId::name(rdg->service());
+    uint64_t    pid = rdg->pulseId();
+    unsigned    ctl = rdg->control();
+    size_t      sz  = sizeof(rdg) + rdg->xtc.sizeofPayload();
+    unsigned    src = rdg->xtc.src.value();
+    unsigned    env = rdg->env;
+    uint32_t*   pld = reinterpret_cast<uint32_t*>(rdg->xtc.payload());
+    printf("TEB processed %15s result [%8u] @ "
+           "%16p, ctl %02x, pid %014lx, env %08x, sz %6zd, src %2u, dsts %016lx, res [%08x, %08x]\n",
+           svc, idx, rdg, ctl, pid, env, sz, src, dsts, pld[0], pld[1]);
+  }
+
+  _tryPost(rdg, dsts, idx);
+}
+
+// Obtain the results of events queued to a deferring trigger and post them
+void Teb::_flushTrigger()
+{
+  if (_pending.empty())  return;
+
+  // Posting may wrap the batch region, which calls flush() and thus us again,
+  // so work on a local copy that the nested call finds empty
+  std::vector<Deferred> pending;
+  pending.swap(_pending);
+
+  auto t0 = std::chrono::system_clock::now();
+  _trigger->flush();
+  auto t1 = std::chrono::system_clock::now();
+  _trgTime  = std::chrono::duration_cast<ns_t>(t1 - t0).count();
+  _trgBatch = pending.size();
+
+  for (const auto& deferred : pending)
+  {
+    _complete(deferred.rdg, deferred.dsts, deferred.idx);
+  }
+
+  pending.clear();                      // Reuse the storage
+  if (_pending.empty())  _pending.swap(pending);
 }
 
 // Called by EB  on timeout when it is empty of events
 // to flush out any in-progress batch
 void Teb::flush()
 {
+  _flushTrigger();
+
   //printf("TEB::flush: start %p, end %p\n", _batch.start, _batch.end);
 
   if (_batch.start)
@@ -737,6 +841,16 @@ void Teb::_post(const Batch& batch)
   uint64_t data   = ImmData::value(ImmData::Buffer, _prms.id, batch.idx);
   uint64_t destns = batch.dsts; // & ~_trimmed;
 
+  // A batch for every DRP is posted to the roots of the relay tree only.
+  // Others (e.g., for some RoGs, or with a contributor missing) are posted
+  // to each of their destinations, as the relays would pass them on to all.
+  if (_rlyRoots && (destns == _prms.contributors))
+  {
+    destns = _rlyRoots;
+    data   = ImmData::flg(data, ImmData::Buffer | ImmData::Relay);
+    ++_relayCount;
+  }
+
   batch.end->setEOL();                  // Terminate the batch
 
   if (UNLIKELY(_prms.verbose >= VL_BATCH))
@@ -765,7 +879,10 @@ void Teb::_post(const Batch& batch)
              dst, rmtAdx);
     }
 
-    int rc = link->post(batch.start, extent, offset, data);
+    auto t0 = std::chrono::steady_clock::now();
+    int  rc = link->post(batch.start, extent, offset, data);
+    auto t1 = std::chrono::steady_clock::now();
+    _postLatHist[dst]->record(std::chrono::duration_cast<ns_t>(t1 - t0).count());
     if (rc < 0)
     {
       uint64_t pid    = batch.start->pulseId();
@@ -1389,6 +1506,9 @@ int main(int argc, char **argv)
     if (kwargs.first == "ep_provider")  continue;
     if (kwargs.first == "script_path")  continue;
     if (kwargs.first == "mon_throttle") continue;
+    if (kwargs.first == "result_fanout") continue;
+    if (kwargs.first == "trg_batch")    continue; // TebPyTrig
+    if (kwargs.first == "trg_deadline") continue; // TebPyTrig
     logging::critical("Unrecognized kwarg '%s=%s'",
                       kwargs.first.c_str(), kwargs.second.c_str());
     return 1;
@@ -0,0 +1,98 @@
+#include "utilities.hh"
+
+#include <cstdint>
+#include <stdio.h>
+#include <vector>
+
+//
+//  Checks that relayRoots() and relayChildren() arrange any set of DRP IDs,
+//  including sparse ones, into a tree: every member is either a root or the
+//  child of exactly one other member, and only members are children.
+//
+
+using namespace Pds::Eb;
+
+
+static unsigned check(uint64_t members, unsigned degree)
+{
+  uint64_t roots = relayRoots(members, degree);
+  unsigned nFail = 0;
+
+  if ((roots & ~members) || (members && !roots))
+  {
+    printf("FAIL members %016lx degree %2u: roots %016lx\n", members, degree, roots);
+    return 1;
+  }
+
+  std::vector<unsigned> parents(64, 0);
+  for (unsigned id = 0; id < 64; ++id)
+  {
+    uint64_t children = relayChildren(members, degree, id);
+    if (!(members & (1ull << id)) && children)
+    {
+      printf("FAIL members %016lx degree %2u: non-member %u has children %016lx\n",
+             members, degree, id, children);
+      ++nFail;
+    }
+    if ((children & ~members) || (children & (1ull << id)))
+    {
+      printf("FAIL members %016lx degree %2u: member %u has children %016lx\n",
+             members, degree, id, children);
+      ++nFail;
+    }
+    for (unsigned child = 0; child < 64; ++child)
+    {
+      if (children & (1ull << child))  ++parents[child];
+    }
+  }
+
+  for (unsigned id = 0; id < 64; ++id)
+  {
+    if (!(members & (1ull << id)))  continue;
+    bool     root     = roots & (1ull << id);
+    unsigned expected = root ? 0 : 1;
+    if (parents[id] != expected)
+    {
+      printf("FAIL members %016lx degree %2u: %s %u has %u parents\n",
+             members, degree, root ? "root" : "member", id, parents[id]);
+      ++nFail;
+    }
+  }
+
+  return nFail;
+}
+
+
+int main(int argc, char **argv)
+{
+  const uint64_t sets[] = { 0x0000000000000001ull,  // One member
+                            0x00000000000000ffull,  // Dense
+                            0x00000000000a5a5aull,  // Sparse
+                            0x8000000000000001ull,  // The extremes
+                            0x9249249249249249ull,  // Every third ID
+                            0xf00000000000000full,  // Two clusters
+                            0xffffffffffffffffull,  // All
+                            0x0000100400100004ull };
+  unsigned nFail = 0;
+
+  for (auto members : sets)
+  {
+    for (unsigned degree = 0; degree <= 65; ++degree)
+    {
+      nFail += check(members, degree);
+    }
+  }
+
+  // A few pseudo-random sparse sets
+  uint64_t members = 0x123456789abcdefull;
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    members ^= members << 13;
+    members ^= members >> 7;
+    members ^= members << 17;
+    nFail += check(members, 1 + i % 8);
+  }
+
+  printf("%u failures\n", nFail);
+  return nFail ? 1 : 0;
+}
@@ -50,3 +50,33 @@ int Pds::Eb::pinThread(const pthread_t& th, int cpu)
   }
   return 0;
 }
+
+// Returns the members at positions [first, first + count) of the bit list
+static uint64_t _members(uint64_t members, unsigned first, unsigned count)
+{
+  uint64_t subset = 0;
+  for (unsigned i = 0; members && (i < first + count); ++i)
+  {
+    uint64_t lowest = members & -members;
+    if (i >= first)  subset |= lowest;
+    members &= ~lowest;
+  }
+  return subset;
+}
+
+uint64_t Pds::Eb::relayRoots(uint64_t members, unsigned degree)
+{
+  if (!degree || (degree >= unsigned(__builtin_popcountll(members))))
+    return members;
+
+  return _members(members, 0, degree);
+}
+
+uint64_t Pds::Eb::relayChildren(uint64_t members, unsigned degree, unsigned id)
+{
+  if (!degree || !(members & (1ull << id)))  return 0;
+
+  // Member at position p has those at positions degree * (p + 1) + [0, degree)
+  unsigned position = __builtin_popcountll(members & ((1ull << id) - 1));
+  return _members(members, degree * (position + 1), degree);
+}
@@ -18,6 +18,13 @@ namespace Pds
     void*  allocRegion(size_t size);
     int    pinThread(const pthread_t& th, int cpu);
 
+    // Results relay tree: the members of an ID bit list, taken in ID order,
+    // form a complete tree of the given degree.  The TEB posts to the roots
+    // and each member passes the batch on to its children.  A degree of 0,
+    // or one that covers all the members, makes all of them roots.
+    uint64_t relayRoots   (uint64_t members, unsigned degree);
+    uint64_t relayChildren(uint64_t members, unsigned degree, unsigned id);
+
     class ImmData
     {
     private:
@@ -39,6 +46,9 @@ namespace Pds
       // The Monitor request server protocol depends on this
       enum Flags { Transition = 0 << 0, Buffer     = 1 << 0,
                    Response   = 0 << 1, NoResponse = 1 << 1 };
+      // Results batches don't use the response flag; set, it asks the
+      // receiving DRP to relay the batch to its children in the relay tree
+      enum { Relay = NoResponse };
       enum { MaxSrc = m_src, MaxIdx = m_idx };
     public:
       ImmData()  { }
@@ -1,4 +1,5 @@
 #include "psalg/shmem/XtcMonitorServer.hh"
+#include "psalg/shmem/XtcMonitorDir.hh"
 
 #include "psdaq/eb/eb.hh"
 #include "psdaq/eb/EbAppBase.hh"
@@ -18,6 +19,8 @@
 
 #include <signal.h>
 #include <errno.h>
+#include <fcntl.h>                      // For O_* constants
+#include <sys/mman.h>                   // For shm_open(), mmap()
 #include <unistd.h>                     // For getopt(), gethostname()
 #include <string.h>
 #include <vector>
@@ -86,6 +89,8 @@ namespace Pds {
       bool        ldist;
       unsigned    maxBufferSize;        // Maximum built event size
       unsigned    numEvBuffers;         // Number of event buffers
+      bool        directory;            // Serve events as directories into the MRs
+      bool        rings;                // Pass buffers to clients through index rings
     };
   };
 
@@ -151,6 +156,7 @@ namespace Pds {
   class MyXtcMonitorServer : public XtcMonitorServer {
   public:
     MyXtcMonitorServer(std::vector<EbLfCltLink*>&     links,
+                       const std::vector<char*>&      regions,
                        uint64_t&                      requestCount,
                        std::shared_ptr<PromHistogram> bufUseCnts,
                        std::atomic<uint64_t>&         prcBufCount,
@@ -163,6 +169,7 @@ namespace Pds {
                        prms.numEvBuffers,
                        prms.nevqueues),
       _mrqLinks    (links),
+      _regions     (regions),
       _requestCount(requestCount),
       _bufFreeList (prms.numEvBuffers),
       _bufUseCnts  (bufUseCnts),
@@ -185,6 +192,10 @@ namespace Pds {
       _requestCount = 0;
       _bufUseCnts->clear();
 
+      // Must be set before clients connect in order for them to know
+      directory(prms.directory);
+      rings(prms.rings);
+
       _init();
     }
     virtual ~MyXtcMonitorServer()
@@ -210,6 +221,17 @@ namespace Pds {
       odg->xtc.src      = XtcData::Src(_prms.id, XtcData::Level::Event);
       odg->xtc.contains = XtcData::TypeId(XtcData::TypeId::Parent, 0);
       const void* bufEnd = buf + bSz;
+
+      // In directory mode, L1Accepts are described to the clients by where
+      // their contributions sit in the shared memory MRs.  The contributions
+      // are held until the client returns the buffer.  Transitions' MR
+      // buffers are reused right away, so they're always copied
+      if (_prms.directory && (dg->service() == TransitionId::L1Accept))
+      {
+        _directory(odg, ctrb, last, bufEnd);
+        return;
+      }
+
       do
       {
         const EbDgram* idg = *ctrb;
@@ -231,6 +253,32 @@ namespace Pds {
       while (++ctrb != last);
     }
 
+    void _directory(Dgram* odg, const EbDgram* const* ctrb, const EbDgram** const last, const void* bufEnd)
+    {
+      do
+      {
+        const EbDgram* idg = *ctrb;
+        unsigned       src = idg->xtc.src.value();
+
+        odg->xtc.damage.increase(idg->xtc.damage.value());
+
+        if (!_regions[src])
+        {
+          logging::critical("No shared memory region for contribution from source %u", src);
+          throw "No shared memory region";
+        }
+        if ((const char*)odg->xtc.next() + sizeof(XtcMonitorDirEntry) > bufEnd)
+        {
+          logging::critical("Buffer is too small for a directory of %zu entries",
+                            size_t(last - ctrb));
+          throw "Buffer too small";
+        }
+        uint64_t ofs = (const char*)&idg->xtc - _regions[src];
+        new(odg->xtc.alloc(sizeof(XtcMonitorDirEntry), bufEnd)) XtcMonitorDirEntry(src, ofs, idg->xtc.extent);
+      }
+      while (++ctrb != last);
+    }
+
     virtual void _deleteDatagram(Dgram* dg) // Not called for transitions
     {
       unsigned idx = dg->xtc.src.value();
@@ -320,6 +368,7 @@ namespace Pds {
 
   private:
     std::vector<EbLfCltLink*>&     _mrqLinks;
+    const std::vector<char*>&      _regions;
     uint64_t&                      _requestCount;
     FifoMT<unsigned, std::mutex>   _bufFreeList;
     std::shared_ptr<PromHistogram> _bufUseCnts;
@@ -335,6 +384,7 @@ namespace Pds {
   {
   public:
     Meb(const MebParams& prms, ZmqContext& context, const MetricExporter_t& exporter);
+    virtual ~Meb();
   public:
     int  resetCounters();
     int  connect();
@@ -345,12 +395,17 @@ namespace Pds {
   private:                              // For EventBuilder
     virtual
     void process(EbEvent* event);
+  private:                              // For EbAppBase
+    virtual void* _allocRegion(unsigned rmtId, size_t size);
+    virtual void  _freeRegion (unsigned rmtId, void* region, size_t size);
   private:
     std::unique_ptr<MyXtcMonitorServer> _apps;
     std::vector<EbLfCltLink*>           _mrqLinks;
+    std::vector<char*>                  _regions;
     std::unique_ptr<GenericPool>        _pool;
     uint64_t                            _pidPrv;
     int64_t                             _latency;
+    std::shared_ptr<LatencyHistogram>   _latencyHist;
     uint64_t                            _eventCount;
     uint64_t                            _trCount;
     uint64_t                            _splitCount;
@@ -382,6 +437,7 @@ Meb::Meb(const MebParams&        prms,
          ZmqContext&             context,
          const MetricExporter_t& exporter) :
   EbAppBase    (prms, exporter, "MEB", EB_TMO_MS),
+  _regions     (MAX_DRPS, nullptr),
   _pidPrv      (0),
   _latency     (0),
   _eventCount  (0),
@@ -405,6 +461,7 @@ Meb::Meb(const MebParams&        prms,
   exporter->add("MEB_EvtCt",  labels, MetricType::Counter, [&](){ return _eventCount;      });
   exporter->add("MEB_TrCt",   labels, MetricType::Counter, [&](){ return _trCount;         });
   exporter->add("MEB_EvtLat", labels, MetricType::Gauge,   [&](){ return _latency;         });
+  _latencyHist = exporter->latency("MEB_EvtLatQ", labels); // ns
   exporter->add("MEB_SpltCt", labels, MetricType::Counter, [&](){ return _splitCount;      });
   exporter->add("MEB_ReqCt",  labels, MetricType::Counter, [&](){ return _requestCount;    });
   exporter->add("MRQ_TxPdg",  labels, MetricType::Gauge,   [&](){ return _mrqTransport.posting(); });
@@ -440,6 +497,62 @@ Meb::Meb(const MebParams&        prms,
   _inprocSend.connect("inproc://drp");  // Yes, 'drp' is the name
 }
 
+Meb::~Meb()
+{
+  // EbAppBase's destructor can't call our _freeRegion()
+  EbAppBase::_freeRegions();
+}
+
+// In directory mode, the MRs receiving the contributions are named shared
+// memory segments that the XtcMonitorServer's clients map to read the events
+void* Meb::_allocRegion(unsigned rmtId, size_t size)
+{
+  if (!_prms.directory)  return EbAppBase::_allocRegion(rmtId, size);
+
+  char name[128];
+  XtcMonitorMsg::regionMemoryName(_prms.tag.c_str(), rmtId, name);
+  size = roundUpSize(size);
+  int shm = shm_open(name, O_CREAT | O_RDWR, 0666);
+  if (shm < 0)
+  {
+    logging::error("%s:\n  shm_open(%s) failed: %m", __PRETTY_FUNCTION__, name);
+    return nullptr;
+  }
+  if (ftruncate(shm, size) < 0)
+  {
+    logging::error("%s:\n  ftruncate(%s, %zu) failed: %m", __PRETTY_FUNCTION__, name, size);
+    close(shm);
+    shm_unlink(name);
+    return nullptr;
+  }
+  void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+  close(shm);                           // Done with the file descriptor
+  if (region == MAP_FAILED)
+  {
+    logging::error("%s:\n  mmap(%s, %zu) failed: %m", __PRETTY_FUNCTION__, name, size);
+    shm_unlink(name);
+    return nullptr;
+  }
+  _regions[rmtId] = static_cast<char*>(region);
+
+  return region;
+}
+
+void Meb::_freeRegion(unsigned rmtId, void* region, size_t size)
+{
+  if (!_prms.directory)
+  {
+    EbAppBase::_freeRegion(rmtId, region, size);
+    return;
+  }
+
+  char name[128];
+  XtcMonitorMsg::regionMemoryName(_prms.tag.c_str(), rmtId, name);
+  munmap(region, roundUpSize(size));
+  shm_unlink(name);
+  _regions[rmtId] = nullptr;
+}
+
 int Meb::resetCounters()
 {
   EbAppBase::resetCounters();
@@ -503,7 +616,7 @@ int Meb::configure()
 
   // Code added here involving the links must be coordinated with the other side
 
-  _apps = std::make_unique<MyXtcMonitorServer>(_mrqLinks, _requestCount,
+  _apps = std::make_unique<MyXtcMonitorServer>(_mrqLinks, _regions, _requestCount,
                                                _bufUseCnts, _prcBufCount,
                                                _bufPrcMetric, _monTrgMetric, _appPrcMetric,
                                                _prms);
@@ -649,6 +762,8 @@ void Meb::process(EbEvent* event)
            + std::chrono::nanoseconds{dgram->time.nanoseconds()};
   tp_t tp   {std::chrono::duration_cast<std::chrono::system_clock::duration>(dgt)};
   _latency = std::chrono::duration_cast<ms_t>(now - tp).count();
+  if (now > tp)
+    _latencyHist->record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - tp).count());
 
   if (dg->service() == TransitionId::L1Accept)
   {
@@ -1017,6 +1132,8 @@ void MebApp::_printParams(const MebParams& prms) const
   printf("  # of event message queues:  0x%08x = %u\n",        prms.nevqueues, prms.nevqueues);
   printf("  Distribute:                 %s\n",                 prms.ldist ? "yes" : "no");
   printf("  Tag:                        %s\n",                 prms.tag.c_str());
+  printf("  Serve directories:          %s\n",                 prms.directory ? "yes" : "no");
+  printf("  Use index rings:            %s\n",                 prms.rings ? "yes" : "no");
   printf("\n");
 }
 
@@ -1061,6 +1178,8 @@ int main(int argc, char** argv)
   prms.numEvBuffers  = NUMBEROF_XFERBUFFERS;
   prms.nevqueues     = 1;
   prms.ldist         = false;
+  prms.directory     = false;
+  prms.rings         = false;
 
   int c;
   while ((c = getopt(argc, argv, "p:P:n:t:q:dA:C:1:2:u:M:k:vh")) != -1)
@@ -1165,10 +1284,16 @@ int main(int argc, char** argv)
     if (kwargs.first == "ep_fabric")    continue;
     if (kwargs.first == "ep_domain")    continue;
     if (kwargs.first == "ep_provider")  continue;
+    if (kwargs.first == "directory")    continue;
+    if (kwargs.first == "rings")        continue;
     logging::critical("Unrecognized kwarg '%s=%s'",
                       kwargs.first.c_str(), kwargs.second.c_str());
     return 1;
   }
+  prms.directory = prms.kwargs.find("directory") != prms.kwargs.end()
+                 && prms.kwargs["directory"] == "yes";
+  prms.rings     = prms.kwargs.find("rings") != prms.kwargs.end()
+                 && prms.kwargs["rings"] == "yes";
 
   struct sigaction sigAction;
 
@@ -0,0 +1,112 @@
+#include "LatencyHistogram.hh"
+
+#include <cmath>
+#include <utility>
+
+using namespace Pds;
+
+static std::atomic<uint64_t> histogramCount(0);
+
+LatencyHistogram::LatencyHistogram(unsigned numShards, unsigned subBucketBits) :
+    m_id           (histogramCount++),
+    m_subBucketBits(subBucketBits),
+    m_numBuckets   ((65 - subBucketBits) << subBucketBits),
+    m_nextShard    (0)
+{
+    if (numShards == 0)  numShards = 1;
+    m_shards.reserve(numShards);
+    for (unsigned i = 0; i < numShards; ++i) {
+        m_shards.emplace_back(Buckets + m_numBuckets + Pad);
+    }
+    clear();
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    // Threads are handed out this histogram's shards round robin the first
+    // time they record into it.  A thread records into only a few histograms.
+    static thread_local std::vector<std::pair<uint64_t, unsigned> > shards;
+    for (const auto& s : shards) {
+        if (s.first == m_id) {
+            record(s.second, value);
+            return;
+        }
+    }
+    unsigned shard = m_nextShard.fetch_add(1, std::memory_order_relaxed);
+    shards.emplace_back(m_id, shard);
+    record(shard, value);
+}
+
+uint64_t LatencyHistogram::lowerBound(unsigned bucket) const
+{
+    const unsigned sb    = m_subBucketBits;
+    const unsigned group = bucket >> sb;
+    const uint64_t sub   = bucket & ((1u << sb) - 1);
+    return group == 0 ? sub : (sub + (1ull << sb)) << (group - 1);
+}
+
+uint64_t LatencyHistogram::upperBound(unsigned bucket) const
+{
+    const unsigned group = bucket >> m_subBucketBits;
+    return lowerBound(bucket) + (group == 0 ? 1 : 1ull << (group - 1));
+}
+
+void LatencyHistogram::snapshot(Snapshot& snap) const
+{
+    snap.subBucketBits = m_subBucketBits;
+    snap.counts.assign(m_numBuckets, 0);
+    snap.count = 0;
+    snap.sum   = 0;
+    snap.max   = 0;
+    for (const auto& s : m_shards) {
+        for (unsigned i = 0; i < m_numBuckets; ++i) {
+            uint64_t n = s[Buckets + i].load(std::memory_order_relaxed);
+            snap.counts[i] += n;
+            snap.count     += n;
+        }
+        snap.sum += s[Sum].load(std::memory_order_relaxed);
+        uint64_t max = s[Max].load(std::memory_order_relaxed);
+        if (max > snap.max)  snap.max = max;
+    }
+}
+
+void LatencyHistogram::clear()
+{
+    for (auto& s : m_shards) {
+        for (auto& n : s)  n.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double q) const
+{
+    if (count == 0)  return 0;
+    uint64_t rank = std::ceil(q * double(count));
+    if (rank == 0)      rank = 1;
+    if (rank > count)   rank = count;
+    const unsigned sb = subBucketBits;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // Report the highest value that falls into the same bucket
+            const unsigned group = i >> sb;
+            const uint64_t sub   = i & ((1u << sb) - 1);
+            uint64_t lo = group == 0 ? sub : (sub + (1ull << sb)) << (group - 1);
+            uint64_t hi = lo + (group == 0 ? 0 : (1ull << (group - 1)) - 1);
+            return hi < max ? hi : max;
+        }
+    }
+    return max;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Snapshot::operator-(const Snapshot& earlier) const
+{
+    Snapshot diff(*this);
+    if (earlier.counts.size() == counts.size()) {
+        for (unsigned i = 0; i < counts.size(); ++i)
+            diff.counts[i] -= earlier.counts[i];
+        diff.count -= earlier.count;
+        diff.sum   -= earlier.sum;
+    }
+    return diff;
+}
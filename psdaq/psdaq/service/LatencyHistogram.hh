@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Pds
+{
+
+// Log-linear ("HDR") histogram of integer latencies, typically in ns.
+// Each power of two is split into 2^subBucketBits linear buckets, so a
+// value is known to within 1/2^subBucketBits of itself (3% by default)
+// over the whole uint64_t range: nanoseconds and seconds land in the
+// same ~2k buckets.  Values below 2^subBucketBits are exact.
+//
+// Recording is lock free: each thread counts into its own shard (a
+// relaxed atomic increment on a cache line no other thread touches),
+// and the shards are only added up by snapshot(), at collection time.
+// Size the histogram with one shard per thread that records into it:
+// threads are handed this histogram's shards in the order they first
+// record, and only share one once there are more threads than shards.
+class LatencyHistogram
+{
+public:
+    class Snapshot
+    {
+    public:
+        Snapshot() : subBucketBits(0), count(0), sum(0), max(0) {}
+        // Smallest value v such that a fraction q of the samples are <= v,
+        // to within the resolution of the histogram
+        uint64_t percentile(double q) const;
+        // Difference of two snapshots of the same histogram: the samples
+        // recorded in between.  max stays that of the later one.
+        Snapshot operator-(const Snapshot& earlier) const;
+    public:
+        unsigned              subBucketBits;
+        std::vector<uint64_t> counts;
+        uint64_t              count;
+        uint64_t              sum;
+        uint64_t              max;
+    };
+public:
+    LatencyHistogram(unsigned numShards=1, unsigned subBucketBits=5);
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+public:
+    void     record(uint64_t value);    // In the shard of the calling thread
+    void     record(unsigned shard, uint64_t value);
+    void     snapshot(Snapshot&) const;
+    void     clear();
+    unsigned numShards()  const { return m_shards.size(); }
+    unsigned numBuckets() const { return m_numBuckets; }
+    unsigned bucket(uint64_t value) const;
+    uint64_t lowerBound(unsigned bucket) const;
+    uint64_t upperBound(unsigned bucket) const; // Exclusive; 0 for the last
+private:
+    // Shard layout: padding, sum, max, buckets, padding
+    enum { Pad = 64/sizeof(uint64_t), Sum = Pad, Max, Buckets };
+    using Shard = std::vector<std::atomic<uint64_t> >;
+private:
+    uint64_t              m_id;         // Unique, unlike the address
+    unsigned              m_subBucketBits;
+    unsigned              m_numBuckets;
+    std::vector<Shard>    m_shards;
+    std::atomic<unsigned> m_nextShard;
+};
+
+inline unsigned LatencyHistogram::bucket(uint64_t value) const
+{
+    const unsigned sb = m_subBucketBits;
+    if (value < (1ull << sb))  return value;
+    const unsigned msb = 63 - __builtin_clzll(value);
+    // The sb bits below the leading one pick the linear bucket
+    return ((msb - sb + 1) << sb) + (value >> (msb - sb)) - (1u << sb);
+}
+
+inline void LatencyHistogram::record(unsigned shard, uint64_t value)
+{
+    Shard& s = m_shards[shard % m_shards.size()];
+    s[Buckets + bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    s[Sum].fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = s[Max].load(std::memory_order_relaxed);
+    while (value > max &&
+           !s[Max].compare_exchange_weak(max, value, std::memory_order_relaxed));
+}
+
+};
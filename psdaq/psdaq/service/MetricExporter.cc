@@ -1,5 +1,6 @@
 #include <iostream>
 #include <map>
+#include <limits>
 #include <algorithm>    // std::find_if
 #include <sys/stat.h>
 #include "MetricExporter.hh"
@@ -96,12 +97,34 @@ int Pds::MetricExporter::find(const std::string& name) const
     return -1;
 }
 
+int Pds::MetricExporter::find(const std::string& name,
+                              const std::map<std::string, std::string>& labels) const
+{
+    int i = 0;
+
+    for (const auto& family : m_families) {
+        if (family.name == name) {
+            const auto& label = family.metric[0].label;
+            if (std::equal(label.begin(), label.end(), labels.begin(), labels.end(),
+                           [](const prometheus::ClientMetric::Label& l,
+                              const std::pair<const std::string, std::string>& p) {
+                               return l.name == p.first && l.value == p.second;
+                           })) {
+                return i;
+            }
+        }
+        ++i;
+    }
+    return -1;
+}
+
 void Pds::MetricExporter::_erase(unsigned index)
 {
     m_families.erase(m_families.begin() + index);
     m_values.  erase(m_values.  begin() + index);
     m_floats.  erase(m_floats.  begin() + index);
     m_histos.  erase(m_histos.  begin() + index);
+    m_latencies.erase(m_latencies.begin() + index);
     m_type.    erase(m_type.    begin() + index);
     m_previous.erase(m_previous.begin() + index);
 }
@@ -135,6 +158,7 @@ void Pds::MetricExporter::add(const std::string& name,
     m_values.push_back(value);
     m_floats.push_back(nullptr);
     m_histos.push_back(nullptr);        // Placeholder; not used
+    m_latencies.push_back(nullptr);     // Placeholder; not used
     m_type.push_back(type);
     Pds::Previous previous;
     if (type == Pds::MetricType::Rate) {
@@ -159,6 +183,7 @@ void Pds::MetricExporter::addFloat(const std::string& name,
     m_values.push_back(nullptr);
     m_floats.push_back(value);
     m_histos.push_back(nullptr);        // Placeholder; not used
+    m_latencies.push_back(nullptr);     // Placeholder; not used
     m_type.push_back(Pds::MetricType::Float);
     Pds::Previous previous;
     m_previous.push_back(previous);
@@ -203,6 +228,10 @@ std::vector<prometheus::MetricFamily> Pds::MetricExporter::Collect() const
                 m_histos[i]->collect(m_families[i]);
                 break;
             }
+            case Pds::MetricType::Latency: {
+                m_latencies[i]->collect(m_families[i]);
+                break;
+            }
             case Pds::MetricType::Constant: {
                 break;                    // Nothing to do
             }
@@ -219,7 +248,21 @@ std::vector<prometheus::MetricFamily> Pds::MetricExporter::Collect() const
             }
         }
     }
-    return m_families;
+
+    // A name may appear only once in the exposition, so families that differ
+    // only in their labels are merged into one with a metric per label set
+    std::vector<prometheus::MetricFamily> families;
+    for (const auto& family : m_families) {
+        auto it = std::find_if(families.begin(), families.end(),
+                               [&](const prometheus::MetricFamily& f) { return f.name == family.name; });
+        if (it == families.end()) {
+            families.push_back(family);
+        }
+        else {
+            it->metric.insert(it->metric.end(), family.metric.begin(), family.metric.end());
+        }
+    }
+    return families;
 }
 
 
@@ -250,7 +293,9 @@ std::shared_ptr<Pds::PromHistogram>
     m_families.emplace_back(makeMetric(name, labels, prometheusType));
     m_families.back().metric[0].histogram.bucket.resize(numBins + 1);
     m_values.push_back(nullptr);        // Placeholder; won't be called
+    m_floats.push_back(nullptr);        // Placeholder; won't be called
     m_histos.push_back(std::make_shared<PromHistogram>(numBins, binWidth, binMin));
+    m_latencies.push_back(nullptr);     // Placeholder; not used
     m_type.push_back(type);
     m_previous.push_back({});           // Placeholder: unused
 
@@ -306,3 +351,51 @@ void Pds::PromHistogram::clear()
         m_counts[i] = 0;
     m_sum = 0.0;
 }
+
+std::shared_ptr<Pds::LatencyHistogram>
+    Pds::MetricExporter::latency(const std::string& name,
+                                 const std::map<std::string, std::string>& labels,
+                                 unsigned numShards,
+                                 const std::vector<double>& quantiles)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int i = find(name, labels);
+    if (i != -1) {
+        _erase(i);
+    }
+    auto histogram = std::make_shared<LatencyHistogram>(numShards);
+    m_families.emplace_back(makeMetric(name, labels, prometheus::MetricType::Summary));
+    m_families.back().metric[0].summary.quantile.resize(quantiles.size());
+    m_values.push_back(nullptr);        // Placeholder; won't be called
+    m_floats.push_back(nullptr);        // Placeholder; won't be called
+    m_histos.push_back(nullptr);        // Placeholder; not used
+    m_latencies.push_back(std::make_shared<PromLatency>(histogram, quantiles));
+    m_type.push_back(Pds::MetricType::Latency);
+    m_previous.push_back({});           // Placeholder: unused
+    return histogram;
+}
+
+Pds::PromLatency::PromLatency(std::shared_ptr<LatencyHistogram> histogram,
+                              const std::vector<double>& quantiles) :
+  m_histogram(histogram),
+  m_quantiles(quantiles)
+{
+}
+
+void Pds::PromLatency::collect(prometheus::MetricFamily& family)
+{
+    auto& metric = family.metric[0];
+
+    m_histogram->snapshot(m_current);
+    auto interval = m_current - m_previous;
+    for (unsigned i = 0; i < m_quantiles.size(); ++i) {
+        auto& quantile = metric.summary.quantile[i];
+        quantile.quantile = m_quantiles[i];
+        quantile.value = (interval.count
+                       ? static_cast<double>(interval.percentile(m_quantiles[i]))
+                       : std::numeric_limits<double>::quiet_NaN());
+    }
+    metric.summary.sample_count = m_current.count;
+    metric.summary.sample_sum = static_cast<double>(m_current.sum);
+    std::swap(m_previous, m_current);
+}
@@ -7,6 +7,7 @@
 #include <prometheus/exposer.h>
 #include <prometheus/metric_type.h>
 #include <prometheus/metric_family.h>
+#include "LatencyHistogram.hh"
 
 namespace Pds
 {
@@ -38,6 +39,25 @@ private:
     double                m_sum;
 };
 
+// Publishes a LatencyHistogram as a Prometheus summary: the quantiles
+// are those of the samples recorded since the previous collection, so
+// that the tails of each scrape interval show up, while the count and
+// sum are totals, as Prometheus expects
+class PromLatency
+{
+public:
+    PromLatency(std::shared_ptr<LatencyHistogram> histogram,
+                const std::vector<double>& quantiles);
+
+    void collect(prometheus::MetricFamily& family);
+
+private:
+    std::shared_ptr<LatencyHistogram> m_histogram;
+    std::vector<double>               m_quantiles;
+    LatencyHistogram::Snapshot        m_previous;
+    LatencyHistogram::Snapshot        m_current;
+};
+
 enum class MetricType
 {
     Gauge,
@@ -45,13 +65,16 @@ enum class MetricType
     Rate,
     Constant,                           // To be used only by addConst()
     Histogram,
-    Float
+    Float,
+    Latency
 };
 
 class MetricExporter : public prometheus::Collectable
 {
 public:
     int find(const std::string& name) const;
+    int find(const std::string& name,
+             const std::map<std::string, std::string>& labels) const;
     void add(const std::string& name,
              const std::map<std::string, std::string>& labels,
              MetricType type, std::function<int64_t()> value);
@@ -65,6 +88,14 @@ public:
          histogram(const std::string& name,
                    const std::map<std::string, std::string>& labels,
                    unsigned numBins, double binWidth=1.0, double binMin=0.0);
+    // Histograms of the same name but different labels, e.g., one per link,
+    // are kept apart and exposed as one family.  Give numShards as the number
+    // of threads that record into the histogram.
+    std::shared_ptr<LatencyHistogram>
+         latency(const std::string& name,
+                 const std::map<std::string, std::string>& labels,
+                 unsigned numShards=1,
+                 const std::vector<double>& quantiles={0.5, 0.99, 0.999});
     std::vector<prometheus::MetricFamily> Collect() const override;
 private:
     void _erase(unsigned index);
@@ -74,6 +105,7 @@ private:
     std::vector<std::function<int64_t()> > m_values;
     std::vector<std::function<bool(double&)> > m_floats;
     mutable std::vector<std::shared_ptr<PromHistogram> > m_histos;
+    mutable std::vector<std::shared_ptr<PromLatency> > m_latencies;
     std::vector<MetricType> m_type;
     mutable std::vector<Previous> m_previous;
 };
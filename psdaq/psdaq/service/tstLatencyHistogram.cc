@@ -0,0 +1,143 @@
+#include "LatencyHistogram.hh"
+
+#include <cstdint>
+#include <stdio.h>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+//
+//  Checks LatencyHistogram's bucketing against its bounds, percentiles
+//  against those of the exact samples, and the difference of snapshots.
+//
+
+using namespace Pds;
+
+static unsigned nFail = 0;
+
+static void check(bool ok, const char* what)
+{
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok)  nFail++;
+}
+
+static void testBuckets()
+{
+  LatencyHistogram hist(1, 5);
+  const unsigned n = hist.numBuckets();
+  bool exact = true, bounds = true, contiguous = true, resolution = true;
+
+  for (uint64_t v = 0; v < 32; ++v)
+    exact &= hist.bucket(v) == v;
+
+  for (unsigned b = 0; b < n; ++b)
+  {
+    uint64_t lo = hist.lowerBound(b);
+    uint64_t hi = hist.upperBound(b);   // 0 for the last bucket
+    bounds &= hist.bucket(lo) == b && hist.bucket(hi - 1) == b;
+    if (b + 1 < n)
+    {
+      contiguous &= hist.lowerBound(b + 1) == hi;
+      resolution &= (hi - lo) <= std::max<uint64_t>(1, lo >> 5);
+    }
+  }
+
+  check(exact,      "values below 2^subBucketBits have a bucket of their own");
+  check(bounds,     "lower and upper bounds fall in their bucket");
+  check(contiguous, "buckets are contiguous");
+  check(resolution, "bucket widths are within 1/2^subBucketBits of the values");
+  check(hist.bucket(std::numeric_limits<uint64_t>::max()) == n - 1,
+        "the largest value falls in the last bucket");
+}
+
+static void testPercentiles()
+{
+  LatencyHistogram hist(1, 5);
+  LatencyHistogram::Snapshot snap;
+
+  hist.snapshot(snap);
+  check(snap.count == 0 && snap.percentile(0.5) == 0, "percentile of nothing is 0");
+
+  // Latencies from 1 us to 10 ms
+  std::vector<uint64_t> values;
+  for (uint64_t v = 1000; v <= 10000000; v += 997)  values.push_back(v);
+  for (auto v : values)  hist.record(v);
+  hist.snapshot(snap);
+  std::sort(values.begin(), values.end());
+
+  bool ok = true;
+  for (double q : {0.01, 0.1, 0.5, 0.9, 0.99, 0.999})
+  {
+    uint64_t exact  = values[size_t(q * values.size() + 0.999999) - 1];
+    uint64_t approx = snap.percentile(q);
+    if (approx < exact || approx - exact > exact / 32)
+    {
+      printf("  q %5.3f: %lu, exact %lu\n", q, approx, exact);
+      ok = false;
+    }
+  }
+  check(ok, "percentiles are within the resolution above the exact ones");
+  check(snap.percentile(1.0) == values.back() && snap.max == values.back(),
+        "percentile 1 is the maximum");
+  check(snap.percentile(0.0) <= values.front() + values.front() / 32,
+        "percentile 0 is in the bucket of the minimum");
+}
+
+static void testDifference()
+{
+  LatencyHistogram hist(1, 5);
+  LatencyHistogram reference(1, 5);
+  LatencyHistogram::Snapshot before, after, expected;
+
+  for (uint64_t v = 1; v < 100000; v *= 3)  hist.record(v);
+  hist.snapshot(before);
+
+  uint64_t sum = 0, count = 0;
+  for (uint64_t v = 500; v < 5000000; v += 12345)
+  {
+    hist.record(v);
+    reference.record(v);
+    sum += v;
+    ++count;
+  }
+  hist.snapshot(after);
+  reference.snapshot(expected);
+
+  auto diff = after - before;
+  check(diff.count == count && diff.sum == sum, "difference has the count and sum in between");
+  check(diff.counts == expected.counts, "difference has the buckets in between");
+  check(diff.max == after.max, "difference keeps the later maximum");
+  check(diff.percentile(0.5) == expected.percentile(0.5), "difference has the percentiles in between");
+}
+
+static void testThreads()
+{
+  const unsigned numThreads = 4;
+  const unsigned perThread  = 100000;
+  LatencyHistogram hist(numThreads, 5);
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < numThreads; ++t)
+    threads.emplace_back([&hist, t]() {
+      for (unsigned i = 0; i < perThread; ++i)  hist.record(t * perThread + i);
+    });
+  for (auto& th : threads)  th.join();
+
+  LatencyHistogram::Snapshot snap;
+  hist.snapshot(snap);
+  uint64_t n = uint64_t(numThreads) * perThread;
+  check(snap.count == n && snap.sum == n * (n - 1) / 2 && snap.max == n - 1,
+        "shards add up to what the threads recorded");
+}
+
+int main(int argc, char **argv)
+{
+  testBuckets();
+  testPercentiles();
+  testDifference();
+  testThreads();
+
+  printf("%u failures\n", nFail);
+  return nFail ? 1 : 0;
+}
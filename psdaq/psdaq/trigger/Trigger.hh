@@ -31,6 +31,15 @@ namespace Pds {
       virtual void     event(const Pds::EbDgram* const* start,
                              const Pds::EbDgram**       end,
                              Pds::Eb::ResultDgram&      result) = 0;
+      // Triggers with a high per-call overhead may instead accept events for
+      // deferred processing: when queue() returns true, the result is filled
+      // in by a later flush(), in the order the events were queued.  ready()
+      // indicates that a flush is due, e.g., the batch is full or too old.
+      virtual bool     queue(const Pds::EbDgram* const* start,
+                             const Pds::EbDgram**       end,
+                             Pds::Eb::ResultDgram&      result) { return false; }
+      virtual bool     ready() const { return true; }
+      virtual void     flush() {};
       virtual void     shutdown() {};
     public:
       static size_t size() { return sizeof(Pds::Eb::ResultDgram); }
@@ -23,6 +23,8 @@ using namespace rapidjson;
 using json = nlohmann::json;
 using logging = psalg::SysLog;
 using ms_t = std::chrono::milliseconds;
+using us_t = std::chrono::microseconds;
+using ns_t = std::chrono::nanoseconds;
 
 
 namespace Pds {
@@ -44,9 +46,18 @@ namespace Pds {
       void event(const Pds::EbDgram* const* start,
                  const Pds::EbDgram**       end,
                  Pds::Eb::ResultDgram&      result) override;
+      bool queue(const Pds::EbDgram* const* start,
+                 const Pds::EbDgram**       end,
+                 Pds::Eb::ResultDgram&      result) override;
+      bool ready() const override;
+      void flush() override;
       void shutdown() override;
       void cleanup();
     private:
+      void _copyInputs(unsigned                   slot,
+                       const Pds::EbDgram* const* start,
+                       const Pds::EbDgram**       end);
+      int  _exchange(const char* msg, size_t size);
       int  _startPython(pid_t& pyPid);
       int  _setupMsgQueue(std::string key, const char* name, int& id, bool write);
       int  _setupShMem(std::string key,
@@ -72,6 +83,15 @@ namespace Pds {
       int                _resShmId;
       std::vector<void*> _inpData;
       void*              _resData;
+    private:
+      // Events are handed to Python in batches of up to _batchSize, each event
+      // in its own slot of the Inputs and Results shared memory regions
+      unsigned           _batchSize;
+      ns_t               _batchDeadline;
+      size_t             _inpSlotSize;
+      size_t             _resSlotSize;
+      std::vector<Pds::Eb::ResultDgram*> _batch;
+      Pds::fast_monotonic_clock::time_point _batchStart;
     };
   };
 };
@@ -95,7 +115,10 @@ Pds::Trg::TebPyTrig::TebPyTrig() :
   _resMqId (0),
   _inpShmId(0),
   _resShmId(0),
-  _resData (nullptr)
+  _resData (nullptr),
+  _batchSize(1),
+  _inpSlotSize(0),
+  _resSlotSize(0)
 {
   _tebPyTrigger = this;
 
@@ -169,6 +192,19 @@ int Pds::Trg::TebPyTrig::configure(const json&              connectMsg,
   _pythonScript = scriptPath + "/" + _pythonScript;
   _partition    = prms.partition;
 
+  // Batching amortizes the message queue round trip to Python over several
+  // events at the cost of holding results back for up to the deadline
+  auto& kwargs = const_cast<Pds::Eb::EbParams&>(prms).kwargs;
+  _batchSize     = kwargs.find("trg_batch") != kwargs.end()
+                 ? std::stoul(kwargs["trg_batch"])
+                 : 1;
+  _batchDeadline = kwargs.find("trg_deadline") != kwargs.end() // In us
+                 ? us_t(std::stoul(kwargs["trg_deadline"]))
+                 : us_t(1000);
+  if (_batchSize == 0)  _batchSize = 1;
+  logging::info("[C++] Python trigger batch size %u, deadline %ld us",
+                _batchSize, std::chrono::duration_cast<us_t>(_batchDeadline).count());
+
   _keyBase = "p" + std::to_string(prms.partition) + "_teb" + std::to_string(prms.id) ;
 
   _inpMqId  = 0;
@@ -177,6 +213,7 @@ int Pds::Trg::TebPyTrig::configure(const json&              connectMsg,
   _inpData  .clear();
   _resShmId = 0;
   _resData  = nullptr;
+  _batch    .clear();
 
   return rc;
 }
@@ -329,12 +366,13 @@ int Pds::Trg::TebPyTrig::initialize(const std::vector<size_t>& inputsSizes,
   // Creating shared memory
   logging::info("[C++] Creating shared memory blocks");
 
-  // Calculate the size of the Inputs data block
-  size_t inputsSize = 0;
+  // Calculate the size of the Inputs data block: one slot per batched event
+  _inpSlotSize = 0;
   for (unsigned i = 0; i < inputsSizes.size(); ++i)
   {
-    inputsSize += inputsSizes[i];
+    _inpSlotSize += inputsSizes[i];
   }
+  size_t inputsSize = _inpSlotSize * _batchSize;
 
   // Round up to an integral number of pages
   auto pageSize = sysconf(_SC_PAGESIZE);
@@ -354,7 +392,9 @@ int Pds::Trg::TebPyTrig::initialize(const std::vector<size_t>& inputsSizes,
   }
 
   // Round up to an integral number of pages
-  resultsSize = (resultsSize + pageSize - 1) & ~(pageSize - 1);
+  _resSlotSize = resultsSize;
+  resultsSize  = _resSlotSize * _batchSize;
+  resultsSize  = (resultsSize + pageSize - 1) & ~(pageSize - 1);
 
   rc = _setupShMem("/shmtebres_" + _keyBase, resultsSize, "Results", _resShmId, _resData, true);
   if (rc)  return rc;
@@ -414,6 +454,9 @@ int Pds::Trg::TebPyTrig::initialize(const std::vector<size_t>& inputsSizes,
   cnt = snprintf(mtext, size, ",%zu", resultsSize);
   mtext += cnt;
   size  -= cnt;
+  cnt = snprintf(mtext, size, ",%zu", _resSlotSize);
+  mtext += cnt;
+  size  -= cnt;
   if (size == 0)
   {
     logging::critical("mtext buffer is too small for Results message");
@@ -466,30 +509,29 @@ int Pds::Trg::TebPyTrig::initialize(const std::vector<size_t>& inputsSizes,
   return rc;
 }
 
-void Pds::Trg::TebPyTrig::event(const Pds::EbDgram* const* start,
-                                const Pds::EbDgram**       end,
-                                Pds::Eb::ResultDgram&      result)
+void Pds::Trg::TebPyTrig::_copyInputs(unsigned                   slot,
+                                      const Pds::EbDgram* const* start,
+                                      const Pds::EbDgram**       end)
 {
-  *(Pds::Eb::ResultDgram*)_resData = result;
-
-  unsigned idx = 0;
+  size_t   offset = slot * _inpSlotSize;
+  unsigned idx    = 0;
   const Pds::EbDgram* const* ctrb = start;
   do
   {
     auto dg   = *ctrb;
     auto size = sizeof(*dg) + dg->xtc.sizeofPayload();
-    auto dest = _inpData[idx++];
+    auto dest = (char*)_inpData[idx++] + offset;
     memcpy(dest, dg, size);
   }
   while(++ctrb != end);
 
   if (idx < _inpData.size())            // zero terminate
-    *(EbDgram*)(_inpData[idx]) = EbDgram(PulseId{0}, XtcData::Dgram());
+    *(EbDgram*)((char*)_inpData[idx] + offset) = EbDgram(PulseId{0}, XtcData::Dgram());
+}
 
-  int       rc;
-  char msg[512];
-  msg[0] = 'g';
-  rc = _send(_inpMqId, msg, 1);
+int Pds::Trg::TebPyTrig::_exchange(const char* msg, size_t size)
+{
+  int rc = _send(_inpMqId, msg, size);
 
   if (rc == 0)
     rc = _checkPy(_pyPid);
@@ -502,9 +544,64 @@ void Pds::Trg::TebPyTrig::event(const Pds::EbDgram* const* start,
     if (recvmsg[0] != 'g')
       logging::error("Received error from Python: msg '%c'", recvmsg[0]);
 
+  return rc;
+}
+
+void Pds::Trg::TebPyTrig::event(const Pds::EbDgram* const* start,
+                                const Pds::EbDgram**       end,
+                                Pds::Eb::ResultDgram&      result)
+{
+  *(Pds::Eb::ResultDgram*)_resData = result;
+
+  _copyInputs(0, start, end);
+
+  char msg[512];
+  msg[0] = 'g';
+  _exchange(msg, 1);
+
   result = *(Pds::Eb::ResultDgram*)_resData;
 }
 
+bool Pds::Trg::TebPyTrig::queue(const Pds::EbDgram* const* start,
+                                const Pds::EbDgram**       end,
+                                Pds::Eb::ResultDgram&      result)
+{
+  if (_batchSize < 2)  return false;    // Handle events one at a time
+
+  unsigned slot = _batch.size();
+  if (slot == 0)  _batchStart = Pds::fast_monotonic_clock::now();
+
+  *(Pds::Eb::ResultDgram*)((char*)_resData + slot * _resSlotSize) = result;
+
+  _copyInputs(slot, start, end);
+
+  _batch.push_back(&result);
+
+  return true;
+}
+
+bool Pds::Trg::TebPyTrig::ready() const
+{
+  return (_batch.size() >= _batchSize) ||
+         (Pds::fast_monotonic_clock::now() - _batchStart >= _batchDeadline);
+}
+
+void Pds::Trg::TebPyTrig::flush()
+{
+  if (_batch.empty())  return;
+
+  // A single message covers all events of the batch
+  char msg[512];
+  int  cnt = snprintf(msg, sizeof(msg), "b,%zu", _batch.size());
+  _exchange(msg, cnt);
+
+  for (unsigned slot = 0; slot < _batch.size(); ++slot)
+  {
+    *_batch[slot] = *(Pds::Eb::ResultDgram*)((char*)_resData + slot * _resSlotSize);
+  }
+  _batch.clear();
+}
+
 
 // The class factory
 
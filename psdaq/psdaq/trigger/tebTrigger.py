@@ -33,6 +33,12 @@ class TriggerDataSource(object):
 
         self.connect_json = None
 
+        # Events arrive either one at a time ('g') or in batches ('b,<count>'),
+        # one event per slot of the shared memory regions.  The results of a
+        # batch are acknowledged together after the last one is filled in.
+        self._slot  = 0
+        self._batch = 1
+
         # Make args available to the user scripts
         self.args = ArgsParser().parse()
 
@@ -97,6 +103,7 @@ class TriggerDataSource(object):
                     shm_msg = message.decode().split(',')
                     self._shm_res = posix_ipc.SharedMemory(shm_msg[1], size=int(shm_msg[2]))
                     self._shm_res_mmap = mmap.mmap(self._shm_res.fd, self._shm_res.size)
+                    self._shm_res_slotSize = int(shm_msg[3]) if len(shm_msg) > 3 else self._shm_res.size
                 except posix_ipc.Error as exp:
                     print(
                         f"[Python] Error connecting to 'Results' shared memory - Error: {exp}"
@@ -147,8 +154,17 @@ class TriggerDataSource(object):
             #print(f"[Python] Received msg '{message}', prio '{priority}'")
 
             if chr(message[0]) == 'g':
+                self._slot  = 0
+                self._batch = 1
                 event = Event(self._shm_inp_mmap, self._shm_inp_bufSizes)
                 yield event
+            elif chr(message[0]) == 'b':
+                self._batch = int((message.decode())[2:])
+                slotSize    = self._shm_inp_bufSizes[-1]
+                for self._slot in range(self._batch):
+                    event = Event(self._shm_inp_mmap, self._shm_inp_bufSizes,
+                                  self._slot * slotSize)
+                    yield event
             elif chr(message[0]) == 's':
                 break
             else:
@@ -156,9 +172,14 @@ class TriggerDataSource(object):
 
     def result(self, persist, monitor):
 
-        result = rdg.ResultDgram(self._shm_res_mmap, persist, monitor)
+        offset = self._slot * self._shm_res_slotSize
+        view   = memoryview(self._shm_res_mmap)[offset:offset + self._shm_res_slotSize]
+        result = rdg.ResultDgram(view, persist, monitor)
+        del result
+        view.release()
 
-        self._mq_res.send(b"g")
+        if self._slot == self._batch - 1:
+            self._mq_res.send(b"g")
 
         #print(
         #    f"[Python] Sent message 'g'"
@@ -167,9 +188,10 @@ class TriggerDataSource(object):
 
 # Revisit: Move this into a .pyx?
 class Event(object):
-    def __init__(self, shm_inp_mmap, shm_bufSizes):
+    def __init__(self, shm_inp_mmap, shm_bufSizes, offset=0):
         self._shm_inp_mmap      = shm_inp_mmap
         self._shm_bufSizes = shm_bufSizes
+        self._offset       = offset
         self._idx = 0
         self._pid = 0
 
@@ -180,8 +202,8 @@ class Event(object):
         if self._idx == len(self._shm_bufSizes) - 1:
             raise StopIteration
 
-        beg = self._shm_bufSizes[self._idx]
-        end = self._shm_bufSizes[self._idx + 1]
+        beg = self._offset + self._shm_bufSizes[self._idx]
+        end = self._offset + self._shm_bufSizes[self._idx + 1]
         datagram = edg.EbDgram(view=self._shm_inp_mmap[beg:end])
         if datagram.pulseId() == 0:
             raise StopIteration
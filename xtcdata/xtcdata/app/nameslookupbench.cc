@@ -0,0 +1,142 @@
+#include "xtcdata/xtc/ShapesData.hh"
+#include "xtcdata/xtc/VarDef.hh"
+#include "xtcdata/xtc/NamesLookup.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace XtcData;
+
+/*
+ * Compare NamesLookup with the std::unordered_map it replaced, on a
+ * configure transition of many detectors: the time to fill the lookup
+ * from the Names, and to resolve the NamesId of every ShapesData of
+ * an event, as the DRP and psana do per event.
+ */
+
+typedef std::unordered_map<unsigned,NameIndex> NamesMap;
+
+class BenchDef:public VarDef
+{
+public:
+  BenchDef()
+   {
+       NameVec.push_back({"intOffset",Name::UINT32});
+       NameVec.push_back({"fltPos",Name::DOUBLE});
+       NameVec.push_back({"array",Name::UINT16,2});
+   }
+} BenchDef;
+
+void usage(char* progname)
+{
+    fprintf(stderr, "Usage: %s [-n <nodes>] [-m <names per node>] [-e <events>] [-r <configures>] [-h]\n", progname);
+}
+
+static double seconds(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+}
+
+template <class Lookup>
+static double configure(Lookup& lookup, std::vector<Names*>& names, unsigned nconfig)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned i=0; i<nconfig; i++) {
+        lookup.clear();
+        for (Names* n : names)
+            lookup[n->namesId()] = NameIndex(*n);
+    }
+    return seconds(t0);
+}
+
+template <class Lookup>
+static double lookup(Lookup& lookup, std::vector<unsigned>& ids, unsigned nevent, unsigned& sum)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned i=0; i<nevent; i++) {
+        for (unsigned id : ids)
+            sum += lookup[id].exists();
+    }
+    return seconds(t0);
+}
+
+int main(int argc, char* argv[])
+{
+    int c;
+    unsigned nnodes = 300;
+    unsigned nnames = 4;
+    unsigned nevent = 10000;
+    unsigned nconfig = 100;
+    int parseErr = 0;
+
+    while ((c = getopt(argc, argv, "hn:m:e:r:")) != -1) {
+        switch (c) {
+        case 'h':
+            usage(argv[0]);
+            exit(0);
+        case 'n':
+            nnodes = atoi(optarg);
+            break;
+        case 'm':
+            nnames = atoi(optarg);
+            break;
+        case 'e':
+            nevent = atoi(optarg);
+            break;
+        case 'r':
+            nconfig = atoi(optarg);
+            break;
+        default:
+            parseErr++;
+        }
+    }
+    if (parseErr || nnodes==0 || nnodes>0x1000 || nnames==0 || nnames>0x100) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    // the Names of a configure transition, spread over the nodeIds
+    const unsigned bufsize = 0x4000000;
+    std::vector<char> buf(bufsize);
+    const void* bufEnd = buf.data()+bufsize;
+    Xtc& xtc = *new(buf.data(), bufEnd) Xtc(TypeId(TypeId::Parent, 0));
+    std::vector<Names*> names;
+    std::vector<unsigned> ids;
+    Alg alg("raw",1,2,3);
+    for (unsigned node=0; node<nnodes; node++) {
+        unsigned nodeId = (node*0xfff)/nnodes;
+        for (unsigned i=0; i<nnames; i++) {
+            NamesId namesId(nodeId, i);
+            Names& n = *new(xtc, bufEnd) Names(bufEnd, "bench", alg, "bench", "detnum1234", namesId, i);
+            n.add(xtc, bufEnd, BenchDef);
+            names.push_back(&n);
+            ids.push_back(namesId);
+        }
+    }
+    // the ShapesData of an event don't come in key order
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(42));
+
+    NamesLookup namesLookup;
+    NamesMap    namesMap;
+    unsigned    sum = 0;
+
+    double cfgLookup = configure(namesLookup, names, nconfig);
+    double cfgMap    = configure(namesMap,    names, nconfig);
+    double evtLookup = lookup(namesLookup, ids, nevent, sum);
+    double evtMap    = lookup(namesMap,    ids, nevent, sum);
+
+    printf("%u nodes x %u names, %u configures, %u events (checksum %u)\n",
+           nnodes, nnames, nconfig, nevent, sum);
+    printf("%-20s %14s %14s\n", "", "configure [us]", "lookup [ns]");
+    printf("%-20s %14.1f %14.2f\n", "NamesLookup",
+           cfgLookup*1e6/nconfig, evtLookup*1e9/(double(nevent)*ids.size()));
+    printf("%-20s %14.1f %14.2f\n", "std::unordered_map",
+           cfgMap*1e6/nconfig, evtMap*1e9/(double(nevent)*ids.size()));
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <fcntl.h>
+#include <inttypes.h>
 #include <map>
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,6 +7,8 @@
 #include <unistd.h>
 
 #include "xtcdata/xtc/XtcFileIterator.hh"
+#include "xtcdata/xtc/XtcMmapFileIterator.hh"
+#include "xtcdata/xtc/XtcIndex.hh"
 #include "xtcdata/xtc/XtcIterator.hh"
 #include "xtcdata/xtc/ShapesData.hh"
 #include "xtcdata/xtc/DescData.hh"
@@ -72,7 +75,7 @@ private:
 
 void usage(char* progname)
 {
-    fprintf(stderr, "Usage: %s -f <filename> [-h]\n", progname);
+    fprintf(stderr, "Usage: %s -f <filename> [-n <nEvents>] [-t <timestamp> [-i <indexname>]] [-h]\n", progname);
 }
 
 int main(int argc, char* argv[])
@@ -81,8 +84,10 @@ int main(int argc, char* argv[])
     string xtcname;
     int parseErr = 0;
     unsigned neventreq = 0xffffffff;
+    uint64_t timestamp = 0;
+    string idxname;
 
-    while ((c = getopt(argc, argv, "hf:n")) != -1) {
+    while ((c = getopt(argc, argv, "hf:n:t:i:")) != -1) {
         switch (c) {
         case 'h':
             usage(argv[0]);
@@ -93,6 +98,12 @@ int main(int argc, char* argv[])
         case 'n':
             neventreq = atoi(optarg);
             break;
+        case 't':
+            timestamp = strtoull(optarg, NULL, 0);
+            break;
+        case 'i':
+            idxname = optarg;
+            break;
         default:
             parseErr++;
         }
@@ -103,6 +114,38 @@ int main(int argc, char* argv[])
         exit(-1);
     }
 
+    // With a timestamp, look the event up in the index rather than
+    // scanning the smd file
+    if (timestamp) {
+        int bigfd = open((xtcname+".xtc2").c_str(), O_RDONLY);
+        if (bigfd < 0) {
+            fprintf(stderr, "Unable to open big file '%s'\n", xtcname.c_str());
+            exit(-1);
+        }
+        if (idxname.empty()) idxname = xtcname+".xtc2.idx";
+        XtcIndex index;
+        if (index.open(idxname.c_str())) exit(-1);
+        const XtcIndexEntry* entry = index.find(timestamp);
+        if (!entry) {
+            fprintf(stderr, "Timestamp 0x%llx not found in index of %zu entries\n",
+                    (unsigned long long)timestamp, index.size());
+            exit(-1);
+        }
+        XtcMmapFileIterator bigiter(bigfd, 0x4000000);
+        Dgram* bigdg = bigiter.seek(entry->offset);
+        if (!bigdg) {
+            printf("Big dgram read error at offset 0x%llx\n", (unsigned long long)entry->offset);
+            exit(-1);
+        }
+        printf("Big   event %s transition: time %d.%09d, "
+               "extent %d offset 0x%llx damage 0x%x\n",
+               TransitionId::name(bigdg->service()), bigdg->time.seconds(),
+               bigdg->time.nanoseconds(), bigdg->xtc.extent,
+               (unsigned long long)entry->offset, entry->damage);
+        ::close(bigfd);
+        return 0;
+    }
+
     int smallfd = open((xtcname+".smd.xtc2").c_str(), O_RDONLY);
     if (smallfd < 0) {
         fprintf(stderr, "Unable to open smd file '%s'\n", xtcname.c_str());
@@ -115,7 +158,7 @@ int main(int argc, char* argv[])
     }
 
     static const size_t bigdgBufferSize = 0x4000000;
-    Dgram* bigdg = (Dgram*)malloc(bigdgBufferSize);
+    XtcMmapFileIterator bigiter(bigfd, bigdgBufferSize);
 
     XtcFileIterator iter(smallfd, 0x4000000);
     Dgram* smalldg = iter.next();
@@ -128,28 +171,19 @@ int main(int argc, char* argv[])
         smditer.reset();
         smditer.iterate(&(smalldg->xtc), bufEnd);
         printf("Small event %d, %s transition: time %d.%09d, "
-               "extent %d offset 0x%llx\n",
+               "extent %d offset 0x%" PRIx64 "\n",
                nevent,
                TransitionId::name(smalldg->service()),
                smalldg->time.seconds(),
                smalldg->time.nanoseconds(), smalldg->xtc.extent,
                smditer.offset);
-        if (smditer.offset<=0) continue; // non-L1 transitions are stored in smd
-        if (lseek(bigfd, (off_t)smditer.offset, SEEK_SET) < 0) {
-            printf("lseek error\n");
-            exit(-1);
-        }
-        if (::read(bigfd, bigdg, sizeof(Dgram)) == 0) {
-            printf("Big dgram header read error\n");
-            exit(-1);
-        }
-        size_t bigdgsize = sizeof(Dgram)+bigdg->xtc.extent;
-        if (bigdgsize>bigdgBufferSize) {
-            printf("Big dgram too large %zu\n",bigdgsize);
-            exit(-1);
+        if (smditer.offset<=0) { // non-L1 transitions are stored in smd
+            smalldg = iter.next();
+            continue;
         }
-        if (::read(bigfd, bigdg->xtc.payload(), bigdg->xtc.extent) == 0) {
-            printf("Big dgram payload read error\n");
+        Dgram* bigdg = bigiter.seek((uint64_t)smditer.offset);
+        if (!bigdg) {
+            printf("Big dgram read error at offset 0x%" PRIx64 "\n", smditer.offset);
             exit(-1);
         }
         printf("Big   event %d, %s transition: time %d.%09d, "
@@ -162,6 +196,5 @@ int main(int argc, char* argv[])
 
     ::close(smallfd);
     ::close(bigfd);
-    free(bigdg);
     return 0;
 }
@@ -13,6 +13,7 @@
 // additions from xtc writer
 #include <type_traits>
 #include "xtcdata/xtc/XtcFileIterator.hh"
+#include "xtcdata/xtc/XtcMmapFileIterator.hh"
 #include "xtcdata/xtc/VarDef.hh"
 #include "xtcdata/xtc/DescData.hh"
 #include "xtcdata/xtc/Dgram.hh"
@@ -264,13 +265,14 @@ int main(int argc, char* argv[])
     int parseErr = 0;
     size_t n_events = 0;
     int n_mod = 0;
+    bool useMmap = false;
     char outname[MAX_FNAME_LEN];
     strncpy(outname, "smd.xtc2", MAX_FNAME_LEN);
     auto usage = [](const char* progname) {
-        fprintf(stderr, "Usage: %s -f <filename> [-h]\n", progname);
+        fprintf(stderr, "Usage: %s -f <filename> [-o <outname>] [-n <nEvents>] [-M] [-h]\n", progname);
     };
 
-    while ((c = getopt(argc, argv, "ht:n:m:f:o:")) != -1) {
+    while ((c = getopt(argc, argv, "ht:n:m:f:o:M")) != -1) {
     switch (c) {
       case 'h':
         usage(argv[0]);
@@ -291,6 +293,9 @@ int main(int argc, char* argv[])
       case 'o':
         strncpy(outname, optarg, MAX_FNAME_LEN);
         break;
+      case 'M':
+        useMmap = true;
+        break;
       default:
         parseErr++;
     }
@@ -309,7 +314,8 @@ int main(int argc, char* argv[])
     exit(2);
     }
 
-    XtcFileIterator iter(fd, BUFSIZE);
+    XtcFileIterator* iter = useMmap ? 0 : new XtcFileIterator(fd, BUFSIZE);
+    XtcMmapFileIterator* miter = useMmap ? new XtcMmapFileIterator(fd, BUFSIZE) : 0;
     Dgram* dgIn;
 
     // Prepare output smd.xtc2 file
@@ -352,7 +358,7 @@ int main(int argc, char* argv[])
 
     Smd smd;
     Dgram* dgOut;
-    while ((dgIn = iter.next())) {
+    while ((dgIn = useMmap ? miter->next() : iter->next())) {
         nowDgramSize = (uint64_t)(sizeof(*dgIn) + dgIn->xtc.sizeofPayload());
         dgOut = smd.generate(dgIn, buf, bufEnd, nowOffset, nowDgramSize, namesLookup, namesId);
 
@@ -380,6 +386,8 @@ int main(int argc, char* argv[])
 
   cout << "Finished writing smd for " << eventId << " events with size (B): " << nowOffset << endl;
   fclose(xtcFile);
+  delete iter;
+  delete miter;
   ::close(fd);
   free(buf);
 
@@ -0,0 +1,90 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+#include "xtcdata/xtc/XtcMmapFileIterator.hh"
+#include "xtcdata/xtc/XtcIndex.hh"
+
+using namespace XtcData;
+using std::string;
+
+/*
+ * Build the timestamp/offset index for an existing xtc2 file.  The DRP
+ * writes the same index while recording; this is for files recorded
+ * without it.
+ */
+
+void usage(char* progname)
+{
+    fprintf(stderr, "Usage: %s -f <filename> [-o <indexname>] [-h]\n", progname);
+}
+
+int main(int argc, char* argv[])
+{
+    int c;
+    char* xtcname = 0;
+    string outname;
+    int parseErr = 0;
+
+    while ((c = getopt(argc, argv, "hf:o:")) != -1) {
+        switch (c) {
+        case 'h':
+            usage(argv[0]);
+            exit(0);
+        case 'f':
+            xtcname = optarg;
+            break;
+        case 'o':
+            outname = optarg;
+            break;
+        default:
+            parseErr++;
+        }
+    }
+
+    if (!xtcname || parseErr) {
+        usage(argv[0]);
+        exit(2);
+    }
+    if (outname.empty()) outname = string(xtcname) + ".idx";
+
+    int fd = open(xtcname, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Unable to open file '%s'\n", xtcname);
+        exit(2);
+    }
+
+    FILE* idxFile = fopen(outname.c_str(), "w");
+    if (!idxFile) {
+        fprintf(stderr, "Unable to open index file '%s'\n", outname.c_str());
+        exit(2);
+    }
+
+    XtcIndexHeader hdr;
+    if (fwrite(&hdr, sizeof(hdr), 1, idxFile) != 1) {
+        fprintf(stderr, "Error writing index header\n");
+        exit(2);
+    }
+
+    XtcMmapFileIterator iter(fd, 0x4000000);
+    Dgram* dg;
+    unsigned nentries = 0;
+    uint64_t offset = 0;
+    while ((dg = iter.next())) {
+        XtcIndexEntry entry(*dg, offset);
+        if (fwrite(&entry, sizeof(entry), 1, idxFile) != 1) {
+            fprintf(stderr, "Error writing index entry %u\n", nentries);
+            exit(2);
+        }
+        nentries++;
+        offset = iter.offset();
+    }
+
+    printf("Wrote %u index entries for %llu bytes to '%s'\n",
+           nentries, (unsigned long long)offset, outname.c_str());
+    fclose(idxFile);
+    ::close(fd);
+    return 0;
+}
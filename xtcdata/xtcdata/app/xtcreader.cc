@@ -7,6 +7,7 @@
 #include <cinttypes>
 
 #include "xtcdata/xtc/XtcFileIterator.hh"
+#include "xtcdata/xtc/XtcMmapFileIterator.hh"
 #include "xtcdata/xtc/XtcIterator.hh"
 #include "xtcdata/xtc/ShapesData.hh"
 #include "xtcdata/xtc/DescData.hh"
@@ -237,7 +238,7 @@ private:
 
 void usage(char* progname)
 {
-    fprintf(stderr, "Usage: %s -f <filename> [-d] [-n <nEvents>] [-w <nWords>] [-h]\n", progname);
+    fprintf(stderr, "Usage: %s -f <filename> [-d] [-n <nEvents>] [-w <nWords>] [-M] [-h]\n", progname);
 }
 
 int main(int argc, char* argv[])
@@ -250,8 +251,9 @@ int main(int argc, char* argv[])
     bool debugprint = false;
     unsigned numWords = 3;
     bool printTimeAsUnsignedLong = false;
+    bool useMmap = false;
 
-    while ((c = getopt(argc, argv, "hf:n:dw:c:T")) != -1) {
+    while ((c = getopt(argc, argv, "hf:n:dw:c:TM")) != -1) {
         switch (c) {
         case 'h':
             usage(argv[0]);
@@ -274,6 +276,9 @@ int main(int argc, char* argv[])
         case 'T':
             printTimeAsUnsignedLong = true;
             break;
+        case 'M':
+            useMmap = true;
+            break;
         default:
             parseErr++;
         }
@@ -314,11 +319,15 @@ int main(int argc, char* argv[])
 
     }
 
-    XtcFileIterator iter(fd, 0x4000000);
+    // The mmap'd iterator hands out datagrams in place, so the end of
+    // the buffer is the end of each datagram rather than of a fixed buffer
+    XtcFileIterator* iter = useMmap ? 0 : new XtcFileIterator(fd, 0x4000000);
+    XtcMmapFileIterator* miter = useMmap ? new XtcMmapFileIterator(fd, 0x4000000) : 0;
     unsigned nevent=0;
-    dg = iter.next();
-    const void* bufEnd = ((char*)dg) + 0x4000000;
+    dg = useMmap ? miter->next() : iter->next();
     while (dg) {
+        const void* bufEnd = useMmap ? ((char*)dg) + sizeof(Dgram) + dg->xtc.sizeofPayload()
+                                     : ((char*)dg) + 0x4000000;
         if (nevent>=neventreq) break;
         nevent++;
         printf("event %d, %11s transition: ",
@@ -332,8 +341,10 @@ int main(int argc, char* argv[])
         printf(" env 0x%08x, payloadSize %d damage 0x%x extent %d\n",
                dg->env, dg->xtc.sizeofPayload(),dg->xtc.damage.value(),dg->xtc.extent);
         if (debugprint) dbgiter.iterate(&(dg->xtc), bufEnd);
-        dg = iter.next();
+        dg = useMmap ? miter->next() : iter->next();
     }
+    delete iter;
+    delete miter;
 
     if (cfg_fd >= 0) {
         ::close(cfg_fd);
@@ -10,6 +10,8 @@
 //#include "xtcdata/xtc/DescData.hh"
 //#include "xtcdata/xtc/NamesLookup.hh"
 
+#include <unordered_map>
+
 namespace XtcData{
 
 //class XtcData::NamesIter;
@@ -27,30 +27,19 @@ class VarDef;
 // with the names (including shapes) to compute offsets.
 class DescData {
 public:
-    // reading an existing ShapesData
+    // reading an existing ShapesData.  The payload layout comes from the
+    // NameIndex, so constructing one of these per event does no allocation
+    // and no walk over the Names.
     DescData(ShapesData& shapesdata, NameIndex& nameindex) :
-        _offset(nameindex.names().num()+1),
         _shapesdata(shapesdata),
         _nameindex(nameindex),
-        _numarrays(0)
+        _numarrays(nameindex.layout().numArrays()),
+        _layout(&nameindex.layout()),
+        _arrayCursor(0),
+        _arrayBytes(0)
     {
-        Names& names = _nameindex.names();
-        _unused(names);
-        _offset[0]=0;
-        _numentries = names.num();
-        unsigned shapeIndex = 0;
-        for (unsigned i=0; i<_numentries-1; i++) {
-            Name& name = names.get(i);
-            if (name.rank()==0) _offset[i+1]=_offset[i]+Name::get_element_size(name.type());
-            else {
-                // Since we are enforcing consecutive shapes, there's no need for this map lookup
-                //unsigned shapeIndex = _nameindex.shapeMap()[name.name()];
-                unsigned size = _shapesdata.shapes().get(shapeIndex).size(name);
-                _offset[i+1]=_offset[i]+size;
-                _numarrays++;
-                shapeIndex++;
-            }
-        }
+        // names() throws if the NamesId was missing from the NamesLookup
+        _numentries = _nameindex.names().num();
     }
 
     ~DescData() {}
@@ -122,9 +111,10 @@ public:
     Array<T> get_array(unsigned index)
     {
         Name& name = _nameindex.names().get(index);
-        uint32_t *shape = this->shape(name);
+        uint32_t *shape = _layout ? _shapesdata.shapes().get(_layout->shapeIndex[index]).shape()
+                                  : this->shape(name);
         Data& data = _shapesdata.data();
-        T* ptr = reinterpret_cast<T*>(data.payload() + _offset[index]);
+        T* ptr = reinterpret_cast<T*>(data.payload() + _offsetOf(index));
 
         // Create an Array<T> struct at the memory address of ptr
         Array<T> arrT(ptr, shape, name.rank());
@@ -137,11 +127,12 @@ public:
     T get_value(const char* name)
     {
         IndexMap& nameMap = _nameindex.nameMap();
-        if (nameMap.find(name) == nameMap.end()) {
+        IndexMap::iterator it = nameMap.find(name);
+        if (it == nameMap.end()) {
             printf("*** %s:%d: failed to find name %s\n",__FILE__,__LINE__,name);
             abort();
         }
-        unsigned index = nameMap[name];
+        unsigned index = it->second;
 
         return get_value<T>(index);
     }
@@ -156,11 +147,20 @@ public:
         Data& data = _shapesdata.data();
         Name& name = _nameindex.names().get(index);
 
-        T val = *reinterpret_cast<T*>(data.payload() + _offset[index]);
+        T val = *reinterpret_cast<T*>(data.payload() + _offsetOf(index));
         checkType(val, name);
         return val;
     }
 
+    // The fastest accessor, for code that knows the VarDef it is reading at
+    // compile time, e.g. get_value<uint64_t, SmdDef::intOffset>().  There is
+    // no range or type check: the VarDef guarantees both.
+    template <class T, unsigned Index>
+    T get_value()
+    {
+        return *reinterpret_cast<T*>(_shapesdata.data().payload() + _offsetOf(Index));
+    }
+
     // void* address(unsigned index) {
     //     Data& data = _shapesdata.data();
     //     return data.payload() + _offset[index];
@@ -181,7 +181,10 @@ protected:
         _offset(nameindex.names().num()+1),
         _shapesdata(*new (parent, bufEnd) ShapesData(namesId)),
         _nameindex(nameindex),
-        _numarrays(0)
+        _numarrays(0),
+        _layout(0),
+        _arrayCursor(0),
+        _arrayBytes(0)
     {
         Names& names = _nameindex.names();
         _unused(names);
@@ -193,7 +196,10 @@ protected:
         _offset(nameindex.names().num()+1),
         _shapesdata(*new (parent, bufEnd) ShapesData(namesId)),
         _nameindex(nameindex),
-        _numarrays(0)
+        _numarrays(0),
+        _layout(0),
+        _arrayCursor(0),
+        _arrayBytes(0)
     {
         Names& names = _nameindex.names();
         _unused(names);
@@ -221,11 +227,34 @@ protected:
     }
 
 
-    std::vector<unsigned> _offset;
+    // Offset of an entry in the Data payload.  When reading, the sizes of
+    // the preceding arrays are accumulated from the Shapes on demand and
+    // remembered, so accessing entries in order costs O(1) each.
+    unsigned _offsetOf(unsigned index) {
+        if (!_layout) return _offset[index];
+        unsigned shapeIndex = _layout->shapeIndex[index];
+        if (shapeIndex < _arrayCursor) {
+            _arrayCursor = 0;
+            _arrayBytes  = 0;
+        }
+        if (_arrayCursor < shapeIndex) {
+            Shapes& shapes = _shapesdata.shapes();
+            while (_arrayCursor < shapeIndex) {
+                _arrayBytes += _layout->arraySize(_arrayCursor, shapes.get(_arrayCursor).shape());
+                _arrayCursor++;
+            }
+        }
+        return _layout->fixedOffset[index] + _arrayBytes;
+    }
+
+    std::vector<unsigned> _offset;      // only used when creating data
     ShapesData& _shapesdata;
     unsigned    _numentries;
     NameIndex&  _nameindex;
     unsigned    _numarrays;
+    const NameLayout* _layout;          // only used when reading data
+    unsigned    _arrayCursor;
+    unsigned    _arrayBytes;
 };
 
 class DescribedData : public DescData {
@@ -4,19 +4,63 @@
 #include "xtcdata/xtc/ShapesData.hh"
 
 #include <map>
+#include <vector>
 
 typedef std::map<std::string, unsigned> IndexMap;
 
 namespace XtcData
 {
 
+// The layout of the Data payload described by a Names xtc.  The Names
+// are fixed for a run, so this is computed once per NamesId rather than
+// for every event.  The offset of an entry is the size of the scalars
+// that precede it (fixed) plus the sizes of the arrays that precede it
+// (which depend on the per-event Shapes).
+class NameLayout {
+public:
+    NameLayout() {}
+    NameLayout(Names& names) {
+        unsigned num = names.num();
+        fixedOffset.resize(num+1);
+        shapeIndex.resize(num+1);
+        fixedOffset[0] = 0;
+        shapeIndex[0]  = 0;
+        for (unsigned i=0; i<num; i++) {
+            Name& name = names.get(i);
+            unsigned elemSize = Name::get_element_size(name.type());
+            if (name.rank()==0) {
+                fixedOffset[i+1] = fixedOffset[i] + elemSize;
+                shapeIndex[i+1]  = shapeIndex[i];
+            } else {
+                fixedOffset[i+1] = fixedOffset[i];
+                shapeIndex[i+1]  = shapeIndex[i] + 1;
+                arrayRank.push_back(name.rank());
+                arrayElemSize.push_back(elemSize);
+            }
+        }
+    }
+    unsigned num()       const {return fixedOffset.empty() ? 0 : fixedOffset.size()-1;}
+    unsigned numArrays() const {return arrayRank.size();}
+    // size of the array with the given shape index in this event
+    unsigned arraySize(unsigned shapeIdx, const uint32_t* shape) const {
+        unsigned size = arrayElemSize[shapeIdx];
+        for (unsigned i=0; i<arrayRank[shapeIdx]; i++) size *= shape[i];
+        return size;
+    }
+public:
+    std::vector<uint32_t> fixedOffset;   // bytes of scalars before each entry
+    std::vector<uint32_t> shapeIndex;    // number of arrays before each entry
+    std::vector<uint32_t> arrayRank;     // per array, in Shapes order
+    std::vector<uint32_t> arrayElemSize; // per array, in Shapes order
+};
+
 class NameIndex {
 public:
-    // default constructor, used by NamesLookup std::map for keys
+    // default constructor, used by NamesLookup for keys
     // that don't exist (see comment in names() method below).
     NameIndex() : _names(0) {}
 
-    NameIndex(Names& names) {
+    NameIndex(Names& names) : _layout(names) {
         _init_names(names);
         unsigned iarray = 0;
         for (unsigned i=0; i<_names->num(); i++) {
@@ -36,6 +80,7 @@ public:
         }
         _shapeMap = old._shapeMap;
         _nameMap = old._nameMap;
+        _layout = old._layout;
     }
     NameIndex& operator=(const NameIndex& rhs) {
         if (_names) free(_names);
@@ -47,18 +92,20 @@ public:
         }
         _shapeMap = rhs._shapeMap;
         _nameMap = rhs._nameMap;
+        _layout = rhs._layout;
         return *this;
     }
     ~NameIndex() {if (_names) free(_names);}
     IndexMap& shapeMap() {return _shapeMap;}
     IndexMap& nameMap()  {return _nameMap;}
+    const NameLayout& layout() const {return _layout;}
     Names&    names()    {
         if (_names == 0) {
             // this typically happens when the user gives a bad NamesId
             // to NamesLookup[NamesId], which is in turn often caused by the
             // NamesLookup being empty (NamesLookup should be filled in on the
             // configure transition).  The reason the _names pointer is
-            // zero is that std::map (implementation of NamesLookup) uses
+            // zero is that NamesLookup (like the std::map it replaced) uses
             // the default NameIndex constructor for keys that don't exist.
             // We considered throwing an error in the default constructor,
             // but that constructor is also used for assignments like
@@ -86,6 +133,7 @@ private:
     Names*   _names;
     IndexMap _shapeMap;
     IndexMap _nameMap;
+    NameLayout _layout;
 };
 
 }
@@ -4,7 +4,13 @@
 #include "xtcdata/xtc/NameIndex.hh"
 #include "xtcdata/xtc/NamesId.hh"
 
-#include <unordered_map>
+#include <iterator>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace XtcData{
 
@@ -13,11 +19,157 @@ namespace XtcData{
 // ShapesData xtc that shows up every event. The Names and ShapesData
 // xtc's each get a unique identifier that can be used to associate
 // the two (the NamesId class which is put in the xtc Src field).
-// This identifier is used as a key in the map below.  An earlier
-// implementation was done with std::vector, to avoid the map key
-// search, but used alot of memory (see NamesId::NumberOf)
+// This identifier is used as a key in the table below.
+//
+// An earlier implementation was a std::vector of NamesId::NumberOf
+// entries, which used alot of memory, and the one after that a
+// std::unordered_map, which hashes the key on every lookup.  Here the
+// key is split the way NamesId builds it: the nodeId picks a page of
+// 256 slots, allocated the first time that node shows up, and the
+// namesId picks the slot.  A lookup is two array indexings, and the
+// memory is a page per node (2kB) plus a NameIndex per Names.
+//
+// The interface is the subset of std::unordered_map used with it:
+// operator[] creates missing entries, and iterating visits the
+// entries as std::pair<const unsigned,NameIndex> in key order.
+// Entries don't move once created, so references to them stay valid
+// until clear().
 
-typedef std::unordered_map<unsigned,NameIndex> NamesLookup;
+class NamesLookup {
+public:
+    typedef unsigned                              key_type;
+    typedef NameIndex                             mapped_type;
+    typedef std::pair<const unsigned, NameIndex>  value_type;
+    typedef size_t                                size_type;
+
+    enum {SlotBits=8, SlotsPerNode=1<<SlotBits, NumberOfNodes=NamesId::NumberOf>>SlotBits};
+private:
+    struct Node {
+        std::unique_ptr<value_type> slot[SlotsPerNode];
+    };
+
+    template <bool Const>
+    class Iter {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef NamesLookup::value_type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef typename std::conditional<Const, const value_type*, value_type*>::type pointer;
+        typedef typename std::conditional<Const, const value_type&, value_type&>::type reference;
+        typedef typename std::conditional<Const, const NamesLookup*, NamesLookup*>::type table_type;
+
+        Iter() : _table(0), _key(NamesId::NumberOf) {}
+        Iter(table_type table, unsigned key) : _table(table), _key(key) {}
+        // iterator converts to const_iterator
+        template <bool C, class = typename std::enable_if<Const && !C>::type>
+        Iter(const Iter<C>& it) : _table(it._table), _key(it._key) {}
+
+        reference operator*()  const {return *_table->_slot(_key);}
+        pointer   operator->() const {return  _table->_slot(_key);}
+        Iter& operator++()    {_key = _table->_next(_key+1); return *this;}
+        Iter  operator++(int) {Iter it(*this); ++*this; return it;}
+        bool operator==(const Iter& it) const {return _key==it._key;}
+        bool operator!=(const Iter& it) const {return _key!=it._key;}
+    private:
+        friend class NamesLookup;
+        template <bool> friend class Iter;
+        table_type _table;
+        unsigned   _key;
+    };
+public:
+    typedef Iter<false> iterator;
+    typedef Iter<true>  const_iterator;
+
+    NamesLookup() : _size(0) {}
+    NamesLookup(const NamesLookup& rhs) : _size(0) {*this = rhs;}
+    NamesLookup(NamesLookup&& rhs) : _nodes(std::move(rhs._nodes)), _size(rhs._size) {rhs._size = 0;}
+    NamesLookup& operator=(NamesLookup&& rhs) {
+        _nodes = std::move(rhs._nodes);
+        _size  = rhs._size;
+        rhs._nodes.clear();
+        rhs._size = 0;
+        return *this;
+    }
+    NamesLookup& operator=(const NamesLookup& rhs) {
+        if (this == &rhs) return *this;
+        clear();
+        for (const value_type& entry : rhs)
+            (*this)[entry.first] = entry.second;
+        return *this;
+    }
+
+    // Like std::unordered_map, creates a default (empty) NameIndex for
+    // a key that doesn't exist yet
+    NameIndex& operator[](unsigned key) {
+        value_type* entry = _slot(key);
+        if (entry) return entry->second;
+        return _insert(key);
+    }
+
+    size_type count(unsigned key) const {return _slot(key) ? 1 : 0;}
+
+    iterator       find(unsigned key)       {return _slot(key) ? iterator(this, key) : end();}
+    const_iterator find(unsigned key) const {return _slot(key) ? const_iterator(this, key) : end();}
+
+    iterator       begin()       {return iterator(this, _next(0));}
+    const_iterator begin() const {return const_iterator(this, _next(0));}
+    iterator       end()         {return iterator(this, NamesId::NumberOf);}
+    const_iterator end()   const {return const_iterator(this, NamesId::NumberOf);}
+
+    size_type size()  const {return _size;}
+    bool      empty() const {return _size==0;}
+
+    size_type erase(unsigned key) {
+        if (!_slot(key)) return 0;
+        _nodes[key>>SlotBits]->slot[key&(SlotsPerNode-1)].reset();
+        _size--;
+        return 1;
+    }
+
+    // releases the pages too: the nodes of the next configure may differ
+    void clear() {
+        for (std::unique_ptr<Node>& node : _nodes) node.reset();
+        _size = 0;
+    }
+private:
+    // called for keys that have no entry
+    NameIndex& _insert(unsigned key) {
+        if (key >= NamesId::NumberOf) {
+            printf("*** %s:%d: NamesId 0x%x too large\n",__FILE__,__LINE__,key);
+            abort();
+        }
+        if (_nodes.empty()) _nodes.resize(NumberOfNodes);
+        std::unique_ptr<Node>& node = _nodes[key>>SlotBits];
+        if (!node) node.reset(new Node);
+        std::unique_ptr<value_type>& slot = node->slot[key&(SlotsPerNode-1)];
+        slot.reset(new value_type(key, NameIndex()));
+        _size++;
+        return slot->second;
+    }
+
+    value_type* _slot(unsigned key) const {
+        if (key >= NamesId::NumberOf || _nodes.empty()) return 0;
+        const Node* node = _nodes[key>>SlotBits].get();
+        return node ? node->slot[key&(SlotsPerNode-1)].get() : 0;
+    }
+    // first key >= key that has an entry, or NumberOf
+    unsigned _next(unsigned key) const {
+        if (_nodes.empty()) return NamesId::NumberOf;
+        while (key < NamesId::NumberOf) {
+            const Node* node = _nodes[key>>SlotBits].get();
+            if (!node) {
+                key = ((key>>SlotBits)+1)<<SlotBits;
+                continue;
+            }
+            if (node->slot[key&(SlotsPerNode-1)]) return key;
+            key++;
+        }
+        return NamesId::NumberOf;
+    }
+private:
+    std::vector<std::unique_ptr<Node> > _nodes;  // NumberOfNodes, once something was added
+    size_type                           _size;
+};
 
 };
 
@@ -11,11 +11,16 @@ class Smd
 {
 public:
 
-    Smd() {
+    // With striped, the offset info also records which of the striped
+    // bigdata files (0 being the primary one) holds the L1Accept
+    Smd(bool striped = false) : _striped(striped) {
     };
 
     Dgram* generate(Dgram* dgIn, void* buf, const void* bufEnd, uint64_t offset, uint64_t size,
-                    NamesLookup& namesLookup, NamesId namesId);
+                    NamesLookup& namesLookup, NamesId namesId, unsigned stripe = 0);
+
+private:
+    bool _striped;
 
 }; // end class Smd
 
@@ -0,0 +1,76 @@
+#ifndef XtcData_XtcIndex_hh
+#define XtcData_XtcIndex_hh
+
+#include "xtcdata/xtc/Dgram.hh"
+
+#include <stdint.h>
+#include <stddef.h>
+
+//
+// Fixed-record binary index for an xtc2 file (chunk).  The file starts with
+// an XtcIndexHeader followed by one XtcIndexEntry per datagram in file order.
+// Since datagrams are written in timestamp order, the index can be binary
+// searched by timestamp without scanning the xtc2 or smd files.
+//
+
+#pragma pack(push,4)
+
+namespace XtcData
+{
+
+class XtcIndexHeader
+{
+public:
+    enum { Magic = 0x58444958 }; // "XIDX"
+    enum { Version = 1 };
+    XtcIndexHeader();
+    bool valid() const;
+public:
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entrySize;
+    uint32_t reserved[2];
+};
+
+class XtcIndexEntry
+{
+public:
+    XtcIndexEntry() {}
+    XtcIndexEntry(const Dgram& dg, uint64_t offset_);
+    TransitionId::Value service() const { return TransitionId::Value(_service); }
+public:
+    uint64_t time;      // TimeStamp::value()
+    uint64_t offset;    // byte offset of the datagram in its xtc2 file
+    uint32_t size;      // size of the datagram, including its header
+    uint16_t damage;
+    uint8_t  _service;
+    uint8_t  _reserved;
+};
+
+class XtcIndex
+{
+public:
+    XtcIndex();
+    ~XtcIndex();
+    // Returns 0 on success
+    int open(const char* fileName);
+    void close();
+    size_t size() const { return _nEntries; }
+    const XtcIndexEntry& entry(size_t i) const { return _entries[i]; }
+    // Index of the first entry with time >= the requested one (size() if none)
+    size_t lowerBound(uint64_t time) const;
+    // The entry with exactly the requested timestamp, or 0 if not present.
+    // When a transition and an event share a timestamp, the first is returned.
+    const XtcIndexEntry* find(uint64_t time) const;
+private:
+    void*                _map;
+    size_t               _mapSize;
+    const XtcIndexEntry* _entries;
+    size_t               _nEntries;
+};
+
+}
+
+#pragma pack(pop)
+
+#endif
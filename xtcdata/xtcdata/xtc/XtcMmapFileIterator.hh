@@ -0,0 +1,54 @@
+#ifndef XtcData_XtcMmapFileIterator_hh
+#define XtcData_XtcMmapFileIterator_hh
+
+#include "xtcdata/xtc/Dgram.hh"
+
+#include <stdint.h>
+#include <stdio.h>
+
+namespace XtcData
+{
+
+// Alternative to XtcFileIterator for offline replay of closed files.
+// The file is mapped once and datagrams are handed out in place, so
+// there are no read() calls per event.  A window of readAhead bytes
+// beyond the current position is advised to the kernel (MADV_WILLNEED),
+// which starts the page-cache read-ahead asynchronously, and pages
+// well behind the current position are marked cold (MADV_COLD) so that
+// they are reclaimed first and the resident set stays bounded on
+// multi-TB files.  The mapping is private, so
+// callers may modify the returned datagrams without touching the file.
+// The returned datagram is valid until the iterator is destroyed.
+
+class XtcMmapFileIterator
+{
+public:
+    XtcMmapFileIterator(int fd, size_t maxDgramSize, size_t readAhead = 0x4000000);
+    ~XtcMmapFileIterator();
+    Dgram* next();
+    void rewind();
+    // Position the iterator at a datagram offset, e.g. one taken from
+    // the smd file, and return that datagram.  Subsequent calls to next()
+    // continue with the datagram that follows.
+    Dgram* seek(uint64_t offset);
+    size_t size() const { return _maxDgramSize; }
+    uint64_t offset() const { return _offset; }
+    uint64_t fileSize() const { return _fileSize; }
+
+private:
+    Dgram* _dgram(uint64_t offset);
+    void _advise(uint64_t offset);
+
+private:
+    int _fd;
+    size_t _maxDgramSize;
+    size_t _readAhead;
+    char* _base;
+    uint64_t _fileSize;
+    uint64_t _offset;
+    uint64_t _adviseEnd;
+    uint64_t _releaseEnd;
+};
+}
+
+#endif
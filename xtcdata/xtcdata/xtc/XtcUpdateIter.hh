@@ -15,6 +15,7 @@
 #include <string>
 #include <typeinfo>
 #include <memory>
+#include <vector>
 
 namespace XtcData
 {
@@ -92,6 +93,8 @@ public:
         _removedSize = 0;              // counting size of removed det/alg in bytes
         _cfgFlag = 0;                   // tells if this dgram is a Configure
         _cfgWriteFlag = 0;              // default is not to write to _cfgbuf when iterated.
+        _outbuf = 0;
+        _staged = false;
         _nodeId = 0;
         _maxOfMinNamesId = 0;           // stores the highest value of the lower range existing NamesIds
         _minOfMaxNamesId = 255;         // stores the lowest value of the upper range existing NamesIds
@@ -138,9 +141,9 @@ public:
     void setCfgWriteFlag(int cfgWriteFlag) {
         _cfgWriteFlag = cfgWriteFlag;
     }
-    void setOutput(char* outbuf) {
-        _outbuf = outbuf;
-    }
+    // input - the Xtc to be iterated into outbuf, if it may be the same
+    // memory as outbuf (saving in place, e.g. in the DRP's pebble)
+    void setOutput(char* outbuf, const Xtc* input=0);
 
     int isConfig(){
         return _cfgFlag;
@@ -184,6 +187,12 @@ private:
     unsigned _bufSize;
     char* _outbuf;
 
+    // When saving over the input, XtcIterator still reads the Xtc headers
+    // after process() returns, so the payload is collected in _stage and
+    // only copied to _outbuf by copyParent().
+    std::vector<char> _stage;
+    bool _staged;
+
     // Used for couting no. of ShapesData bytes removed per event.
     // This gets reset to 0 when the event is saved.
     uint32_t _removedSize;
@@ -28,6 +28,24 @@ public:
    }
 } SmdDef;
 
+class SmdStripeDef:public VarDef
+{
+public:
+  enum index
+    {
+      intOffset,
+      intDgramSize,
+      intStripe
+    };
+
+   SmdStripeDef()
+   {
+     NameVec.push_back({"intOffset", Name::UINT64});
+     NameVec.push_back({"intDgramSize", Name::UINT64});
+     NameVec.push_back({"intStripe", Name::UINT32});
+   }
+} SmdStripeDef;
+
 class CheckNamesIdIter : public XtcIterator
 {
 public:
@@ -60,7 +78,7 @@ private:
     NamesId _offset_namesId;
 };
 
-void addNames(Xtc& parent, const void* bufEnd, NamesLookup& namesLookup, NamesId namesId)
+void addNames(Xtc& parent, const void* bufEnd, NamesLookup& namesLookup, NamesId namesId, VarDef& def)
 {
     Alg alg("offsetAlg",0,0,0);
 
@@ -69,12 +87,12 @@ void addNames(Xtc& parent, const void* bufEnd, NamesLookup& namesLookup, NamesId
     checkNamesId.iterate(&parent, bufEnd);
 
     Names& offsetNames = *new(parent, bufEnd) Names(bufEnd, "smdinfo", alg, "offset", "", namesId);
-    offsetNames.add(parent,bufEnd,SmdDef);
+    offsetNames.add(parent,bufEnd,def);
     namesLookup[namesId] = NameIndex(offsetNames);
 }
 
 Dgram* Smd::generate(Dgram* dgIn, void* buf, const void* bufEnd, uint64_t offset, uint64_t size,
-        NamesLookup& namesLookup, NamesId namesId)
+        NamesLookup& namesLookup, NamesId namesId, unsigned stripe)
 {
     if (dgIn->service() != TransitionId::L1Accept) {
         Dgram *dgOut;
@@ -83,7 +101,10 @@ Dgram* Smd::generate(Dgram* dgIn, void* buf, const void* bufEnd, uint64_t offset
         memcpy(dgOut->xtc.payload(), dgIn->xtc.payload(), dgIn->xtc.sizeofPayload());
 
         if (dgIn->service() == TransitionId::Configure) {
-            addNames(dgOut->xtc, bufEnd, namesLookup, namesId);
+            if (_striped)
+                addNames(dgOut->xtc, bufEnd, namesLookup, namesId, SmdStripeDef);
+            else
+                addNames(dgOut->xtc, bufEnd, namesLookup, namesId, SmdDef);
         }
 
         return dgOut;
@@ -97,6 +118,8 @@ Dgram* Smd::generate(Dgram* dgIn, void* buf, const void* bufEnd, uint64_t offset
         CreateData createSmd(dgOut.xtc, bufEnd, namesLookup, namesId);
         createSmd.set_value(SmdDef::intOffset, offset);
         createSmd.set_value(SmdDef::intDgramSize, size);
+        if (_striped)
+            createSmd.set_value(SmdStripeDef::intStripe, (uint32_t)stripe);
 
         if (offset < 0) {
             cout << "Error offset value (offset=" << offset << ")" << endl;
@@ -0,0 +1,106 @@
+
+#include "xtcdata/xtc/XtcIndex.hh"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace XtcData;
+
+XtcIndexHeader::XtcIndexHeader() :
+    magic(Magic), version(Version), entrySize(sizeof(XtcIndexEntry))
+{
+    reserved[0] = reserved[1] = 0;
+}
+
+bool XtcIndexHeader::valid() const
+{
+    return magic == Magic && version == Version && entrySize == sizeof(XtcIndexEntry);
+}
+
+XtcIndexEntry::XtcIndexEntry(const Dgram& dg, uint64_t offset_) :
+    time    (dg.time.value()),
+    offset  (offset_),
+    size    (sizeof(Dgram) + dg.xtc.sizeofPayload()),
+    damage  (dg.xtc.damage.value()),
+    _service(dg.service()),
+    _reserved(0)
+{
+}
+
+XtcIndex::XtcIndex() : _map(0), _mapSize(0), _entries(0), _nEntries(0)
+{
+}
+
+XtcIndex::~XtcIndex()
+{
+    close();
+}
+
+int XtcIndex::open(const char* fileName)
+{
+    close();
+
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0) {
+        printf("XtcIndex: unable to open '%s': %s\n", fileName, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(XtcIndexHeader)) {
+        printf("XtcIndex: '%s' is too short to be an index\n", fileName);
+        ::close(fd);
+        return -1;
+    }
+    void* p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        printf("XtcIndex: mmap of '%s' failed: %s\n", fileName, strerror(errno));
+        return -1;
+    }
+    const XtcIndexHeader& hdr = *(const XtcIndexHeader*)p;
+    if (!hdr.valid()) {
+        printf("XtcIndex: '%s' has bad header: magic 0x%x, version %u, entry size %u\n",
+               fileName, hdr.magic, hdr.version, hdr.entrySize);
+        munmap(p, st.st_size);
+        return -1;
+    }
+    _map      = p;
+    _mapSize  = st.st_size;
+    _entries  = (const XtcIndexEntry*)(&hdr + 1);
+    // A partial trailing record (e.g. from a file still being written) is ignored
+    _nEntries = (_mapSize - sizeof(XtcIndexHeader)) / sizeof(XtcIndexEntry);
+    return 0;
+}
+
+void XtcIndex::close()
+{
+    if (_map) munmap(_map, _mapSize);
+    _map      = 0;
+    _mapSize  = 0;
+    _entries  = 0;
+    _nEntries = 0;
+}
+
+size_t XtcIndex::lowerBound(uint64_t time) const
+{
+    size_t lo = 0;
+    size_t hi = _nEntries;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (_entries[mid].time < time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+const XtcIndexEntry* XtcIndex::find(uint64_t time) const
+{
+    size_t i = lowerBound(time);
+    return (i < _nEntries && _entries[i].time == time) ? &_entries[i] : 0;
+}
@@ -0,0 +1,106 @@
+
+#include "xtcdata/xtc/XtcMmapFileIterator.hh"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace XtcData;
+
+XtcMmapFileIterator::XtcMmapFileIterator(int fd, size_t maxDgramSize, size_t readAhead)
+: _fd(fd), _maxDgramSize(maxDgramSize), _readAhead(readAhead), _base(0),
+  _fileSize(0), _offset(0), _adviseEnd(0), _releaseEnd(0)
+{
+    struct stat st;
+    if (fstat(_fd, &st) < 0) {
+        printf("XtcMmapFileIterator: fstat failed: %s\n", strerror(errno));
+        return;
+    }
+    _fileSize = st.st_size;
+    if (_fileSize == 0) return;
+
+    void* p = mmap(0, _fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, _fd, 0);
+    if (p == MAP_FAILED) {
+        printf("XtcMmapFileIterator: mmap of %lu bytes failed: %s\n",
+               (unsigned long)_fileSize, strerror(errno));
+        _fileSize = 0;
+        return;
+    }
+    _base = (char*)p;
+    _advise(0);
+}
+
+XtcMmapFileIterator::~XtcMmapFileIterator()
+{
+    if (_base) munmap(_base, _fileSize);
+}
+
+void XtcMmapFileIterator::_advise(uint64_t offset)
+{
+    // Only re-advise once half of the previous window has been consumed
+    // to keep the number of madvise calls per event at zero on average
+    if (!_base) return;
+    if (offset + _readAhead/2 < _adviseEnd) return;
+
+    static const uint64_t pageMask = ~uint64_t(sysconf(_SC_PAGESIZE) - 1);
+    uint64_t begin = offset & pageMask;
+    uint64_t end   = offset + _readAhead;
+    if (end > _fileSize) end = _fileSize;
+    if (end > begin) madvise(_base + begin, end - begin, MADV_WILLNEED);
+    _adviseEnd = end;
+
+    // Make pages more than one window behind us the first to be reclaimed.
+    // Not MADV_DONTNEED: on this private mapping it would discard whatever
+    // the caller wrote into datagrams handed out earlier
+#ifdef MADV_COLD
+    if (begin > _readAhead) {
+        uint64_t release = (begin - _readAhead) & pageMask;
+        if (release > _releaseEnd) {
+            madvise(_base + _releaseEnd, release - _releaseEnd, MADV_COLD);
+            _releaseEnd = release;
+        }
+    }
+#endif
+}
+
+Dgram* XtcMmapFileIterator::_dgram(uint64_t offset)
+{
+    if (offset + sizeof(Dgram) > _fileSize) return 0;
+    Dgram& dg = *(Dgram*)(_base + offset);
+    size_t payloadSize = dg.xtc.sizeofPayload();
+    if ((payloadSize + sizeof(dg)) > _maxDgramSize) {
+        printf("Datagram size %zu larger than maximum: %zu\n", payloadSize + sizeof(dg), _maxDgramSize);
+        return 0;
+    }
+    if (offset + sizeof(dg) + payloadSize > _fileSize) {
+        printf("XtcMmapFileIterator::next read incomplete payload %d/%d\n",
+               (int)(_fileSize - offset - sizeof(dg)), (int)payloadSize);
+        return 0;
+    }
+    _offset = offset + sizeof(dg) + payloadSize;
+    return &dg;
+}
+
+Dgram* XtcMmapFileIterator::next()
+{
+    _advise(_offset);
+    return _dgram(_offset);
+}
+
+Dgram* XtcMmapFileIterator::seek(uint64_t offset)
+{
+    // Don't read ahead for random access: the pages of this datagram are
+    // faulted in on demand, and the window is re-established by next()
+    _adviseEnd = 0;
+    return _dgram(offset);
+}
+
+void XtcMmapFileIterator::rewind()
+{
+    _offset = 0;
+    _adviseEnd = 0;
+    _releaseEnd = 0;
+    _advise(0);
+}
@@ -305,8 +305,22 @@ int XtcUpdateIter::process(Xtc* xtc, const void* bufEnd)
 }
 
 
+void XtcUpdateIter::setOutput(char* outbuf, const Xtc* input){
+    _outbuf = outbuf;
+    _staged = false;
+    if (input) {
+        const char* begin = (const char*)input;
+        const char* end   = (const char*)input->next();
+        _staged = outbuf < end && begin < outbuf + sizeof(Dgram) + (end - begin);
+        if (_staged && _stage.size() < size_t(end - begin))
+            _stage.resize(end - begin);
+    }
+}
+
+
 void XtcUpdateIter::copyPayload(char* in_buf, unsigned in_size){
-    memcpy(_outbuf + _payloadSize + sizeof(Dgram), in_buf, in_size);
+    char* payload = _staged ? _stage.data() : _outbuf + sizeof(Dgram);
+    memcpy(payload + _payloadSize, in_buf, in_size);
     _payloadSize += in_size;
 }
 
@@ -316,7 +330,12 @@ void XtcUpdateIter::copyPayload(char* in_buf, unsigned in_size){
 */
 void XtcUpdateIter::copyParent(Dgram* parent_d){
     // TODO Add checks for overflown
-    memcpy(_outbuf, (char *) parent_d, sizeof(Dgram));
+    // memmove: parent_d is _outbuf itself when saving in place
+    memmove(_outbuf, (char *) parent_d, sizeof(Dgram));
+    if (_staged) {
+        memcpy(_outbuf + sizeof(Dgram), _stage.data(), _payloadSize);
+        _staged = false;
+    }
     _bufSize = sizeof(Dgram) + _payloadSize;
     _payloadSize = 0;
     _removedSize = 0;